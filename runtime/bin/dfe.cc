@@ -221,6 +221,29 @@ void DFE::CompileAndReadScript(const char* script_uri,
                                int* exit_code,
                                const char* package_config,
                                bool snapshot) {
+  // The incremental compiler has to see the program to recompile it later.
+  const bool use_cache =
+      (kernel_cache_ != nullptr) && !use_incremental_compiler();
+  uint64_t cache_key = 0;
+  int64_t compile_start = 0;
+  if (use_cache) {
+    int64_t start = Dart_TimelineGetMicros();
+    cache_key = kernel_cache_->KeyFor(script_uri, package_config, snapshot);
+    const bool hit =
+        kernel_cache_->Lookup(cache_key, kernel_buffer, kernel_buffer_size);
+    int64_t end = Dart_TimelineGetMicros();
+    const char* arg_name = "hit";
+    const char* arg_value = hit ? "true" : "false";
+    Dart_TimelineEvent("DFE::KernelCacheLookup", start, end,
+                       Dart_Timeline_Event_Duration, 1, &arg_name, &arg_value);
+    if (hit) {
+      *error = nullptr;
+      *exit_code = 0;
+      return;
+    }
+    compile_start = KernelCache::CurrentTimeMillis();
+  }
+
   Dart_KernelCompilationResult result = CompileScript(
       script_uri, use_incremental_compiler(), package_config, snapshot);
   switch (result.status) {
@@ -229,6 +252,10 @@ void DFE::CompileAndReadScript(const char* script_uri,
       *kernel_buffer_size = result.kernel_size;
       *error = nullptr;
       *exit_code = 0;
+      if (use_cache) {
+        StoreInKernelCache(cache_key, compile_start, result.kernel,
+                           result.kernel_size);
+      }
       break;
     case Dart_KernelCompilationStatus_Error:
       free(result.kernel);
@@ -249,6 +276,24 @@ void DFE::CompileAndReadScript(const char* script_uri,
   }
 }
 
+void DFE::StoreInKernelCache(uint64_t key,
+                             int64_t compile_start,
+                             const uint8_t* kernel_buffer,
+                             intptr_t kernel_buffer_size) {
+  int64_t start = Dart_TimelineGetMicros();
+  Dart_KernelCompilationResult dependencies = Dart_KernelListDependencies();
+  if (dependencies.status == Dart_KernelCompilationStatus_Ok) {
+    kernel_cache_->Store(key, compile_start, kernel_buffer, kernel_buffer_size,
+                         reinterpret_cast<const char*>(dependencies.kernel),
+                         dependencies.kernel_size);
+  }
+  free(dependencies.kernel);
+  free(dependencies.error);
+  int64_t end = Dart_TimelineGetMicros();
+  Dart_TimelineEvent("DFE::KernelCacheStore", start, end,
+                     Dart_Timeline_Event_Duration, 0, nullptr, nullptr);
+}
+
 void DFE::ReadScript(const char* script_uri,
                      uint8_t** kernel_buffer,
                      intptr_t* kernel_buffer_size,
@@ -7,6 +7,7 @@
 
 #include <memory>
 
+#include "bin/kernel_cache.h"
 #include "bin/thread.h"
 #include "include/dart_api.h"
 #include "include/dart_native_api.h"
@@ -64,6 +65,11 @@ class DFE {
     *size = application_kernel_buffer_size_;
   }
 
+  // Takes ownership of [cache], which CompileAndReadScript then consults
+  // before compiling a script with the non-incremental compiler.
+  void set_kernel_cache(KernelCache* cache) { kernel_cache_.reset(cache); }
+  KernelCache* kernel_cache() const { return kernel_cache_.get(); }
+
   // Compiles specified script.
   // Returns result from compiling the script.
   //
@@ -92,6 +98,9 @@ class DFE {
   // representation of the script, NULL otherwise
   // 'error' and 'exit_code' have the error values in case of errors.
   //
+  // If a kernel cache is set, the kernel is read from the cache if the
+  // script and its dependencies did not change since it was cached.
+  //
   // `snapshot` is used by the frontend to determine if compilation
   // related information should be printed to console (e.g., null safety mode).
   void CompileAndReadScript(const char* script_uri,
@@ -176,8 +185,17 @@ class DFE {
   intptr_t kernel_blob_counter_ = 0;
   Mutex kernel_blobs_lock_;
 
+  std::unique_ptr<KernelCache> kernel_cache_;
+
   void InitKernelServiceAndPlatformDills();
 
+  // Caches [kernel_buffer] compiled for [key] together with the list of
+  // files the kernel service read to compile it.
+  void StoreInKernelCache(uint64_t key,
+                          int64_t compile_start,
+                          const uint8_t* kernel_buffer,
+                          intptr_t kernel_buffer_size);
+
   DISALLOW_COPY_AND_ASSIGN(DFE);
 };
 
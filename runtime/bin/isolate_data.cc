@@ -3,12 +3,19 @@
 // BSD-style license that can be found in the LICENSE file.
 
 #include "bin/isolate_data.h"
+#include "bin/file.h"
+#include "bin/lockers.h"
 #include "bin/snapshot_utils.h"
+#include "bin/thread.h"
 #include "platform/growable_array.h"
+#include "platform/syslog.h"
 
 namespace dart {
 namespace bin {
 
+// The root loading unit is the app snapshot itself.
+static constexpr intptr_t kFirstPrefetchedLoadingUnitId = 2;
+
 IsolateGroupData::IsolateGroupData(const char* url,
                                    const char* packages_file,
                                    AppSnapshot* app_snapshot,
@@ -25,6 +32,16 @@ IsolateGroupData::IsolateGroupData(const char* url,
 }
 
 IsolateGroupData::~IsolateGroupData() {
+  if (prefetch_monitor_ != nullptr) {
+    MonitorLocker ml(prefetch_monitor_.get());
+    prefetch_cancelled_ = true;
+    while (prefetching_) {
+      ml.Wait();
+    }
+    for (intptr_t i = 0; i < prefetched_units_.length(); i++) {
+      delete prefetched_units_[i];
+    }
+  }
   for (intptr_t i = 0; i < loading_units_.length(); i++) {
     delete loading_units_[i];
   }
@@ -38,6 +55,76 @@ IsolateGroupData::~IsolateGroupData() {
   kernel_buffer_size_ = 0;
 }
 
+void IsolateGroupData::StartPrefetchingLoadingUnits() {
+  ASSERT(prefetch_monitor_ == nullptr);
+  prefetch_monitor_.reset(new Monitor());
+  MonitorLocker ml(prefetch_monitor_.get());
+  prefetching_ = true;
+  int result = Thread::Start("Dart LoadingUnitPrefetcher", PrefetchLoadingUnits,
+                             reinterpret_cast<uword>(this));
+  if (result != 0) {
+    Syslog::PrintErr("Failed to start loading unit prefetcher: %d\n", result);
+    prefetching_ = false;
+  }
+}
+
+// Reads the file at [path] so its pages are in the page cache when it is
+// mapped, which makes the page faults taken by the isolate when it reads the
+// snapshot minor ones.
+static void ReadIntoPageCache(const char* path) {
+  File* file = File::Open(nullptr, path, File::kRead);
+  if (file == nullptr) {
+    return;
+  }
+  const intptr_t kChunkSize = 64 * KB;
+  uint8_t* chunk = reinterpret_cast<uint8_t*>(malloc(kChunkSize));
+  while (file->Read(chunk, kChunkSize) > 0) {
+  }
+  free(chunk);
+  file->Release();
+}
+
+void IsolateGroupData::PrefetchLoadingUnits(uword parameter) {
+  auto data = reinterpret_cast<IsolateGroupData*>(parameter);
+  for (intptr_t id = kFirstPrefetchedLoadingUnitId;; id++) {
+    {
+      MonitorLocker ml(data->prefetch_monitor_.get());
+      if (data->prefetch_cancelled_) break;
+    }
+    char* unit_url =
+        Utils::SCreate("%s-%" Pd ".part.so", data->script_url, id);
+    ReadIntoPageCache(unit_url);
+    AppSnapshot* unit = Snapshot::TryReadAppSnapshot(unit_url);
+    free(unit_url);
+    if (unit == nullptr) break;
+    MonitorLocker ml(data->prefetch_monitor_.get());
+    data->prefetched_units_.Add(unit);
+    ml.NotifyAll();
+  }
+  MonitorLocker ml(data->prefetch_monitor_.get());
+  data->prefetching_ = false;
+  ml.NotifyAll();
+}
+
+AppSnapshot* IsolateGroupData::TakePrefetchedLoadingUnit(intptr_t id) {
+  if (prefetch_monitor_ == nullptr) {
+    return nullptr;
+  }
+  const intptr_t index = id - kFirstPrefetchedLoadingUnitId;
+  if (index < 0) {
+    return nullptr;
+  }
+  MonitorLocker ml(prefetch_monitor_.get());
+  if (index >= prefetched_units_.length()) {
+    // Not read yet. Waiting for the prefetcher, which may be reading other
+    // units first, would delay the load more than reading the unit here.
+    return nullptr;
+  }
+  AppSnapshot* unit = prefetched_units_[index];
+  prefetched_units_[index] = nullptr;
+  return unit;
+}
+
 IsolateData::IsolateData(IsolateGroupData* isolate_group_data)
     : isolate_group_data_(isolate_group_data),
       loader_(nullptr),
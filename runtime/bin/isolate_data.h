@@ -29,6 +29,7 @@ namespace bin {
 class AppSnapshot;
 class EventHandler;
 class Loader;
+class Monitor;
 
 // Data associated with every isolate group in the standalone VM
 // embedding. This is used to free external resources for each isolate
@@ -101,11 +102,30 @@ class IsolateGroupData {
     loading_units_.Add(loading_unit);
   }
 
+  // Starts reading the deferred loading units of the AOT snapshot at
+  // [script_url] on a helper thread, in the order of their ids, until a unit
+  // is missing. Each unit is read into the page cache and mapped; it is
+  // still deserialized by the isolate when it is loaded.
+  void StartPrefetchingLoadingUnits();
+
+  // Returns the snapshot of the loading unit [id] read by the prefetcher, or
+  // nullptr if the prefetcher has not read it (yet). Does not block.
+  // The caller takes ownership of the snapshot.
+  AppSnapshot* TakePrefetchedLoadingUnit(intptr_t id);
+
  private:
   friend class IsolateData;  // For packages_file_
 
+  static void PrefetchLoadingUnits(uword parameter);
+
   std::unique_ptr<AppSnapshot> app_snapshot_;
   MallocGrowableArray<AppSnapshot*> loading_units_;
+  // Guards the fields below, which are shared with the prefetcher.
+  std::unique_ptr<Monitor> prefetch_monitor_;
+  // Indexed by loading unit id - kFirstPrefetchedLoadingUnitId.
+  MallocGrowableArray<AppSnapshot*> prefetched_units_;
+  bool prefetching_ = false;
+  bool prefetch_cancelled_ = false;
   char* resolved_packages_config_;
   std::shared_ptr<uint8_t> kernel_buffer_;
   intptr_t kernel_buffer_size_;
@@ -0,0 +1,374 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "bin/kernel_cache.h"
+
+#include <time.h>
+
+#include <memory>
+
+#include "bin/directory.h"
+#include "bin/file.h"
+#include "bin/process.h"
+#include "include/dart_api.h"
+#include "platform/growable_array.h"
+
+namespace dart {
+namespace bin {
+
+static constexpr uint32_t kEntryMagic = 0x444b4331;  // 'DKC1'
+static const char kEntrySuffix[] = ".dillcache";
+static constexpr uint64_t kHashPrime = 0x100000001b3ULL;
+
+// Paths longer than this are not valid, so an entry recording one is
+// corrupt.
+static constexpr uint32_t kMaxPathLength = 64 * KB;
+
+struct DependencyInfo {
+  int64_t size;
+  int64_t mtime;
+  uint64_t hash;
+};
+
+KernelCache::KernelCache(const char* directory,
+                         int64_t max_size,
+                         bool verify_contents)
+    : directory_(Utils::StrDup(directory)),
+      max_size_(max_size),
+      verify_contents_(verify_contents) {}
+
+KernelCache::~KernelCache() {
+  free(directory_);
+}
+
+uint64_t KernelCache::Hash(const void* data, intptr_t length, uint64_t hash) {
+  const uint8_t* bytes = reinterpret_cast<const uint8_t*>(data);
+  for (intptr_t i = 0; i < length; i++) {
+    hash ^= bytes[i];
+    hash *= kHashPrime;
+  }
+  return hash;
+}
+
+static uint64_t HashCString(const char* str, uint64_t hash) {
+  if (str == nullptr) {
+    const uint8_t kNull = 0xff;
+    return KernelCache::Hash(&kNull, 1, hash);
+  }
+  // Include the terminator so that consecutive strings cannot run together.
+  return KernelCache::Hash(str, strlen(str) + 1, hash);
+}
+
+// Hashes the contents of the file at [path]. Returns false if it cannot be
+// read.
+static bool HashFile(const char* path, uint64_t* hash) {
+  File* file = File::Open(nullptr, path, File::kRead);
+  if (file == nullptr) {
+    return false;
+  }
+  RefCntReleaseScope<File> rs(file);
+  uint8_t buffer[16 * KB];
+  uint64_t result = KernelCache::kHashSeed;
+  int64_t remaining = file->Length();
+  while (remaining > 0) {
+    const int64_t chunk =
+        Utils::Minimum<int64_t>(remaining, static_cast<int64_t>(KB * 16));
+    if (!file->ReadFully(buffer, chunk)) {
+      return false;
+    }
+    result = KernelCache::Hash(buffer, chunk, result);
+    remaining -= chunk;
+  }
+  *hash = result;
+  return true;
+}
+
+int64_t KernelCache::CurrentTimeMillis() {
+  return static_cast<int64_t>(time(nullptr)) * 1000;
+}
+
+void KernelCache::AddFlags(const char** flags, intptr_t count) {
+  for (intptr_t i = 0; i < count; i++) {
+    flags_hash_ = HashCString(flags[i], flags_hash_);
+  }
+}
+
+uint64_t KernelCache::KeyFor(const char* script_uri,
+                             const char* package_config,
+                             bool snapshot) const {
+  uint64_t hash = HashCString(Dart_VersionString(), flags_hash_);
+  hash = HashCString(script_uri, hash);
+  hash = HashCString(package_config, hash);
+  // Relative paths in the script URI and the package config are resolved
+  // against the working directory.
+  char* cwd = Directory::CurrentNoScope();
+  hash = HashCString(cwd, hash);
+  free(cwd);
+  const uint8_t snapshot_byte = snapshot ? 1 : 0;
+  return Hash(&snapshot_byte, 1, hash);
+}
+
+char* KernelCache::EntryPath(uint64_t key) const {
+  return Utils::SCreate("%s%s%016" Px64 "%s", directory_, File::PathSeparator(),
+                        key, kEntrySuffix);
+}
+
+// Returns true if the file at [path] still matches [recorded].
+static bool IsUnchanged(const char* path,
+                        const DependencyInfo& recorded,
+                        bool verify_contents) {
+  int64_t stat[File::kStatSize];
+  File::Stat(nullptr, path, stat);
+  if ((stat[File::kType] != File::kIsFile) ||
+      (stat[File::kSize] != recorded.size)) {
+    return false;
+  }
+  if (!verify_contents && (stat[File::kModifiedTime] == recorded.mtime)) {
+    return true;
+  }
+  uint64_t hash;
+  return HashFile(path, &hash) && (hash == recorded.hash);
+}
+
+static bool ReadEntry(File* file,
+                      bool verify_contents,
+                      uint8_t** kernel_buffer,
+                      intptr_t* kernel_buffer_size) {
+  uint32_t header[2];
+  if (!file->ReadFully(header, sizeof(header)) || (header[0] != kEntryMagic)) {
+    return false;
+  }
+  for (uint32_t i = 0; i < header[1]; i++) {
+    uint32_t path_length;
+    if (!file->ReadFully(&path_length, sizeof(path_length)) ||
+        (path_length > kMaxPathLength)) {
+      return false;
+    }
+    std::unique_ptr<char[]> path(new char[path_length + 1]);
+    DependencyInfo recorded;
+    if (!file->ReadFully(path.get(), path_length) ||
+        !file->ReadFully(&recorded, sizeof(recorded))) {
+      return false;
+    }
+    path[path_length] = '\0';
+    if (!IsUnchanged(path.get(), recorded, verify_contents)) {
+      return false;
+    }
+  }
+  int64_t size;
+  if (!file->ReadFully(&size, sizeof(size)) || (size <= 0) ||
+      (size > file->Length() - file->Position())) {
+    return false;
+  }
+  uint8_t* buffer = reinterpret_cast<uint8_t*>(malloc(size));
+  if ((buffer == nullptr) || !file->ReadFully(buffer, size)) {
+    free(buffer);
+    return false;
+  }
+  *kernel_buffer = buffer;
+  *kernel_buffer_size = size;
+  return true;
+}
+
+bool KernelCache::Lookup(uint64_t key,
+                         uint8_t** kernel_buffer,
+                         intptr_t* kernel_buffer_size) {
+  *kernel_buffer = nullptr;
+  *kernel_buffer_size = -1;
+  char* path = EntryPath(key);
+  File* file = File::Open(nullptr, path, File::kRead);
+  bool found = false;
+  if (file != nullptr) {
+    found = ReadEntry(file, verify_contents_, kernel_buffer,
+                      kernel_buffer_size);
+    file->Release();
+  }
+  if (found) {
+    // Trim evicts the entries that were used least recently first.
+    File::SetLastModified(nullptr, path, CurrentTimeMillis());
+  }
+  free(path);
+  return found;
+}
+
+// Splits the escaped, space separated [dependencies] into malloced paths.
+static void ParseDependencies(const char* dependencies,
+                              intptr_t length,
+                              MallocGrowableArray<char*>* paths) {
+  char* path = reinterpret_cast<char*>(malloc(length + 1));
+  intptr_t path_length = 0;
+  for (intptr_t i = 0; i <= length; i++) {
+    if ((i == length) || (dependencies[i] == ' ')) {
+      if (path_length > 0) {
+        path[path_length] = '\0';
+        paths->Add(Utils::StrDup(path));
+        path_length = 0;
+      }
+      continue;
+    }
+    if ((dependencies[i] == '\\') && (i + 1 < length)) {
+      i++;
+    }
+    path[path_length++] = dependencies[i];
+  }
+  free(path);
+}
+
+static bool WriteEntry(File* file,
+                       const MallocGrowableArray<char*>& paths,
+                       int64_t compile_start,
+                       const uint8_t* kernel_buffer,
+                       intptr_t kernel_buffer_size) {
+  const uint32_t header[2] = {kEntryMagic,
+                              static_cast<uint32_t>(paths.length())};
+  if (!file->WriteFully(header, sizeof(header))) {
+    return false;
+  }
+  for (intptr_t i = 0; i < paths.length(); i++) {
+    const char* path = paths[i];
+    int64_t stat[File::kStatSize];
+    File::Stat(nullptr, path, stat);
+    // A file modified while it was being compiled may not match the kernel,
+    // so the entry could never be validated.
+    if ((stat[File::kType] != File::kIsFile) ||
+        (stat[File::kModifiedTime] >= compile_start)) {
+      return false;
+    }
+    DependencyInfo info = {stat[File::kSize], stat[File::kModifiedTime], 0};
+    const uint32_t path_length = strlen(path);
+    if (!HashFile(path, &info.hash) ||
+        !file->WriteFully(&path_length, sizeof(path_length)) ||
+        !file->WriteFully(path, path_length) ||
+        !file->WriteFully(&info, sizeof(info))) {
+      return false;
+    }
+  }
+  const int64_t size = kernel_buffer_size;
+  return file->WriteFully(&size, sizeof(size)) &&
+         file->WriteFully(kernel_buffer, kernel_buffer_size);
+}
+
+bool KernelCache::Store(uint64_t key,
+                        int64_t compile_start,
+                        const uint8_t* kernel_buffer,
+                        intptr_t kernel_buffer_size,
+                        const char* dependencies,
+                        intptr_t dependencies_length) {
+  MallocGrowableArray<char*> paths;
+  ParseDependencies(dependencies, dependencies_length, &paths);
+  bool success = !paths.is_empty();
+  if (success &&
+      (Directory::Exists(nullptr, directory_) != Directory::EXISTS)) {
+    success = Directory::Create(nullptr, directory_);
+  }
+
+  char* path = EntryPath(key);
+  // Write to a file private to this process and rename it into place, so
+  // that concurrent lookups never see a partial entry.
+  char* temp_path =
+      Utils::SCreate("%s.%" Pd, path, Process::CurrentProcessId());
+  if (success) {
+    File* file = File::Open(nullptr, temp_path, File::kWriteTruncate);
+    success = file != nullptr;
+    if (success) {
+      success = WriteEntry(file, paths, compile_start, kernel_buffer,
+                           kernel_buffer_size);
+      file->Release();
+    }
+    success = success && File::Rename(nullptr, temp_path, path);
+    if (!success) {
+      File::Delete(nullptr, temp_path);
+    }
+  }
+  free(temp_path);
+  free(path);
+  for (intptr_t i = 0; i < paths.length(); i++) {
+    free(paths[i]);
+  }
+
+  if (success) {
+    Trim();
+  }
+  return success;
+}
+
+class KernelCacheListing : public DirectoryListing {
+ public:
+  struct Entry {
+    char* path;
+    int64_t size;
+    int64_t mtime;
+  };
+
+  explicit KernelCacheListing(const char* directory)
+      : DirectoryListing(nullptr, directory, false, false) {}
+
+  virtual ~KernelCacheListing() {
+    for (intptr_t i = 0; i < entries_.length(); i++) {
+      free(entries_[i].path);
+    }
+  }
+
+  virtual bool HandleDirectory(const char* dir_name) { return true; }
+  virtual bool HandleLink(const char* link_name) { return true; }
+  virtual bool HandleError() { return false; }
+
+  virtual bool HandleFile(const char* file_name) {
+    const intptr_t length = strlen(file_name);
+    const intptr_t suffix_length = strlen(kEntrySuffix);
+    if ((length < suffix_length) ||
+        (strcmp(file_name + length - suffix_length, kEntrySuffix) != 0)) {
+      return true;
+    }
+    int64_t stat[File::kStatSize];
+    File::Stat(nullptr, file_name, stat);
+    if (stat[File::kType] == File::kIsFile) {
+      entries_.Add({Utils::StrDup(file_name), stat[File::kSize],
+                    stat[File::kModifiedTime]});
+    }
+    return true;
+  }
+
+  MallocGrowableArray<Entry>* entries() { return &entries_; }
+
+ private:
+  MallocGrowableArray<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(KernelCacheListing);
+};
+
+static int CompareByMtime(const KernelCacheListing::Entry* a,
+                          const KernelCacheListing::Entry* b) {
+  if (a->mtime != b->mtime) {
+    return a->mtime < b->mtime ? -1 : 1;
+  }
+  return strcmp(a->path, b->path);
+}
+
+void KernelCache::Trim() {
+  if (max_size_ <= 0) {
+    return;
+  }
+  char* directory = Utils::SCreate("%s%s", directory_, File::PathSeparator());
+  KernelCacheListing listing(directory);
+  free(directory);
+  Directory::List(&listing);
+
+  MallocGrowableArray<KernelCacheListing::Entry>* entries = listing.entries();
+  int64_t total_size = 0;
+  for (intptr_t i = 0; i < entries->length(); i++) {
+    total_size += entries->At(i).size;
+  }
+  entries->Sort(CompareByMtime);
+  for (intptr_t i = 0; (i < entries->length()) && (total_size > max_size_);
+       i++) {
+    const KernelCacheListing::Entry& entry = entries->At(i);
+    // Another process may have deleted the entry already.
+    File::Delete(nullptr, entry.path);
+    total_size -= entry.size;
+  }
+}
+
+}  // namespace bin
+}  // namespace dart
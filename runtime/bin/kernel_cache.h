@@ -0,0 +1,100 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_BIN_KERNEL_CACHE_H_
+#define RUNTIME_BIN_KERNEL_CACHE_H_
+
+#include "platform/globals.h"
+#include "platform/utils.h"
+
+namespace dart {
+namespace bin {
+
+// An on-disk cache of kernel binaries produced by the kernel service, so that
+// running an unchanged program does not compile it again.
+//
+// Entries are stored as '<key>.dillcache' files in the cache directory, where
+// the key is a hash of the script URI, the package config, the working
+// directory, the SDK version and the VM flags. Each entry records the files
+// the compilation read, with their size, modification time and a hash of
+// their contents:
+//
+//   uint32 magic, uint32 number of dependencies
+//   for each dependency:
+//     uint32 path length, path, int64 size, int64 mtime, uint64 hash
+//   int64 kernel size, kernel
+//
+// An entry is only used if all of its dependencies are unchanged. A file
+// whose size and mtime are unchanged is assumed to be unchanged, unless
+// [verify_contents] is set. A file whose mtime changed is hashed again, so
+// touching a file does not invalidate the entries depending on it.
+//
+// Entries are written to a temporary file and renamed into place, so several
+// processes can share a cache directory. Once the entries exceed [max_size]
+// bytes, the least recently used ones are deleted.
+class KernelCache {
+ public:
+  KernelCache(const char* directory, int64_t max_size, bool verify_contents);
+  ~KernelCache();
+
+  const char* directory() const { return directory_; }
+
+  // Mixes [flags] into the keys of all entries. Used for the VM flags, which
+  // may change how the kernel service compiles a program.
+  void AddFlags(const char** flags, intptr_t count);
+
+  // Returns the key of the entry for compiling [script_uri] with
+  // [package_config].
+  uint64_t KeyFor(const char* script_uri,
+                  const char* package_config,
+                  bool snapshot) const;
+
+  // Returns true and sets [kernel_buffer] to a malloced copy of the kernel
+  // binary cached under [key] if there is a valid entry.
+  bool Lookup(uint64_t key,
+              uint8_t** kernel_buffer,
+              intptr_t* kernel_buffer_size);
+
+  // Caches [kernel_buffer] under [key]. [dependencies] lists the files that
+  // were read to produce it, separated by spaces and escaped as in depfiles.
+  // Nothing is cached if one of them was modified after [compile_start], as
+  // returned by CurrentTimeMillis. Returns false if the entry could not be
+  // written. Must be called in a Dart API scope.
+  bool Store(uint64_t key,
+             int64_t compile_start,
+             const uint8_t* kernel_buffer,
+             intptr_t kernel_buffer_size,
+             const char* dependencies,
+             intptr_t dependencies_length);
+
+  // Deletes the least recently used entries until the remaining ones take at
+  // most [max_size] bytes. Must be called in a Dart API scope.
+  void Trim();
+
+  // Returns the wall clock time in milliseconds, in the resolution used for
+  // compile_start.
+  static int64_t CurrentTimeMillis();
+
+  // FNV-1a hash of [length] bytes at [data], continuing from [hash].
+  static uint64_t Hash(const void* data,
+                       intptr_t length,
+                       uint64_t hash = kHashSeed);
+
+  static constexpr uint64_t kHashSeed = 0xcbf29ce484222325ULL;
+
+ private:
+  char* EntryPath(uint64_t key) const;
+
+  char* directory_;
+  const int64_t max_size_;
+  const bool verify_contents_;
+  uint64_t flags_hash_ = kHashSeed;
+
+  DISALLOW_COPY_AND_ASSIGN(KernelCache);
+};
+
+}  // namespace bin
+}  // namespace dart
+
+#endif  // RUNTIME_BIN_KERNEL_CACHE_H_
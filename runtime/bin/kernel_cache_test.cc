@@ -0,0 +1,156 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "bin/kernel_cache.h"
+#include "bin/directory.h"
+#include "bin/file.h"
+#include "platform/assert.h"
+#include "platform/globals.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+static const char* CreateTempCacheDirectory() {
+  const char* system_temp = bin::Directory::SystemTemp(NULL);
+  EXPECT_NOTNULL(system_temp);
+  const char* prefix = OS::SCreate(Thread::Current()->zone(),
+                                   "%s%skernel_cache_test", system_temp,
+                                   bin::File::PathSeparator());
+  const char* directory = bin::Directory::CreateTemp(NULL, prefix);
+  EXPECT_NOTNULL(directory);
+  return directory;
+}
+
+static const char* WriteSource(const char* directory,
+                               const char* name,
+                               const char* contents,
+                               int64_t mtime) {
+  const char* path = OS::SCreate(Thread::Current()->zone(), "%s%s%s",
+                                 directory, bin::File::PathSeparator(), name);
+  bin::File* file = bin::File::Open(NULL, path, bin::File::kWriteTruncate);
+  EXPECT(file != NULL);
+  EXPECT(file->WriteFully(contents, strlen(contents)));
+  file->Release();
+  EXPECT(bin::File::SetLastModified(NULL, path, mtime));
+  return path;
+}
+
+// Any time after the sources were written.
+static int64_t CompileStart() {
+  return bin::KernelCache::CurrentTimeMillis() + 60 * 1000;
+}
+
+static bool LookupKernel(bin::KernelCache* cache,
+                         uint64_t key,
+                         const char* expected) {
+  uint8_t* kernel = nullptr;
+  intptr_t kernel_size = -1;
+  if (!cache->Lookup(key, &kernel, &kernel_size)) {
+    EXPECT(kernel == nullptr);
+    return false;
+  }
+  EXPECT_EQ(static_cast<intptr_t>(strlen(expected)), kernel_size);
+  EXPECT(memcmp(kernel, expected, kernel_size) == 0);
+  free(kernel);
+  return true;
+}
+
+static void StoreKernel(bin::KernelCache* cache,
+                        uint64_t key,
+                        const char* kernel,
+                        const char* dependencies) {
+  EXPECT(cache->Store(key, CompileStart(),
+                      reinterpret_cast<const uint8_t*>(kernel),
+                      strlen(kernel), dependencies, strlen(dependencies)));
+}
+
+TEST_CASE(KernelCache_LookupValidatesDependencies) {
+  const char* directory = CreateTempCacheDirectory();
+  const int64_t mtime = 1000 * 1000;
+  const char* source = WriteSource(directory, "main.dart", "main() {}", mtime);
+
+  bin::KernelCache cache(directory, 0, false);
+  const uint64_t key = cache.KeyFor("file:///main.dart", nullptr, false);
+  EXPECT(!LookupKernel(&cache, key, "kernel"));
+  StoreKernel(&cache, key, "kernel", source);
+  EXPECT(LookupKernel(&cache, key, "kernel"));
+
+  // Touching a source does not invalidate the entry.
+  WriteSource(directory, "main.dart", "main() {}", mtime + 1000);
+  EXPECT(LookupKernel(&cache, key, "kernel"));
+
+  // Changing it does.
+  WriteSource(directory, "main.dart", "main() {;}", mtime);
+  EXPECT(!LookupKernel(&cache, key, "kernel"));
+
+  // A change that keeps the size and mtime is only noticed when verifying
+  // the contents.
+  StoreKernel(&cache, key, "kernel", source);
+  WriteSource(directory, "main.dart", "main() {} ", mtime);
+  EXPECT(LookupKernel(&cache, key, "kernel"));
+  bin::KernelCache verifying_cache(directory, 0, true);
+  EXPECT(!LookupKernel(&verifying_cache, key, "kernel"));
+
+  // A deleted source invalidates the entry.
+  StoreKernel(&cache, key, "kernel", source);
+  EXPECT(bin::File::Delete(NULL, source));
+  EXPECT(!LookupKernel(&cache, key, "kernel"));
+
+  EXPECT(bin::Directory::Delete(NULL, directory, true));
+}
+
+TEST_CASE(KernelCache_RejectsSourcesModifiedWhileCompiling) {
+  const char* directory = CreateTempCacheDirectory();
+  const int64_t now = bin::KernelCache::CurrentTimeMillis();
+  const char* source = WriteSource(directory, "main.dart", "main() {}", now);
+
+  bin::KernelCache cache(directory, 0, false);
+  const uint64_t key = cache.KeyFor("file:///main.dart", nullptr, false);
+  EXPECT(!cache.Store(key, now, reinterpret_cast<const uint8_t*>("kernel"), 6,
+                      source, strlen(source)));
+  EXPECT(!LookupKernel(&cache, key, "kernel"));
+
+  EXPECT(bin::Directory::Delete(NULL, directory, true));
+}
+
+TEST_CASE(KernelCache_KeyIncludesFlags) {
+  bin::KernelCache cache("unused", 0, false);
+  const uint64_t key = cache.KeyFor("file:///main.dart", nullptr, false);
+  EXPECT_EQ(key, cache.KeyFor("file:///main.dart", nullptr, false));
+  EXPECT_NE(key, cache.KeyFor("file:///main.dart", "package_config.json",
+                              false));
+  EXPECT_NE(key, cache.KeyFor("file:///main.dart", nullptr, true));
+  EXPECT_NE(key, cache.KeyFor("file:///other.dart", nullptr, false));
+
+  const char* flags[] = {"--enable-asserts"};
+  cache.AddFlags(flags, 1);
+  EXPECT_NE(key, cache.KeyFor("file:///main.dart", nullptr, false));
+}
+
+TEST_CASE(KernelCache_TrimEvictsLeastRecentlyUsed) {
+  const char* directory = CreateTempCacheDirectory();
+  const char* source =
+      WriteSource(directory, "main.dart", "main() {}", 1000 * 1000);
+  // Room for two entries.
+  const intptr_t entry_size = 8 + 4 + strlen(source) + 24 + 8 + 6;
+  bin::KernelCache cache(directory, 2 * entry_size, false);
+
+  StoreKernel(&cache, 1, "kernel", source);
+  StoreKernel(&cache, 2, "kernel", source);
+  // Make entry 1 the least recently used one, regardless of the resolution
+  // of the file system's timestamps.
+  const char* entry1 = OS::SCreate(Thread::Current()->zone(),
+                                   "%s%s%016" Px64 ".dillcache", directory,
+                                   bin::File::PathSeparator(), uint64_t{1});
+  EXPECT(bin::File::SetLastModified(NULL, entry1, 1000 * 1000));
+  StoreKernel(&cache, 3, "kernel", source);
+
+  EXPECT(!LookupKernel(&cache, 1, "kernel"));
+  EXPECT(LookupKernel(&cache, 2, "kernel"));
+  EXPECT(LookupKernel(&cache, 3, "kernel"));
+
+  EXPECT(bin::Directory::Delete(NULL, directory, true));
+}
+
+}  // namespace dart
@@ -129,7 +129,12 @@ Dart_Handle Loader::DeferredLoadHandler(intptr_t loading_unit_id) {
   char* unit_url = Utils::SCreate(
       "%s-%" Pd ".part.so", isolate_group_data->script_url, loading_unit_id);
 
-  AppSnapshot* loading_unit_snapshot = Snapshot::TryReadAppSnapshot(unit_url);
+  // With --prefetch-deferred-units, the unit has likely been read already.
+  AppSnapshot* loading_unit_snapshot =
+      isolate_group_data->TakePrefetchedLoadingUnit(loading_unit_id);
+  if (loading_unit_snapshot == nullptr) {
+    loading_unit_snapshot = Snapshot::TryReadAppSnapshot(unit_url);
+  }
   Dart_Handle result;
   if (loading_unit_snapshot != nullptr) {
     isolate_group_data->AddLoadingUnit(loading_unit_snapshot);
@@ -770,6 +770,11 @@ static Dart_Isolate CreateIsolateGroupAndSetupHelper(
 
   auto isolate_group_data = new IsolateGroupData(
       script_uri, packages_config, app_snapshot, isolate_run_app_snapshot);
+#if defined(DART_PRECOMPILED_RUNTIME)
+  if (is_main_isolate && Options::prefetch_deferred_units()) {
+    isolate_group_data->StartPrefetchingLoadingUnits();
+  }
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
   if (kernel_buffer != NULL) {
     if (kernel_buffer_ptr) {
       isolate_group_data->SetKernelBufferAlreadyOwned(
@@ -1309,6 +1314,17 @@ void main(int argc, char** argv) {
   // Load vm_platform_strong.dill for dart:* source support.
   dfe.Init();
   dfe.set_verbosity(Options::verbosity_level());
+  // Snapshots and depfiles are produced from the state of the kernel
+  // service, which does not see programs read from the cache.
+  if ((Options::kernel_cache_directory() != nullptr) &&
+      (Options::gen_snapshot_kind() == kNone) &&
+      (Options::depfile() == nullptr)) {
+    KernelCache* kernel_cache = new KernelCache(
+        Options::kernel_cache_directory(), Options::kernel_cache_max_size(),
+        Options::kernel_cache_verify_sources());
+    kernel_cache->AddFlags(vm_options.arguments(), vm_options.count());
+    dfe.set_kernel_cache(kernel_cache);
+  }
   if (script_name != nullptr) {
     uint8_t* application_kernel_buffer = NULL;
     intptr_t application_kernel_buffer_size = 0;
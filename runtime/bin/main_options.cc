@@ -43,6 +43,7 @@ static const char* const kVerbosityLevelNames[] = {
 SnapshotKind Options::gen_snapshot_kind_ = kNone;
 VerbosityLevel Options::verbosity_ = kAll;
 bool Options::enable_vm_service_ = false;
+int64_t Options::kernel_cache_max_size_ = 512 * MB;
 
 #define OPTION_FIELD(variable) Options::variable##_
 
@@ -235,6 +236,24 @@ void Options::PrintUsage() {
 "--root-certs-cache=<path>\n"
 "  The path to a cache directory containing the trusted root certificates to\n"
 "  use for secure socket connections.\n"
+#if !defined(DART_PRECOMPILED_RUNTIME)
+"--kernel-cache=<path>\n"
+"  The path to a directory in which to cache the kernel compiled for\n"
+"  scripts, which is reused while the scripts and the files they import\n"
+"  do not change. Not used when generating snapshots or depfiles, or with\n"
+"  the VM service enabled.\n"
+"--kernel-cache-size=<megabytes>\n"
+"  The size above which the least recently used kernel cache entries are\n"
+"  deleted (default 512, 0 for no limit).\n"
+"--kernel-cache-verify-sources\n"
+"  Hash the sources of a cached kernel to validate it, instead of trusting\n"
+"  their size and modification time.\n"
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
+#if defined(DART_PRECOMPILED_RUNTIME)
+"--prefetch-deferred-units\n"
+"  Read the deferred loading units of the AOT snapshot on a helper thread at\n"
+"  startup, so that loading a deferred library does not wait for I/O.\n"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
 #if defined(DART_HOST_OS_LINUX) || \
     defined(DART_HOST_OS_ANDROID) || \
     defined(DART_HOST_OS_FUCHSIA)
@@ -687,6 +706,17 @@ bool Options::ParseArguments(int argc,
     snapshot_deps_filename_ = NULL;
   }
 
+  if (kernel_cache_size_ != NULL) {
+    char* end = nullptr;
+    const int64_t megabytes = strtoll(kernel_cache_size_, &end, 10);
+    if ((*end != '\0') || (megabytes < 0)) {
+      Syslog::PrintErr("Invalid value for --kernel-cache-size: '%s'\n",
+                       kernel_cache_size_);
+      return false;
+    }
+    kernel_cache_max_size_ = megabytes * MB;
+  }
+
   if ((packages_file_ != NULL) && (strlen(packages_file_) == 0)) {
     Syslog::PrintErr("Empty package file name specified.\n");
     return false;
@@ -26,7 +26,9 @@ namespace bin {
   V(root_certs_file, root_certs_file)                                          \
   V(root_certs_cache, root_certs_cache)                                        \
   V(namespace, namespc)                                                        \
-  V(write_service_info, vm_write_service_info_filename)
+  V(write_service_info, vm_write_service_info_filename)                        \
+  V(kernel_cache, kernel_cache_directory)                                      \
+  V(kernel_cache_size, kernel_cache_size)
 
 // As STRING_OPTIONS_LIST but for boolean valued options. The default value is
 // always false, and the presence of the flag switches the value to true.
@@ -48,7 +50,9 @@ namespace bin {
   V(long_ssl_cert_evaluation, long_ssl_cert_evaluation)                        \
   V(bypass_trusting_system_roots, bypass_trusting_system_roots)                \
   V(delayed_filewatch_callback, delayed_filewatch_callback)                    \
-  V(mark_main_isolate_as_system_isolate, mark_main_isolate_as_system_isolate)
+  V(mark_main_isolate_as_system_isolate, mark_main_isolate_as_system_isolate) \
+  V(kernel_cache_verify_sources, kernel_cache_verify_sources)                  \
+  V(prefetch_deferred_units, prefetch_deferred_units)
 
 // Boolean flags that have a short form.
 #define SHORT_BOOL_OPTIONS_LIST(V)                                             \
@@ -142,6 +146,10 @@ class Options {
   static const char* vm_service_server_ip() { return vm_service_server_ip_; }
   static int vm_service_server_port() { return vm_service_server_port_; }
 
+  // The size in bytes above which the kernel cache deletes entries, or 0
+  // if it is unlimited.
+  static int64_t kernel_cache_max_size() { return kernel_cache_max_size_; }
+
   static Dart_KernelCompilationVerbosityLevel verbosity_level() {
     return VerbosityLevelToDartAPI(verbosity_);
   }
@@ -203,6 +211,8 @@ class Options {
   static const char* vm_service_server_ip_;
   static bool enable_vm_service_;
   static int vm_service_server_port_;
+  static int64_t kernel_cache_max_size_;
+
   static bool ExtractPortAndAddress(const char* option_value,
                                     int* out_port,
                                     const char** out_ip,
@@ -75,6 +75,11 @@ void Benchmark::RunBenchmark() {
     this->Run();
     Syslog::Print("%s(%s): %" Pd64 "\n", this->name(), this->score_kind(),
                   this->score());
+    for (intptr_t i = 0; i < this->num_extra_scores(); i++) {
+      Syslog::Print("%s.%s(%s): %" Pd64 "\n", this->name(),
+                    this->extra_score_suffix(i), this->extra_score_kind(i),
+                    this->extra_score(i));
+    }
     run_matches++;
   } else if (run_filter == kList) {
     Syslog::Print("%s Pass\n", this->name());
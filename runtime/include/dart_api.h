@@ -3381,6 +3381,27 @@ Dart_DeferredLoadCompleteError(intptr_t loading_unit_id,
                                const char* error_message,
                                bool transient);
 
+/**
+ * Loads a deferred loading unit before the program requests it, so that a
+ * later `prefix.loadLibrary()` completes without invoking the
+ * Dart_DeferredLoadHandler. Embedders can call this when the isolate is idle,
+ * e.g. after startup, for the units the program is likely to need.
+ *
+ * The snapshot is deserialized before this function returns. If the program
+ * is already waiting for the unit, its load completes as with
+ * Dart_DeferredLoadComplete. Prefetching a unit that is already loaded has
+ * no effect. The parent of the unit must be loaded.
+ *
+ * The latency of every deferred load, from the request to its completion, is
+ * recorded as a "DeferredLoad" event on the Isolate timeline stream.
+ *
+ * Requires a current isolate.
+ */
+DART_EXPORT DART_WARN_UNUSED_RESULT Dart_Handle
+Dart_PrefetchLoadingUnit(intptr_t loading_unit_id,
+                         const uint8_t* snapshot_data,
+                         const uint8_t* snapshot_instructions);
+
 /**
  * Canonicalizes a url with respect to some library.
  *
@@ -143,6 +143,11 @@ DART_EXPORT bool Dart_PostInteger(Dart_Port port_id, int64_t message);
  * lifetime of the message data is controlled by the caller. All the
  * data references from the message are allocated by the caller and
  * will be reclaimed when returning to it.
+ *
+ * The exception are Dart_CObject_kExternalTypedData objects in messages
+ * received on ports created with Dart_NewNativePortReceivingExternalTypedData,
+ * see there. The handler owns their data and has to eventually release it by
+ * invoking the callback with the peer.
  */
 typedef void (*Dart_NativeMessageHandler)(Dart_Port dest_port_id,
                                           Dart_CObject* message);
@@ -165,6 +170,21 @@ DART_EXPORT Dart_Port Dart_NewNativePort(const char* name,
                                          bool handle_concurrently);
 /* TODO(turnidge): Currently handle_concurrently is ignored. */
 
+/**
+ * Creates a new native port like Dart_NewNativePort, except that typed data
+ * of at least --out-of-line-typed-data-threshold bytes sent to the port from
+ * Dart is copied into its own buffer instead of the message, and delivered
+ * to the handler as Dart_CObject_kExternalTypedData. The handler owns the
+ * buffer, so it can keep the data without copying it.
+ *
+ * Typed data sent to ports created with Dart_NewNativePort is always
+ * delivered as Dart_CObject_kTypedData.
+ */
+DART_EXPORT Dart_Port
+Dart_NewNativePortReceivingExternalTypedData(const char* name,
+                                             Dart_NativeMessageHandler handler,
+                                             bool handle_concurrently);
+
 /**
  * Closes the native port with the given id.
  *
@@ -353,6 +353,8 @@ DART_EXPORT bool Dart_IsReloading();
  *   "API" - Execution of Dart C API functions
  *   "Compiler" - Execution of Dart JIT compiler
  *   "CompilerVerbose" - More detailed Execution of Dart JIT compiler
+ *   "CompilerDecisions" - Inlining and deoptimization decisions of Dart JIT
+ *     compiler
  *   "Dart" - Execution of Dart code
  *   "Debugger" - Execution of Dart debugger
  *   "Embedder" - Execution of Dart embedder code
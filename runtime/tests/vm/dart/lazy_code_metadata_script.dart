@@ -0,0 +1,42 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Used by lazy_code_metadata_test.dart. Throws through code whose
+// PcDescriptors and CodeSourceMap are only read from the snapshot when the
+// exception is handled and the stack trace is symbolized.
+
+@pragma('vm:never-inline')
+void thrower(int depth) {
+  if (depth == 0) throw StateError('boom');
+  thrower(depth - 1);
+}
+
+@pragma('vm:never-inline')
+Future<void> asyncThrower() async {
+  await null;
+  thrower(1);
+}
+
+void expectFrames(StackTrace stackTrace, List<String> names) {
+  final trace = stackTrace.toString();
+  for (final name in names) {
+    if (!trace.contains(name)) throw 'Missing $name in:\n$trace';
+  }
+}
+
+main() async {
+  try {
+    thrower(3);
+  } on StateError catch (_, stackTrace) {
+    expectFrames(stackTrace, <String>['thrower', 'main']);
+  }
+
+  try {
+    await asyncThrower();
+  } on StateError catch (_, stackTrace) {
+    expectFrames(stackTrace, <String>['thrower', 'asyncThrower']);
+  }
+
+  print('SUCCESS');
+}
@@ -0,0 +1,23 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// Used by profile_guided_code_layout_test.dart. Only [hot] runs while
+// training, while [cold] is compiled but never called.
+
+@pragma('vm:never-inline')
+int hot(int i) => i + 1;
+
+@pragma('vm:never-inline')
+int cold(int i) => i * 2;
+
+main(List<String> args) {
+  int x = 0;
+  for (int i = 0; i < 100000; i++) {
+    x = hot(x);
+  }
+  if (args.contains('cold')) {
+    x = cold(x);
+  }
+  print(x);
+}
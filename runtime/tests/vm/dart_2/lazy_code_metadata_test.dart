@@ -0,0 +1,50 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// @dart = 2.9
+
+// Checks that exceptions are handled and stack traces are symbolized in AOT
+// snapshots whose code metadata is read on first use.
+
+import 'dart:io';
+
+import 'package:expect/expect.dart';
+import 'package:path/path.dart' as path;
+
+import 'use_flag_test_helper.dart';
+
+main(List<String> args) async {
+  if (!isAOTRuntime) {
+    return; // Running in JIT: AOT binaries not available.
+  }
+
+  if (Platform.isAndroid) {
+    return; // SDK tree and gen_snapshot not available on the test device.
+  }
+
+  final scriptUrl = path.join(sdkDir, 'runtime', 'tests', 'vm', 'dart_2',
+      'lazy_code_metadata_script.dart');
+
+  await withTempDir('lazy-code-metadata-test', (String tempDir) async {
+    final scriptDill = path.join(tempDir, 'test.dill');
+    await run(genKernel, <String>[
+      '--aot',
+      '--platform=$platformDill',
+      '-o',
+      scriptDill,
+      scriptUrl,
+    ]);
+
+    final snapshotPath = path.join(tempDir, 'aot.snapshot');
+    await run(genSnapshot, <String>[
+      '--snapshot-kind=app-aot-elf',
+      '--elf=$snapshotPath',
+      '--lazy-code-metadata',
+      scriptDill,
+    ]);
+
+    final output = await runOutput(aotRuntime, <String>[snapshotPath]);
+    Expect.listEquals(<String>['SUCCESS'], output);
+  });
+}
@@ -0,0 +1,89 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// @dart = 2.9
+
+// Checks that gen_snapshot lays out the code of functions which ran while
+// collecting the profile given with --read-aot-profile-from before the code
+// of functions which did not run.
+
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:expect/expect.dart';
+import 'package:path/path.dart' as path;
+
+import 'use_flag_test_helper.dart';
+
+main(List<String> args) async {
+  if (!isAOTRuntime) {
+    return; // Running in JIT: AOT binaries not available.
+  }
+
+  if (Platform.isAndroid) {
+    return; // SDK tree and gen_snapshot not available on the test device.
+  }
+
+  final jitRuntime =
+      path.join(buildDir, 'dart' + (Platform.isWindows ? '.exe' : ''));
+  if (!File(jitRuntime).existsSync()) {
+    return; // Training needs the JIT built with gen_snapshot.
+  }
+
+  final scriptUrl = path.join(sdkDir, 'runtime', 'tests', 'vm', 'dart_2',
+      'profile_guided_code_layout_script.dart');
+
+  await withTempDir('profile-guided-code-layout-test', (String tempDir) async {
+    // The profile identifies functions by script and position, so both
+    // kernel files are compiled from the same script.
+    final jitDill = path.join(tempDir, 'jit.dill');
+    await run(genKernel, <String>[
+      '--platform=$platformDill',
+      '-o',
+      jitDill,
+      scriptUrl,
+    ]);
+    final aotDill = path.join(tempDir, 'aot.dill');
+    await run(genKernel, <String>[
+      '--aot',
+      '--platform=$platformDill',
+      '-o',
+      aotDill,
+      scriptUrl,
+    ]);
+
+    final profilePath = path.join(tempDir, 'profile.txt');
+    await run(jitRuntime, <String>[
+      '--write-aot-profile-to=$profilePath',
+      jitDill,
+    ]);
+
+    final sizesPath = path.join(tempDir, 'sizes.json');
+    final snapshotPath = path.join(tempDir, 'aot.snapshot');
+    await run(genSnapshot, <String>[
+      '--snapshot-kind=app-aot-elf',
+      '--elf=$snapshotPath',
+      '--read-aot-profile-from=$profilePath',
+      '--print-instructions-sizes-to=$sizesPath',
+      aotDill,
+    ]);
+
+    // The instructions are listed in the order they are laid out in.
+    final names = <String>[
+      for (final entry in jsonDecode(File(sizesPath).readAsStringSync()))
+        if ((entry['l'] as String)
+                ?.endsWith('profile_guided_code_layout_script.dart') ??
+            false)
+          entry['n'] as String,
+    ];
+    final hotIndex = names.indexOf('hot');
+    final coldIndex = names.indexOf('cold');
+    Expect.notEquals(-1, hotIndex, 'no code for hot in $names');
+    Expect.notEquals(-1, coldIndex, 'no code for cold in $names');
+    Expect.isTrue(hotIndex < coldIndex, 'cold laid out before hot: $names');
+
+    final output = await runOutput(aotRuntime, <String>[snapshotPath, 'cold']);
+    Expect.listEquals(<String>['200000'], output);
+  });
+}
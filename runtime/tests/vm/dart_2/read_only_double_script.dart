@@ -0,0 +1,32 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// @dart = 2.9
+
+// Used by read_only_double_test.dart. The constant below is a canonical
+// double in the snapshot, which AOT snapshots map from their read-only data.
+
+import 'dart:isolate';
+
+const double kValue = 3.14159;
+const List<double> kValues = <double>[kValue, -0.5];
+
+int hashes() => identityHashCode(kValue) ^ identityHashCode(kValues[1]);
+
+void child(SendPort port) {
+  port.send(<Object>[hashes(), identical(kValues[0], kValue)]);
+}
+
+main() async {
+  final hash = hashes();
+  if (hash != hashes()) throw 'Unstable identity hash';
+
+  final port = ReceivePort();
+  await Isolate.spawn(child, port.sendPort);
+  final result = await port.first as List<Object>;
+  if (result[0] != hash) throw 'Identity hash differs between isolates';
+  if (result[1] != true) throw 'Constant is not canonical in child isolate';
+
+  print('SUCCESS');
+}
@@ -0,0 +1,63 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+// @dart = 2.9
+
+// Checks that canonical doubles of AOT snapshots are written to the
+// read-only data image, and that isolates can hash them without writing to
+// their headers.
+
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:expect/expect.dart';
+import 'package:path/path.dart' as path;
+import 'package:vm_snapshot_analysis/v8_profile.dart';
+
+import 'use_flag_test_helper.dart';
+
+main(List<String> args) async {
+  if (!isAOTRuntime) {
+    return; // Running in JIT: AOT binaries not available.
+  }
+
+  if (Platform.isAndroid) {
+    return; // SDK tree and gen_snapshot not available on the test device.
+  }
+
+  final scriptUrl = path.join(sdkDir, 'runtime', 'tests', 'vm', 'dart_2',
+      'read_only_double_script.dart');
+
+  await withTempDir('read-only-double-test', (String tempDir) async {
+    final scriptDill = path.join(tempDir, 'test.dill');
+    await run(genKernel, <String>[
+      '--aot',
+      '--platform=$platformDill',
+      '-o',
+      scriptDill,
+      scriptUrl,
+    ]);
+
+    final profilePath = path.join(tempDir, 'profile.heapsnapshot');
+    final snapshotPath = path.join(tempDir, 'aot.snapshot');
+    await run(genSnapshot, <String>[
+      '--snapshot-kind=app-aot-elf',
+      '--elf=$snapshotPath',
+      '--write-v8-snapshot-profile-to=$profilePath',
+      scriptDill,
+    ]);
+
+    final profile = Snapshot.fromJson(
+        jsonDecode(File(profilePath).readAsStringSync()));
+    final types = profile.nodes.map((n) => n.type).toSet();
+    // Targets with compressed pointers have no read-only data objects.
+    if (types.contains('OneByteStringCid')) {
+      Expect.isTrue(types.contains('CanonicalDouble'),
+          'no canonical doubles in the read-only data image');
+    }
+
+    final output = await runOutput(aotRuntime, <String>[snapshotPath]);
+    Expect.listEquals(<String>['SUCCESS'], output);
+  });
+}
@@ -22,12 +22,16 @@
 #include "vm/growable_array.h"
 #include "vm/heap/heap.h"
 #include "vm/image_snapshot.h"
+#include "vm/lazy_code_metadata.h"
 #include "vm/native_entry.h"
 #include "vm/object.h"
 #include "vm/object_store.h"
 #include "vm/program_visitor.h"
+#include "vm/snapshot_compression.h"
 #include "vm/stub_code.h"
 #include "vm/symbols.h"
+#include "vm/thread_barrier.h"
+#include "vm/thread_pool.h"
 #include "vm/timeline.h"
 #include "vm/v8_snapshot_writer.h"
 #include "vm/version.h"
@@ -46,6 +50,7 @@ DEFINE_FLAG(bool,
             print_cluster_information,
             false,
             "Print information about clusters written to snapshot");
+DECLARE_FLAG(bool, compress_snapshot_data);
 #endif
 
 #if defined(DART_PRECOMPILER)
@@ -53,6 +58,11 @@ DEFINE_FLAG(charp,
             write_v8_snapshot_profile_to,
             NULL,
             "Write a snapshot profile in V8 format to a file.");
+DEFINE_FLAG(bool,
+            lazy_code_metadata,
+            false,
+            "Leave the PcDescriptors and CodeSourceMaps of AOT snapshots in "
+            "the snapshot until they are first used.");
 #endif  // defined(DART_PRECOMPILER)
 
 namespace {
@@ -1958,6 +1968,7 @@ class CodeSerializationCluster : public SerializationCluster {
     CodePtr code;
     intptr_t not_discarded;  // 1 if this code was not discarded and
                              // 0 otherwise.
+    intptr_t usage_counter;
     intptr_t instructions_id;
   };
 
@@ -1972,10 +1983,21 @@ class CodeSerializationCluster : public SerializationCluster {
   // there is no way to identify which specific Code object (out of those
   // which point to the specific instructions range) actually corresponds
   // to a particular frame.
+  //
+  // Within both groups, code whose owner has a higher usage counter is
+  // placed closer to the boundary between them, so that hot code is
+  // contiguous in the middle of the code section and cold code is at its
+  // ends. Usage counters are only set in AOT mode when the precompiler was
+  // given a profile, and are 0 otherwise. The profile does not record when
+  // functions first ran, so code run during startup is not placed first.
   static int CompareCodeOrderInfo(CodeOrderInfo const* a,
                                   CodeOrderInfo const* b) {
     if (a->not_discarded < b->not_discarded) return -1;
     if (a->not_discarded > b->not_discarded) return 1;
+    if (a->usage_counter != b->usage_counter) {
+      const bool hot_last = a->not_discarded == 0;
+      return ((a->usage_counter < b->usage_counter) == hot_last) ? -1 : 1;
+    }
     if (a->instructions_id < b->instructions_id) return -1;
     if (a->instructions_id > b->instructions_id) return 1;
     return 0;
@@ -2002,9 +2024,26 @@ class CodeSerializationCluster : public SerializationCluster {
     info.code = code;
     info.instructions_id = instructions_id;
     info.not_discarded = Code::IsDiscarded(code) ? 0 : 1;
+    info.usage_counter = UsageCounterOf(code);
     order_list->Add(info);
   }
 
+  // Code objects sharing instructions must stay adjacent, which is only
+  // guaranteed in the precompiled mode where they are merged.
+  static intptr_t UsageCounterOf(CodePtr code) {
+#if defined(DART_PRECOMPILER)
+    if (FLAG_precompiled_mode) {
+      const ObjectPtr owner =
+          WeakSerializationReference::Unwrap(code->untag()->owner_);
+      if (owner->IsFunction()) {
+        return Utils::Maximum<intptr_t>(
+            0, Function::Handle(Function::RawCast(owner)).usage_counter());
+      }
+    }
+#endif
+    return 0;
+  }
+
   static void Sort(Serializer* s, GrowableArray<CodePtr>* codes) {
     GrowableArray<CodeOrderInfo> order_list;
     IntMap<intptr_t> order_map;
@@ -2654,8 +2693,9 @@ class WeakSerializationReferenceSerializationCluster
 #if !defined(DART_PRECOMPILED_RUNTIME)
 class PcDescriptorsSerializationCluster : public SerializationCluster {
  public:
-  PcDescriptorsSerializationCluster()
-      : SerializationCluster("PcDescriptors", kPcDescriptorsCid) {}
+  explicit PcDescriptorsSerializationCluster(bool is_lazy)
+      : SerializationCluster("PcDescriptors", kPcDescriptorsCid),
+        is_lazy_(is_lazy) {}
   ~PcDescriptorsSerializationCluster() {}
 
   void Trace(Serializer* s, ObjectPtr object) {
@@ -2664,6 +2704,7 @@ class PcDescriptorsSerializationCluster : public SerializationCluster {
   }
 
   void WriteAlloc(Serializer* s) {
+    s->Write<bool>(is_lazy_);
     const intptr_t count = objects_.length();
     s->WriteUnsigned(count);
     for (intptr_t i = 0; i < count; i++) {
@@ -2672,8 +2713,10 @@ class PcDescriptorsSerializationCluster : public SerializationCluster {
       AutoTraceObject(desc);
       const intptr_t length = desc->untag()->length_;
       s->WriteUnsigned(length);
-      target_memory_size_ +=
-          compiler::target::PcDescriptors::InstanceSize(length);
+      if (!is_lazy_) {
+        target_memory_size_ +=
+            compiler::target::PcDescriptors::InstanceSize(length);
+      }
     }
   }
 
@@ -2690,10 +2733,37 @@ class PcDescriptorsSerializationCluster : public SerializationCluster {
   }
 
  private:
+  const bool is_lazy_;
   GrowableArray<PcDescriptorsPtr> objects_;
 };
 #endif  // !DART_PRECOMPILED_RUNTIME
 
+// Lazy PcDescriptors and CodeSourceMaps are not allocated. Their refs are
+// Smis indexing the isolate group's LazyCodeMetadata, which records where
+// their contents are in the fill section. The Code objects referring to them
+// allocate them on first use.
+static void ReadAllocLazyCodeMetadata(Deserializer* d, intptr_t count) {
+  const intptr_t first_entry =
+      d->isolate_group()->lazy_code_metadata()->Reserve(count);
+  for (intptr_t i = 0; i < count; i++) {
+    d->ReadUnsigned();  // Length.
+    d->AssignRef(Smi::New(first_entry + i));
+  }
+}
+
+static void ReadFillLazyCodeMetadata(Deserializer* d,
+                                     intptr_t start_index,
+                                     intptr_t stop_index) {
+  LazyCodeMetadata* metadata = d->isolate_group()->lazy_code_metadata();
+  MutexLocker ml(metadata->mutex());
+  for (intptr_t id = start_index; id < stop_index; id++) {
+    const intptr_t length = d->ReadUnsigned();
+    metadata->SetLocked(Smi::Value(static_cast<SmiPtr>(d->Ref(id))),
+                        d->CurrentBufferAddress(), length);
+    d->Advance(length);
+  }
+}
+
 class PcDescriptorsDeserializationCluster : public DeserializationCluster {
  public:
   PcDescriptorsDeserializationCluster()
@@ -2703,7 +2773,13 @@ class PcDescriptorsDeserializationCluster : public DeserializationCluster {
   void ReadAlloc(Deserializer* d) {
     start_index_ = d->next_index();
     PageSpace* old_space = d->heap()->old_space();
+    is_lazy_ = d->Read<bool>();
     const intptr_t count = d->ReadUnsigned();
+    if (is_lazy_) {
+      ReadAllocLazyCodeMetadata(d, count);
+      stop_index_ = d->next_index();
+      return;
+    }
     for (intptr_t i = 0; i < count; i++) {
       const intptr_t length = d->ReadUnsigned();
       d->AssignRef(
@@ -2712,8 +2788,14 @@ class PcDescriptorsDeserializationCluster : public DeserializationCluster {
     stop_index_ = d->next_index();
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     ASSERT(!is_canonical());  // Never canonical.
+    if (is_lazy_) {
+      ReadFillLazyCodeMetadata(d, start_index_, stop_index_);
+      return;
+    }
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       const intptr_t length = d->ReadUnsigned();
       PcDescriptorsPtr desc = static_cast<PcDescriptorsPtr>(d->Ref(id));
@@ -2724,13 +2806,17 @@ class PcDescriptorsDeserializationCluster : public DeserializationCluster {
       d->ReadBytes(cdata, length);
     }
   }
+
+ private:
+  bool is_lazy_ = false;
 };
 
 #if !defined(DART_PRECOMPILED_RUNTIME)
 class CodeSourceMapSerializationCluster : public SerializationCluster {
  public:
-  CodeSourceMapSerializationCluster()
-      : SerializationCluster("CodeSourceMap", kCodeSourceMapCid) {}
+  explicit CodeSourceMapSerializationCluster(bool is_lazy)
+      : SerializationCluster("CodeSourceMap", kCodeSourceMapCid),
+        is_lazy_(is_lazy) {}
   ~CodeSourceMapSerializationCluster() {}
 
   void Trace(Serializer* s, ObjectPtr object) {
@@ -2739,6 +2825,7 @@ class CodeSourceMapSerializationCluster : public SerializationCluster {
   }
 
   void WriteAlloc(Serializer* s) {
+    s->Write<bool>(is_lazy_);
     const intptr_t count = objects_.length();
     s->WriteUnsigned(count);
     for (intptr_t i = 0; i < count; i++) {
@@ -2747,8 +2834,10 @@ class CodeSourceMapSerializationCluster : public SerializationCluster {
       AutoTraceObject(map);
       const intptr_t length = map->untag()->length_;
       s->WriteUnsigned(length);
-      target_memory_size_ +=
-          compiler::target::PcDescriptors::InstanceSize(length);
+      if (!is_lazy_) {
+        target_memory_size_ +=
+            compiler::target::PcDescriptors::InstanceSize(length);
+      }
     }
   }
 
@@ -2765,6 +2854,7 @@ class CodeSourceMapSerializationCluster : public SerializationCluster {
   }
 
  private:
+  const bool is_lazy_;
   GrowableArray<CodeSourceMapPtr> objects_;
 };
 #endif  // !DART_PRECOMPILED_RUNTIME
@@ -2778,7 +2868,13 @@ class CodeSourceMapDeserializationCluster : public DeserializationCluster {
   void ReadAlloc(Deserializer* d) {
     start_index_ = d->next_index();
     PageSpace* old_space = d->heap()->old_space();
+    is_lazy_ = d->Read<bool>();
     const intptr_t count = d->ReadUnsigned();
+    if (is_lazy_) {
+      ReadAllocLazyCodeMetadata(d, count);
+      stop_index_ = d->next_index();
+      return;
+    }
     for (intptr_t i = 0; i < count; i++) {
       const intptr_t length = d->ReadUnsigned();
       d->AssignRef(
@@ -2787,7 +2883,13 @@ class CodeSourceMapDeserializationCluster : public DeserializationCluster {
     stop_index_ = d->next_index();
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
+    if (is_lazy_) {
+      ReadFillLazyCodeMetadata(d, start_index_, stop_index_);
+      return;
+    }
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       const intptr_t length = d->ReadUnsigned();
       CodeSourceMapPtr map = static_cast<CodeSourceMapPtr>(d->Ref(id));
@@ -2798,6 +2900,9 @@ class CodeSourceMapDeserializationCluster : public DeserializationCluster {
       d->ReadBytes(cdata, length);
     }
   }
+
+ private:
+  bool is_lazy_ = false;
 };
 
 #if !defined(DART_PRECOMPILED_RUNTIME)
@@ -2865,6 +2970,8 @@ class CompressedStackMapsDeserializationCluster
     stop_index_ = d->next_index();
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       const intptr_t flags_and_size = d->ReadUnsigned();
@@ -2883,7 +2990,7 @@ class CompressedStackMapsDeserializationCluster
 };
 
 #if !defined(DART_PRECOMPILED_RUNTIME) && !defined(DART_COMPRESSED_POINTERS)
-// PcDescriptor, CompressedStackMaps, OneByteString, TwoByteString
+// PcDescriptor, CompressedStackMaps, OneByteString, TwoByteString, Double
 class RODataSerializationCluster
     : public CanonicalSetSerializationCluster<CanonicalStringSet,
                                               String,
@@ -3075,6 +3182,8 @@ class ExceptionHandlersDeserializationCluster : public DeserializationCluster {
     stop_index_ = d->next_index();
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     ASSERT(!is_canonical());  // Never canonical.
     for (intptr_t id = start_index_; id < stop_index_; id++) {
@@ -3164,6 +3273,8 @@ class ContextDeserializationCluster : public DeserializationCluster {
     stop_index_ = d->next_index();
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     ASSERT(!is_canonical());  // Never canonical.
     for (intptr_t id = start_index_; id < stop_index_; id++) {
@@ -3564,6 +3675,8 @@ class LoadingUnitDeserializationCluster : public DeserializationCluster {
       unit->untag()->id_ = d->Read<int32_t>();
       unit->untag()->loaded_ = false;
       unit->untag()->load_outstanding_ = false;
+      unit->untag()->prefetched_ = false;
+      unit->untag()->load_issued_micros_ = 0;
     }
   }
 };
@@ -3839,6 +3952,8 @@ class InstanceDeserializationCluster
     stop_index_ = d->next_index();
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     intptr_t next_field_offset = next_field_offset_in_words_
                                  << kCompressedWordSizeLog2;
@@ -4486,6 +4601,8 @@ class ClosureDeserializationCluster
     ReadAllocFixedSize(d, Closure::InstanceSize());
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       ClosurePtr closure = static_cast<ClosurePtr>(d->Ref(id));
@@ -4647,6 +4764,8 @@ class DoubleDeserializationCluster
     ReadAllocFixedSize(d, Double::InstanceSize());
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       DoublePtr dbl = static_cast<DoublePtr>(d->Ref(id));
@@ -4707,6 +4826,8 @@ class GrowableObjectArrayDeserializationCluster
     ReadAllocFixedSize(d, GrowableObjectArray::InstanceSize());
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       GrowableObjectArrayPtr list =
@@ -4782,6 +4903,8 @@ class TypedDataDeserializationCluster : public DeserializationCluster {
     stop_index_ = d->next_index();
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     ASSERT(!is_canonical());  // Never canonical.
     intptr_t element_size = TypedData::ElementSizeInBytes(cid_);
@@ -5133,6 +5256,8 @@ class WeakPropertyDeserializationCluster : public DeserializationCluster {
     ReadAllocFixedSize(d, WeakProperty::InstanceSize());
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     ASSERT(!is_canonical());  // Never canonical.
     for (intptr_t id = start_index_; id < stop_index_; id++) {
@@ -5199,6 +5324,8 @@ class LinkedHashMapDeserializationCluster
     ReadAllocFixedSize(d, LinkedHashMap::InstanceSize());
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       LinkedHashMapPtr map = static_cast<LinkedHashMapPtr>(d->Ref(id));
@@ -5266,6 +5393,8 @@ class LinkedHashSetDeserializationCluster
     ReadAllocFixedSize(d, LinkedHashSet::InstanceSize());
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       LinkedHashSetPtr set = static_cast<LinkedHashSetPtr>(d->Ref(id));
@@ -5348,6 +5477,8 @@ class ArrayDeserializationCluster
     stop_index_ = d->next_index();
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       ArrayPtr array = static_cast<ArrayPtr>(d->Ref(id));
@@ -5425,6 +5556,11 @@ class StringSerializationCluster
       const intptr_t length = Smi::Value(str->untag()->length());
       const intptr_t encoded = EncodeLengthAndCid(length, cid);
       s->WriteUnsigned(encoded);
+      if (is_canonical()) {
+        // Canonical strings are looked up in the symbol table immediately,
+        // so their hash is written out instead of recomputed on load.
+        s->Write<int32_t>(String::Hash(str));
+      }
       if (cid == kOneByteStringCid) {
         s->WriteBytes(static_cast<OneByteStringPtr>(str)->untag()->data(),
                       length);
@@ -5471,6 +5607,8 @@ class StringDeserializationCluster
     BuildCanonicalSetFromLayout(d);
   }
 
+  bool CanReadFillInParallel() const { return true; }
+
   void ReadFill(Deserializer* d, bool primary) {
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       StringPtr str = static_cast<StringPtr>(d->Ref(id));
@@ -5480,22 +5618,22 @@ class StringDeserializationCluster
       Deserializer::InitializeHeader(str, cid, InstanceSize(length, cid),
                                      primary && is_canonical());
       str->untag()->length_ = Smi::New(length);
-      StringHasher hasher;
+      if (is_canonical()) {
+        String::SetCachedHash(str, d->Read<int32_t>());
+      } else {
+        // Other strings compute their hash on first use.
+#if !defined(HASH_IN_OBJECT_HEADER)
+        str->untag()->hash_ = Smi::New(0);
+#endif
+      }
       if (cid == kOneByteStringCid) {
-        for (intptr_t j = 0; j < length; j++) {
-          uint8_t code_unit = d->Read<uint8_t>();
-          static_cast<OneByteStringPtr>(str)->untag()->data()[j] = code_unit;
-          hasher.Add(code_unit);
-        }
+        d->ReadBytes(static_cast<OneByteStringPtr>(str)->untag()->data(),
+                     length);
       } else {
-        for (intptr_t j = 0; j < length; j++) {
-          uint16_t code_unit = d->Read<uint8_t>();
-          code_unit = code_unit | (d->Read<uint8_t>() << 8);
-          static_cast<TwoByteStringPtr>(str)->untag()->data()[j] = code_unit;
-          hasher.Add(code_unit);
-        }
+        d->ReadBytes(reinterpret_cast<uint8_t*>(
+                         static_cast<TwoByteStringPtr>(str)->untag()->data()),
+                     length * 2);
       }
-      String::SetCachedHash(str, hasher.Finalize());
     }
   }
 
@@ -6481,7 +6619,8 @@ intptr_t Serializer::UnsafeRefId(ObjectPtr object) const {
   FATAL("Reference for object %s is unallocated", handle.ToCString());
 }
 
-const char* Serializer::ReadOnlyObjectType(intptr_t cid) {
+const char* Serializer::ReadOnlyObjectType(intptr_t cid,
+                                           bool is_canonical) {
   switch (cid) {
     case kPcDescriptorsCid:
       return "PcDescriptors";
@@ -6501,11 +6640,28 @@ const char* Serializer::ReadOnlyObjectType(intptr_t cid) {
       return current_loading_unit_id_ <= LoadingUnit::kRootId
                  ? "TwoByteStringCid"
                  : nullptr;
+    case kDoubleCid:
+      // Canonical doubles are never written after they are created, so
+      // those of the root unit of AOT snapshots can be mapped as well.
+      return (kind_ == Snapshot::kFullAOT) && is_canonical &&
+                     (current_loading_unit_id_ <= LoadingUnit::kRootId)
+                 ? "CanonicalDouble"
+                 : nullptr;
     default:
       return nullptr;
   }
 }
 
+// Metadata of the VM snapshot is shared by all isolate groups, so it is
+// always read eagerly.
+bool Serializer::HasLazyCodeMetadata() const {
+#if defined(DART_PRECOMPILER)
+  return FLAG_lazy_code_metadata && (kind_ == Snapshot::kFullAOT) && !vm_;
+#else
+  return false;
+#endif
+}
+
 SerializationCluster* Serializer::NewClusterForClass(intptr_t cid,
                                                      bool is_canonical) {
 #if defined(DART_PRECOMPILED_RUNTIME)
@@ -6537,7 +6693,7 @@ SerializationCluster* Serializer::NewClusterForClass(intptr_t cid,
   // the memory image, and it might be outside the 4GB region addressable by
   // compressed pointers.
   if (Snapshot::IncludesCode(kind_)) {
-    if (auto const type = ReadOnlyObjectType(cid)) {
+    if (auto const type = ReadOnlyObjectType(cid, is_canonical)) {
       return new (Z) RODataSerializationCluster(Z, type, cid, is_canonical);
     }
   }
@@ -6577,9 +6733,9 @@ SerializationCluster* Serializer::NewClusterForClass(intptr_t cid,
     case kObjectPoolCid:
       return new (Z) ObjectPoolSerializationCluster();
     case kPcDescriptorsCid:
-      return new (Z) PcDescriptorsSerializationCluster();
+      return new (Z) PcDescriptorsSerializationCluster(HasLazyCodeMetadata());
     case kCodeSourceMapCid:
-      return new (Z) CodeSourceMapSerializationCluster();
+      return new (Z) CodeSourceMapSerializationCluster(HasLazyCodeMetadata());
     case kCompressedStackMapsCid:
       return new (Z) CompressedStackMapsSerializationCluster();
     case kExceptionHandlersCid:
@@ -7359,12 +7515,31 @@ ZoneGrowableArray<Object*>* Serializer::Serialize(SerializationRoots* roots) {
   }
 #endif
 
+  // The fill sections are preceded by their sizes, which are patched in
+  // below, so that the deserializer can locate the fill of every cluster
+  // without reading the ones before it.
+  const intptr_t fill_sizes_position = bytes_written();
+  for (intptr_t i = 0; i < clusters.length(); i++) {
+    stream_->WriteFixed<uint32_t>(0);
+  }
+  GrowableArray<intptr_t> fill_sizes(clusters.length());
   for (SerializationCluster* cluster : clusters) {
+    const intptr_t start = bytes_written();
     cluster->WriteAndMeasureFill(this);
 #if defined(DEBUG)
     Write<int32_t>(kSectionMarker);
 #endif
+    fill_sizes.Add(bytes_written() - start);
+  }
+  const intptr_t fill_end_position = bytes_written();
+  stream_->SetPosition(fill_sizes_position);
+  for (intptr_t fill_size : fill_sizes) {
+    if (!Utils::IsUint(32, fill_size)) {
+      FATAL("Fill section overflow");
+    }
+    stream_->WriteFixed<uint32_t>(fill_size);
   }
+  stream_->SetPosition(fill_end_position);
 
   roots->WriteRoots(this);
 
@@ -7626,6 +7801,27 @@ Deserializer::Deserializer(Thread* thread,
   stream_.SetPosition(offset);
 }
 
+Deserializer::Deserializer(Thread* thread, Deserializer* parent)
+    : ThreadStackResource(thread),
+      heap_(parent->heap_),
+      zone_(thread->zone()),
+      kind_(parent->kind_),
+      stream_(parent->stream_.AddressOfCurrentPosition() -
+                  parent->stream_.Position(),
+              parent->stream_.Position() + parent->stream_.PendingBytes()),
+      image_reader_(parent->image_reader_),
+      num_base_objects_(parent->num_base_objects_),
+      num_objects_(parent->num_objects_),
+      num_clusters_(parent->num_clusters_),
+      refs_(parent->refs_),
+      next_ref_index_(parent->next_ref_index_),
+      code_start_index_(parent->code_start_index_),
+      code_stop_index_(parent->code_stop_index_),
+      clusters_(nullptr),
+      initial_field_table_(parent->initial_field_table_),
+      is_non_root_unit_(parent->is_non_root_unit_),
+      instructions_table_(parent->instructions_table_) {}
+
 Deserializer::~Deserializer() {
   delete[] clusters_;
 }
@@ -7667,6 +7863,13 @@ DeserializationCluster* Deserializer::ReadCluster() {
                                                       !is_non_root_unit_, cid);
         }
         break;
+      case kDoubleCid:
+        if ((kind_ == Snapshot::kFullAOT) && is_canonical &&
+            !is_non_root_unit_) {
+          return new (Z) RODataDeserializationCluster(is_canonical,
+                                                      !is_non_root_unit_, cid);
+        }
+        break;
     }
   }
 #endif
@@ -8128,6 +8331,144 @@ class HeapLocker : public StackResource {
   FreeList* freelist_;
 };
 
+static void ReadFillCluster(Deserializer* d,
+                            DeserializationCluster* cluster,
+                            bool primary) {
+  TIMELINE_DURATION(d->thread(), Isolate, cluster->name());
+  cluster->ReadFill(d, primary);
+#if defined(DEBUG)
+  int32_t section_marker = d->Read<int32_t>();
+  ASSERT(section_marker == kSectionMarker);
+#endif
+}
+
+// The clusters that are filled by helper threads, and the positions of their
+// fill sections.
+struct ParallelFillWork {
+  ParallelFillWork(Zone* zone, intptr_t capacity, bool primary)
+      : clusters(zone, capacity), positions(zone, capacity), primary(primary) {}
+
+  GrowableArray<DeserializationCluster*> clusters;
+  GrowableArray<intptr_t> positions;
+  const bool primary;
+  RelaxedAtomic<intptr_t> next = 0;
+};
+
+// Fills clusters taken from [work] until there are none left. Every cluster
+// is filled by exactly one thread from its own fill section, so the result
+// does not depend on how the clusters are distributed.
+static void ReadFillParallelClusters(Deserializer* d, ParallelFillWork* work) {
+  for (;;) {
+    const intptr_t i = work->next.fetch_add(1);
+    if (i >= work->clusters.length()) {
+      break;
+    }
+    d->set_position(work->positions[i]);
+    ReadFillCluster(d, work->clusters[i], work->primary);
+  }
+}
+
+class ParallelFillTask : public ThreadPool::Task {
+ public:
+  ParallelFillTask(IsolateGroup* isolate_group,
+                   ThreadBarrier* barrier,
+                   Deserializer* parent,
+                   ParallelFillWork* work)
+      : isolate_group_(isolate_group),
+        barrier_(barrier),
+        parent_(parent),
+        work_(work) {}
+
+  virtual void Run() {
+    if (!barrier_->TryEnter()) {
+      barrier_->Release();
+      return;
+    }
+
+    bool result = Thread::EnterIsolateGroupAsHelper(
+        isolate_group_, Thread::kDeserializerTask, /*bypass_safepoint=*/true);
+    ASSERT(result);
+    {
+      Thread* thread = Thread::Current();
+      StackZone stack_zone(thread);
+      // The isolate thread holds the heap in a state where no GC can happen
+      // until all clusters are filled.
+      NoSafepointScope no_safepoint;
+      Deserializer helper(thread, parent_);
+      ReadFillParallelClusters(&helper, work_);
+    }
+    Thread::ExitIsolateGroupAsHelper(/*bypass_safepoint=*/true);
+
+    barrier_->Sync();
+    barrier_->Release();
+  }
+
+ private:
+  IsolateGroup* isolate_group_;
+  ThreadBarrier* barrier_;
+  Deserializer* parent_;
+  ParallelFillWork* work_;
+
+  DISALLOW_COPY_AND_ASSIGN(ParallelFillTask);
+};
+
+void Deserializer::FillClusters(bool primary) {
+  intptr_t* fill_positions = zone_->Alloc<intptr_t>(num_clusters_);
+  intptr_t fill_position =
+      position() + num_clusters_ * static_cast<intptr_t>(sizeof(uint32_t));
+  for (intptr_t i = 0; i < num_clusters_; i++) {
+    uint32_t fill_size;
+    ReadBytes(reinterpret_cast<uint8_t*>(&fill_size), sizeof(fill_size));
+    fill_positions[i] = fill_position;
+    fill_position += fill_size;
+  }
+  const intptr_t fill_end_position = fill_position;
+
+  const intptr_t num_tasks = FLAG_deserializer_tasks;
+  ParallelFillWork work(zone_, num_clusters_, primary);
+  // The small VM snapshot is read before helper threads can enter the VM
+  // isolate group.
+  if ((num_tasks > 1) && (isolate_group() != Dart::vm_isolate_group())) {
+    for (intptr_t i = 0; i < num_clusters_; i++) {
+      if (clusters_[i]->CanReadFillInParallel()) {
+        work.clusters.Add(clusters_[i]);
+        work.positions.Add(fill_positions[i]);
+      }
+    }
+  }
+
+  if (work.clusters.length() < 2) {
+    for (intptr_t i = 0; i < num_clusters_; i++) {
+      ASSERT_EQUAL(position(), fill_positions[i]);
+      ReadFillCluster(this, clusters_[i], primary);
+    }
+    ASSERT_EQUAL(position(), fill_end_position);
+    return;
+  }
+
+  // Helper tasks fill the independent clusters while this thread fills the
+  // others in order, since their fills may depend on earlier clusters. This
+  // thread then helps with the independent clusters that are left. A task
+  // that starts after this thread reached the barrier does not participate.
+  ThreadBarrier* barrier = new ThreadBarrier(num_tasks, 1);
+  for (intptr_t i = 0; i < num_tasks - 1; i++) {
+    bool result = Dart::thread_pool()->Run<ParallelFillTask>(
+        thread()->isolate_group(), barrier, this, &work);
+    ASSERT(result);
+  }
+  for (intptr_t i = 0; i < num_clusters_; i++) {
+    if (!clusters_[i]->CanReadFillInParallel()) {
+      set_position(fill_positions[i]);
+      ReadFillCluster(this, clusters_[i], primary);
+    }
+  }
+  ReadFillParallelClusters(this, &work);
+  barrier->Sync();
+  barrier->Release();
+
+  set_position(fill_end_position);
+}
+
 void Deserializer::Deserialize(DeserializationRoots* roots) {
   const void* clustered_start = CurrentBufferAddress();
 
@@ -8214,14 +8555,7 @@ void Deserializer::Deserialize(DeserializationRoots* roots) {
     {
       TIMELINE_DURATION(thread(), Isolate, "ReadFill");
       SafepointWriteRwLocker ml(thread(), isolate_group()->program_lock());
-      for (intptr_t i = 0; i < num_clusters_; i++) {
-        TIMELINE_DURATION(thread(), Isolate, clusters_[i]->name());
-        clusters_[i]->ReadFill(this, primary);
-#if defined(DEBUG)
-        int32_t section_marker = Read<int32_t>();
-        ASSERT(section_marker == kSectionMarker);
-#endif
-      }
+      FillClusters(primary);
     }
 
     roots->ReadRoots(this);
@@ -8252,7 +8586,7 @@ void Deserializer::Deserialize(DeserializationRoots* roots) {
     }
   }
 
-  if (isolate_group->snapshot_is_dontneed_safe()) {
+  if (isolate_group->snapshot_is_dontneed_safe() && !clustered_data_is_copy_) {
     size_t clustered_length = reinterpret_cast<uword>(CurrentBufferAddress()) -
                               reinterpret_cast<uword>(clustered_start);
     VirtualMemory::DontNeed(const_cast<void*>(clustered_start),
@@ -8303,10 +8637,15 @@ ZoneGrowableArray<Object*>* FullSnapshotWriter::WriteVMSnapshot() {
 
   serializer.ReserveHeader();
   serializer.WriteVersionAndFeatures(true);
+  const intptr_t format_position =
+      SnapshotCompression::WriteFormat(serializer.stream());
   VMSerializationRoots roots(
       Array::Handle(Dart::vm_isolate_group()->object_store()->symbol_table()),
       /*should_write_symbols=*/!Snapshot::IncludesStringsInROData(kind_));
   ZoneGrowableArray<Object*>* objects = serializer.Serialize(&roots);
+  uncompressed_vm_size_ =
+      format_position + 1 +
+      SnapshotCompression::Compress(serializer.stream(), format_position);
   serializer.FillHeader(serializer.kind());
   clustered_vm_size_ = serializer.bytes_written();
   heap_vm_size_ = serializer.bytes_heap_allocated();
@@ -8347,11 +8686,16 @@ void FullSnapshotWriter::WriteProgramSnapshot(
 
   serializer.ReserveHeader();
   serializer.WriteVersionAndFeatures(false);
+  const intptr_t format_position =
+      SnapshotCompression::WriteFormat(serializer.stream());
   ProgramSerializationRoots roots(objects, object_store, kind_);
   objects = serializer.Serialize(&roots);
   if (units != nullptr) {
     (*units)[LoadingUnit::kRootId]->set_objects(objects);
   }
+  uncompressed_isolate_size_ =
+      format_position + 1 +
+      SnapshotCompression::Compress(serializer.stream(), format_position);
   serializer.FillHeader(serializer.kind());
   clustered_isolate_size_ = serializer.bytes_written();
   heap_isolate_size_ = serializer.bytes_heap_allocated();
@@ -8386,11 +8730,16 @@ void FullSnapshotWriter::WriteUnitSnapshot(
 
   serializer.ReserveHeader();
   serializer.WriteVersionAndFeatures(false);
+  const intptr_t format_position =
+      SnapshotCompression::WriteFormat(serializer.stream());
   serializer.Write(program_hash);
 
   UnitSerializationRoots roots(unit);
   unit->set_objects(serializer.Serialize(&roots));
 
+  uncompressed_isolate_size_ =
+      format_position + 1 +
+      SnapshotCompression::Compress(serializer.stream(), format_position);
   serializer.FillHeader(serializer.kind());
   clustered_isolate_size_ = serializer.bytes_written();
 
@@ -8427,6 +8776,12 @@ void FullSnapshotWriter::WriteFullSnapshot(
   if (FLAG_print_snapshot_sizes) {
     OS::Print("VMIsolate(CodeSize): %" Pd "\n", clustered_vm_size_);
     OS::Print("Isolate(CodeSize): %" Pd "\n", clustered_isolate_size_);
+    if (FLAG_compress_snapshot_data) {
+      OS::Print("VMIsolate(UncompressedCodeSize): %" Pd "\n",
+                uncompressed_vm_size_);
+      OS::Print("Isolate(UncompressedCodeSize): %" Pd "\n",
+                uncompressed_isolate_size_);
+    }
     OS::Print("ReadOnlyData(CodeSize): %" Pd "\n", mapped_data_size_);
     OS::Print("Instructions(CodeSize): %" Pd "\n", mapped_text_size_);
     OS::Print("Total(CodeSize): %" Pd "\n",
@@ -8610,6 +8965,33 @@ bool SnapshotHeaderReader::NullSafetyFromSnapshot(const Snapshot* snapshot) {
   return null_safety;
 }
 
+char* FullSnapshotReader::PrepareClusteredData(intptr_t* offset) {
+  if (*offset >= size_) {
+    return Utils::StrDup("Truncated snapshot");
+  }
+  const uint8_t format = buffer_[*offset];
+  if (format == SnapshotCompression::kCompressed) {
+    TIMELINE_DURATION(thread_, Isolate, "DecompressSnapshotData");
+    intptr_t decompressed_size = 0;
+    char* error = nullptr;
+    uint8_t* decompressed = SnapshotCompression::Decompress(
+        buffer_, size_, *offset, FLAG_deserializer_tasks, &decompressed_size,
+        &error);
+    if (decompressed == nullptr) {
+      return error;
+    }
+    // Objects read from the snapshot may point into its clustered data.
+    isolate_group()->AddDecompressedSnapshot(decompressed);
+    buffer_ = decompressed;
+    size_ = decompressed_size;
+    clustered_data_is_copy_ = true;
+  } else if (format != SnapshotCompression::kUncompressed) {
+    return Utils::StrDup("Invalid snapshot data format");
+  }
+  *offset += 1;
+  return nullptr;
+}
+
 ApiErrorPtr FullSnapshotReader::ReadVMSnapshot() {
   SnapshotHeaderReader header_reader(kind_, buffer_, size_);
 
@@ -8619,10 +9001,15 @@ ApiErrorPtr FullSnapshotReader::ReadVMSnapshot() {
   if (error != nullptr) {
     return ConvertToApiError(error);
   }
+  error = PrepareClusteredData(&offset);
+  if (error != nullptr) {
+    return ConvertToApiError(error);
+  }
 
   Deserializer deserializer(thread_, kind_, buffer_, size_, data_image_,
                             instructions_image_, /*is_non_root_unit=*/false,
                             offset);
+  deserializer.set_clustered_data_is_copy(clustered_data_is_copy_);
   ApiErrorPtr api_error = deserializer.VerifyImageAlignment();
   if (api_error != ApiError::null()) {
     return api_error;
@@ -8660,10 +9047,15 @@ ApiErrorPtr FullSnapshotReader::ReadProgramSnapshot() {
   if (error != nullptr) {
     return ConvertToApiError(error);
   }
+  error = PrepareClusteredData(&offset);
+  if (error != nullptr) {
+    return ConvertToApiError(error);
+  }
 
   Deserializer deserializer(thread_, kind_, buffer_, size_, data_image_,
                             instructions_image_, /*is_non_root_unit=*/false,
                             offset);
+  deserializer.set_clustered_data_is_copy(clustered_data_is_copy_);
   ApiErrorPtr api_error = deserializer.VerifyImageAlignment();
   if (api_error != ApiError::null()) {
     return api_error;
@@ -8694,10 +9086,15 @@ ApiErrorPtr FullSnapshotReader::ReadUnitSnapshot(const LoadingUnit& unit) {
   if (error != nullptr) {
     return ConvertToApiError(error);
   }
+  error = PrepareClusteredData(&offset);
+  if (error != nullptr) {
+    return ConvertToApiError(error);
+  }
 
   Deserializer deserializer(
       thread_, kind_, buffer_, size_, data_image_, instructions_image_,
       /*is_non_root_unit=*/unit.id() != LoadingUnit::kRootId, offset);
+  deserializer.set_clustered_data_is_copy(clustered_data_is_copy_);
   ApiErrorPtr api_error = deserializer.VerifyImageAlignment();
   if (api_error != ApiError::null()) {
     return api_error;
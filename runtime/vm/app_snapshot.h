@@ -147,6 +147,10 @@ class DeserializationCluster : public ZoneAllocated {
   // Initialize the cluster's objects. Do not touch the memory of other objects.
   virtual void ReadFill(Deserializer* deserializer, bool primary) = 0;
 
+  // Whether [ReadFill] only reads the snapshot and the ref array, so that it
+  // can run on a helper thread concurrently with the fills of other clusters.
+  virtual bool CanReadFillInParallel() const { return false; }
+
   // Complete any action that requires the full graph to be deserialized, such
   // as rehashing.
   virtual void PostLoad(Deserializer* deserializer,
@@ -496,7 +500,8 @@ class Serializer : public ThreadStackResource {
   }
 
  private:
-  const char* ReadOnlyObjectType(intptr_t cid);
+  const char* ReadOnlyObjectType(intptr_t cid, bool is_canonical);
+  bool HasLazyCodeMetadata() const;
   void FlushProfile();
 
   Heap* heap_;
@@ -615,6 +620,9 @@ class Deserializer : public ThreadStackResource {
                const uint8_t* instructions_buffer,
                bool is_non_root_unit,
                intptr_t offset = 0);
+  // Creates a deserializer for the current helper thread that reads the fill
+  // sections of the snapshot being deserialized by [parent].
+  Deserializer(Thread* thread, Deserializer* parent);
   ~Deserializer();
 
   // Verifies the image alignment.
@@ -708,6 +716,7 @@ class Deserializer : public ThreadStackResource {
   void Deserialize(DeserializationRoots* roots);
 
   DeserializationCluster* ReadCluster();
+  void FillClusters(bool primary);
 
   void ReadDispatchTable() {
     ReadDispatchTable(&stream_, /*deferred=*/false, InstructionsTable::Handle(),
@@ -733,6 +742,11 @@ class Deserializer : public ThreadStackResource {
     return instructions_table_;
   }
   intptr_t num_base_objects() const { return num_base_objects_; }
+  // Set when reading a decompressed copy of the snapshot, whose pages cannot
+  // be dropped once they are read.
+  void set_clustered_data_is_copy(bool value) {
+    clustered_data_is_copy_ = value;
+  }
 
  private:
   Heap* heap_;
@@ -752,6 +766,7 @@ class Deserializer : public ThreadStackResource {
   FieldTable* initial_field_table_;
   const bool is_non_root_unit_;
   InstructionsTable& instructions_table_;
+  bool clustered_data_is_copy_ = false;
 };
 
 #define ReadFromTo(obj, ...) d->ReadFromTo(obj, ##__VA_ARGS__);
@@ -801,6 +816,8 @@ class FullSnapshotWriter {
   // Stats for benchmarking.
   intptr_t clustered_vm_size_ = 0;
   intptr_t clustered_isolate_size_ = 0;
+  intptr_t uncompressed_vm_size_ = 0;
+  intptr_t uncompressed_isolate_size_ = 0;
   intptr_t mapped_data_size_ = 0;
   intptr_t mapped_text_size_ = 0;
   intptr_t heap_vm_size_ = 0;
@@ -828,10 +845,16 @@ class FullSnapshotReader {
   ApiErrorPtr ConvertToApiError(char* message);
   void InitializeBSS();
 
+  // Sets [offset] to the start of the clustered data after the format byte
+  // at [offset], decompressing the data into a copy of the snapshot if it is
+  // compressed. Returns null on success and a malloc()ed error on failure.
+  char* PrepareClusteredData(intptr_t* offset);
+
   Snapshot::Kind kind_;
   Thread* thread_;
   const uint8_t* buffer_;
   intptr_t size_;
+  bool clustered_data_is_copy_ = false;
   const uint8_t* data_image_;
   const uint8_t* instructions_image_;
 
@@ -4,6 +4,8 @@
 
 #include "vm/benchmark_test.h"
 
+#include <algorithm>
+
 #include "bin/builtin.h"
 #include "bin/file.h"
 #include "bin/isolate_data.h"
@@ -19,13 +21,19 @@
 #include "vm/dart_api_impl.h"
 #include "vm/datastream.h"
 #include "vm/message_snapshot.h"
+#include "vm/port.h"
 #include "vm/stack_frame.h"
+#include "vm/symbols.h"
+#include "vm/thread_pool.h"
 #include "vm/timer.h"
 
 using dart::bin::File;
 
 namespace dart {
 
+DECLARE_FLAG(bool, compress_snapshot_data);
+DECLARE_FLAG(int, kernel_source_tasks);
+
 Benchmark* Benchmark::first_ = NULL;
 Benchmark* Benchmark::tail_ = NULL;
 const char* Benchmark::executable_ = NULL;
@@ -105,6 +113,65 @@ BENCHMARK(CorelibIsolateStartup) {
   Dart_EnterIsolate(reinterpret_cast<Dart_Isolate>(isolate));
 }
 
+//
+// Measure isolate startup from a snapshot against the number of symbols.
+//
+static void SymbolTableIsolateStartup(Benchmark* benchmark,
+                                      intptr_t num_symbols) {
+  const int kNumIterations = 100;
+  Thread* thread = Thread::Current();
+  uint8_t* isolate_snapshot_data_buffer;
+  {
+    TransitionNativeToVM transition(thread);
+    StackZone zone(thread);
+    HandleScope scope(thread);
+
+    char name[64];
+    for (intptr_t i = 0; i < num_symbols; i++) {
+      Utils::SNPrint(name, sizeof(name), "benchmarkSymbol%" Pd, i);
+      Symbols::New(thread, name);
+    }
+
+    MallocWriteStream isolate_snapshot_data(FullSnapshotWriter::kInitialSize);
+    FullSnapshotWriter writer(
+        Snapshot::kFull, /*vm_snapshot_data=*/nullptr, &isolate_snapshot_data,
+        /*vm_image_writer=*/nullptr, /*iso_image_writer=*/nullptr);
+    writer.WriteFullSnapshot();
+    intptr_t unused;
+    isolate_snapshot_data_buffer = isolate_snapshot_data.Steal(&unused);
+  }
+
+  Timer timer;
+  Isolate* isolate = thread->isolate();
+  Dart_ExitIsolate();
+  for (int i = 0; i < kNumIterations; i++) {
+    timer.Start();
+    TestCase::CreateTestIsolateFromSnapshot(isolate_snapshot_data_buffer);
+    timer.Stop();
+    Dart_ShutdownIsolate();
+  }
+  benchmark->set_score(timer.TotalElapsedTime() / kNumIterations);
+  Dart_EnterIsolate(reinterpret_cast<Dart_Isolate>(isolate));
+  free(isolate_snapshot_data_buffer);
+}
+
+BENCHMARK(SymbolTableIsolateStartup10K) {
+  SymbolTableIsolateStartup(benchmark, 10 * KB);
+}
+
+BENCHMARK(SymbolTableIsolateStartup100K) {
+  SymbolTableIsolateStartup(benchmark, 100 * KB);
+}
+
+BENCHMARK(SymbolTableIsolateStartup1M) {
+  SymbolTableIsolateStartup(benchmark, 1 * MB);
+}
+
+BENCHMARK(SymbolTableIsolateStartup1MCompressed) {
+  SetFlagScope<bool> sfs(&FLAG_compress_snapshot_data, true);
+  SymbolTableIsolateStartup(benchmark, 1 * MB);
+}
+
 //
 // Measure invocation of Dart API functions.
 //
@@ -302,6 +369,46 @@ BENCHMARK(KernelServiceCompileAll) {
   free(kernel_buffer);
 }
 
+//
+// Measure loading and class finalization of the kernel Service(CFE).
+//
+static void KernelServiceLoad(Benchmark* benchmark, int source_tasks) {
+  // kernel_service.dill is built with sound null safety.
+  if (FLAG_sound_null_safety != kNullSafetyOptionStrong) {
+    return;
+  }
+  SetFlagScope<int> sfs(&FLAG_kernel_source_tasks, source_tasks);
+  char* dill_path = ComputeKernelServicePath(Benchmark::Executable());
+  File* file = File::Open(NULL, dill_path, File::kRead);
+  EXPECT(file != NULL);
+  bin::RefCntReleaseScope<File> rs(file);
+  intptr_t kernel_buffer_size = file->Length();
+  uint8_t* kernel_buffer =
+      reinterpret_cast<uint8_t*>(malloc(kernel_buffer_size));
+  bool read_fully = file->ReadFully(kernel_buffer, kernel_buffer_size);
+  EXPECT(read_fully);
+
+  Timer timer;
+  timer.Start();
+  Dart_Handle result =
+      Dart_LoadScriptFromKernel(kernel_buffer, kernel_buffer_size);
+  EXPECT_VALID(result);
+  result = Dart_FinalizeLoading(false);
+  EXPECT_VALID(result);
+  timer.Stop();
+  benchmark->set_score(timer.TotalElapsedTime());
+  free(dill_path);
+  free(kernel_buffer);
+}
+
+BENCHMARK(KernelServiceLoad) {
+  KernelServiceLoad(benchmark, FLAG_kernel_source_tasks);
+}
+
+BENCHMARK(KernelServiceLoadSerial) {
+  KernelServiceLoad(benchmark, 1);
+}
+
 //
 // Measure frame lookup during stack traversal.
 //
@@ -393,7 +500,7 @@ BENCHMARK(FrameLookup) {
   benchmark->set_score(elapsed_time);
 }
 
-BENCHMARK_SIZE(CoreSnapshotSize) {
+static void MeasureCoreSnapshotSize(Benchmark* benchmark, Thread* thread) {
   const char* kScriptChars =
       "import 'dart:async';\n"
       "import 'dart:core';\n"
@@ -428,6 +535,15 @@ BENCHMARK_SIZE(CoreSnapshotSize) {
   benchmark->set_score(snapshot->length());
 }
 
+BENCHMARK_SIZE(CoreSnapshotSize) {
+  MeasureCoreSnapshotSize(benchmark, thread);
+}
+
+BENCHMARK_SIZE(CompressedCoreSnapshotSize) {
+  SetFlagScope<bool> sfs(&FLAG_compress_snapshot_data, true);
+  MeasureCoreSnapshotSize(benchmark, thread);
+}
+
 BENCHMARK_SIZE(StandaloneSnapshotSize) {
   const char* kScriptChars =
       "import 'dart:async';\n"
@@ -604,6 +720,414 @@ BENCHMARK(LargeMap) {
   benchmark->set_score(elapsed_time);
 }
 
+// Latency samples of a messaging benchmark, reported as percentiles in
+// microseconds. Samples can be added concurrently.
+class LatencySamples {
+ public:
+  explicit LatencySamples(intptr_t capacity)
+      : samples_(new int64_t[capacity]), capacity_(capacity), length_(0) {}
+  ~LatencySamples() { delete[] samples_; }
+
+  void Add(int64_t micros) {
+    const intptr_t index = length_.fetch_add(1);
+    if (index < capacity_) {
+      samples_[index] = micros;
+    }
+  }
+
+  void Report(Benchmark* benchmark) {
+    const intptr_t length = Utils::Minimum<intptr_t>(length_, capacity_);
+    if (length == 0) return;
+    std::sort(samples_, samples_ + length);
+    benchmark->AddScore("p50", "Latency", samples_[length * 50 / 100]);
+    benchmark->AddScore("p90", "Latency", samples_[length * 90 / 100]);
+    benchmark->AddScore("p99", "Latency", samples_[length * 99 / 100]);
+    benchmark->AddScore("max", "Latency", samples_[length - 1]);
+  }
+
+ private:
+  int64_t* const samples_;
+  const intptr_t capacity_;
+  RelaxedAtomic<intptr_t> length_;
+
+  DISALLOW_COPY_AND_ASSIGN(LatencySamples);
+};
+
+// Receives messages carrying the time they were sent at on native ports.
+// Native port handlers have no user data, so there is one active receiver at
+// a time.
+class TimestampReceiver {
+ public:
+  TimestampReceiver(intptr_t expected, LatencySamples* samples)
+      : expected_(expected), received_(0), samples_(samples) {
+    ASSERT(current_ == nullptr);
+    current_ = this;
+  }
+  ~TimestampReceiver() { current_ = nullptr; }
+
+  Dart_Port NewPort() {
+    return Dart_NewNativePort("TimestampReceiver", &HandleMessage,
+                              /*handle_concurrently=*/false);
+  }
+
+  void WaitForAll() {
+    MonitorLocker ml(&monitor_);
+    while (!done_) {
+      ml.Wait();
+    }
+  }
+
+ private:
+  static void HandleMessage(Dart_Port dest_port_id, Dart_CObject* message) {
+    TimestampReceiver* receiver = current_;
+    int64_t sent = 0;
+    if (message->type == Dart_CObject_kInt32) {
+      sent = message->value.as_int32;
+    } else if (message->type == Dart_CObject_kInt64) {
+      sent = message->value.as_int64;
+    } else {
+      UNREACHABLE();
+    }
+    receiver->samples_->Add(OS::GetCurrentMonotonicMicros() - sent);
+    if (receiver->received_.fetch_add(1) + 1 == receiver->expected_) {
+      MonitorLocker ml(&receiver->monitor_);
+      receiver->done_ = true;
+      ml.Notify();
+    }
+  }
+
+  static TimestampReceiver* current_;
+
+  const intptr_t expected_;
+  RelaxedAtomic<intptr_t> received_;
+  LatencySamples* samples_;
+  Monitor monitor_;
+  bool done_ = false;
+
+  DISALLOW_COPY_AND_ASSIGN(TimestampReceiver);
+};
+
+TimestampReceiver* TimestampReceiver::current_ = nullptr;
+
+// Posts [count] timestamps round-robin to [ports].
+class TimestampSenderTask : public ThreadPool::Task {
+ public:
+  TimestampSenderTask(const Dart_Port* ports,
+                      intptr_t num_ports,
+                      intptr_t count)
+      : ports_(ports), num_ports_(num_ports), count_(count) {}
+
+  virtual void Run() {
+    for (intptr_t i = 0; i < count_; i++) {
+      Dart_PostInteger(ports_[i % num_ports_], OS::GetCurrentMonotonicMicros());
+    }
+  }
+
+ private:
+  const Dart_Port* ports_;
+  const intptr_t num_ports_;
+  const intptr_t count_;
+};
+
+// Posts [kMessagesPerSender] messages from each of [num_senders] threads to
+// [num_ports] native ports. The score is the total run time, additional
+// scores are the throughput in messages per second and the latency between
+// posting and handling a message.
+static void MeasurePosting(Benchmark* benchmark,
+                           intptr_t num_senders,
+                           intptr_t num_ports) {
+  const intptr_t kMessagesPerSender = 100000 / num_senders;
+  const intptr_t total = kMessagesPerSender * num_senders;
+  LatencySamples samples(total);
+  TimestampReceiver receiver(total, &samples);
+  Dart_Port* ports = new Dart_Port[num_ports];
+  for (intptr_t i = 0; i < num_ports; i++) {
+    ports[i] = receiver.NewPort();
+  }
+  Timer timer;
+  timer.Start();
+  {
+    ThreadPool senders;
+    for (intptr_t i = 0; i < num_senders; i++) {
+      senders.Run<TimestampSenderTask>(ports, num_ports, kMessagesPerSender);
+    }
+    receiver.WaitForAll();
+  }
+  timer.Stop();
+  for (intptr_t i = 0; i < num_ports; i++) {
+    Dart_CloseNativePort(ports[i]);
+  }
+  delete[] ports;
+  const int64_t elapsed_time = timer.TotalElapsedTime();
+  benchmark->set_score(elapsed_time);
+  benchmark->AddScore("Throughput", "MessagesPerSecond",
+                      total * kMicrosecondsPerSecond /
+                          Utils::Maximum<int64_t>(elapsed_time, 1));
+  samples.Report(benchmark);
+}
+
+BENCHMARK(PostManyToOne) {
+  MeasurePosting(benchmark, /*num_senders=*/8, /*num_ports=*/1);
+}
+
+BENCHMARK(PostOneToMany) {
+  MeasurePosting(benchmark, /*num_senders=*/1, /*num_ports=*/8);
+}
+
+// Round trip of OOB ping messages handled by the isolate, which respond to a
+// native port with the time the ping was sent at.
+BENCHMARK(PostOOBPing) {
+  const intptr_t kBatchSize = 100;
+  const intptr_t kNumBatches = 100;
+  const intptr_t total = kBatchSize * kNumBatches;
+  LatencySamples samples(total);
+  TimestampReceiver receiver(total, &samples);
+  const Dart_Port response_port = receiver.NewPort();
+  const Dart_Port isolate_port = thread->isolate()->main_port();
+  Timer timer;
+  for (intptr_t batch = 0; batch < kNumBatches; batch++) {
+    timer.Start();
+    {
+      TransitionNativeToVM transition(thread);
+      StackZone zone(thread);
+      const Array& ping = Array::Handle(Array::New(5));
+      ping.SetAt(0, Smi::Handle(Smi::New(Message::kIsolateLibOOBMsg)));
+      ping.SetAt(1, Smi::Handle(Smi::New(Isolate::kPingMsg)));
+      ping.SetAt(2, SendPort::Handle(SendPort::New(response_port)));
+      ping.SetAt(3, Smi::Handle(Smi::New(Isolate::kImmediateAction)));
+      Integer& sent = Integer::Handle();
+      for (intptr_t i = 0; i < kBatchSize; i++) {
+        sent = Integer::New(OS::GetCurrentMonotonicMicros());
+        ping.SetAt(4, sent);
+        PortMap::PostMessage(WriteMessage(
+            /* can_send_any_object */ false, /* same_group */ false, ping,
+            isolate_port, Message::kOOBPriority));
+      }
+    }
+    EXPECT_VALID(Dart_HandleMessage());
+    timer.Stop();
+  }
+  receiver.WaitForAll();
+  Dart_CloseNativePort(response_port);
+  const int64_t elapsed_time = timer.TotalElapsedTime();
+  benchmark->set_score(elapsed_time);
+  benchmark->AddScore("Throughput", "MessagesPerSecond",
+                      total * kMicrosecondsPerSecond /
+                          Utils::Maximum<int64_t>(elapsed_time, 1));
+  samples.Report(benchmark);
+}
+
+// Sending and receiving TransferableTypedData of several sizes. The
+// additional scores are the time per message in nanoseconds.
+BENCHMARK(TransferableTypedDataMessage) {
+  TransitionNativeToVM transition(thread);
+  StackZone zone(thread);
+  const intptr_t kSizes[] = {KB, 64 * KB, MB};
+  const char* kSizeNames[] = {"1KB", "64KB", "1MB"};
+  const intptr_t kLoopCount = 1000;
+  TransferableTypedData& transferable = TransferableTypedData::Handle();
+  Timer total_timer;
+  for (intptr_t s = 0; s < static_cast<intptr_t>(ARRAY_SIZE(kSizes)); s++) {
+    Timer timer;
+    for (intptr_t i = 0; i < kLoopCount; i++) {
+      HANDLESCOPE(thread);
+      uint8_t* data = reinterpret_cast<uint8_t*>(malloc(kSizes[s]));
+      memset(data, 0, kSizes[s]);
+      transferable = TransferableTypedData::New(data, kSizes[s]);
+      timer.Start();
+      total_timer.Start();
+      std::unique_ptr<Message> message =
+          WriteMessage(/* can_send_any_object */ false, /* same_group */ false,
+                       transferable, ILLEGAL_PORT, Message::kNormalPriority);
+      ReadMessage(thread, message.get());
+      total_timer.Stop();
+      timer.Stop();
+    }
+    benchmark->AddScore(kSizeNames[s], "RunTimeNanos",
+                        timer.TotalElapsedTime() * 1000 / kLoopCount);
+  }
+  benchmark->set_score(total_timer.TotalElapsedTime());
+}
+
+// Copying object graphs between isolates of the same group. The additional
+// scores are the time per message in microseconds for several sizes.
+static void MeasureObjectGraphCopy(Benchmark* benchmark,
+                                   Thread* thread,
+                                   const char* constructor) {
+  const char* kScript =
+      "class Foo {\n"
+      "  final int a;\n"
+      "  final String b;\n"
+      "  final Foo? next;\n"
+      "  Foo(this.a, this.b, this.next);\n"
+      "}\n"
+      "makeList(int n) => List.generate(n, (i) => i);\n"
+      "makeMap(int n) => {for (int i = 0; i < n; i++) i: 'value $i'};\n"
+      "makeInstances(int n) {\n"
+      "  Foo? next;\n"
+      "  return List.generate(n, (i) => next = Foo(i, 'foo', next));\n"
+      "}\n";
+  const intptr_t kSizes[] = {10, 1000, 100000};
+  const char* kSizeNames[] = {"10", "1000", "100000"};
+  const intptr_t kElementsPerSize = 1000000;
+  Dart_Handle lib = TestCase::LoadTestScript(kScript, NULL);
+  EXPECT_VALID(lib);
+  Timer total_timer;
+  for (intptr_t s = 0; s < static_cast<intptr_t>(ARRAY_SIZE(kSizes)); s++) {
+    Dart_Handle args[] = {Dart_NewInteger(kSizes[s])};
+    Dart_Handle graph = Dart_Invoke(lib, NewString(constructor), 1, args);
+    EXPECT_VALID(graph);
+    TransitionNativeToVM transition(thread);
+    StackZone zone(thread);
+    const Object& object = Object::Handle(Api::UnwrapHandle(graph));
+    const intptr_t loop_count = kElementsPerSize / kSizes[s];
+    Timer timer;
+    timer.Start();
+    total_timer.Start();
+    for (intptr_t i = 0; i < loop_count; i++) {
+      StackZone zone(thread);
+      std::unique_ptr<Message> message =
+          WriteMessage(/* can_send_any_object */ true, /* same_group */ true,
+                       object, ILLEGAL_PORT, Message::kNormalPriority);
+      ReadMessage(thread, message.get());
+    }
+    total_timer.Stop();
+    timer.Stop();
+    benchmark->AddScore(kSizeNames[s], "RunTime",
+                        timer.TotalElapsedTime() / loop_count);
+  }
+  benchmark->set_score(total_timer.TotalElapsedTime());
+}
+
+BENCHMARK(ObjectGraphCopyList) {
+  MeasureObjectGraphCopy(benchmark, thread, "makeList");
+}
+
+BENCHMARK(ObjectGraphCopyMap) {
+  MeasureObjectGraphCopy(benchmark, thread, "makeMap");
+}
+
+BENCHMARK(ObjectGraphCopyInstances) {
+  MeasureObjectGraphCopy(benchmark, thread, "makeInstances");
+}
+
+// Spawning an isolate into the group of the benchmark isolate and shutting
+// it down again.
+BENCHMARK(IsolateSpawnAndExit) {
+  const intptr_t kNumIterations = 1000;
+  LatencySamples spawn_samples(kNumIterations);
+  Timer timer;
+  Dart_Isolate parent = Dart_CurrentIsolate();
+  Dart_ExitIsolate();
+  for (intptr_t i = 0; i < kNumIterations; i++) {
+    timer.Start();
+    const int64_t start = OS::GetCurrentMonotonicMicros();
+    char* error = nullptr;
+    Dart_Isolate child = Dart_CreateIsolateInGroup(
+        parent, "IsolateSpawnAndExit", nullptr, nullptr, nullptr, &error);
+    EXPECT(child != nullptr);
+    spawn_samples.Add(OS::GetCurrentMonotonicMicros() - start);
+    Dart_ShutdownIsolate();
+    timer.Stop();
+  }
+  Dart_EnterIsolate(parent);
+  benchmark->set_score(timer.TotalElapsedTime() / kNumIterations);
+  spawn_samples.Report(benchmark);
+}
+
+// Scheduling overhead of the thread pool with many concurrently scheduling
+// workers. [kProducers] tasks are posted from the main thread, and each of
+// them schedules [kTasksPerProducer] tiny tasks from within the pool, either
+// all at once (exercising local queues and stealing) or as a chain of
+// continuations (exercising the LIFO slots).
+class ThreadPoolBenchmark {
+ public:
+  static constexpr intptr_t kProducers = 64;
+  static constexpr intptr_t kTasksPerProducer = 10000;
+
+  static int64_t Measure(bool chained) {
+    ThreadPool pool;
+    ThreadPoolBenchmark benchmark(&pool);
+    Timer timer;
+    timer.Start();
+    for (intptr_t i = 0; i < kProducers; i++) {
+      if (chained) {
+        pool.Run<ChainTask>(&benchmark, kTasksPerProducer);
+      } else {
+        pool.Run<ProducerTask>(&benchmark);
+      }
+    }
+    MonitorLocker ml(&benchmark.monitor_);
+    while (benchmark.remaining_ > 0) {
+      ml.Wait();
+    }
+    timer.Stop();
+    return timer.TotalElapsedTime();
+  }
+
+ private:
+  explicit ThreadPoolBenchmark(ThreadPool* pool)
+      : pool_(pool), remaining_(kProducers * kTasksPerProducer) {}
+
+  void TaskDone() {
+    if (remaining_.fetch_sub(1) == 1) {
+      MonitorLocker ml(&monitor_);
+      ml.Notify();
+    }
+  }
+
+  class LeafTask : public ThreadPool::Task {
+   public:
+    explicit LeafTask(ThreadPoolBenchmark* benchmark) : benchmark_(benchmark) {}
+    virtual void Run() { benchmark_->TaskDone(); }
+
+   private:
+    ThreadPoolBenchmark* benchmark_;
+  };
+
+  class ProducerTask : public ThreadPool::Task {
+   public:
+    explicit ProducerTask(ThreadPoolBenchmark* benchmark)
+        : benchmark_(benchmark) {}
+    virtual void Run() {
+      for (intptr_t i = 0; i < kTasksPerProducer; i++) {
+        benchmark_->pool_->Run<LeafTask>(benchmark_);
+      }
+    }
+
+   private:
+    ThreadPoolBenchmark* benchmark_;
+  };
+
+  class ChainTask : public ThreadPool::Task {
+   public:
+    ChainTask(ThreadPoolBenchmark* benchmark, intptr_t remaining)
+        : benchmark_(benchmark), remaining_(remaining) {}
+    virtual void Run() {
+      if (remaining_ > 1) {
+        benchmark_->pool_->Run<ChainTask>(benchmark_, remaining_ - 1);
+      }
+      benchmark_->TaskDone();
+    }
+
+   private:
+    ThreadPoolBenchmark* benchmark_;
+    intptr_t remaining_;
+  };
+
+  ThreadPool* pool_;
+  Monitor monitor_;
+  RelaxedAtomic<intptr_t> remaining_;
+};
+
+BENCHMARK(ThreadPoolFanOut) {
+  benchmark->set_score(ThreadPoolBenchmark::Measure(/*chained=*/false));
+}
+
+BENCHMARK(ThreadPoolContinuations) {
+  benchmark->set_score(ThreadPoolBenchmark::Measure(/*chained=*/true));
+}
+
 BENCHMARK_MEMORY(InitialRSS) {
   benchmark->set_score(bin::Process::MaxRSS());
 }
@@ -81,6 +81,23 @@ class Benchmark {
   const char* score_kind() const { return score_kind_; }
   void set_score(int64_t value) { score_ = value; }
   int64_t score() const { return score_; }
+
+  // Additional scores reported as "<name>.<suffix>(<kind>): <value>" after
+  // the main score, e.g. latency percentiles or results for several message
+  // sizes. [suffix] and [kind] have to outlive the benchmark run.
+  static constexpr intptr_t kMaxExtraScores = 16;
+  void AddScore(const char* suffix, const char* kind, int64_t value) {
+    RELEASE_ASSERT(num_extra_scores_ < kMaxExtraScores);
+    extra_scores_[num_extra_scores_++] = {suffix, kind, value};
+  }
+  intptr_t num_extra_scores() const { return num_extra_scores_; }
+  const char* extra_score_suffix(intptr_t i) const {
+    return extra_scores_[i].suffix;
+  }
+  const char* extra_score_kind(intptr_t i) const {
+    return extra_scores_[i].kind;
+  }
+  int64_t extra_score(intptr_t i) const { return extra_scores_[i].value; }
   Isolate* isolate() const { return reinterpret_cast<Isolate*>(isolate_); }
 
   void Run() { (*run_)(this); }
@@ -104,6 +121,13 @@ class Benchmark {
   const char* name_;
   const char* score_kind_;
   int64_t score_;
+  struct ExtraScore {
+    const char* suffix;
+    const char* kind;
+    int64_t value;
+  };
+  ExtraScore extra_scores_[kMaxExtraScores];
+  intptr_t num_extra_scores_ = 0;
   Dart_Isolate isolate_;
   Benchmark* next_;
 
@@ -5,6 +5,7 @@
 #include "vm/compiler/aot/aot_call_specializer.h"
 
 #include "vm/bit_vector.h"
+#include "vm/compiler/aot/aot_profile.h"
 #include "vm/compiler/aot/precompiler.h"
 #include "vm/compiler/backend/branch_optimizer.h"
 #include "vm/compiler/backend/flow_graph_compiler.h"
@@ -34,8 +35,14 @@ namespace dart {
 DEFINE_FLAG(int,
             max_exhaustive_polymorphic_checks,
             5,
-            "If a call receiver is known to be of at most this many classes, "
-            "generate exhaustive class tests instead of a megamorphic call");
+            "If a call receiver is known to be of classes which fall into at "
+            "most this many class-id ranges with the same target, generate "
+            "exhaustive class tests instead of a megamorphic call");
+DEFINE_FLAG(int,
+            max_exhaustive_polymorphic_classes,
+            64,
+            "Maximum number of receiver classes to group into class-id "
+            "ranges for exhaustive class tests");
 
 // Quick access to the current isolate and zone.
 #define IG (isolate_group())
@@ -869,7 +876,7 @@ void AotCallSpecializer::VisitInstanceCall(InstanceCallInstr* instr) {
 
           // The call does not resolve to a single target within the hierarchy.
           // If we have too many subclasses abort the optimization.
-          if (class_ids.length() > FLAG_max_exhaustive_polymorphic_checks) {
+          if (class_ids.length() > FLAG_max_exhaustive_polymorphic_classes) {
             single_target = Function::null();
             break;
           }
@@ -918,13 +925,20 @@ void AotCallSpecializer::VisitInstanceCall(InstanceCallInstr* instr) {
         return;
       } else if ((ic_data.ptr() != ICData::null()) &&
                  !ic_data.NumberOfChecksIs(0)) {
-        const CallTargets* targets = CallTargets::Create(Z, ic_data);
+        // Subclasses sharing a target usually have adjacent class ids, and
+        // the class ids in between belong to classes which inherit the same
+        // target or are abstract, so the class tests can check ranges. If
+        // there are still too many of them, the call goes through the
+        // dispatch table instead.
+        const CallTargets* targets = CallTargets::CreateAndExpand(Z, ic_data);
         ASSERT(!targets->is_empty());
-        PolymorphicInstanceCallInstr* call =
-            PolymorphicInstanceCallInstr::FromCall(Z, instr, *targets,
-                                                   /* complete = */ true);
-        instr->ReplaceWith(call, current_iterator());
-        return;
+        if (targets->length() <= FLAG_max_exhaustive_polymorphic_checks) {
+          PolymorphicInstanceCallInstr* call =
+              PolymorphicInstanceCallInstr::FromCall(Z, instr, *targets,
+                                                     /* complete = */ true);
+          instr->ReplaceWith(call, current_iterator());
+          return;
+        }
       }
     }
 
@@ -935,6 +949,10 @@ void AotCallSpecializer::VisitInstanceCall(InstanceCallInstr* instr) {
     }
   }
 
+  if (targets.is_empty() && TryReplaceWithProfiledTargets(instr)) {
+    return;
+  }
+
   // More than one target. Generate generic polymorphic call without
   // deoptimization.
   if (targets.length() > 0) {
@@ -949,6 +967,31 @@ void AotCallSpecializer::VisitInstanceCall(InstanceCallInstr* instr) {
   }
 }
 
+bool AotCallSpecializer::TryReplaceWithProfiledTargets(
+    InstanceCallInstr* instr) {
+  AotProfile* profile = AotProfile::Current();
+  if (profile == nullptr) {
+    return false;
+  }
+  // Calls inlined from other functions were visited in the graph of their
+  // function, which is where the profile applies.
+  if (instr->inlining_id() > 0) {
+    return false;
+  }
+  const CallTargets* targets =
+      profile->ReceiverTargets(Z, flow_graph()->function(), instr);
+  if (targets == nullptr) {
+    return false;
+  }
+  // Receivers that were not seen while training go through the instance
+  // call, so the call cannot be complete.
+  PolymorphicInstanceCallInstr* call =
+      PolymorphicInstanceCallInstr::FromCall(Z, instr, *targets,
+                                             /* complete = */ false);
+  instr->ReplaceWith(call, current_iterator());
+  return true;
+}
+
 void AotCallSpecializer::VisitStaticCall(StaticCallInstr* instr) {
   if (TryInlineFieldAccess(instr)) {
     return;
@@ -1183,6 +1226,9 @@ void AotCallSpecializer::TryReplaceWithDispatchTableCall(
   const Function& interface_target = InterfaceTargetForTableDispatch(call);
   if (interface_target.IsNull()) {
     // Dynamic call.
+    if (precompiler_ != nullptr) {
+      precompiler_->RecordDispatchSite(Precompiler::kDynamicSite);
+    }
     return;
   }
 
@@ -1211,6 +1257,7 @@ void AotCallSpecializer::TryReplaceWithDispatchTableCall(
   auto dispatch_table_call = DispatchTableCallInstr::FromCall(
       Z, call, new (Z) Value(load_cid), interface_target, selector);
   call->ReplaceWith(dispatch_table_call, current_iterator());
+  precompiler_->RecordDispatchSite(Precompiler::kDispatchTableSite);
 }
 
 #endif  // DART_PRECOMPILER
@@ -51,6 +51,10 @@ class AotCallSpecializer : public CallSpecializer {
 
   bool TryOptimizeInstanceCallUsingStaticTypes(InstanceCallInstr* instr);
 
+  // Speculates that the receiver of [instr] is of one of the classes seen
+  // at the call while training, if there is a profile.
+  bool TryReplaceWithProfiledTargets(InstanceCallInstr* instr);
+
   virtual bool TryOptimizeStaticCallUsingStaticTypes(StaticCallInstr* call);
 
   // If a call can be dispatched through the global dispatch table, replace
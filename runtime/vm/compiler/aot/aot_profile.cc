@@ -0,0 +1,434 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/aot/aot_profile.h"
+
+#include "platform/text_buffer.h"
+#include "vm/compiler/aot/precompiler.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/dart.h"
+#include "vm/flags.h"
+#include "vm/object.h"
+#include "vm/os.h"
+#include "vm/program_visitor.h"
+#include "vm/symbols.h"
+
+namespace dart {
+
+DEFINE_FLAG(charp,
+            write_aot_profile_to,
+            nullptr,
+            "Write a profile to guide AOT compilation to the given file when "
+            "an isolate shuts down");
+
+// Identifies [function] across a JIT training run and AOT compilation.
+static const char* FunctionKey(Zone* zone, const Function& function) {
+  const auto& script = Script::Handle(zone, function.script());
+  const auto& url =
+      String::Handle(zone, script.IsNull() ? String::null() : script.url());
+  const auto& name = String::Handle(zone, function.QualifiedScrubbedName());
+  return OS::SCreate(zone, "%s\t%" Pd32 "\t%s",
+                     url.IsNull() ? "" : url.ToCString(),
+                     function.token_pos().Serialize(), name.ToCString());
+}
+
+class AotProfileVisitor : public FunctionVisitor {
+ public:
+  AotProfileVisitor(Thread* thread, TextBuffer* buffer)
+      : zone_(thread->zone()),
+        class_table_(thread->isolate_group()->class_table()),
+        buffer_(buffer),
+        ic_data_array_(Array::Handle(zone_)),
+        edge_counters_(Array::Handle(zone_)),
+        code_(Code::Handle(zone_)),
+        descriptors_(PcDescriptors::Handle(zone_)),
+        cls_(Class::Handle(zone_)),
+        library_(Library::Handle(zone_)),
+        name_(String::Handle(zone_)),
+        cids_(zone_, 4),
+        counts_(zone_, 4) {}
+
+  void VisitFunction(const Function& function) {
+    if (!function.WasExecuted()) return;
+    ic_data_array_ = function.ic_data_array();
+    code_ = function.unoptimized_code();
+    if (ic_data_array_.IsNull() || code_.IsNull()) return;
+
+    buffer_->Printf("F\t%s\t%" Pd "\n", FunctionKey(zone_, function),
+                    Utils::Maximum<intptr_t>(0, function.usage_counter()));
+
+    // Calls are identified by source position rather than deopt id, which
+    // depends on how the graph was built.
+    auto deopt_id_to_ic_data = new (zone_) ZoneGrowableArray<const ICData*>();
+    function.RestoreICDataMap(deopt_id_to_ic_data, /*clone_ic_data=*/false);
+    descriptors_ = code_.pc_descriptors();
+    PcDescriptors::Iterator iter(descriptors_,
+                                 UntaggedPcDescriptors::kIcCall |
+                                     UntaggedPcDescriptors::kUnoptStaticCall);
+    while (iter.MoveNext()) {
+      if (iter.DeoptId() >= deopt_id_to_ic_data->length()) continue;
+      const ICData* ic_data = (*deopt_id_to_ic_data)[iter.DeoptId()];
+      if ((ic_data != nullptr) && iter.TokenPos().IsReal()) {
+        WriteCallSite(iter.TokenPos(), *ic_data);
+      }
+    }
+
+    edge_counters_ ^=
+        ic_data_array_.At(Function::ICDataArrayIndices::kEdgeCounters);
+    if (!edge_counters_.IsNull()) {
+      buffer_->AddString("B");
+      for (intptr_t i = 0; i < edge_counters_.Length(); i++) {
+        buffer_->Printf("\t%" Pd,
+                        Smi::Value(Smi::RawCast(edge_counters_.At(i))));
+      }
+      buffer_->AddString("\n");
+    }
+  }
+
+ private:
+  void WriteCallSite(TokenPosition token_pos, const ICData& ic_data) {
+    const intptr_t count = ic_data.AggregateCount();
+    if (count == 0) return;
+    name_ = ic_data.target_name();
+    buffer_->Printf("C\t%" Pd32 "\t%s\t%" Pd "\n", token_pos.Serialize(),
+                    String::ScrubName(name_), count);
+    if (ic_data.is_static_call() || (ic_data.NumArgsTested() == 0)) {
+      return;
+    }
+
+    // Checks on two arguments can repeat the receiver class.
+    cids_.Clear();
+    counts_.Clear();
+    for (intptr_t i = 0; i < ic_data.NumberOfChecks(); i++) {
+      const intptr_t cid = ic_data.GetReceiverClassIdAt(i);
+      intptr_t j = 0;
+      while ((j < cids_.length()) && (cids_[j] != cid)) {
+        j++;
+      }
+      if (j == cids_.length()) {
+        cids_.Add(cid);
+        counts_.Add(0);
+      }
+      counts_[j] += ic_data.GetCountAt(i);
+    }
+    for (intptr_t i = 0; i < cids_.length(); i++) {
+      if ((counts_[i] == 0) || !class_table_->HasValidClassAt(cids_[i])) {
+        continue;
+      }
+      cls_ = class_table_->At(cids_[i]);
+      library_ = cls_.library();
+      if (library_.IsNull()) continue;
+      name_ = library_.url();
+      buffer_->Printf("R\t%s\t", name_.ToCString());
+      name_ = cls_.ScrubbedName();
+      buffer_->Printf("%s\t%" Pd "\n", name_.ToCString(), counts_[i]);
+    }
+  }
+
+  Zone* const zone_;
+  ClassTable* const class_table_;
+  TextBuffer* const buffer_;
+  Array& ic_data_array_;
+  Array& edge_counters_;
+  Code& code_;
+  PcDescriptors& descriptors_;
+  Class& cls_;
+  Library& library_;
+  String& name_;
+  GrowableArray<intptr_t> cids_;
+  GrowableArray<intptr_t> counts_;
+
+  DISALLOW_COPY_AND_ASSIGN(AotProfileVisitor);
+};
+
+void AotProfileWriter::Write(Thread* thread, const char* filename) {
+  if ((Dart::file_write_callback() == nullptr) ||
+      (Dart::file_open_callback() == nullptr) ||
+      (Dart::file_close_callback() == nullptr)) {
+    OS::PrintErr("warning: Could not access file callbacks.");
+    return;
+  }
+
+  TextBuffer buffer(64 * KB);
+  Write(thread, &buffer);
+
+  void* file = Dart::file_open_callback()(filename, /*write=*/true);
+  if (file == nullptr) {
+    OS::PrintErr("warning: Failed to write AOT profile: %s\n", filename);
+    return;
+  }
+  const intptr_t length = buffer.length();
+  char* output = buffer.Steal();
+  Dart::file_write_callback()(output, length, file);
+  free(output);
+  Dart::file_close_callback()(file);
+}
+
+void AotProfileWriter::Write(Thread* thread, TextBuffer* buffer) {
+  AotProfileVisitor visitor(thread, buffer);
+  ProgramVisitor::WalkProgram(thread->zone(), thread->isolate_group(),
+                              &visitor);
+}
+
+#if defined(DART_PRECOMPILER)
+
+DEFINE_FLAG(charp,
+            read_aot_profile_from,
+            nullptr,
+            "Guide AOT compilation with the profile in the given file");
+
+const AotProfile::CallSite* AotProfile::FunctionProfile::LookupCall(
+    TokenPosition token_pos,
+    const String& selector) const {
+  const char* name = nullptr;
+  for (intptr_t i = 0; i < calls.length(); i++) {
+    if (calls[i]->token_pos != token_pos) continue;
+    if (name == nullptr) {
+      name = String::ScrubName(selector);
+    }
+    if (strcmp(calls[i]->selector, name) == 0) {
+      return calls[i];
+    }
+  }
+  return nullptr;
+}
+
+AotProfile* AotProfile::Load(Thread* thread, const char* filename) {
+  if (filename == nullptr) return nullptr;
+
+  if ((Dart::file_read_callback() == nullptr) ||
+      (Dart::file_open_callback() == nullptr) ||
+      (Dart::file_close_callback() == nullptr)) {
+    OS::PrintErr("warning: Could not access file callbacks.");
+    return nullptr;
+  }
+  void* file = Dart::file_open_callback()(filename, /*write=*/false);
+  if (file == nullptr) {
+    OS::PrintErr("warning: Failed to read AOT profile: %s\n", filename);
+    return nullptr;
+  }
+  uint8_t* data = nullptr;
+  intptr_t length = -1;
+  Dart::file_read_callback()(&data, &length, file);
+  Dart::file_close_callback()(file);
+  if ((data == nullptr) || (length < 0)) {
+    OS::PrintErr("warning: Failed to read AOT profile: %s\n", filename);
+    return nullptr;
+  }
+
+  Zone* zone = thread->zone();
+  char* contents = zone->Alloc<char>(length + 1);
+  memmove(contents, data, length);
+  contents[length] = '\0';
+  free(data);
+
+  AotProfile* profile = new (zone) AotProfile(zone);
+  if (!profile->Parse(thread, contents)) {
+    OS::PrintErr("warning: Malformed AOT profile: %s\n", filename);
+    return nullptr;
+  }
+  return profile;
+}
+
+AotProfile* AotProfile::Read(Thread* thread, const char* contents) {
+  Zone* zone = thread->zone();
+  AotProfile* profile = new (zone) AotProfile(zone);
+  if (!profile->Parse(thread, zone->MakeCopyOfString(contents))) {
+    return nullptr;
+  }
+  return profile;
+}
+
+AotProfile* AotProfile::current_for_testing_ = nullptr;
+
+AotProfile* AotProfile::Current() {
+  Precompiler* precompiler = Precompiler::Instance();
+  return (precompiler == nullptr) ? current_for_testing_
+                                  : precompiler->profile();
+}
+
+void AotProfile::SetCurrentForTesting(AotProfile* profile) {
+  current_for_testing_ = profile;
+}
+
+// Splits off the next tab separated field of [*cursor].
+static char* NextField(char** cursor) {
+  char* field = *cursor;
+  if (field == nullptr) return nullptr;
+  char* end = strchr(field, '\t');
+  if (end != nullptr) {
+    *end = '\0';
+    *cursor = end + 1;
+  } else {
+    *cursor = nullptr;
+  }
+  return field;
+}
+
+static bool ParseInt(const char* field, int64_t* value) {
+  return (field != nullptr) && (*field != '\0') &&
+         OS::StringToInt64(field, value);
+}
+
+bool AotProfile::Parse(Thread* thread, char* contents) {
+  const auto& class_table = *thread->isolate_group()->class_table();
+  auto& url = String::Handle(zone_);
+  auto& name = String::Handle(zone_);
+  auto& library = Library::Handle(zone_);
+  auto& cls = Class::Handle(zone_);
+
+  FunctionProfile* function = nullptr;
+  CallSite* call = nullptr;
+  char* next = nullptr;
+  for (char* line = contents; line != nullptr; line = next) {
+    next = strchr(line, '\n');
+    if (next != nullptr) {
+      *next++ = '\0';
+    }
+    char* cursor = line;
+    const char* kind = NextField(&cursor);
+    int64_t value = 0;
+    int64_t count = 0;
+    if ((kind[0] == '\0') || (kind[0] == '#')) {
+      // Empty line or comment.
+    } else if (strcmp(kind, "F") == 0) {
+      const char* script = NextField(&cursor);
+      const char* token_pos = NextField(&cursor);
+      const char* qualified_name = NextField(&cursor);
+      if ((qualified_name == nullptr) ||
+          !ParseInt(NextField(&cursor), &count)) {
+        return false;
+      }
+      const char* key = OS::SCreate(zone_, "%s\t%s\t%s", script, token_pos,
+                                    qualified_name);
+      function = new (zone_) FunctionProfile(zone_, count);
+      function_ids_.Update({key, functions_.length()});
+      functions_.Add(function);
+      call = nullptr;
+    } else if (strcmp(kind, "C") == 0) {
+      if (function == nullptr) return false;
+      if (!ParseInt(NextField(&cursor), &value)) return false;
+      const char* selector = NextField(&cursor);
+      if (!ParseInt(NextField(&cursor), &count)) return false;
+      call = new (zone_) CallSite(
+          zone_, TokenPosition::Deserialize(static_cast<int32_t>(value)),
+          selector, count);
+      function->calls.Add(call);
+    } else if (strcmp(kind, "R") == 0) {
+      if (call == nullptr) return false;
+      const char* library_url = NextField(&cursor);
+      const char* class_name = NextField(&cursor);
+      if ((class_name == nullptr) || !ParseInt(NextField(&cursor), &count)) {
+        return false;
+      }
+      // Classes that no longer exist are dropped.
+      url = String::New(library_url);
+      library = Library::LookupLibrary(thread, url);
+      if (library.IsNull()) continue;
+      name = Symbols::New(thread, class_name);
+      cls = library.LookupClassAllowPrivate(name);
+      if (cls.IsNull() || !class_table.HasValidClassAt(cls.id())) continue;
+      call->receivers.Add({cls.id(), static_cast<intptr_t>(count)});
+    } else if (strcmp(kind, "B") == 0) {
+      if (function == nullptr) return false;
+      while (cursor != nullptr) {
+        if (!ParseInt(NextField(&cursor), &count)) return false;
+        function->edge_counters.Add(count);
+      }
+    } else {
+      return false;
+    }
+  }
+  return true;
+}
+
+const AotProfile::FunctionProfile* AotProfile::Lookup(
+    const Function& function) const {
+  const intptr_t id =
+      function_ids_.LookupValue(FunctionKey(zone_, function));
+  return (id == CStringIntMapKeyValueTrait::kNoValue) ? nullptr
+                                                      : functions_[id];
+}
+
+intptr_t AotProfile::CallCount(const Function& owner,
+                               TokenPosition token_pos,
+                               const String& selector) const {
+  const FunctionProfile* function = Lookup(owner);
+  if (function == nullptr) return -1;
+  const CallSite* call = function->LookupCall(token_pos, selector);
+  return (call == nullptr) ? 0 : call->count;
+}
+
+const CallTargets* AotProfile::ReceiverTargets(Zone* zone,
+                                               const Function& owner,
+                                               InstanceCallInstr* call) const {
+  const FunctionProfile* function = Lookup(owner);
+  if (function == nullptr) return nullptr;
+  const CallSite* site =
+      function->LookupCall(call->token_pos(), call->function_name());
+  if ((site == nullptr) || site->receivers.is_empty()) return nullptr;
+
+  ClassTable* class_table = IsolateGroup::Current()->class_table();
+  const Array& arguments_descriptor =
+      Array::Handle(zone, call->GetArgumentsDescriptor());
+  const ICData& ic_data = ICData::Handle(
+      zone, ICData::New(owner, call->function_name(), arguments_descriptor,
+                        DeoptId::kNone, /*num_args_tested=*/1,
+                        ICData::kOptimized));
+  auto& cls = Class::Handle(zone);
+  auto& target = Function::Handle(zone);
+  for (const Receiver& receiver : site->receivers) {
+    cls = class_table->At(receiver.cid);
+    if (!cls.is_finalized() || cls.is_abstract()) continue;
+    target = call->ResolveForReceiverClass(cls);
+    if (target.IsNull()) continue;
+    ic_data.AddReceiverCheck(receiver.cid, target, receiver.count);
+  }
+  if (ic_data.NumberOfChecksIs(0)) return nullptr;
+  const CallTargets* targets = CallTargets::Create(zone, ic_data);
+  return targets->is_empty() ? nullptr : targets;
+}
+
+ArrayPtr AotProfile::EdgeCounters(const Function& function,
+                                  intptr_t num_blocks) const {
+  const FunctionProfile* profile = Lookup(function);
+  if ((profile == nullptr) ||
+      (profile->edge_counters.length() != num_blocks)) {
+    return Array::null();
+  }
+  const Array& counters = Array::Handle(Array::New(num_blocks, Heap::kOld));
+  for (intptr_t i = 0; i < num_blocks; i++) {
+    const intptr_t count = Utils::Minimum<intptr_t>(
+        profile->edge_counters[i], Smi::kMaxValue);
+    counters.SetAt(i, Smi::Handle(Smi::New(count)));
+  }
+  return counters.ptr();
+}
+
+class UsageCounterVisitor : public FunctionVisitor {
+ public:
+  explicit UsageCounterVisitor(const AotProfile* profile)
+      : profile_(profile) {}
+
+  void VisitFunction(const Function& function) {
+    const AotProfile::FunctionProfile* profile = profile_->Lookup(function);
+    function.SetUsageCounter(
+        (profile == nullptr)
+            ? 0
+            : Utils::Minimum<intptr_t>(profile->usage_counter, kMaxInt32));
+  }
+
+ private:
+  const AotProfile* const profile_;
+};
+
+void AotProfile::ApplyUsageCounters(Thread* thread) const {
+  UsageCounterVisitor visitor(this);
+  ProgramVisitor::WalkProgram(thread->zone(), thread->isolate_group(),
+                              &visitor);
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
@@ -0,0 +1,153 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_AOT_AOT_PROFILE_H_
+#define RUNTIME_VM_COMPILER_AOT_AOT_PROFILE_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+#include "vm/growable_array.h"
+#include "vm/hash_map.h"
+#include "vm/tagged_pointer.h"
+#include "vm/token_position.h"
+
+namespace dart {
+
+class Array;
+class CallTargets;
+class Function;
+class InstanceCallInstr;
+class String;
+class TextBuffer;
+class Thread;
+
+// Profiles collected by a JIT training run to guide AOT compilation.
+//
+// The profile is a text file with one record per line and tab separated
+// fields. Every function that was executed while training starts with
+//
+//   F <script url> <token pos> <qualified name> <usage counter>
+//
+// and is followed by its call sites, each with the receiver classes that
+// were seen at instance calls, and the edge counters of its unoptimized
+// code indexed by block preorder number:
+//
+//   C <token pos> <selector> <count>
+//   R <library url> <class name> <count>
+//   B <count> <count> ...
+//
+// Functions, selectors and classes are identified by their scrubbed names
+// and source positions, which are the same for the JIT and the AOT compiler
+// as long as both consume the same program.
+class AotProfileWriter : public AllStatic {
+ public:
+  // Writes the profile of all functions executed in [thread]'s isolate
+  // group to [filename].
+  static void Write(Thread* thread, const char* filename);
+
+  // Appends the same profile to [buffer].
+  static void Write(Thread* thread, TextBuffer* buffer);
+};
+
+#if defined(DART_PRECOMPILER)
+
+class AotProfile : public ZoneAllocated {
+ public:
+  struct Receiver {
+    intptr_t cid;
+    intptr_t count;
+  };
+
+  class CallSite : public ZoneAllocated {
+   public:
+    CallSite(Zone* zone,
+             TokenPosition token_pos,
+             const char* selector,
+             intptr_t count)
+        : token_pos(token_pos),
+          selector(selector),
+          count(count),
+          receivers(zone, 0) {}
+
+    const TokenPosition token_pos;
+    const char* const selector;
+    const intptr_t count;
+    GrowableArray<Receiver> receivers;
+  };
+
+  class FunctionProfile : public ZoneAllocated {
+   public:
+    FunctionProfile(Zone* zone, intptr_t usage_counter)
+        : usage_counter(usage_counter),
+          calls(zone, 0),
+          edge_counters(zone, 0) {}
+
+    // Returns the call site at [token_pos] invoking [selector], if any.
+    const CallSite* LookupCall(TokenPosition token_pos,
+                               const String& selector) const;
+
+    const intptr_t usage_counter;
+    GrowableArray<CallSite*> calls;
+    GrowableArray<intptr_t> edge_counters;
+  };
+
+  // Reads the profile in [filename], resolving the classes it refers to in
+  // the current program. Returns nullptr if the file cannot be read.
+  static AotProfile* Load(Thread* thread, const char* filename);
+
+  // Reads the profile in [contents]. Returns nullptr if it is malformed.
+  static AotProfile* Read(Thread* thread, const char* contents);
+
+  // Returns the profile guiding the current precompilation, if any.
+  static AotProfile* Current();
+
+  // Makes [profile] guide compilations outside of a precompilation, for
+  // tests which run AOT passes without the precompiler. nullptr resets it.
+  static void SetCurrentForTesting(AotProfile* profile);
+
+  // Returns the profile of [function], or nullptr if it did not run while
+  // training.
+  const FunctionProfile* Lookup(const Function& function) const;
+
+  // Returns the number of times the call at [token_pos] invoking [selector]
+  // in [owner] was executed while training, or -1 if [owner] did not run.
+  intptr_t CallCount(const Function& owner,
+                     TokenPosition token_pos,
+                     const String& selector) const;
+
+  // Returns the targets of [call] in [owner] for the receiver classes seen
+  // while training, most frequent first, or nullptr if there were none.
+  const CallTargets* ReceiverTargets(Zone* zone,
+                                     const Function& owner,
+                                     InstanceCallInstr* call) const;
+
+  // Returns edge counters for the [num_blocks] blocks of a graph built for
+  // [function], or a null array if there are none for a graph of that size.
+  ArrayPtr EdgeCounters(const Function& function, intptr_t num_blocks) const;
+
+  // Sets the usage counter of every function in the program to its usage
+  // counter in the profile, or to 0 if it did not run while training.
+  void ApplyUsageCounters(Thread* thread) const;
+
+ private:
+  explicit AotProfile(Zone* zone)
+      : zone_(zone), functions_(zone, 0), function_ids_(zone) {}
+
+  bool Parse(Thread* thread, char* contents);
+
+  static AotProfile* current_for_testing_;
+
+  Zone* const zone_;
+  GrowableArray<FunctionProfile*> functions_;
+  CStringIntMap function_ids_;
+};
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_AOT_AOT_PROFILE_H_
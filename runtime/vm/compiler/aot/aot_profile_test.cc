@@ -0,0 +1,226 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/aot/aot_profile.h"
+
+#include "platform/text_buffer.h"
+#include "vm/compiler/backend/block_scheduler.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+#if defined(DART_PRECOMPILER)
+
+static const char* kTrainingScript = R"(
+    abstract class Base {
+      int m();
+    }
+    class A implements Base {
+      int m() => 1;
+    }
+    class B implements Base {
+      int m() => 2;
+    }
+    class C implements Base {
+      int m() => 3;
+    }
+
+    int callM(Base o) => o.m();
+    int unused() => 0;
+
+    main() {
+      final receivers = <Base>[A(), A(), A(), B()];
+      for (int i = 0; i < 10; i++) {
+        for (final o in receivers) {
+          callM(o);
+        }
+      }
+    }
+  )";
+
+// Runs main of [lib] in the JIT, then reads back the profile it produced.
+static AotProfile* TrainAndReadProfile(Thread* thread, const Library& lib) {
+  Invoke(lib, "main");
+  TextBuffer buffer(1 * KB);
+  AotProfileWriter::Write(thread, &buffer);
+  return AotProfile::Read(thread, buffer.buffer());
+}
+
+ISOLATE_UNIT_TEST_CASE(AotProfile_RoundTrip) {
+  const auto& root_library = Library::Handle(LoadTestScript(kTrainingScript));
+  AotProfile* profile = TrainAndReadProfile(thread, root_library);
+  EXPECT(profile != nullptr);
+
+  const auto& call_m = Function::Handle(GetFunction(root_library, "callM"));
+  const AotProfile::FunctionProfile* function = profile->Lookup(call_m);
+  EXPECT(function != nullptr);
+  EXPECT(function->usage_counter > 0);
+
+  const AotProfile::CallSite* call = nullptr;
+  for (intptr_t i = 0; i < function->calls.length(); i++) {
+    if (strcmp(function->calls[i]->selector, "m") == 0) {
+      call = function->calls[i];
+    }
+  }
+  EXPECT(call != nullptr);
+  EXPECT_EQ(40, call->count);
+  EXPECT_EQ(40, profile->CallCount(call_m, call->token_pos,
+                                   String::Handle(Symbols::New(thread, "m"))));
+
+  const auto& class_a = Class::Handle(GetClass(root_library, "A"));
+  const auto& class_b = Class::Handle(GetClass(root_library, "B"));
+  EXPECT_EQ(2, call->receivers.length());
+  for (const AotProfile::Receiver& receiver : call->receivers) {
+    if (receiver.cid == class_a.id()) {
+      EXPECT_EQ(30, receiver.count);
+    } else {
+      EXPECT_EQ(class_b.id(), receiver.cid);
+      EXPECT_EQ(10, receiver.count);
+    }
+  }
+
+  // Functions which did not run while training have no profile.
+  const auto& unused = Function::Handle(GetFunction(root_library, "unused"));
+  EXPECT(profile->Lookup(unused) == nullptr);
+  EXPECT_EQ(-1, profile->CallCount(unused, call->token_pos,
+                                   String::Handle(Symbols::New(thread, "m"))));
+
+  EXPECT(AotProfile::Read(thread, "X\tunknown record\n") == nullptr);
+  EXPECT(AotProfile::Read(thread, "C\t0\tm\t1\n") == nullptr);
+}
+
+ISOLATE_UNIT_TEST_CASE(AotProfile_PolymorphicInliningWithFallback) {
+  const auto& root_library = Library::Handle(LoadTestScript(kTrainingScript));
+  AotProfile* profile = TrainAndReadProfile(thread, root_library);
+  EXPECT(profile != nullptr);
+  AotProfile::SetCurrentForTesting(profile);
+
+  const auto& function = Function::Handle(GetFunction(root_library, "callM"));
+  const auto& class_a = Class::Handle(GetClass(root_library, "A"));
+  const auto& class_b = Class::Handle(GetClass(root_library, "B"));
+
+  {
+    // The call cannot be devirtualized, so it is specialized on the
+    // receivers seen while training, and others still have to be handled.
+    TestPipeline pipeline(function, CompilerPass::kAOT);
+    FlowGraph* flow_graph = pipeline.RunPasses({
+        CompilerPass::kComputeSSA,
+        CompilerPass::kApplyICData,
+    });
+
+    PolymorphicInstanceCallInstr* call = nullptr;
+    ILMatcher cursor(flow_graph, flow_graph->graph_entry()->normal_entry());
+    RELEASE_ASSERT(cursor.TryMatch({
+        kMoveGlob,
+        {kMatchAndMovePolymorphicInstanceCall, &call},
+    }));
+    EXPECT(!call->complete());
+    EXPECT_EQ(2, call->targets().length());
+    EXPECT_EQ(class_a.id(), call->targets()[0].cid_start);
+    EXPECT_EQ(class_b.id(), call->targets()[1].cid_start);
+  }
+
+  {
+    TestPipeline pipeline(function, CompilerPass::kAOT);
+    FlowGraph* flow_graph = pipeline.RunPasses({
+        CompilerPass::kComputeSSA,
+        CompilerPass::kApplyICData,
+        CompilerPass::kTryOptimizePatterns,
+        CompilerPass::kSetOuterInliningId,
+        CompilerPass::kTypePropagation,
+        CompilerPass::kApplyClassIds,
+        CompilerPass::kInlining,
+    });
+
+    // Both targets are inlined behind class id checks, followed by a call
+    // for other receivers instead of a deoptimization.
+    intptr_t static_calls = 0;
+    intptr_t class_id_loads = 0;
+    PolymorphicInstanceCallInstr* fallback = nullptr;
+    for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+         !block_it.Done(); block_it.Advance()) {
+      for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+           it.Advance()) {
+        Instruction* current = it.Current();
+        if (current->IsPolymorphicInstanceCall()) {
+          EXPECT(fallback == nullptr);
+          fallback = current->AsPolymorphicInstanceCall();
+        } else if (current->IsStaticCall()) {
+          static_calls++;
+        } else if (current->IsLoadClassId()) {
+          class_id_loads++;
+        }
+      }
+    }
+    EXPECT_EQ(0, static_calls);
+    EXPECT_EQ(1, class_id_loads);
+    EXPECT(fallback != nullptr);
+    EXPECT(!fallback->complete());
+    EXPECT_EQ(0, fallback->targets().length());
+  }
+
+  AotProfile::SetCurrentForTesting(nullptr);
+}
+
+// Returns a profile with the edge counters [count, ...] of [num_blocks]
+// blocks for [function].
+static AotProfile* EdgeCountersProfile(Thread* thread,
+                                       const Function& function,
+                                       intptr_t num_blocks,
+                                       intptr_t count) {
+  const auto& script = Script::Handle(function.script());
+  const auto& url = String::Handle(script.url());
+  const auto& name = String::Handle(function.QualifiedScrubbedName());
+  TextBuffer buffer(256);
+  buffer.Printf("F\t%s\t%" Pd32 "\t%s\t1\nB", url.ToCString(),
+                function.token_pos().Serialize(), name.ToCString());
+  for (intptr_t i = 0; i < num_blocks; i++) {
+    buffer.Printf("\t%" Pd, count);
+  }
+  buffer.AddString("\n");
+  return AotProfile::Read(thread, buffer.buffer());
+}
+
+ISOLATE_UNIT_TEST_CASE(AotProfile_EdgeCountersNeedMatchingBlocks) {
+  const char* kScript = R"(
+    int branch(int x) {
+      if (x > 0) return 1;
+      return 2;
+    }
+  )";
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "branch"));
+
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  FlowGraph* flow_graph = pipeline.RunPasses({CompilerPass::kComputeSSA});
+  const intptr_t num_blocks = flow_graph->preorder().length();
+
+  AotProfile* profile =
+      EdgeCountersProfile(thread, function, num_blocks, /*count=*/10);
+  EXPECT(profile != nullptr);
+  EXPECT(!Array::Handle(profile->EdgeCounters(function, num_blocks)).IsNull());
+  AotProfile::SetCurrentForTesting(profile);
+  flow_graph->graph_entry()->set_entry_count(0);
+  BlockScheduler::AssignEdgeWeights(flow_graph);
+  EXPECT_EQ(10, flow_graph->graph_entry()->entry_count());
+
+  // Counters collected on a graph with a different number of blocks cannot
+  // be matched to the blocks of this one, and are ignored.
+  profile = EdgeCountersProfile(thread, function, num_blocks + 1, 10);
+  EXPECT(profile != nullptr);
+  EXPECT(Array::Handle(profile->EdgeCounters(function, num_blocks)).IsNull());
+  AotProfile::SetCurrentForTesting(profile);
+  flow_graph->graph_entry()->set_entry_count(0);
+  BlockScheduler::AssignEdgeWeights(flow_graph);
+  EXPECT_EQ(0, flow_graph->graph_entry()->entry_count());
+
+  AotProfile::SetCurrentForTesting(nullptr);
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
@@ -11,9 +11,11 @@
 #include "vm/closure_functions_cache.h"
 #include "vm/code_patcher.h"
 #include "vm/compiler/aot/aot_call_specializer.h"
+#include "vm/compiler/aot/aot_profile.h"
 #include "vm/compiler/aot/precompiler_tracer.h"
 #include "vm/compiler/assembler/assembler.h"
 #include "vm/compiler/assembler/disassembler.h"
+#include "vm/compiler/backend/block_scheduler.h"
 #include "vm/compiler/backend/branch_optimizer.h"
 #include "vm/compiler/backend/constant_propagator.h"
 #include "vm/compiler/backend/flow_graph.h"
@@ -72,11 +74,26 @@ DEFINE_FLAG(charp,
             nullptr,
             "Print layout of Dart objects to the given file");
 DEFINE_FLAG(bool, trace_precompiler, false, "Trace precompiler.");
+DEFINE_FLAG(bool,
+            print_dispatch_coverage,
+            false,
+            "Print how instance call sites are dispatched in precompiled "
+            "code");
+DEFINE_FLAG(bool,
+            print_spill_stats,
+            false,
+            "Print the number and size of spills and reloads emitted for "
+            "each precompiled function");
 DEFINE_FLAG(
     int,
     max_speculative_inlining_attempts,
     1,
     "Max number of attempts with speculative inlining (precompilation only)");
+DEFINE_FLAG(bool,
+            profile_guided_code_layout,
+            true,
+            "Lay out the code of functions that ran while collecting "
+            "--read_aot_profile_from together, hottest in the middle");
 DEFINE_FLAG(charp,
             write_retained_reasons_to,
             nullptr,
@@ -98,6 +115,7 @@ DECLARE_FLAG(int, inlining_caller_size_threshold);
 DECLARE_FLAG(int, inlining_constant_arguments_max_size_threshold);
 DECLARE_FLAG(int, inlining_constant_arguments_min_size_threshold);
 DECLARE_FLAG(bool, print_instruction_stats);
+DECLARE_FLAG(charp, read_aot_profile_from);
 
 Precompiler* Precompiler::singleton_ = nullptr;
 
@@ -472,6 +490,8 @@ void Precompiler::DoCompileAll() {
       FinalizeAllClasses();
       ASSERT(Error::Handle(Z, T->sticky_error()).IsNull());
 
+      profile_ = AotProfile::Load(T, FLAG_read_aot_profile_from);
+
       if (FLAG_print_object_layout_to != nullptr) {
         IG->class_table()->PrintObjectLayout(FLAG_print_object_layout_to);
       }
@@ -602,6 +622,12 @@ void Precompiler::DoCompileAll() {
       FinalizeDispatchTable();
       ReplaceFunctionStaticCallEntries();
 
+      if ((profile_ != nullptr) && FLAG_profile_guided_code_layout) {
+        // The snapshot writer orders code by the usage counters of its
+        // owners, as the profile is gone by then.
+        profile_->ApplyUsageCounters(T);
+      }
+
       {
         PRECOMPILER_TIMER_SCOPE(this, Drop);
 
@@ -664,6 +690,7 @@ void Precompiler::DoCompileAll() {
       retained_reasons_writer_ = nullptr;
     }
 
+    profile_ = nullptr;
     zone_ = NULL;
   }
 
@@ -674,6 +701,10 @@ void Precompiler::DoCompileAll() {
     Symbols::GetStats(IG, &symbols_before, &capacity);
   }
 
+  if (FLAG_print_dispatch_coverage) {
+    PrintDispatchCoverage();
+  }
+
   if (FLAG_trace_precompiler) {
     Symbols::GetStats(IG, &symbols_after, &capacity);
     THR_Print("Precompiled %" Pd " functions,", function_count_);
@@ -692,6 +723,46 @@ void Precompiler::DoCompileAll() {
   }
 }
 
+void Precompiler::DiscardDispatchSites() {
+  for (intptr_t i = 0; i < kNumDispatchSiteKinds; i++) {
+    pending_dispatch_sites_[i] = 0;
+  }
+}
+
+void Precompiler::CommitDispatchSites() {
+  for (intptr_t i = 0; i < kNumDispatchSiteKinds; i++) {
+    dispatch_sites_[i] += pending_dispatch_sites_[i];
+    pending_dispatch_sites_[i] = 0;
+  }
+}
+
+void Precompiler::PrintDispatchCoverage() {
+  static const char* const kNames[kNumDispatchSiteKinds] = {
+      "ClassIdSwitch",
+      "DispatchTable",
+      "Dynamic",
+  };
+  intptr_t total = 0;
+  for (intptr_t i = 0; i < kNumDispatchSiteKinds; i++) {
+    total += dispatch_sites_[i];
+  }
+  TextBuffer buffer(256);
+  buffer.Printf("%25s", "Dispatch");
+  buffer.Printf(" %8s", "Sites");
+  buffer.Printf(" %8s", "Fraction");
+  buffer.AddString("\n");
+  for (intptr_t i = 0; i < kNumDispatchSiteKinds; i++) {
+    const double fraction =
+        (total == 0) ? 0.0
+                     : static_cast<double>(dispatch_sites_[i]) / total;
+    buffer.Printf("%25s", kNames[i]);
+    buffer.Printf(" %8" Pd "", dispatch_sites_[i]);
+    buffer.Printf(" %1.6lf", fraction);
+    buffer.AddString("\n");
+  }
+  OS::PrintErr("%s", buffer.buffer());
+}
+
 void Precompiler::PrecompileConstructors() {
   PRECOMPILER_TIMER_SCOPE(this, PrecompileConstructors);
   class ConstructorVisitor : public FunctionVisitor {
@@ -3100,6 +3171,7 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
     LongJumpScope jump;
     const intptr_t val = setjmp(*jump.Set());
     if (val == 0) {
+      precompiler_->DiscardDispatchSites();
       FlowGraph* flow_graph = nullptr;
       ZoneGrowableArray<const ICData*>* ic_data_array = nullptr;
       const Function& function = parsed_function()->function();
@@ -3120,6 +3192,7 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
 
       if (optimized()) {
         flow_graph->PopulateWithICData(function);
+        BlockScheduler::AssignEdgeWeights(flow_graph);
       }
 
       const bool print_flow_graph =
@@ -3183,7 +3256,7 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
       compiler::Assembler assembler(&object_pool_builder, far_branch_level);
 
       CodeStatistics* function_stats = NULL;
-      if (FLAG_print_instruction_stats) {
+      if (FLAG_print_instruction_stats || FLAG_print_spill_stats) {
         // At the moment we are leaking CodeStatistics objects for
         // simplicity because this is just a development mode flag.
         function_stats = new CodeStatistics(&assembler);
@@ -3241,6 +3314,15 @@ bool PrecompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
         done = false;
         continue;
       }
+      if (FLAG_print_spill_stats) {
+        THR_Print("spills %s: %" Pd " spills (%" Pd " bytes), %" Pd
+                  " reloads (%" Pd " bytes)\n",
+                  function.ToFullyQualifiedCString(),
+                  function_stats->spill_count(), function_stats->spill_bytes(),
+                  function_stats->reload_count(),
+                  function_stats->reload_bytes());
+      }
+      precompiler_->CommitDispatchSites();
       // Exit the loop and the function with the correct result value.
       is_compiled = true;
       done = true;
@@ -21,6 +21,7 @@
 namespace dart {
 
 // Forward declarations.
+class AotProfile;
 class Class;
 class Error;
 class Field;
@@ -268,6 +269,29 @@ class Precompiler : public ValueObject {
 
   bool is_tracing() const { return is_tracing_; }
 
+  // Profile of a JIT training run guiding compilation, if any.
+  AotProfile* profile() const { return profile_; }
+
+  // How an instance call site is dispatched in the generated code.
+  enum DispatchSiteKind {
+    // All targets are inlined behind a class-id switch.
+    kClassIdSwitchSite,
+    // Called through the global dispatch table.
+    kDispatchTableSite,
+    // Called through a switchable call.
+    kDynamicSite,
+    kNumDispatchSiteKinds,
+  };
+
+  // Counts a dispatch site of the function being compiled. The counts are
+  // only added to the totals reported by --print_dispatch_coverage once the
+  // compilation succeeds, as it may be retried.
+  void RecordDispatchSite(DispatchSiteKind kind) {
+    pending_dispatch_sites_[kind]++;
+  }
+  void DiscardDispatchSites();
+  void CommitDispatchSites();
+
   Thread* thread() const { return thread_; }
   Zone* zone() const { return zone_; }
   Isolate* isolate() const { return isolate_; }
@@ -295,6 +319,7 @@ class Precompiler : public ValueObject {
   ~Precompiler();
 
   void ReportStats();
+  void PrintDispatchCoverage();
 
   void DoCompileAll();
   void AddRoots();
@@ -370,6 +395,8 @@ class Precompiler : public ValueObject {
   intptr_t dropped_functiontype_count_;
   intptr_t dropped_typeparam_count_;
   intptr_t dropped_library_count_;
+  intptr_t dispatch_sites_[kNumDispatchSiteKinds] = {};
+  intptr_t pending_dispatch_sites_[kNumDispatchSiteKinds] = {};
 
   compiler::ObjectPoolBuilder global_object_pool_builder_;
   GrowableObjectArray& libraries_;
@@ -397,6 +424,7 @@ class Precompiler : public ValueObject {
   Phase phase_ = Phase::kPreparation;
   PrecompilerTracer* tracer_ = nullptr;
   RetainedReasonsWriter* retained_reasons_writer_ = nullptr;
+  AotProfile* profile_ = nullptr;
   bool is_tracing_ = false;
 };
 
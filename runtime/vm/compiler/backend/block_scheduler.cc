@@ -6,6 +6,7 @@
 
 #include "vm/allocation.h"
 #include "vm/code_patcher.h"
+#include "vm/compiler/aot/aot_profile.h"
 #include "vm/compiler/backend/flow_graph.h"
 #include "vm/compiler/jit/compiler.h"
 
@@ -50,21 +51,30 @@ void BlockScheduler::AssignEdgeWeights(FlowGraph* flow_graph) {
   if (!FLAG_reorder_basic_blocks) {
     return;
   }
-  if (CompilerState::Current().is_aot()) {
-    return;
-  }
 
   const Function& function = flow_graph->parsed_function().function();
-  const Array& ic_data_array =
-      Array::Handle(flow_graph->zone(), function.ic_data_array());
-  if (ic_data_array.IsNull()) {
-    DEBUG_ASSERT(IsolateGroup::Current()->HasAttemptedReload() ||
-                 function.ForceOptimize());
-    return;
-  }
   Array& edge_counters = Array::Handle();
-  edge_counters ^=
-      ic_data_array.At(Function::ICDataArrayIndices::kEdgeCounters);
+  if (CompilerState::Current().is_aot()) {
+#if defined(DART_PRECOMPILER)
+    // Counters of a training run only apply if the graph has the same shape
+    // as the unoptimized graph they were collected for.
+    AotProfile* profile = AotProfile::Current();
+    if (profile != nullptr) {
+      edge_counters =
+          profile->EdgeCounters(function, flow_graph->preorder().length());
+    }
+#endif  // defined(DART_PRECOMPILER)
+  } else {
+    const Array& ic_data_array =
+        Array::Handle(flow_graph->zone(), function.ic_data_array());
+    if (ic_data_array.IsNull()) {
+      DEBUG_ASSERT(IsolateGroup::Current()->HasAttemptedReload() ||
+                   function.ForceOptimize());
+      return;
+    }
+    edge_counters ^=
+        ic_data_array.At(Function::ICDataArrayIndices::kEdgeCounters);
+  }
   if (edge_counters.IsNull()) {
     return;
   }
@@ -156,7 +166,9 @@ static void Union(GrowableArray<Chain*>* chains,
 }
 
 void BlockScheduler::ReorderBlocks(FlowGraph* flow_graph) {
-  if (CompilerState::Current().is_aot()) {
+  // AOT graphs only have edge weights if a training profile provided them.
+  if (CompilerState::Current().is_aot() &&
+      (flow_graph->graph_entry()->entry_count() == 0)) {
     ReorderBlocksAOT(flow_graph);
   } else {
     ReorderBlocksJIT(flow_graph);
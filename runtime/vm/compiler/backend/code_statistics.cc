@@ -12,6 +12,8 @@ CombinedCodeStatistics::CombinedCodeStatistics() {
   object_header_bytes_ = 0;
   return_const_count_ = 0;
   return_const_with_load_field_count_ = 0;
+  spills_ = {"spills", 0, 0};
+  reloads_ = {"reloads", 0, 0};
   intptr_t i = 0;
 
 #define DO(type, attrs)                                                        \
@@ -105,6 +107,12 @@ void CombinedCodeStatistics::DumpStatistics() {
   OS::PrintErr("% 8" Pd " return-constant-with-load-field functions\n",
                return_const_with_load_field_count_);
   OS::PrintErr("--------------------\n");
+  for (const Entry* entry : {&spills_, &reloads_}) {
+    OS::PrintErr("%5.2f %% % 8" Pd " bytes % 8" Pd " count    -    %s\n",
+                 entry->bytes / ftotal, entry->bytes, entry->count,
+                 entry->name);
+  }
+  OS::PrintErr("--------------------\n");
 }
 
 int CombinedCodeStatistics::CompareEntries(const void* a, const void* b) {
@@ -129,6 +137,10 @@ CodeStatistics::CodeStatistics(compiler::Assembler* assembler)
   stack_index_ = -1;
   for (intptr_t i = 0; i < kStackSize; i++)
     stack_[i] = -1;
+
+  move_start_ = -1;
+  spills_ = {0, 0};
+  reloads_ = {0, 0};
 }
 
 void CodeStatistics::Begin(Instruction* instruction) {
@@ -163,6 +175,31 @@ void CodeStatistics::SpecialEnd(intptr_t tag) {
   stack_index_--;
 }
 
+void CodeStatistics::MoveBegin() {
+  RELEASE_ASSERT(move_start_ == -1);
+  move_start_ = assembler_->CodeSize();
+}
+
+void CodeStatistics::MoveEnd(Location dst, Location src) {
+  RELEASE_ASSERT(move_start_ >= 0);
+  const intptr_t diff = assembler_->CodeSize() - move_start_;
+  RELEASE_ASSERT(diff >= 0);
+  move_start_ = -1;
+
+  const bool src_is_register = src.IsRegister() || src.IsFpuRegister();
+  const bool dst_is_register = dst.IsRegister() || dst.IsFpuRegister();
+  Entry* entry = nullptr;
+  if (src_is_register && dst.HasStackIndex()) {
+    entry = &spills_;
+  } else if (src.HasStackIndex() && dst_is_register) {
+    entry = &reloads_;
+  }
+  if (entry != nullptr) {
+    entry->bytes += diff;
+    entry->count++;
+  }
+}
+
 void CodeStatistics::Finalize() {
   intptr_t function_size = assembler_->CodeSize();
   unaccounted_bytes_ = function_size - instruction_bytes_;
@@ -200,6 +237,10 @@ void CodeStatistics::AppendTo(CombinedCodeStatistics* stat) {
   ASSERT(stat->unaccounted_bytes_ >= 0);
   stat->alignment_bytes_ += alignment_bytes_;
   stat->object_header_bytes_ += Instructions::HeaderSize();
+  stat->spills_.bytes += spills_.bytes;
+  stat->spills_.count += spills_.count;
+  stat->reloads_.bytes += reloads_.bytes;
+  stat->reloads_.count += reloads_.count;
 
   if (returns_constant) stat->return_const_count_++;
   if (returns_const_with_load_field_) {
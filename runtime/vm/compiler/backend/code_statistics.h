@@ -67,6 +67,8 @@ class CombinedCodeStatistics {
   intptr_t object_header_bytes_;
   intptr_t return_const_count_;
   intptr_t return_const_with_load_field_count_;
+  Entry spills_;
+  Entry reloads_;
 };
 
 class CodeStatistics {
@@ -79,6 +81,18 @@ class CodeStatistics {
   void SpecialBegin(intptr_t tag);
   void SpecialEnd(intptr_t tag);
 
+  // Brackets a move emitted by the parallel move resolver. Moves from a
+  // register to a stack slot are counted as spills and moves from a stack
+  // slot to a register as reloads. The bytes are also accounted to the
+  // enclosing ParallelMove instruction.
+  void MoveBegin();
+  void MoveEnd(Location dst, Location src);
+
+  intptr_t spill_count() const { return spills_.count; }
+  intptr_t spill_bytes() const { return spills_.bytes; }
+  intptr_t reload_count() const { return reloads_.count; }
+  intptr_t reload_bytes() const { return reloads_.bytes; }
+
   void AppendTo(CombinedCodeStatistics* stat);
 
   void Finalize();
@@ -100,6 +114,10 @@ class CodeStatistics {
 
   intptr_t stack_[kStackSize];
   intptr_t stack_index_;
+
+  intptr_t move_start_;
+  Entry spills_;
+  Entry reloads_;
 };
 
 }  // namespace dart
@@ -536,6 +536,7 @@ class FlowGraph : public ZoneAllocated {
   friend class BranchSimplifier;
   friend class ConstantPropagator;
   friend class DeadCodeElimination;
+  friend class LoopUnroller;
   friend class compiler::GraphIntrinsifier;
 
   void CompressPath(intptr_t start_index,
@@ -58,6 +58,7 @@ DEFINE_FLAG(int,
             "The scale of invocation count, by size of the function.");
 DEFINE_FLAG(bool, source_lines, false, "Emit source line as assembly comment.");
 
+DECLARE_FLAG(int, baseline_optimization_counter_threshold);
 DECLARE_FLAG(charp, deoptimize_filter);
 DECLARE_FLAG(bool, intrinsify);
 DECLARE_FLAG(int, regexp_optimization_counter_threshold);
@@ -252,6 +253,10 @@ bool FlowGraphCompiler::CanOptimize() {
   return FLAG_optimization_counter_threshold >= 0;
 }
 
+bool FlowGraphCompiler::is_baseline() const {
+  return is_optimizing() && CompilerState::Current().is_baseline();
+}
+
 bool FlowGraphCompiler::CanOptimizeFunction() const {
   return CanOptimize() && !parsed_function().function().HasBreakpoint();
 }
@@ -1466,10 +1471,13 @@ void FlowGraphCompiler::GenerateInstanceCall(intptr_t deopt_id,
     return;
   }
   ASSERT(!ic_data.IsNull());
-  if (is_optimizing() && (ic_data_in.NumberOfUsedChecks() == 0)) {
+  if (is_optimizing() &&
+      (is_baseline() || (ic_data_in.NumberOfUsedChecks() == 0))) {
     // Emit IC call that will count and thus may need reoptimization at
-    // function entry.
-    ASSERT(may_reoptimize() || flow_graph().IsCompiledForOsr());
+    // function entry. Baseline code emits it for every instance call, so the
+    // ICData keeps being updated until the function is fully optimized.
+    ASSERT(is_baseline() || may_reoptimize() ||
+           flow_graph().IsCompiledForOsr());
     EmitOptimizedInstanceCall(StubEntryFor(ic_data, /*optimized=*/true),
                               ic_data, deopt_id, source, locs, entry_kind);
     return;
@@ -1934,7 +1942,9 @@ void ParallelMoveResolver::EmitMove(int index) {
   }
   const Location src = move->src();
   ParallelMoveResolver::TemporaryAllocator temp(this, /*blocked=*/kNoRegister);
+  compiler_->MoveStatsBegin();
   compiler_->EmitMove(dst, src, &temp);
+  compiler_->MoveStatsEnd(dst, src);
 #if defined(DEBUG)
   // Allocating a scratch register here may cause stack spilling. Neither the
   // source nor destination register should be SP-relative in that case.
@@ -2143,7 +2153,7 @@ const ICData* FlowGraphCompiler::GetOrAddStaticCallICData(
 
 intptr_t FlowGraphCompiler::GetOptimizationThreshold() const {
   intptr_t threshold;
-  if (is_optimizing()) {
+  if (is_optimizing() && !is_baseline()) {
     threshold = FLAG_reoptimization_counter_threshold;
   } else if (parsed_function_.function().IsIrregexpFunction()) {
     threshold = FLAG_regexp_optimization_counter_threshold;
@@ -2158,6 +2168,13 @@ intptr_t FlowGraphCompiler::GetOptimizationThreshold() const {
     if (threshold > FLAG_optimization_counter_threshold) {
       threshold = FLAG_optimization_counter_threshold;
     }
+    // Unoptimized code is first recompiled in the baseline tier. Baseline
+    // code keeps the threshold above and starts counting again from zero.
+    if (!is_optimizing() &&
+        Compiler::UseBaselineTier(parsed_function_.function()) &&
+        (threshold > FLAG_baseline_optimization_counter_threshold)) {
+      threshold = FLAG_baseline_optimization_counter_threshold;
+    }
   }
 
   // Threshold = 0 doesn't make sense because we increment the counter before
@@ -556,6 +556,14 @@ class FlowGraphCompiler : public ValueObject {
     if (stats_ != NULL) stats_->SpecialEnd(tag);
   }
 
+  void MoveStatsBegin() {
+    if (stats_ != NULL) stats_->MoveBegin();
+  }
+
+  void MoveStatsEnd(Location dst, Location src) {
+    if (stats_ != NULL) stats_->MoveEnd(dst, src);
+  }
+
   GrowableArray<const Field*>& used_static_fields() {
     return used_static_fields_;
   }
@@ -941,6 +949,10 @@ class FlowGraphCompiler : public ValueObject {
 
   bool may_reoptimize() const { return may_reoptimize_; }
 
+  // Whether this is optimized code of the baseline tier, which counts its
+  // invocations to be recompiled with the full optimizing pipeline.
+  bool is_baseline() const;
+
   // Use in unoptimized compilation to preserve/reuse ICData.
   //
   // If [binary_smi_target] is non-null and we have to create the ICData, the
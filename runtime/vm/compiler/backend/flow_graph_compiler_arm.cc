@@ -303,7 +303,7 @@ void FlowGraphCompiler::GenerateMethodExtractorIntrinsic(
 void FlowGraphCompiler::EmitFrameEntry() {
   const Function& function = parsed_function().function();
   if (CanOptimizeFunction() && function.IsOptimizable() &&
-      (!is_optimizing() || may_reoptimize())) {
+      (!is_optimizing() || is_baseline() || may_reoptimize())) {
     __ Comment("Invocation Count Check");
     const Register function_reg = R8;
     __ ldr(function_reg, compiler::FieldAddress(
@@ -311,9 +311,10 @@ void FlowGraphCompiler::EmitFrameEntry() {
     __ ldr(R3, compiler::FieldAddress(
                    function_reg,
                    compiler::target::Function::usage_counter_offset()));
-    // Reoptimization of an optimized function is triggered by counting in
+    // Baseline code counts invocations like unoptimized code to tier up.
+    // Reoptimization of other optimized code is triggered by counting in
     // IC stubs, but not at the entry of the function.
-    if (!is_optimizing()) {
+    if (!is_optimizing() || is_baseline()) {
       __ add(R3, R3, compiler::Operand(1));
       __ str(R3, compiler::FieldAddress(
                      function_reg,
@@ -294,7 +294,7 @@ void FlowGraphCompiler::GenerateMethodExtractorIntrinsic(
 void FlowGraphCompiler::EmitFrameEntry() {
   const Function& function = parsed_function().function();
   if (CanOptimizeFunction() && function.IsOptimizable() &&
-      (!is_optimizing() || may_reoptimize())) {
+      (!is_optimizing() || is_baseline() || may_reoptimize())) {
     __ Comment("Invocation Count Check");
     const Register function_reg = R6;
     __ ldr(function_reg,
@@ -302,9 +302,10 @@ void FlowGraphCompiler::EmitFrameEntry() {
 
     __ LoadFieldFromOffset(R7, function_reg, Function::usage_counter_offset(),
                            compiler::kFourBytes);
-    // Reoptimization of an optimized function is triggered by counting in
+    // Baseline code counts invocations like unoptimized code to tier up.
+    // Reoptimization of other optimized code is triggered by counting in
     // IC stubs, but not at the entry of the function.
-    if (!is_optimizing()) {
+    if (!is_optimizing() || is_baseline()) {
       __ add(R7, R7, compiler::Operand(1));
       __ StoreFieldToOffset(R7, function_reg, Function::usage_counter_offset(),
                             compiler::kFourBytes);
@@ -283,7 +283,7 @@ void FlowGraphCompiler::GenerateMethodExtractorIntrinsic(
 void FlowGraphCompiler::EmitFrameEntry() {
   const Function& function = parsed_function().function();
   if (CanOptimizeFunction() && function.IsOptimizable() &&
-      (!is_optimizing() || may_reoptimize())) {
+      (!is_optimizing() || is_baseline() || may_reoptimize())) {
     __ Comment("Invocation Count Check");
     const Register function_reg = A0;
     const Register usage_reg = A1;
@@ -292,9 +292,10 @@ void FlowGraphCompiler::EmitFrameEntry() {
     __ LoadFieldFromOffset(usage_reg, function_reg,
                            Function::usage_counter_offset(),
                            compiler::kFourBytes);
-    // Reoptimization of an optimized function is triggered by counting in
+    // Baseline code counts invocations like unoptimized code to tier up.
+    // Reoptimization of other optimized code is triggered by counting in
     // IC stubs, but not at the entry of the function.
-    if (!is_optimizing()) {
+    if (!is_optimizing() || is_baseline()) {
       __ addi(usage_reg, usage_reg, 1);
       __ StoreFieldToOffset(usage_reg, function_reg,
                             Function::usage_counter_offset(),
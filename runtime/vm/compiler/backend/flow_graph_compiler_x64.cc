@@ -310,15 +310,16 @@ void FlowGraphCompiler::EmitFrameEntry() {
   } else {
     const Function& function = parsed_function().function();
     if (CanOptimizeFunction() && function.IsOptimizable() &&
-        (!is_optimizing() || may_reoptimize())) {
+        (!is_optimizing() || is_baseline() || may_reoptimize())) {
       __ Comment("Invocation Count Check");
       const Register function_reg = RDI;
       __ movq(function_reg,
               compiler::FieldAddress(CODE_REG, Code::owner_offset()));
 
-      // Reoptimization of an optimized function is triggered by counting in
+      // Baseline code counts invocations like unoptimized code to tier up.
+      // Reoptimization of other optimized code is triggered by counting in
       // IC stubs, but not at the entry of the function.
-      if (!is_optimizing()) {
+      if (!is_optimizing() || is_baseline()) {
         __ incl(compiler::FieldAddress(function_reg,
                                        Function::usage_counter_offset()));
       }
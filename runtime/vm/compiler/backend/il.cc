@@ -4783,7 +4783,12 @@ void InstanceCallInstr::EmitNativeCode(FlowGraphCompiler* compiler) {
   }
 
   if (compiler->is_optimizing() && HasICData()) {
-    if (ic_data()->NumberOfUsedChecks() > 0) {
+    if (compiler->is_baseline()) {
+      // Baseline code updates the original ICData, see RunBaselinePipeline.
+      compiler->GenerateInstanceCall(deopt_id(), source(), locs(),
+                                     *call_ic_data, entry_kind(),
+                                     !receiver_is_not_smi());
+    } else if (ic_data()->NumberOfUsedChecks() > 0) {
       const ICData& unary_ic_data =
           ICData::ZoneHandle(zone, ic_data()->AsUnaryClassChecks());
       compiler->GenerateInstanceCall(deopt_id(), source(), locs(),
@@ -5121,6 +5126,10 @@ Definition* InstanceCallInstr::Canonicalize(FlowGraph* flow_graph) {
   // After compilation, add receiver checks to the ICData for those call sites.
   if (Targets().is_empty()) return this;
 
+  // Baseline code keeps every instance call, so it keeps collecting feedback
+  // for the fully optimized code.
+  if (CompilerState::Current().is_baseline()) return this;
+
   const CallTargets* new_target =
       FlowGraphCompiler::ResolveCallTargetsForReceiverCid(
           receiver_cid,
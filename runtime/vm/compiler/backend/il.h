@@ -5851,9 +5851,11 @@ class LoadIndexedInstr : public TemplateDefinition<2, NoThrow> {
 
   Value* array() const { return inputs_[0]; }
   Value* index() const { return inputs_[1]; }
+  bool index_unboxed() const { return index_unboxed_; }
   intptr_t index_scale() const { return index_scale_; }
   intptr_t class_id() const { return class_id_; }
   bool aligned() const { return alignment_ == kAlignedAccess; }
+  CompileType* result_type() const { return result_type_; }
 
   virtual intptr_t DeoptimizationTarget() const { return GetDeoptId(); }
   virtual bool ComputeCanDeoptimize() const {
@@ -6098,6 +6100,7 @@ class StoreIndexedInstr : public TemplateInstruction<3, NoThrow> {
   Value* index() const { return inputs_[kIndexPos]; }
   Value* value() const { return inputs_[kValuePos]; }
 
+  bool index_unboxed() const { return index_unboxed_; }
   intptr_t index_scale() const { return index_scale_; }
   intptr_t class_id() const { return class_id_; }
   bool aligned() const { return alignment_ == kAlignedAccess; }
@@ -6116,6 +6119,7 @@ class StoreIndexedInstr : public TemplateInstruction<3, NoThrow> {
            (emit_store_barrier_ == kEmitStoreBarrier);
   }
 
+  StoreBarrierType emit_store_barrier() const { return emit_store_barrier_; }
   void set_emit_store_barrier(StoreBarrierType value) {
     emit_store_barrier_ = value;
   }
@@ -8332,6 +8336,7 @@ class CheckStackOverflowInstr : public TemplateInstruction<0, NoThrow> {
   bool in_loop() const { return loop_depth_ > 0; }
   intptr_t stack_depth() const { return stack_depth_; }
   intptr_t loop_depth() const { return loop_depth_; }
+  Kind kind() const { return kind_; }
 
   DECLARE_INSTRUCTION(CheckStackOverflow)
 
@@ -9448,6 +9453,11 @@ class SimdOpInstr : public Definition {
     return new SimdOpInstr(kind, left, right, deopt_id);
   }
 
+  // Create a unary SimdOp instr.
+  static SimdOpInstr* Create(Kind kind, Value* left, intptr_t deopt_id) {
+    return new SimdOpInstr(kind, left, deopt_id);
+  }
+
   // Create a binary SimdOp instr.
   static SimdOpInstr* Create(MethodRecognizer::Kind kind,
                              Value* left,
@@ -5,6 +5,7 @@
 #include "vm/compiler/backend/inliner.h"
 
 #include "vm/compiler/aot/aot_call_specializer.h"
+#include "vm/compiler/aot/aot_profile.h"
 #include "vm/compiler/aot/precompiler.h"
 #include "vm/compiler/backend/block_scheduler.h"
 #include "vm/compiler/backend/branch_optimizer.h"
@@ -12,6 +13,7 @@
 #include "vm/compiler/backend/flow_graph_compiler.h"
 #include "vm/compiler/backend/il_printer.h"
 #include "vm/compiler/backend/type_propagator.h"
+#include "vm/compiler/compilation_record.h"
 #include "vm/compiler/compiler_pass.h"
 #include "vm/compiler/compiler_timings.h"
 #include "vm/compiler/frontend/flow_graph_builder.h"
@@ -96,6 +98,7 @@ DECLARE_FLAG(bool, print_flow_graph_optimized);
       inlined_info_.Add(InlinedInfo(caller, target, inlining_depth_,           \
                                     instance_call, comment));                  \
     }                                                                          \
+    RecordInlining(comment, *(target), instance_call);                         \
   } while (false)
 
 // Test and obtain Smi value.
@@ -354,16 +357,33 @@ class CallSites : public ValueObject {
     }
   }
 
+  // Returns the number of times the call at [token_pos] invoking [selector]
+  // in [caller] was executed while training, or -1 if there is no profile
+  // for [caller].
+  static intptr_t AotProfiledCallCount(const Function& caller,
+                                       TokenPosition token_pos,
+                                       const String& selector) {
+#if defined(DART_PRECOMPILER)
+    AotProfile* profile = AotProfile::Current();
+    if (profile != nullptr) {
+      return profile->CallCount(caller, token_pos, selector);
+    }
+#endif  // defined(DART_PRECOMPILER)
+    return -1;
+  }
+
   // Computes the ratio for each call site in a method, defined as the
   // number of times a call site is executed over the maximum number of
   // times any call site is executed in the method. JIT uses actual call
-  // counts whereas AOT uses a static estimate based on nesting depth.
+  // counts whereas AOT uses the counts of a training run if it executed any
+  // of the calls and a static estimate based on nesting depth otherwise.
   void ComputeCallSiteRatio(intptr_t static_call_start_ix,
                             intptr_t instance_call_start_ix) {
     const intptr_t num_static_calls =
         static_calls_.length() - static_call_start_ix;
     const intptr_t num_instance_calls =
         instance_calls_.length() - instance_call_start_ix;
+    const bool is_aot = CompilerState::Current().is_aot();
 
     intptr_t max_count = 0;
     GrowableArray<intptr_t> instance_call_counts(num_instance_calls);
@@ -371,9 +391,9 @@ class CallSites : public ValueObject {
       const InstanceCallInfo& info =
           instance_calls_[i + instance_call_start_ix];
       intptr_t aggregate_count =
-          CompilerState::Current().is_aot()
-              ? AotCallCountApproximation(info.nesting_depth)
-              : info.call->CallCount();
+          is_aot ? AotProfiledCallCount(info.caller(), info.call->token_pos(),
+                                        info.call->function_name())
+                 : info.call->CallCount();
       instance_call_counts.Add(aggregate_count);
       if (aggregate_count > max_count) max_count = aggregate_count;
     }
@@ -382,13 +402,32 @@ class CallSites : public ValueObject {
     for (intptr_t i = 0; i < num_static_calls; ++i) {
       const StaticCallInfo& info = static_calls_[i + static_call_start_ix];
       intptr_t aggregate_count =
-          CompilerState::Current().is_aot()
-              ? AotCallCountApproximation(info.nesting_depth)
-              : info.call->CallCount();
+          is_aot ? AotProfiledCallCount(
+                       info.caller(), info.call->token_pos(),
+                       String::Handle(info.call->function().name()))
+                 : info.call->CallCount();
       static_call_counts.Add(aggregate_count);
       if (aggregate_count > max_count) max_count = aggregate_count;
     }
 
+    if (is_aot && (max_count == 0)) {
+      for (intptr_t i = 0; i < num_instance_calls; ++i) {
+        const InstanceCallInfo& info =
+            instance_calls_[i + instance_call_start_ix];
+        instance_call_counts[i] = AotCallCountApproximation(info.nesting_depth);
+        if (instance_call_counts[i] > max_count) {
+          max_count = instance_call_counts[i];
+        }
+      }
+      for (intptr_t i = 0; i < num_static_calls; ++i) {
+        const StaticCallInfo& info = static_calls_[i + static_call_start_ix];
+        static_call_counts[i] = AotCallCountApproximation(info.nesting_depth);
+        if (static_call_counts[i] > max_count) {
+          max_count = static_call_counts[i];
+        }
+      }
+    }
+
     // Note that max_count can be 0 if none of the calls was executed.
     for (intptr_t i = 0; i < num_instance_calls; ++i) {
       const double ratio =
@@ -600,6 +639,12 @@ class PolymorphicInliner : public ValueObject {
 
   bool Inline();
 
+  // Whether the call is kept for receivers whose targets were not inlined.
+  // Only meaningful after Inline() returned true.
+  bool has_fallback_call() const {
+    return !call_->complete() || !non_inlined_variants_->is_empty();
+  }
+
  private:
   bool CheckInlinedDuplicate(const Function& target);
   bool CheckNonInlinedDuplicate(const Function& target);
@@ -928,6 +973,13 @@ class CallSiteInliner : public ValueObject {
     // late heuristic.
     if (instr_count == 0) {
       return InliningDecision::Yes("need to count first");
+    } else if (CompilerState::Current().is_baseline()) {
+      // The baseline tier only inlines small leaf functions.
+      if ((call_site_count == 0) &&
+          (instr_count <= FLAG_inlining_size_threshold)) {
+        return InliningDecision::Yes("baseline small leaf");
+      }
+      return InliningDecision::No("baseline");
     } else if (instr_count <= FLAG_inlining_size_threshold) {
       return InliningDecision::Yes("--inlining-size-threshold");
     } else if (call_site_count <= FLAG_inlining_callee_call_sites_threshold) {
@@ -1491,6 +1543,16 @@ class CallSiteInliner : public ValueObject {
  private:
   friend class PolymorphicInliner;
 
+  // Adds the decision to the record of the compilation, if one is collected.
+  void RecordInlining(const char* reason,
+                      const Function& target,
+                      const Definition* call) {
+    CompilationRecord* record = CompilerState::Current().record();
+    if (record != nullptr) {
+      record->AddInlining(call->GetDeoptId(), inlining_depth_, target, reason);
+    }
+  }
+
   static bool Contains(const GrowableArray<intptr_t>& a, intptr_t deopt_id) {
     for (intptr_t i = 0; i < a.length(); i++) {
       if (a[i] == deopt_id) return true;
@@ -1692,15 +1754,28 @@ class CallSiteInliner : public ValueObject {
                              call_info.length()));
     for (intptr_t call_idx = 0; call_idx < call_info.length(); ++call_idx) {
       PolymorphicInstanceCallInstr* call = call_info[call_idx].call;
-      // PolymorphicInliner introduces deoptimization paths.
-      if (!call->complete() && !FLAG_polymorphic_with_deopt) {
+      // PolymorphicInliner introduces deoptimization paths, except in AOT
+      // where it keeps a call for receivers that were not expected.
+      if (!call->complete() && !FLAG_polymorphic_with_deopt &&
+          !CompilerState::Current().is_aot()) {
         TRACE_INLINING(THR_Print("  => %s\n     Bailout: call with checks\n",
                                  call->function_name().ToCString()));
         continue;
       }
       const Function& cl = call_info[call_idx].caller();
       PolymorphicInliner inliner(this, call, cl);
-      if (inliner.Inline()) inlined = true;
+      if (inliner.Inline()) {
+        inlined = true;
+#if defined(DART_PRECOMPILER)
+        // Calls kept as a fallback are counted when they are replaced by
+        // dispatch table calls.
+        if ((inliner_->precompiler_ != nullptr) &&
+            !inliner.has_fallback_call()) {
+          inliner_->precompiler_->RecordDispatchSite(
+              Precompiler::kClassIdSwitchSite);
+        }
+#endif  // defined(DART_PRECOMPILER)
+      }
     }
     return inlined;
   }
@@ -2016,8 +2091,9 @@ bool PolymorphicInliner::TryInlineRecognizedMethod(intptr_t receiver_cid,
 // id of the receiver and make explicit comparisons for each inlined body,
 // in frequency order.  If all variants are inlined, the entry to the last
 // inlined body is guarded by a CheckClassId instruction which can deopt.
-// If not all variants are inlined, we add a PolymorphicInstanceCall
-// instruction to handle the non-inlined variants.
+// If not all variants are inlined, or the call is not known to be complete
+// and cannot deopt, we add a PolymorphicInstanceCall instruction to handle
+// the non-inlined variants.
 TargetEntryInstr* PolymorphicInliner::BuildDecisionGraph() {
   COMPILER_TIMINGS_TIMER_SCOPE(owner_->thread(), BuildDecisionGraph);
   const intptr_t try_idx = call_->GetBlock()->try_index();
@@ -2033,6 +2109,11 @@ TargetEntryInstr* PolymorphicInliner::BuildDecisionGraph() {
   BlockEntryInstr* current_block = entry;
   Instruction* cursor = entry;
 
+  // Without deoptimization, receivers of an incomplete call that match none
+  // of the variants still need a call.
+  const bool needs_fallback =
+      !call_->complete() && !FLAG_polymorphic_with_deopt;
+
   Definition* receiver = call_->Receiver()->definition();
   // There are at least two variants including non-inlined ones, so we have
   // at least one branch on the class id.
@@ -2047,7 +2128,8 @@ TargetEntryInstr* PolymorphicInliner::BuildDecisionGraph() {
     // 1. Guard the body with a class id check.  We don't need any check if
     // it's the last test and global analysis has told us that the call is
     // complete.
-    if (is_last_test && non_inlined_variants_->is_empty()) {
+    if (is_last_test && non_inlined_variants_->is_empty() &&
+        !needs_fallback) {
       // If it is the last variant use a check class id instruction which can
       // deoptimize, followed unconditionally by the body. Omit the check if
       // we know that we have covered all possible classes.
@@ -2238,7 +2320,7 @@ TargetEntryInstr* PolymorphicInliner::BuildDecisionGraph() {
   ASSERT(!call_->HasPushArguments());
 
   // Handle any non-inlined variants.
-  if (!non_inlined_variants_->is_empty()) {
+  if (!non_inlined_variants_->is_empty() || needs_fallback) {
     PolymorphicInstanceCallInstr* fallback_call =
         PolymorphicInstanceCallInstr::FromCall(Z, call_, *non_inlined_variants_,
                                                call_->complete());
@@ -2523,6 +2605,10 @@ int FlowGraphInliner::Inline() {
   }
 
   intptr_t inlining_depth_threshold = FLAG_inlining_depth_threshold;
+  if (CompilerState::Current().is_baseline()) {
+    // Leaves have no calls to inline further.
+    inlining_depth_threshold = 1;
+  }
 
   CallSiteInliner inliner(this, inlining_depth_threshold);
   inliner.InlineCalls();
@@ -246,6 +246,68 @@ ISOLATE_UNIT_TEST_CASE(Inliner_List_generate) {
   }));
 }
 
+// Verifies that a call with more receiver classes than class tests is
+// inlined behind a class-id switch when the classes fall into few ranges
+// with the same target.
+ISOLATE_UNIT_TEST_CASE(Inliner_ClassIdRangeSwitch) {
+  const char* kScript = R"(
+    abstract class A {
+      int value() => 1;
+    }
+    class B extends A {}
+    class C extends A {
+      @override
+      int value() => 2;
+    }
+    class D extends A {}
+    class E extends A {}
+    class F extends A {}
+    class G extends A {}
+    class H extends A {}
+
+    int testSwitch(A a) => a.value();
+
+    main() {
+      for (final a in <A>[B(), C(), D(), E(), F(), G(), H()]) {
+        testSwitch(a);
+      }
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function =
+      Function::Handle(GetFunction(root_library, "testSwitch"));
+
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  FlowGraph* flow_graph = pipeline.RunPasses({
+      CompilerPass::kComputeSSA,
+      CompilerPass::kApplyICData,
+      CompilerPass::kTryOptimizePatterns,
+      CompilerPass::kSetOuterInliningId,
+      CompilerPass::kTypePropagation,
+      CompilerPass::kApplyClassIds,
+      CompilerPass::kInlining,
+  });
+
+  intptr_t calls = 0;
+  intptr_t class_id_loads = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      Instruction* current = it.Current();
+      if (current->IsInstanceCallBase() || current->IsStaticCall()) {
+        calls++;
+      } else if (current->IsLoadClassId()) {
+        class_id_loads++;
+      }
+    }
+  }
+  EXPECT_EQ(0, calls);
+  EXPECT_EQ(1, class_id_loads);
+}
+
 #endif  // defined(DART_PRECOMPILER)
 
 }  // namespace dart
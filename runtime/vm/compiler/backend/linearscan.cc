@@ -16,6 +16,13 @@
 
 namespace dart {
 
+DEFINE_FLAG(bool,
+            sink_spill_stores,
+            false,
+            "Store values defined in a loop to their spill slot only where "
+            "they are spilled after the loop instead of at the definition. "
+            "Experimental.");
+
 #if !defined(PRODUCT)
 #define INCLUDE_LINEAR_SCAN_TRACING_CODE
 #endif
@@ -109,6 +116,7 @@ FlowGraphAllocator::FlowGraphAllocator(const FlowGraph& flow_graph,
       blocked_cpu_registers_(),
       blocked_fpu_registers_(),
       spilled_(),
+      sunk_spill_stores_(nullptr),
       safepoints_(),
       register_kind_(),
       number_of_registers_(0),
@@ -2023,7 +2031,8 @@ void FlowGraphAllocator::AllocateSpillSlotFor(LiveRange* range) {
   spilled_.Add(range);
 }
 
-void FlowGraphAllocator::MarkAsObjectAtSafepoints(LiveRange* range) {
+void FlowGraphAllocator::MarkAsObjectAtSafepoints(LiveRange* range,
+                                                  bool only_spilled) {
   Location spill_slot = range->spill_slot();
   intptr_t stack_index = spill_slot.stack_index();
   if (spill_slot.base_reg() == FPREG) {
@@ -2032,10 +2041,12 @@ void FlowGraphAllocator::MarkAsObjectAtSafepoints(LiveRange* range) {
   }
   ASSERT(stack_index >= 0);
   while (range != NULL) {
-    for (SafepointPosition* safepoint = range->first_safepoint();
-         safepoint != NULL; safepoint = safepoint->next()) {
-      // Mark the stack slot as having an object.
-      safepoint->locs()->SetStackBit(stack_index);
+    if (!only_spilled || range->assigned_location().Equals(spill_slot)) {
+      for (SafepointPosition* safepoint = range->first_safepoint();
+           safepoint != NULL; safepoint = safepoint->next()) {
+        // Mark the stack slot as having an object.
+        safepoint->locs()->SetStackBit(stack_index);
+      }
     }
     range = range->next_sibling();
   }
@@ -2044,10 +2055,9 @@ void FlowGraphAllocator::MarkAsObjectAtSafepoints(LiveRange* range) {
 void FlowGraphAllocator::Spill(LiveRange* range) {
   LiveRange* parent = GetLiveRange(range->vreg());
   if (parent->spill_slot().IsInvalid()) {
+    // Safepoints are marked in ResolveControlFlow once it is known where
+    // the value is stored to the spill slot.
     AllocateSpillSlotFor(parent);
-    if (range->representation() == kTagged) {
-      MarkAsObjectAtSafepoints(parent);
-    }
   }
   range->set_assigned_location(parent->spill_slot());
   ConvertAllUses(range);
@@ -2723,9 +2733,49 @@ void FlowGraphAllocator::AllocateUnallocatedRanges() {
 
 bool FlowGraphAllocator::TargetLocationIsSpillSlot(LiveRange* range,
                                                    Location target) {
+  if ((sunk_spill_stores_ != nullptr) &&
+      sunk_spill_stores_->Contains(range->vreg())) {
+    // The spill slot is only written when the value moves into it.
+    return false;
+  }
   return GetLiveRange(range->vreg())->spill_slot().Equals(target);
 }
 
+bool FlowGraphAllocator::CanSinkSpillStore(LiveRange* range) {
+  const Location spill_slot = range->spill_slot();
+  if (range->assigned_location().Equals(spill_slot) ||
+      IsBlockEntry(range->Start())) {
+    // Already spilled at the definition, or a phi or a parameter.
+    return false;
+  }
+
+  LoopInfo* loop_info = BlockEntryAt(range->Start())->loop_info();
+  if (loop_info == nullptr) {
+    return false;
+  }
+
+  // Every part of the range which lives in the spill slot must start after
+  // the loop has been exited, and outside of any other loop nested in the
+  // loop's parents, so that the store is not repeated more often than the
+  // definition itself would be.
+  const intptr_t loop_end = extra_loop_info_[loop_info->id()]->end;
+  for (LiveRange* sibling = range->next_sibling(); sibling != nullptr;
+       sibling = sibling->next_sibling()) {
+    if (!sibling->assigned_location().Equals(spill_slot)) {
+      continue;
+    }
+    if (sibling->Start() < loop_end) {
+      return false;
+    }
+    LoopInfo* sibling_loop = BlockEntryAt(sibling->Start())->loop_info();
+    if ((sibling_loop != nullptr) &&
+        ((sibling_loop == loop_info) || !loop_info->IsIn(sibling_loop))) {
+      return false;
+    }
+  }
+  return true;
+}
+
 static LiveRange* FindCover(LiveRange* parent, intptr_t pos) {
   for (LiveRange* range = parent; range != nullptr;
        range = range->next_sibling()) {
@@ -2760,6 +2810,24 @@ static void EmitMoveOnEdge(BlockEntryInstr* succ,
 }
 
 void FlowGraphAllocator::ResolveControlFlow() {
+  // Values defined in a loop which are only spilled after it (e.g. around a
+  // call on the path following the loop) are stored to the spill slot where
+  // they are moved into it, instead of eagerly at the definition.
+  if (FLAG_sink_spill_stores &&
+      flow_graph_.graph_entry()->catch_entries().is_empty()) {
+    for (intptr_t i = 0; i < spilled_.length(); i++) {
+      LiveRange* range = spilled_[i];
+      if (CanSinkSpillStore(range)) {
+        if (sunk_spill_stores_ == nullptr) {
+          sunk_spill_stores_ = new BitVector(flow_graph_.zone(), vreg_count_);
+        }
+        TRACE_ALLOC(THR_Print("sinking spill store of v%" Pd "\n",
+                              range->vreg()));
+        sunk_spill_stores_->Add(range->vreg());
+      }
+    }
+  }
+
   // Resolve linear control flow between touching split siblings
   // inside basic blocks.
   for (intptr_t vreg = 0; vreg < live_ranges_.length(); vreg++) {
@@ -2818,8 +2886,8 @@ void FlowGraphAllocator::ResolveControlFlow() {
                             dst_cover->Start(), dst_cover->End()));
 
       if (TargetLocationIsSpillSlot(range, dst)) {
-        // Values are eagerly spilled. Spill slot already contains appropriate
-        // value.
+        // Values are eagerly spilled unless their spill store was sunk.
+        // Spill slot already contains appropriate value.
         TRACE_ALLOC(
             THR_Print("  [no resolution necessary - range is spilled]\n"));
         continue;
@@ -2929,12 +2997,17 @@ void FlowGraphAllocator::ResolveControlFlow() {
     }
   }
 
-  // Eagerly spill values.
-  // TODO(vegorov): if value is spilled on the cold path (e.g. by the call)
-  // this will cause spilling to occur on the fast path (at the definition).
+  // Eagerly spill values, unless their spill store was sunk above.
+  // A sunk spill slot only holds the value while the range is spilled, so
+  // it is only reported to the GC at safepoints covered by such siblings.
   for (intptr_t i = 0; i < spilled_.length(); i++) {
     LiveRange* range = spilled_[i];
-    if (!range->assigned_location().Equals(range->spill_slot())) {
+    const bool sunk = (sunk_spill_stores_ != nullptr) &&
+                      sunk_spill_stores_->Contains(range->vreg());
+    if (range->representation() == kTagged) {
+      MarkAsObjectAtSafepoints(range, /*only_spilled=*/sunk);
+    }
+    if (!sunk && !range->assigned_location().Equals(range->spill_slot())) {
       AddMoveAt(range->Start() + 1, range->spill_slot(),
                 range->assigned_location());
     }
@@ -177,9 +177,15 @@ class FlowGraphAllocator : public ValueObject {
   // Connect split siblings over non-linear control flow edges.
   void ResolveControlFlow();
 
-  // Returns true if the target location is the spill slot for the given range.
+  // Returns true if the target location is the spill slot for the given range
+  // and the slot already holds the value when the range is moved into it.
   bool TargetLocationIsSpillSlot(LiveRange* range, Location target);
 
+  // Returns true if the given spilled range is defined in a loop and only
+  // moved into its spill slot after the loop, so its spill store can be
+  // sunk from the definition to the places where it enters the spill slot.
+  bool CanSinkSpillStore(LiveRange* range);
+
   // Update location slot corresponding to the use with location allocated for
   // the use's live range.
   void ConvertUseTo(UsePosition* use, Location loc);
@@ -249,8 +255,9 @@ class FlowGraphAllocator : public ValueObject {
   void SpillBetween(LiveRange* range, intptr_t from, intptr_t to);
 
   // Mark the live range as a live object pointer at all safepoints
-  // contained in the range.
-  void MarkAsObjectAtSafepoints(LiveRange* range);
+  // contained in the range, or only at those contained in its siblings
+  // allocated to the spill slot if [only_spilled] is true.
+  void MarkAsObjectAtSafepoints(LiveRange* range, bool only_spilled = false);
 
   MoveOperands* AddMoveAt(intptr_t pos, Location to, Location from);
 
@@ -311,6 +318,10 @@ class FlowGraphAllocator : public ValueObject {
   // List of spilled live ranges.
   GrowableArray<LiveRange*> spilled_;
 
+  // Virtual registers of spilled live ranges which are stored to their spill
+  // slot when moved into it rather than at their definition.
+  BitVector* sunk_spill_stores_;
+
   // List of instructions containing calls.
   GrowableArray<Instruction*> safepoints_;
 
@@ -0,0 +1,372 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_cloner.h"
+
+#include "vm/bit_vector.h"
+#include "vm/compiler/backend/range_analysis.h"
+
+namespace dart {
+
+LoopCloner::LoopCloner(FlowGraph* flow_graph)
+    : flow_graph_(flow_graph), zone_(flow_graph->zone()), map_() {}
+
+bool LoopCloner::CanClone(Instruction* instr) {
+  switch (instr->tag()) {
+    case Instruction::kBinarySmiOp:
+    case Instruction::kBinaryInt32Op:
+    case Instruction::kBinaryUint32Op:
+    case Instruction::kBinaryInt64Op:
+    case Instruction::kShiftInt64Op:
+    case Instruction::kSpeculativeShiftInt64Op:
+    case Instruction::kShiftUint32Op:
+    case Instruction::kSpeculativeShiftUint32Op:
+    case Instruction::kBinaryDoubleOp:
+    case Instruction::kLoadIndexed:
+    case Instruction::kStoreIndexed:
+    case Instruction::kLoadUntagged:
+    case Instruction::kCheckArrayBound:
+    case Instruction::kGenericCheckBound:
+    case Instruction::kBox:
+    case Instruction::kBoxInt64:
+    case Instruction::kBoxUint32:
+    case Instruction::kBoxInt32:
+    case Instruction::kUnbox:
+    case Instruction::kUnboxInt64:
+    case Instruction::kUnboxUint32:
+    case Instruction::kUnboxInt32:
+    case Instruction::kIntConverter:
+    case Instruction::kUnboxedConstant:
+    case Instruction::kCheckStackOverflow:
+      return true;
+    default:
+      return false;
+  }
+}
+
+void LoopCloner::ResetMap() {
+  map_.Clear();
+  for (intptr_t i = 0; i < flow_graph_->current_ssa_temp_index(); ++i) {
+    map_.Add(nullptr);
+  }
+}
+
+BranchInstr* LoopCloner::CloneBranch(BranchInstr* branch) {
+  ComparisonInstr* original = branch->comparison();
+  ComparisonInstr* comparison = original->CopyWithNewOperands(
+      new (zone_) Value(Lookup(original->left()->definition())),
+      new (zone_) Value(Lookup(original->right()->definition())));
+  BranchInstr* clone = new (zone_) BranchInstr(comparison, DeoptId::kNone);
+  if (branch->env() != nullptr) {
+    clone->InheritDeoptTarget(zone_, branch);
+    RenameEnvironment(clone);
+  }
+  return clone;
+}
+
+void LoopCloner::CollectLiveOut(LoopInfo* loop,
+                                Definition* def,
+                                TargetEntryInstr* exit) {
+  const intptr_t count = live_out_uses_.length();
+  const intptr_t owner = live_out_.length();
+  bool used_by_exit = false;
+  for (Value::Iterator it(def->input_use_list()); !it.Done(); it.Advance()) {
+    if (!loop->Contains(it.Current()->instruction()->GetBlock())) {
+      live_out_uses_.Add(it.Current());
+      live_out_owner_.Add(owner);
+      live_out_in_env_.Add(false);
+    }
+  }
+  for (Value::Iterator it(def->env_use_list()); !it.Done(); it.Advance()) {
+    // The environment of the exit block is replaced by the copy in the join,
+    // whose uses are collected by PrepareExit.
+    if (it.Current()->instruction() == exit) {
+      used_by_exit = true;
+    } else if (!loop->Contains(it.Current()->instruction()->GetBlock())) {
+      live_out_uses_.Add(it.Current());
+      live_out_owner_.Add(owner);
+      live_out_in_env_.Add(true);
+    }
+  }
+  if (used_by_exit || live_out_uses_.length() != count) {
+    live_out_.Add(def);
+  }
+}
+
+JoinEntryInstr* LoopCloner::PrepareExit(LoopInfo* loop,
+                                        TargetEntryInstr* exit) {
+  ASSERT(exit_join_ == nullptr);
+  // Header values that are used past the loop. Since the exit block is the
+  // only way out, all of these uses are dominated by it and get the merged
+  // value instead.
+  JoinEntryInstr* header = loop->header()->AsJoinEntry();
+  for (PhiIterator it(header); !it.Done(); it.Advance()) {
+    CollectLiveOut(loop, it.Current(), exit);
+  }
+  for (ForwardInstructionIterator it(header); !it.Done(); it.Advance()) {
+    if (Definition* def = it.Current()->AsDefinition()) {
+      CollectLiveOut(loop, def, exit);
+    }
+  }
+
+  JoinEntryInstr* join = new (zone_)
+      JoinEntryInstr(exit->block_id(), exit->try_index(), DeoptId::kNone);
+  if (exit->env() != nullptr) {
+    join->InheritDeoptTarget(zone_, exit);
+    for (Environment::DeepIterator it(join->env()); !it.Done(); it.Advance()) {
+      for (intptr_t i = 0; i < live_out_.length(); ++i) {
+        if (it.CurrentValue()->definition() == live_out_[i]) {
+          live_out_uses_.Add(it.CurrentValue());
+          live_out_owner_.Add(i);
+          live_out_in_env_.Add(true);
+        }
+      }
+    }
+  }
+  join->LinkTo(exit->next());
+  join->set_last_instruction(exit->last_instruction());
+  exit->UnuseAllInputs();
+  exit_join_ = join;
+  exit_weight_ = exit->edge_weight();
+  return join;
+}
+
+TargetEntryInstr* LoopCloner::AddExit() {
+  ASSERT(exit_join_ != nullptr);
+  TargetEntryInstr* target = NewTarget(exit_join_, exit_weight_);
+  GotoInstr* jump = new (zone_) GotoInstr(exit_join_, DeoptId::kNone);
+  target->AppendInstruction(jump);
+  target->set_last_instruction(jump);
+  exits_.Add(target);
+  for (intptr_t i = 0; i < live_out_.length(); ++i) {
+    exit_values_.Add(Lookup(live_out_[i]));
+  }
+  return target;
+}
+
+void LoopCloner::MergeExits() {
+  ASSERT(exit_join_ != nullptr);
+  JoinEntryInstr* join = exit_join_;
+  GrowableArray<PhiInstr*> merged;
+  for (intptr_t i = 0; i < live_out_.length(); ++i) {
+    Definition* def = live_out_[i];
+    PhiInstr* phi = new (zone_) PhiInstr(join, join->PredecessorCount());
+    phi->set_representation(def->representation());
+    phi->mark_alive();
+    flow_graph_->AllocateSSAIndexes(phi);
+    for (intptr_t pred = 0; pred < join->PredecessorCount(); ++pred) {
+      BlockEntryInstr* from = join->PredecessorAt(pred);
+      Definition* input = def;
+      for (intptr_t exit = 0; exit < exits_.length(); ++exit) {
+        if (exits_[exit] == from) {
+          input = exit_values_[exit * live_out_.length() + i];
+          break;
+        }
+      }
+      Value* value = new (zone_) Value(input);
+      phi->SetInputAt(pred, value);
+      input->AddInputUse(value);
+    }
+    join->InsertPhi(phi);
+    merged.Add(phi);
+  }
+  for (intptr_t i = 0; i < live_out_uses_.length(); ++i) {
+    Value* use = live_out_uses_[i];
+    PhiInstr* phi = merged[live_out_owner_[i]];
+    if (live_out_in_env_[i]) {
+      use->BindToEnvironment(phi);
+    } else {
+      use->BindTo(phi);
+    }
+  }
+}
+
+void LoopCloner::RestorePhiInputOrder(JoinEntryInstr* join,
+                                      BlockEntryInstr* pred,
+                                      intptr_t old_index) {
+  if (join->IndexOfPredecessor(pred) == old_index) {
+    return;
+  }
+  ASSERT(join->PredecessorCount() == 2);
+  for (PhiIterator it(join); !it.Done(); it.Advance()) {
+    PhiInstr* phi = it.Current();
+    Value* first = phi->InputAt(0);
+    Value* second = phi->InputAt(1);
+    phi->SetInputAt(0, second);
+    phi->SetInputAt(1, first);
+  }
+}
+
+Definition* LoopCloner::Lookup(Definition* def) const {
+  const intptr_t index = def->ssa_temp_index();
+  if (index >= 0 && index < map_.length() && map_[index] != nullptr) {
+    return map_[index];
+  }
+  return def;
+}
+
+void LoopCloner::Map(Definition* original, Definition* copy) {
+  const intptr_t index = original->ssa_temp_index();
+  ASSERT(index >= 0 && index < map_.length());
+  map_[index] = copy;
+}
+
+Instruction* LoopCloner::AppendClone(Instruction* cursor,
+                                       Instruction* instr) {
+  Instruction* clone = CreateClone(instr);
+  Definition* def = instr->AsDefinition();
+  const bool has_value = def != nullptr && def->HasSSATemp();
+  cursor = flow_graph_->AppendTo(cursor, clone, instr->env(),
+                                 has_value ? FlowGraph::kValue
+                                           : FlowGraph::kEffect);
+  RenameEnvironment(clone);
+  if (def != nullptr) {
+    Definition* copy = clone->AsDefinition();
+    if (def->range() != nullptr && copy->range() == nullptr) {
+      copy->set_range(*def->range());
+    }
+    if (has_value) {
+      Map(def, copy);
+    }
+  }
+  return cursor;
+}
+
+Instruction* LoopCloner::CreateClone(Instruction* instr) {
+  auto input = [&](intptr_t i) {
+    return new (zone_) Value(Lookup(instr->InputAt(i)->definition()));
+  };
+  switch (instr->tag()) {
+    case Instruction::kBinaryInt64Op: {
+      // BinaryIntegerOpInstr::Make does not preserve the speculative mode
+      // of 64-bit operations.
+      auto op = instr->AsBinaryInt64Op();
+      auto clone = new (zone_)
+          BinaryInt64OpInstr(op->op_kind(), input(0), input(1),
+                             op->deopt_id(), op->SpeculativeModeOfInputs());
+      clone->set_can_overflow(op->can_overflow());
+      return clone;
+    }
+    case Instruction::kBinarySmiOp:
+    case Instruction::kBinaryInt32Op:
+    case Instruction::kBinaryUint32Op:
+    case Instruction::kShiftInt64Op:
+    case Instruction::kSpeculativeShiftInt64Op:
+    case Instruction::kShiftUint32Op:
+    case Instruction::kSpeculativeShiftUint32Op: {
+      auto op = instr->AsBinaryIntegerOp();
+      auto clone = BinaryIntegerOpInstr::Make(
+          op->representation(), op->op_kind(), input(0), input(1),
+          op->deopt_id(), op->can_overflow(), op->is_truncating(),
+          op->range(), op->SpeculativeModeOfInputs());
+      ASSERT(clone != nullptr && clone->tag() == op->tag());
+      if (auto shift = op->AsShiftIntegerOp()) {
+        clone->AsShiftIntegerOp()->set_shift_range(shift->shift_range());
+      }
+      return clone;
+    }
+    case Instruction::kBinaryDoubleOp: {
+      auto op = instr->AsBinaryDoubleOp();
+      return new (zone_) BinaryDoubleOpInstr(
+          op->op_kind(), input(0), input(1), op->deopt_id(),
+          op->source(), op->SpeculativeModeOfInputs());
+    }
+    case Instruction::kLoadIndexed: {
+      auto load = instr->AsLoadIndexed();
+      return new (zone_) LoadIndexedInstr(
+          input(0), input(1), load->index_unboxed(), load->index_scale(),
+          load->class_id(),
+          load->aligned() ? kAlignedAccess : kUnalignedAccess,
+          load->deopt_id(), load->source(), load->result_type());
+    }
+    case Instruction::kStoreIndexed: {
+      auto store = instr->AsStoreIndexed();
+      return new (zone_) StoreIndexedInstr(
+          input(0), input(1), input(2), store->emit_store_barrier(),
+          store->index_unboxed(), store->index_scale(), store->class_id(),
+          store->aligned() ? kAlignedAccess : kUnalignedAccess,
+          store->deopt_id(), store->source(),
+          store->SpeculativeModeOfInputs());
+    }
+    case Instruction::kLoadUntagged:
+      return new (zone_)
+          LoadUntaggedInstr(input(0), instr->AsLoadUntagged()->offset());
+    case Instruction::kCheckArrayBound:
+      return new (zone_)
+          CheckArrayBoundInstr(input(0), input(1), instr->deopt_id());
+    case Instruction::kGenericCheckBound:
+      return new (zone_)
+          GenericCheckBoundInstr(input(0), input(1), instr->deopt_id());
+    case Instruction::kBox:
+    case Instruction::kBoxInt64:
+    case Instruction::kBoxUint32:
+    case Instruction::kBoxInt32:
+      return BoxInstr::Create(instr->AsBox()->from_representation(), input(0));
+    case Instruction::kUnbox:
+    case Instruction::kUnboxInt64:
+    case Instruction::kUnboxUint32:
+    case Instruction::kUnboxInt32: {
+      auto unbox = instr->AsUnbox();
+      auto clone = UnboxInstr::Create(unbox->representation(), input(0),
+                                      unbox->deopt_id(),
+                                      unbox->SpeculativeModeOfInputs());
+      if (auto unbox_int = unbox->AsUnboxInteger()) {
+        if (unbox_int->is_truncating()) {
+          clone->AsUnboxInteger()->mark_truncating();
+        }
+      }
+      return clone;
+    }
+    case Instruction::kIntConverter: {
+      auto conv = instr->AsIntConverter();
+      auto clone = new (zone_) IntConverterInstr(
+          conv->from(), conv->to(), input(0), conv->deopt_id());
+      if (conv->is_truncating()) {
+        clone->mark_truncating();
+      }
+      return clone;
+    }
+    case Instruction::kUnboxedConstant: {
+      auto constant = instr->AsUnboxedConstant();
+      return new (zone_)
+          UnboxedConstantInstr(constant->value(), constant->representation());
+    }
+    case Instruction::kCheckStackOverflow: {
+      auto check = instr->AsCheckStackOverflow();
+      return new (zone_) CheckStackOverflowInstr(
+          check->source(), check->stack_depth(), check->loop_depth(),
+          check->deopt_id(), check->kind());
+    }
+    default:
+      UNREACHABLE();
+      return nullptr;
+  }
+}
+
+void LoopCloner::RenameEnvironment(Instruction* instr) {
+  if (instr->env() == nullptr) {
+    return;
+  }
+  for (Environment::DeepIterator it(instr->env()); !it.Done(); it.Advance()) {
+    Value* value = it.CurrentValue();
+    Definition* def = Lookup(value->definition());
+    if (def != value->definition()) {
+      value->BindToEnvironment(def);
+    }
+  }
+}
+
+TargetEntryInstr* LoopCloner::NewTarget(BlockEntryInstr* like,
+                                          double edge_weight) {
+  TargetEntryInstr* target = new (zone_) TargetEntryInstr(
+      flow_graph_->allocate_block_id(), like->try_index(), DeoptId::kNone);
+  if (like->env() != nullptr) {
+    target->InheritDeoptTarget(zone_, like);
+    RenameEnvironment(target);
+  }
+  target->set_edge_weight(edge_weight);
+  return target;
+}
+
+}  // namespace dart
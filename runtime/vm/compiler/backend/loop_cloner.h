@@ -0,0 +1,91 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_CLONER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_CLONER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/loops.h"
+
+namespace dart {
+
+// Copies straight-line loop code for transformations such as unrolling and
+// versioning.
+//
+// Copies are renamed through a map from original definitions to their
+// copies; definitions without an entry stand for themselves. Copies keep the
+// deopt ids of their originals and get environments renamed the same way as
+// their inputs.
+//
+// Adding exits to a loop is supported for loops with a single exit block:
+// PrepareExit records the uses of header values past the loop and turns the
+// exit block into a join, AddExit creates an edge into that join carrying
+// the values of the current renaming, and MergeExits, which must run after
+// the blocks were rediscovered, merges these values with new phis.
+class LoopCloner : public ValueObject {
+ public:
+  explicit LoopCloner(FlowGraph* flow_graph);
+
+  // Returns true if AppendClone supports [instr].
+  static bool CanClone(Instruction* instr);
+
+  // Starts a new renaming in which every definition stands for itself.
+  void ResetMap();
+  Definition* Lookup(Definition* def) const;
+  void Map(Definition* original, Definition* copy);
+
+  // Appends a renamed copy of [instr] after [cursor] and returns the copy.
+  Instruction* AppendClone(Instruction* cursor, Instruction* instr);
+
+  // Returns a renamed copy of [branch] without successors.
+  BranchInstr* CloneBranch(BranchInstr* branch);
+
+  void RenameEnvironment(Instruction* instr);
+
+  TargetEntryInstr* NewTarget(BlockEntryInstr* like, double edge_weight);
+
+  JoinEntryInstr* PrepareExit(LoopInfo* loop, TargetEntryInstr* exit);
+  TargetEntryInstr* AddExit();
+  void MergeExits();
+
+  // Predecessors of joins are kept sorted by block id, so adding blocks can
+  // reorder them. Swaps the phi inputs of a two-way [join] if [pred] is no
+  // longer found at [old_index].
+  static void RestorePhiInputOrder(JoinEntryInstr* join,
+                                   BlockEntryInstr* pred,
+                                   intptr_t old_index);
+
+ private:
+  Instruction* CreateClone(Instruction* instr);
+  void CollectLiveOut(LoopInfo* loop,
+                      Definition* def,
+                      TargetEntryInstr* exit);
+
+  FlowGraph* const flow_graph_;
+  Zone* const zone_;
+
+  // Renaming of the copy being emitted, indexed by SSA temp index.
+  GrowableArray<Definition*> map_;
+
+  // Exit block of the loop, header values used past it and those uses.
+  JoinEntryInstr* exit_join_ = nullptr;
+  double exit_weight_ = 0.0;
+  GrowableArray<Definition*> live_out_;
+  GrowableArray<Value*> live_out_uses_;
+  GrowableArray<intptr_t> live_out_owner_;
+  GrowableArray<bool> live_out_in_env_;
+
+  // Edges into the exit join and, for each of them, the live out values.
+  GrowableArray<TargetEntryInstr*> exits_;
+  GrowableArray<Definition*> exit_values_;
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_CLONER_H_
@@ -0,0 +1,285 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_unroller.h"
+
+#include "vm/bit_vector.h"
+#include "vm/flags.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool, loop_unrolling, false, "Unroll small counted loops.");
+DEFINE_FLAG(int,
+            loop_unroll_factor,
+            2,
+            "Number of iterations executed per trip around an unrolled loop.");
+DEFINE_FLAG(int,
+            loop_unroll_max_growth,
+            48,
+            "Maximum number of instructions added when unrolling one loop.");
+DEFINE_FLAG(bool, trace_loop_unrolling, false, "Trace loop unrolling.");
+
+LoopUnroller::LoopUnroller(FlowGraph* flow_graph)
+    : flow_graph_(flow_graph) {}
+
+bool LoopUnroller::Optimize() {
+  if (!FLAG_loop_unrolling || FLAG_loop_unroll_factor < 2) {
+    return false;
+  }
+  // Loops entered from the OSR entry have a second way in that the copies
+  // would have to account for.
+  if (flow_graph_->IsCompiledForOsr()) {
+    return false;
+  }
+
+  // Unrolling rewrites the block order, dominators and loop hierarchy, so
+  // candidates are looked up again after every transformation.
+  bool changed = false;
+  while (true) {
+    const LoopHierarchy& loops = flow_graph_->GetLoopHierarchy();
+    loops.ComputeInduction();
+    LoopInfo* candidate = nullptr;
+    intptr_t factor = 0;
+    bool exit_tests = true;
+    for (intptr_t i = 0; i < loops.num_loops(); ++i) {
+      LoopInfo* loop = loops.headers()[i]->loop_info();
+      if (IsCandidate(loop, &factor, &exit_tests)) {
+        candidate = loop;
+        break;
+      }
+    }
+    if (candidate == nullptr) {
+      break;
+    }
+    if (FLAG_trace_loop_unrolling) {
+      THR_Print("Unrolling loop B%" Pd " by %" Pd "%s in %s\n",
+                candidate->header()->block_id(), factor,
+                exit_tests ? "" : " without exit tests",
+                flow_graph_->function().ToFullyQualifiedCString());
+    }
+    unrolled_.Add(candidate->header());
+    Unroll(candidate, factor, exit_tests);
+    changed = true;
+  }
+  return changed;
+}
+
+bool LoopUnroller::TripCount(LoopInfo* loop, int64_t* trip_count) {
+  InductionVar* control = loop->control();
+  InductionVar* limit = nullptr;
+  for (auto bound : control->bounds()) {
+    if (bound.branch_ == loop->header()->last_instruction()) {
+      limit = bound.limit_;
+      break;
+    }
+  }
+  int64_t stride = 0;
+  int64_t begin = 0;
+  int64_t end = 0;
+  if (limit == nullptr || !InductionVar::IsLinear(control, &stride) ||
+      !InductionVar::IsConstant(control->initial(), &begin) ||
+      !InductionVar::IsConstant(limit, &end)) {
+    return false;
+  }
+  // The bound is strict and the stride is 1 or -1, see InductionVar::Bound.
+  const int64_t distance = (stride == 1) ? end - begin : begin - end;
+  *trip_count = Utils::Maximum<int64_t>(distance, 0);
+  return true;
+}
+
+bool LoopUnroller::IsCandidate(LoopInfo* loop,
+                               intptr_t* factor,
+                               bool* exit_tests) const {
+  if (loop->inner() != nullptr || loop->control() == nullptr) {
+    return false;
+  }
+  for (intptr_t i = 0; i < unrolled_.length(); ++i) {
+    if (unrolled_[i] == loop->header()) {
+      return false;
+    }
+  }
+  JoinEntryInstr* header = loop->header()->AsJoinEntry();
+  if (header == nullptr || header->PredecessorCount() != 2 ||
+      header->try_index() != kInvalidTryIndex) {
+    return false;
+  }
+  if (loop->back_edges().length() != 1) {
+    return false;
+  }
+  BlockEntryInstr* body = loop->back_edges()[0];
+  if (body == header || !body->IsTargetEntry() ||
+      body->PredecessorAt(0) != header || !body->last_instruction()->IsGoto()) {
+    return false;
+  }
+  for (BitVector::Iterator it(loop->blocks()); !it.Done(); it.Advance()) {
+    const intptr_t n = it.Current();
+    if (n != header->preorder_number() && n != body->preorder_number()) {
+      return false;
+    }
+  }
+
+  // The exit test is copied as is, so it must not need a deoptimization
+  // target of its own.
+  BranchInstr* exit_test = header->last_instruction()->AsBranch();
+  if (exit_test == nullptr || exit_test->comparison()->InputCount() != 2 ||
+      exit_test->comparison()->CanDeoptimize() ||
+      exit_test->comparison()->MayThrow()) {
+    return false;
+  }
+
+  for (ForwardInstructionIterator it(header); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current();
+    if (instr != exit_test && !LoopCloner::CanClone(instr)) {
+      return false;
+    }
+  }
+  for (ForwardInstructionIterator it(body); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current();
+    if (!instr->IsGoto() && !LoopCloner::CanClone(instr)) {
+      return false;
+    }
+  }
+
+  // With a known trip count, the largest factor that divides it lets every
+  // copy but the first skip the exit test. Loops that run fewer times than
+  // there would be copies are left alone.
+  *factor = FLAG_loop_unroll_factor;
+  *exit_tests = true;
+  int64_t trip_count = 0;
+  if (TripCount(loop, &trip_count)) {
+    if (trip_count < 2) {
+      return false;
+    }
+    for (intptr_t k = FLAG_loop_unroll_factor; k >= 2; --k) {
+      if (trip_count % k == 0) {
+        *factor = k;
+        *exit_tests = false;
+        break;
+      }
+    }
+  }
+
+  const intptr_t cost = CloneCost(header) + CloneCost(body) -
+                        (*exit_tests ? 0 : 1);
+  return cost * (*factor - 1) <= FLAG_loop_unroll_max_growth;
+}
+
+intptr_t LoopUnroller::CloneCost(BlockEntryInstr* block) const {
+  intptr_t cost = 0;
+  for (ForwardInstructionIterator it(block); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current();
+    if (!instr->IsCheckStackOverflow() && !instr->IsGoto()) {
+      cost++;
+    }
+  }
+  return cost;
+}
+
+void LoopUnroller::Unroll(LoopInfo* loop, intptr_t factor, bool exit_tests) {
+  JoinEntryInstr* header = loop->header()->AsJoinEntry();
+  TargetEntryInstr* body = loop->back_edges()[0]->AsTargetEntry();
+  BranchInstr* exit_test = header->last_instruction()->AsBranch();
+  const bool body_on_true = exit_test->true_successor() == body;
+  TargetEntryInstr* exit =
+      body_on_true ? exit_test->false_successor() : exit_test->true_successor();
+  const intptr_t back_edge_index = header->IndexOfPredecessor(body);
+  const double body_weight = body->edge_weight();
+
+  // Snapshot the code to copy before the body starts growing.
+  GrowableArray<Instruction*> header_code;
+  for (ForwardInstructionIterator it(header); !it.Done(); it.Advance()) {
+    if (it.Current() != exit_test && !it.Current()->IsCheckStackOverflow()) {
+      header_code.Add(it.Current());
+    }
+  }
+  GrowableArray<Instruction*> body_code;
+  for (ForwardInstructionIterator it(body); !it.Done(); it.Advance()) {
+    if (!it.Current()->IsGoto() && !it.Current()->IsCheckStackOverflow()) {
+      body_code.Add(it.Current());
+    }
+  }
+  GrowableArray<PhiInstr*> phis;
+  for (PhiIterator it(header); !it.Done(); it.Advance()) {
+    phis.Add(it.Current());
+  }
+
+  // With exit tests in the copies, the exit block becomes a join of all of
+  // them, and the original exit edge now goes through its own block into
+  // the join. Without them, the header remains the only way out.
+  LoopCloner cloner(flow_graph_);
+  if (exit_tests) {
+    cloner.PrepareExit(loop, exit);
+    cloner.ResetMap();
+    TargetEntryInstr* loop_exit = cloner.AddExit();
+    if (body_on_true) {
+      *exit_test->false_successor_address() = loop_exit;
+    } else {
+      *exit_test->true_successor_address() = loop_exit;
+    }
+  }
+
+  // Detach the back edge; it is re-attached after the last copy.
+  GotoInstr* back_edge = body->last_instruction()->AsGoto();
+  Instruction* cursor = back_edge->previous();
+  cursor->set_next(nullptr);
+  back_edge->set_previous(nullptr);
+  BlockEntryInstr* block = body;
+
+  GrowableArray<Definition*> next;
+  for (intptr_t copy = 1; copy < factor; ++copy) {
+    // Entering the copy takes the header phis around the back edge.
+    next.Clear();
+    for (intptr_t i = 0; i < phis.length(); ++i) {
+      next.Add(cloner.Lookup(phis[i]->InputAt(back_edge_index)->definition()));
+    }
+    cloner.ResetMap();
+    for (intptr_t i = 0; i < phis.length(); ++i) {
+      cloner.Map(phis[i], next[i]);
+    }
+
+    for (intptr_t i = 0; i < header_code.length(); ++i) {
+      cursor = cloner.AppendClone(cursor, header_code[i]);
+    }
+
+    if (exit_tests) {
+      BranchInstr* branch = cloner.CloneBranch(exit_test);
+      cursor->AppendInstruction(branch);
+      block->set_last_instruction(branch);
+
+      TargetEntryInstr* next_body = cloner.NewTarget(body, body_weight);
+      TargetEntryInstr* copy_exit = cloner.AddExit();
+      *branch->true_successor_address() = body_on_true ? next_body : copy_exit;
+      *branch->false_successor_address() = body_on_true ? copy_exit : next_body;
+
+      block = next_body;
+      cursor = next_body;
+    }
+    for (intptr_t i = 0; i < body_code.length(); ++i) {
+      cursor = cloner.AppendClone(cursor, body_code[i]);
+    }
+  }
+
+  // Close the loop from the last copy and let the header phis take the
+  // values it produced.
+  cursor->AppendInstruction(back_edge);
+  block->set_last_instruction(back_edge);
+  next.Clear();
+  for (intptr_t i = 0; i < phis.length(); ++i) {
+    next.Add(cloner.Lookup(phis[i]->InputAt(back_edge_index)->definition()));
+  }
+  for (intptr_t i = 0; i < phis.length(); ++i) {
+    phis[i]->InputAt(back_edge_index)->BindTo(next[i]);
+  }
+
+  flow_graph_->DiscoverBlocks();
+  LoopCloner::RestorePhiInputOrder(header, block, back_edge_index);
+  if (exit_tests) {
+    cloner.MergeExits();
+  }
+
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph_->ComputeDominators(&dominance_frontier);
+}
+
+}  // namespace dart
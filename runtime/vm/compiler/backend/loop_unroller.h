@@ -0,0 +1,69 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/loop_cloner.h"
+#include "vm/compiler/backend/loops.h"
+
+namespace dart {
+
+// Unrolls small counted loops.
+//
+// A loop qualifies when it is innermost and consists of just a header, which
+// ends in the exit test on its control induction (see LoopInfo::control()),
+// and a single body block that jumps back to the header:
+//
+//   H: phis; [CheckStackOverflow]; header code; Branch(exit test) B, X
+//   B: body; Goto H
+//
+// Unrolling by a factor of k replaces the back edge with k - 1 copies of the
+// header code, exit test and body, each of them renamed to consume the values
+// produced by the previous copy. What it saves is the per-iteration stack
+// overflow check, the phi moves and the jump back to the header. Copies keep
+// the deopt ids of their originals; their environments are renamed the same
+// way as their inputs, so deoptimizing in any copy resumes the unoptimized
+// loop at the right iteration.
+//
+// When the trip count is a known constant, k is the largest factor up to
+// --loop_unroll_factor that divides it, and the copies leave out the exit
+// test, since only the test in the header can fail. Otherwise every copy
+// keeps its own exit test, which is valid for any iteration count, and
+// values defined in the header and used after the loop are merged from all
+// exits with new phis in the exit block.
+class LoopUnroller : public ValueObject {
+ public:
+  explicit LoopUnroller(FlowGraph* flow_graph);
+
+  // Returns true if any loop was unrolled.
+  bool Optimize();
+
+ private:
+  // Returns true if [loop] can be unrolled, and sets the unroll [factor] and
+  // whether the copies need [exit_tests].
+  bool IsCandidate(LoopInfo* loop, intptr_t* factor, bool* exit_tests) const;
+  intptr_t CloneCost(BlockEntryInstr* block) const;
+
+  // Returns true if the number of iterations of [loop] is a known constant,
+  // and sets [trip_count] to it.
+  static bool TripCount(LoopInfo* loop, int64_t* trip_count);
+
+  void Unroll(LoopInfo* loop, intptr_t factor, bool exit_tests);
+
+  FlowGraph* const flow_graph_;
+
+  // Headers of the loops unrolled so far, which are not unrolled again.
+  GrowableArray<BlockEntryInstr*> unrolled_;
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_UNROLLER_H_
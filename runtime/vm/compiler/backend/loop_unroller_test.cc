@@ -0,0 +1,206 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_unroller.h"
+
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+DECLARE_FLAG(bool, loop_unrolling);
+DECLARE_FLAG(int, loop_unroll_factor);
+DECLARE_FLAG(int, loop_unroll_max_growth);
+
+static const char* kSumScript = R"(
+    import 'dart:typed_data';
+
+    int sum(Uint8List list) {
+      int result = 0;
+      for (int i = 0; i < list.length; i++) {
+        result += list[i];
+      }
+      return result;
+    }
+
+    Uint8List makeList(int length) {
+      final list = Uint8List(length);
+      for (int i = 0; i < length; i++) {
+        list[i] = i;
+      }
+      return list;
+    }
+
+    int sumEven() => sum(makeList(8));
+    int sumOdd() => sum(makeList(7));
+
+    void main() {
+      for (int i = 0; i < 100; i++) {
+        sum(makeList(i));
+      }
+    }
+  )";
+
+static intptr_t Count(FlowGraph* flow_graph, Instruction::Tag tag) {
+  intptr_t count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (it.Current()->tag() == tag) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+static intptr_t CountLoadIndexed(FlowGraph* flow_graph) {
+  return Count(flow_graph, Instruction::kLoadIndexed);
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopUnroller_CountedLoop) {
+  SetFlagScope<bool> sfs(&FLAG_loop_unrolling, true);
+  SetFlagScope<int> factor(&FLAG_loop_unroll_factor, 2);
+
+  const auto& root_library = Library::Handle(LoadTestScript(kSumScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "sum"));
+
+  Invoke(root_library, "main");
+
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  EXPECT_EQ(2, CountLoadIndexed(flow_graph));
+
+  pipeline.CompileGraphAndAttachFunction();
+
+  // Both an even and an odd number of iterations leave through the right
+  // exit with the right sum.
+  const auto& even = Object::Handle(Invoke(root_library, "sumEven"));
+  EXPECT(even.IsInteger());
+  EXPECT_EQ(28, Integer::Cast(even).AsInt64Value());
+  const auto& odd = Object::Handle(Invoke(root_library, "sumOdd"));
+  EXPECT(odd.IsInteger());
+  EXPECT_EQ(21, Integer::Cast(odd).AsInt64Value());
+}
+
+static const char* kFixedSumScript = R"(
+    import 'dart:typed_data';
+
+    int sum8(Uint8List list) {
+      int result = 0;
+      for (int i = 0; i < 8; i++) {
+        result += list[i];
+      }
+      return result;
+    }
+
+    int sum7(Uint8List list) {
+      int result = 0;
+      for (int i = 0; i < 7; i++) {
+        result += list[i];
+      }
+      return result;
+    }
+
+    Uint8List makeList() {
+      final list = Uint8List(8);
+      for (int i = 0; i < 8; i++) {
+        list[i] = i;
+      }
+      return list;
+    }
+
+    int callSum8() => sum8(makeList());
+    int callSum7() => sum7(makeList());
+
+    void main() {
+      for (int i = 0; i < 100; i++) {
+        callSum8();
+        callSum7();
+      }
+    }
+  )";
+
+// Returns the number of branches added by unrolling [function] by [factor].
+static intptr_t UnrollAndCountBranches(const Function& function,
+                                       intptr_t factor,
+                                       intptr_t* load_indexed) {
+  intptr_t branches = 0;
+  {
+    SetFlagScope<bool> sfs(&FLAG_loop_unrolling, false);
+    TestPipeline pipeline(function, CompilerPass::kJIT);
+    branches -= Count(pipeline.RunPasses({}), Instruction::kBranch);
+  }
+  SetFlagScope<bool> sfs(&FLAG_loop_unrolling, true);
+  SetFlagScope<int> unroll_factor(&FLAG_loop_unroll_factor, factor);
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  branches += Count(flow_graph, Instruction::kBranch);
+  *load_indexed = CountLoadIndexed(flow_graph);
+  return branches;
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopUnroller_KnownTripCount) {
+  const auto& root_library = Library::Handle(LoadTestScript(kFixedSumScript));
+  const auto& sum8 = Function::Handle(GetFunction(root_library, "sum8"));
+  const auto& sum7 = Function::Handle(GetFunction(root_library, "sum7"));
+
+  Invoke(root_library, "main");
+
+  // 8 iterations are unrolled by 2 without an exit test in the copy.
+  intptr_t load_indexed = 0;
+  EXPECT_EQ(0, UnrollAndCountBranches(sum8, 2, &load_indexed));
+  EXPECT_EQ(2, load_indexed);
+
+  // The factor is reduced to one that divides the trip count.
+  EXPECT_EQ(0, UnrollAndCountBranches(sum8, 3, &load_indexed));
+  EXPECT_EQ(2, load_indexed);
+  EXPECT_EQ(0, UnrollAndCountBranches(sum8, 4, &load_indexed));
+  EXPECT_EQ(4, load_indexed);
+
+  // 7 iterations are not a multiple of 2, so the copy keeps its exit test.
+  EXPECT_EQ(1, UnrollAndCountBranches(sum7, 2, &load_indexed));
+  EXPECT_EQ(2, load_indexed);
+
+  {
+    SetFlagScope<bool> sfs(&FLAG_loop_unrolling, true);
+    SetFlagScope<int> factor(&FLAG_loop_unroll_factor, 4);
+    TestPipeline pipeline(sum8, CompilerPass::kJIT);
+    pipeline.RunPasses({});
+    pipeline.CompileGraphAndAttachFunction();
+  }
+  const auto& result8 = Object::Handle(Invoke(root_library, "callSum8"));
+  EXPECT(result8.IsInteger());
+  EXPECT_EQ(28, Integer::Cast(result8).AsInt64Value());
+
+  {
+    SetFlagScope<bool> sfs(&FLAG_loop_unrolling, true);
+    SetFlagScope<int> factor(&FLAG_loop_unroll_factor, 2);
+    TestPipeline pipeline(sum7, CompilerPass::kJIT);
+    pipeline.RunPasses({});
+    pipeline.CompileGraphAndAttachFunction();
+  }
+  const auto& result7 = Object::Handle(Invoke(root_library, "callSum7"));
+  EXPECT(result7.IsInteger());
+  EXPECT_EQ(21, Integer::Cast(result7).AsInt64Value());
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopUnroller_GrowthLimit) {
+  SetFlagScope<bool> sfs(&FLAG_loop_unrolling, true);
+  SetFlagScope<int> growth(&FLAG_loop_unroll_max_growth, 0);
+
+  const auto& root_library = Library::Handle(LoadTestScript(kSumScript));
+  const auto& function = Function::Handle(GetFunction(root_library, "sum"));
+
+  Invoke(root_library, "main");
+
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  EXPECT_EQ(1, CountLoadIndexed(flow_graph));
+}
+
+}  // namespace dart
@@ -0,0 +1,566 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_vectorizer.h"
+
+#include "vm/compiler/backend/flow_graph_compiler.h"
+#include "vm/compiler/backend/range_analysis.h"
+#include "vm/compiler/runtime_api.h"
+#include "vm/flags.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool,
+            loop_vectorization,
+            true,
+            "Vectorize element-wise loops over typed data.");
+DEFINE_FLAG(bool, trace_loop_vectorization, false, "Trace loop vectorization.");
+
+DECLARE_FLAG(bool, enable_simd_inline);
+
+// Typed data class id used to access [lanes] elements of the given array
+// class id at once.
+static intptr_t VectorArrayCid(intptr_t element_cid) {
+  switch (element_cid) {
+    case kTypedDataFloat32ArrayCid:
+      return kTypedDataFloat32x4ArrayCid;
+    case kTypedDataFloat64ArrayCid:
+      return kTypedDataFloat64x2ArrayCid;
+    case kTypedDataInt32ArrayCid:
+      return kTypedDataInt32x4ArrayCid;
+    default:
+      return kIllegalCid;
+  }
+}
+
+static intptr_t VectorCid(intptr_t element_cid) {
+  switch (element_cid) {
+    case kTypedDataFloat32ArrayCid:
+      return kFloat32x4Cid;
+    case kTypedDataFloat64ArrayCid:
+      return kFloat64x2Cid;
+    case kTypedDataInt32ArrayCid:
+      return kInt32x4Cid;
+    default:
+      UNREACHABLE();
+      return kIllegalCid;
+  }
+}
+
+static intptr_t LanesFor(intptr_t element_cid) {
+  return element_cid == kTypedDataFloat64ArrayCid ? 2 : 4;
+}
+
+LoopVectorizer::LoopVectorizer(FlowGraph* flow_graph)
+    : flow_graph_(flow_graph),
+      zone_(flow_graph->zone()),
+      epilogues_(),
+      map_() {}
+
+bool LoopVectorizer::Optimize() {
+  if (!FLAG_loop_vectorization || !FLAG_enable_simd_inline ||
+      !FlowGraphCompiler::SupportsUnboxedSimd128()) {
+    return false;
+  }
+  // Loops entered from the OSR entry would skip the vector loop.
+  if (flow_graph_->IsCompiledForOsr()) {
+    return false;
+  }
+
+  // Vectorizing rewrites the block order, dominators and loop hierarchy, so
+  // candidates are looked up again after every transformation.
+  bool changed = false;
+  while (true) {
+    const LoopHierarchy& loops = flow_graph_->GetLoopHierarchy();
+    loops.ComputeInduction();
+    Plan plan;
+    bool found = false;
+    for (intptr_t i = 0; i < loops.num_loops(); ++i) {
+      plan = Plan();
+      if (IsCandidate(loops.headers()[i]->loop_info(), &plan)) {
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      break;
+    }
+    if (FLAG_trace_loop_vectorization) {
+      THR_Print("Vectorizing loop B%" Pd " (%" Pd " lanes) in %s\n",
+                plan.header->block_id(), LanesFor(plan.element_cid),
+                flow_graph_->function().ToFullyQualifiedCString());
+    }
+    Vectorize(plan);
+    changed = true;
+  }
+  return changed;
+}
+
+bool LoopVectorizer::IsInvariant(LoopInfo* loop, Definition* def) const {
+  return !loop->Contains(def->GetBlock());
+}
+
+bool LoopVectorizer::IsCandidate(LoopInfo* loop, Plan* plan) {
+  if (loop->inner() != nullptr || loop->control() == nullptr) {
+    return false;
+  }
+  JoinEntryInstr* header = loop->header()->AsJoinEntry();
+  if (header == nullptr || header->PredecessorCount() != 2 ||
+      header->try_index() != kInvalidTryIndex) {
+    return false;
+  }
+  for (intptr_t i = 0; i < epilogues_.length(); ++i) {
+    if (epilogues_[i] == header->block_id()) {
+      return false;
+    }
+  }
+  if (loop->back_edges().length() != 1) {
+    return false;
+  }
+  TargetEntryInstr* body = loop->back_edges()[0]->AsTargetEntry();
+  if (body == nullptr || body->PredecessorAt(0) != header ||
+      !body->last_instruction()->IsGoto()) {
+    return false;
+  }
+  for (BitVector::Iterator it(loop->blocks()); !it.Done(); it.Advance()) {
+    const intptr_t n = it.Current();
+    if (n != header->preorder_number() && n != body->preorder_number()) {
+      return false;
+    }
+  }
+  const intptr_t back_edge_index = header->IndexOfPredecessor(body);
+  BlockEntryInstr* preheader = header->PredecessorAt(1 - back_edge_index);
+  if (!preheader->last_instruction()->IsGoto()) {
+    return false;
+  }
+
+  // The induction must be the only value carried around the loop.
+  if (header->phis() == nullptr || header->phis()->length() != 1) {
+    return false;
+  }
+  PhiInstr* induction = (*header->phis())[0];
+  const Representation rep = induction->representation();
+  if (rep != kTagged && rep != kUnboxedInt64) {
+    return false;
+  }
+
+  // Exit test i < n, taken into the body, with n known to be non-negative
+  // so that n - (lanes - 1) cannot overflow.
+  BranchInstr* exit_test = header->last_instruction()->AsBranch();
+  RelationalOpInstr* compare = exit_test->comparison()->AsRelationalOp();
+  if (compare == nullptr || compare->kind() != Token::kLT ||
+      exit_test->true_successor() != body ||
+      compare->left()->definition() != induction) {
+    return false;
+  }
+  Definition* bound = compare->right()->definition();
+  if (!IsInvariant(loop, bound) || bound->representation() != rep ||
+      !RangeUtils::IsPositive(bound->range())) {
+    return false;
+  }
+  if (compare->operation_cid() != (rep == kTagged ? kSmiCid : kMintCid)) {
+    return false;
+  }
+
+  // Step i + 1.
+  BinaryIntegerOpInstr* increment =
+      induction->InputAt(back_edge_index)->definition()->AsBinaryIntegerOp();
+  if (increment == nullptr || increment->op_kind() != Token::kADD ||
+      increment->GetBlock() != body ||
+      increment->representation() != rep ||
+      increment->left()->definition() != induction ||
+      !increment->right()->BindsToSmiConstant() ||
+      increment->right()->BoundSmiConstant() != 1 ||
+      increment->CanDeoptimize()) {
+    return false;
+  }
+
+  plan->header = header;
+  plan->body = body;
+  plan->preheader = preheader;
+  plan->induction = induction;
+  plan->increment = increment;
+  plan->bound = bound;
+
+  for (ForwardInstructionIterator it(header); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current();
+    if (instr == exit_test) continue;
+    if (auto check = instr->AsCheckStackOverflow()) {
+      plan->check = check;
+      continue;
+    }
+    return false;
+  }
+
+  // Vector definitions are marked in the map while the body is checked.
+  map_.Clear();
+  for (intptr_t i = 0; i < flow_graph_->current_ssa_temp_index(); ++i) {
+    map_.Add(nullptr);
+  }
+  bool has_store = false;
+  Definition* first_array = nullptr;
+  bool has_untagged_array = false;
+  bool single_array = true;
+  for (ForwardInstructionIterator it(body); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current();
+    if (instr == increment || instr->IsGoto()) continue;
+    if (auto check = instr->AsCheckStackOverflow()) {
+      if (plan->check == nullptr) plan->check = check;
+      continue;
+    }
+    if (!CanVectorize(loop, instr, plan)) {
+      return false;
+    }
+    Definition* array = nullptr;
+    if (auto load = instr->AsLoadIndexed()) {
+      array = load->array()->definition();
+    } else if (auto store = instr->AsStoreIndexed()) {
+      array = store->array()->definition();
+      has_store = true;
+    }
+    if (array != nullptr) {
+      if (first_array == nullptr) first_array = array;
+      single_array = single_array && (array == first_array);
+      has_untagged_array =
+          has_untagged_array || (array->representation() == kUntagged);
+    }
+  }
+  if (!has_store) {
+    return false;
+  }
+  // Distinct typed data objects never overlap, but untagged pointers into
+  // views or external data might. Reading several lanes ahead of a store
+  // is only safe when that cannot happen.
+  if (has_untagged_array && !single_array) {
+    return false;
+  }
+
+  // The vector loop reuses the stack overflow check with vi standing for i.
+  if (plan->check != nullptr && plan->check->env() != nullptr) {
+    for (Environment::DeepIterator it(plan->check->env()); !it.Done();
+         it.Advance()) {
+      Definition* def = it.CurrentValue()->definition();
+      if (def != induction && !IsInvariant(loop, def)) {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool LoopVectorizer::CanVectorize(LoopInfo* loop,
+                                  Instruction* instr,
+                                  Plan* plan) {
+  if (instr->CanDeoptimize() || instr->MayThrow()) {
+    return false;
+  }
+  auto is_vector = [&](Value* value) {
+    return Lookup(value->definition()) != nullptr;
+  };
+  auto is_element_access = [&](intptr_t cid, Value* array, Value* index,
+                               bool aligned, intptr_t index_scale) {
+    if (VectorArrayCid(cid) == kIllegalCid) return false;
+    if (plan->element_cid == kIllegalCid) plan->element_cid = cid;
+    return cid == plan->element_cid && aligned &&
+           index->definition() == plan->induction &&
+           index_scale == compiler::target::Instance::ElementSizeFor(cid) &&
+           IsInvariant(loop, array->definition());
+  };
+
+  if (auto load = instr->AsLoadIndexed()) {
+    if (!is_element_access(load->class_id(), load->array(), load->index(),
+                           load->aligned(), load->index_scale())) {
+      return false;
+    }
+    Map(load, load);
+    return true;
+  }
+
+  if (auto store = instr->AsStoreIndexed()) {
+    if (!is_element_access(store->class_id(), store->array(), store->index(),
+                           store->aligned(), store->index_scale())) {
+      return false;
+    }
+    // Fill loops store a splatted invariant.
+    Definition* value = store->value()->definition();
+    return is_vector(store->value()) ||
+           (plan->element_cid != kTypedDataInt32ArrayCid &&
+            IsInvariant(loop, value) &&
+            value->representation() == kUnboxedDouble);
+  }
+
+  if (auto op = instr->AsBinaryDoubleOp()) {
+    switch (op->op_kind()) {
+      case Token::kADD:
+      case Token::kSUB:
+      case Token::kMUL:
+      case Token::kDIV:
+        break;
+      default:
+        return false;
+    }
+    if (plan->element_cid == kTypedDataFloat64ArrayCid) {
+      // Float64x2 lanes compute exactly what the scalar code computes, so
+      // any tree of operations over elements and invariants qualifies.
+      for (intptr_t i = 0; i < 2; ++i) {
+        Definition* input = op->InputAt(i)->definition();
+        if (!is_vector(op->InputAt(i)) &&
+            !(IsInvariant(loop, input) &&
+              input->representation() == kUnboxedDouble)) {
+          return false;
+        }
+      }
+    } else if (plan->element_cid == kTypedDataFloat32ArrayCid) {
+      // The scalar code widens Float32 elements to double and rounds the
+      // result when storing it. That matches a Float32x4 operation only for
+      // a single operation between two loaded elements.
+      for (intptr_t i = 0; i < 2; ++i) {
+        if (!is_vector(op->InputAt(i)) ||
+            !op->InputAt(i)->definition()->IsLoadIndexed()) {
+          return false;
+        }
+      }
+      for (Value::Iterator it(op->input_use_list()); !it.Done();
+           it.Advance()) {
+        if (!it.Current()->instruction()->IsStoreIndexed() ||
+            it.Current()->use_index() != StoreIndexedInstr::kValuePos) {
+          return false;
+        }
+      }
+    } else {
+      return false;
+    }
+    Map(op, op);
+    return true;
+  }
+
+  // Int32x4 lanes wrap around, which gives the low 32 bits of the scalar
+  // result for these operations no matter how wide the scalar code is.
+  if (instr->IsBinaryInt64Op() || instr->IsBinaryInt32Op() ||
+      instr->IsBinaryUint32Op()) {
+    auto op = instr->AsBinaryIntegerOp();
+    switch (op->op_kind()) {
+      case Token::kADD:
+      case Token::kSUB:
+      case Token::kBIT_AND:
+      case Token::kBIT_OR:
+      case Token::kBIT_XOR:
+        break;
+      default:
+        return false;
+    }
+    if (plan->element_cid != kTypedDataInt32ArrayCid ||
+        !is_vector(op->left()) || !is_vector(op->right())) {
+      return false;
+    }
+    Map(op, op);
+    return true;
+  }
+
+  if (auto conv = instr->AsIntConverter()) {
+    if (plan->element_cid != kTypedDataInt32ArrayCid ||
+        !is_vector(conv->value())) {
+      return false;
+    }
+    Map(conv, conv);
+    return true;
+  }
+
+  return false;
+}
+
+void LoopVectorizer::Vectorize(const Plan& plan) {
+  JoinEntryInstr* header = plan.header;
+  TargetEntryInstr* body = plan.body;
+  BranchInstr* exit_test = header->last_instruction()->AsBranch();
+  RelationalOpInstr* compare = exit_test->comparison()->AsRelationalOp();
+  const intptr_t back_edge_index = header->IndexOfPredecessor(body);
+  const intptr_t entry_index = 1 - back_edge_index;
+  const Representation rep = plan.induction->representation();
+  const intptr_t lanes = LanesFor(plan.element_cid);
+  const intptr_t vector_array_cid = VectorArrayCid(plan.element_cid);
+  GotoInstr* entry = plan.preheader->last_instruction()->AsGoto();
+
+  for (intptr_t i = 0; i < map_.length(); ++i) {
+    map_[i] = nullptr;
+  }
+
+  auto constant = [&](intptr_t value) -> Definition* {
+    return flow_graph_->GetConstant(Smi::ZoneHandle(zone_, Smi::New(value)),
+                                    rep);
+  };
+
+  // The last index at which a full vector still fits below the bound.
+  Definition* vector_bound = BinaryIntegerOpInstr::Make(
+      rep, Token::kSUB, new (zone_) Value(plan.bound),
+      new (zone_) Value(constant(lanes - 1)), DeoptId::kNone,
+      /*can_overflow=*/false, /*is_truncating=*/false, /*range=*/nullptr,
+      Instruction::kNotSpeculative);
+  flow_graph_->InsertBefore(entry, vector_bound, nullptr, FlowGraph::kValue);
+
+  JoinEntryInstr* vector_header = new (zone_)
+      JoinEntryInstr(flow_graph_->allocate_block_id(), header->try_index(),
+                     DeoptId::kNone);
+  PhiInstr* vector_index = new (zone_) PhiInstr(vector_header, 2);
+  vector_index->set_representation(rep);
+  vector_index->mark_alive();
+  flow_graph_->AllocateSSAIndexes(vector_index);
+  vector_header->InsertPhi(vector_index);
+
+  Instruction* cursor = vector_header;
+  if (plan.check != nullptr) {
+    CheckStackOverflowInstr* check = new (zone_) CheckStackOverflowInstr(
+        plan.check->source(), plan.check->stack_depth(),
+        plan.check->loop_depth(), plan.check->deopt_id(),
+        CheckStackOverflowInstr::kOsrAndPreemption);
+    if (plan.check->env() != nullptr) {
+      // Deoptimizing here resumes the unoptimized loop at i = vi.
+      plan.check->env()->DeepCopyTo(zone_, check);
+      for (Environment::DeepIterator it(check->env()); !it.Done();
+           it.Advance()) {
+        if (it.CurrentValue()->definition() == plan.induction) {
+          it.CurrentValue()->BindToEnvironment(vector_index);
+        }
+      }
+    }
+    cursor = cursor->AppendInstruction(check);
+  }
+  BranchInstr* vector_test = new (zone_) BranchInstr(
+      compare->CopyWithNewOperands(new (zone_) Value(vector_index),
+                                   new (zone_) Value(vector_bound)),
+      DeoptId::kNone);
+  cursor->AppendInstruction(vector_test);
+  vector_header->set_last_instruction(vector_test);
+
+  TargetEntryInstr* vector_body = new (zone_) TargetEntryInstr(
+      flow_graph_->allocate_block_id(), header->try_index(), DeoptId::kNone);
+  vector_body->set_edge_weight(body->edge_weight());
+  TargetEntryInstr* vector_exit = new (zone_) TargetEntryInstr(
+      flow_graph_->allocate_block_id(), header->try_index(), DeoptId::kNone);
+  vector_exit->set_edge_weight(exit_test->false_successor()->edge_weight());
+  *vector_test->true_successor_address() = vector_body;
+  *vector_test->false_successor_address() = vector_exit;
+
+  cursor = vector_body;
+  for (ForwardInstructionIterator it(body); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current();
+    if (instr == plan.increment || instr->IsGoto() ||
+        instr->IsCheckStackOverflow()) {
+      continue;
+    }
+    if (auto load = instr->AsLoadIndexed()) {
+      LoadIndexedInstr* vector = new (zone_) LoadIndexedInstr(
+          new (zone_) Value(load->array()->definition()),
+          new (zone_) Value(vector_index), load->index_unboxed(),
+          load->index_scale(), vector_array_cid, kAlignedAccess,
+          DeoptId::kNone, load->source());
+      cursor =
+          flow_graph_->AppendTo(cursor, vector, nullptr, FlowGraph::kValue);
+      Map(load, vector);
+    } else if (auto store = instr->AsStoreIndexed()) {
+      StoreIndexedInstr* vector = new (zone_) StoreIndexedInstr(
+          new (zone_) Value(store->array()->definition()),
+          new (zone_) Value(vector_index),
+          new (zone_) Value(VectorOperand(plan, store->value()->definition())),
+          kNoStoreBarrier, store->index_unboxed(), store->index_scale(),
+          vector_array_cid, kAlignedAccess, DeoptId::kNone, store->source(),
+          Instruction::kNotSpeculative);
+      cursor =
+          flow_graph_->AppendTo(cursor, vector, nullptr, FlowGraph::kEffect);
+    } else if (auto conv = instr->AsIntConverter()) {
+      // All lanes are 32 bits wide already.
+      Map(conv, Lookup(conv->value()->definition()));
+    } else {
+      const Token::Kind op_kind =
+          instr->IsBinaryDoubleOp() ? instr->AsBinaryDoubleOp()->op_kind()
+                                    : instr->AsBinaryIntegerOp()->op_kind();
+      SimdOpInstr* vector = SimdOpInstr::Create(
+          SimdOpInstr::KindForOperator(VectorCid(plan.element_cid), op_kind),
+          new (zone_)
+              Value(VectorOperand(plan, instr->InputAt(0)->definition())),
+          new (zone_)
+              Value(VectorOperand(plan, instr->InputAt(1)->definition())),
+          DeoptId::kNone);
+      cursor =
+          flow_graph_->AppendTo(cursor, vector, nullptr, FlowGraph::kValue);
+      Map(instr->AsDefinition(), vector);
+    }
+  }
+  Definition* next_index = BinaryIntegerOpInstr::Make(
+      rep, Token::kADD, new (zone_) Value(vector_index),
+      new (zone_) Value(constant(lanes)), DeoptId::kNone,
+      /*can_overflow=*/false, /*is_truncating=*/false, /*range=*/nullptr,
+      Instruction::kNotSpeculative);
+  cursor =
+      flow_graph_->AppendTo(cursor, next_index, nullptr, FlowGraph::kValue);
+  GotoInstr* back_edge = new (zone_) GotoInstr(vector_header, DeoptId::kNone);
+  cursor->AppendInstruction(back_edge);
+  vector_body->set_last_instruction(back_edge);
+
+  // The original loop becomes the epilogue and starts where the vector loop
+  // stopped.
+  GotoInstr* to_epilogue = new (zone_) GotoInstr(header, DeoptId::kNone);
+  vector_exit->AppendInstruction(to_epilogue);
+  vector_exit->set_last_instruction(to_epilogue);
+  entry->set_successor(vector_header);
+  Definition* initial = plan.induction->InputAt(entry_index)->definition();
+  plan.induction->InputAt(entry_index)->BindTo(vector_index);
+
+  flow_graph_->DiscoverBlocks();
+
+  // Predecessors of joins are kept sorted by block id.
+  if (header->IndexOfPredecessor(vector_exit) != entry_index) {
+    Value* first = plan.induction->InputAt(0);
+    Value* second = plan.induction->InputAt(1);
+    plan.induction->SetInputAt(0, second);
+    plan.induction->SetInputAt(1, first);
+  }
+  Value* initial_value = new (zone_) Value(initial);
+  vector_index->SetInputAt(
+      vector_header->IndexOfPredecessor(plan.preheader), initial_value);
+  initial->AddInputUse(initial_value);
+  Value* next_value = new (zone_) Value(next_index);
+  vector_index->SetInputAt(vector_header->IndexOfPredecessor(vector_body),
+                           next_value);
+  next_index->AddInputUse(next_value);
+
+  epilogues_.Add(header->block_id());
+
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph_->ComputeDominators(&dominance_frontier);
+}
+
+Definition* LoopVectorizer::VectorOperand(const Plan& plan, Definition* def) {
+  Definition* vector = Lookup(def);
+  if (vector != nullptr) {
+    return vector;
+  }
+  // A loop invariant is splatted across all lanes once, before the loop.
+  ASSERT(def->representation() == kUnboxedDouble);
+  SimdOpInstr* splat = SimdOpInstr::Create(
+      plan.element_cid == kTypedDataFloat32ArrayCid
+          ? SimdOpInstr::kFloat32x4Splat
+          : SimdOpInstr::kFloat64x2Splat,
+      new (zone_) Value(def), DeoptId::kNone);
+  flow_graph_->InsertBefore(plan.preheader->last_instruction(), splat, nullptr,
+                            FlowGraph::kValue);
+  Map(def, splat);
+  return splat;
+}
+
+Definition* LoopVectorizer::Lookup(Definition* def) const {
+  const intptr_t index = def->ssa_temp_index();
+  if (index >= 0 && index < map_.length()) {
+    return map_[index];
+  }
+  return nullptr;
+}
+
+void LoopVectorizer::Map(Definition* original, Definition* vector) {
+  const intptr_t index = original->ssa_temp_index();
+  ASSERT(index >= 0 && index < map_.length());
+  map_[index] = vector;
+}
+
+}  // namespace dart
@@ -0,0 +1,81 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/loops.h"
+
+namespace dart {
+
+// Rewrites element-wise loops over Float32List, Float64List and Int32List
+// into loops over Float32x4, Float64x2 and Int32x4 lanes.
+//
+// A loop qualifies when it has the shape
+//
+//   H: i = phi(i0, i + 1); [CheckStackOverflow]; Branch(i < n) B, X
+//   B: element-wise body indexed by i; Goto H
+//
+// and its body only loads and stores elements at index i, combines them with
+// operations that have an exact SIMD counterpart, and stores them back at
+// index i. The vectorized loop is inserted in front of the original one:
+//
+//   P:  n' = n - (lanes - 1); Goto VH
+//   VH: vi = phi(i0, vi + lanes); [CheckStackOverflow]; Branch(vi < n') VB, H
+//   VB: vector body indexed by vi; Goto VH
+//
+// and the original loop, entered with i = vi, becomes the scalar epilogue
+// that handles the remaining iterations. The vector loop only touches
+// indices the scalar loop would have touched, so it relies on the bounds
+// checks range analysis already eliminated.
+class LoopVectorizer : public ValueObject {
+ public:
+  explicit LoopVectorizer(FlowGraph* flow_graph);
+
+  // Returns true if any loop was vectorized.
+  bool Optimize();
+
+ private:
+  // What needs to be known about a vectorizable loop.
+  struct Plan {
+    JoinEntryInstr* header = nullptr;
+    TargetEntryInstr* body = nullptr;
+    BlockEntryInstr* preheader = nullptr;
+    PhiInstr* induction = nullptr;
+    Definition* increment = nullptr;
+    Definition* bound = nullptr;
+    CheckStackOverflowInstr* check = nullptr;
+    intptr_t element_cid = kIllegalCid;
+  };
+
+  bool IsCandidate(LoopInfo* loop, Plan* plan);
+  bool CanVectorize(LoopInfo* loop, Instruction* instr, Plan* plan);
+  bool IsInvariant(LoopInfo* loop, Definition* def) const;
+
+  void Vectorize(const Plan& plan);
+
+  Definition* VectorOperand(const Plan& plan, Definition* def);
+
+  Definition* Lookup(Definition* def) const;
+  void Map(Definition* original, Definition* vector);
+
+  FlowGraph* const flow_graph_;
+  Zone* const zone_;
+
+  // Block ids of loops that were turned into scalar epilogues.
+  GrowableArray<intptr_t> epilogues_;
+
+  // Vector counterparts of scalar definitions, indexed by SSA temp index.
+  GrowableArray<Definition*> map_;
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_VECTORIZER_H_
@@ -0,0 +1,163 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_vectorizer.h"
+
+#include "vm/compiler/backend/flow_graph_compiler.h"
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+static intptr_t CountSimdOps(FlowGraph* flow_graph) {
+  intptr_t count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (it.Current()->IsSimdOp()) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+static FlowGraph* CompileAndRun(const Library& root_library,
+                                const char* name) {
+  const auto& function = Function::Handle(GetFunction(root_library, name));
+  TestPipeline pipeline(function, CompilerPass::kJIT);
+  FlowGraph* flow_graph = pipeline.RunPasses({});
+  pipeline.CompileGraphAndAttachFunction();
+  return flow_graph;
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_Float64Add) {
+  if (!FlowGraphCompiler::SupportsUnboxedSimd128()) return;
+
+  const char* kScript = R"(
+    import 'dart:typed_data';
+
+    void add(Float64List a, Float64List b, Float64List c) {
+      for (int i = 0; i < c.length; i++) {
+        c[i] = a[i] + b[i];
+      }
+    }
+
+    double check(int length) {
+      final a = Float64List(length);
+      final b = Float64List(length);
+      final c = Float64List(length);
+      for (int i = 0; i < length; i++) {
+        a[i] = i.toDouble();
+        b[i] = 0.5;
+      }
+      add(a, b, c);
+      double sum = 0.0;
+      for (int i = 0; i < length; i++) {
+        sum += c[i];
+      }
+      return sum;
+    }
+
+    double checkOdd() => check(7);
+
+    void main() {
+      for (int i = 0; i < 100; i++) {
+        check(i);
+      }
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+
+  FlowGraph* flow_graph = CompileAndRun(root_library, "add");
+  EXPECT_EQ(1, CountSimdOps(flow_graph));
+
+  // The scalar epilogue handles the last element of an odd length.
+  const auto& result = Object::Handle(Invoke(root_library, "checkOdd"));
+  EXPECT(result.IsDouble());
+  EXPECT_EQ(24.5, Double::Cast(result).value());
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_Int32Xor) {
+  if (!FlowGraphCompiler::SupportsUnboxedSimd128()) return;
+
+  const char* kScript = R"(
+    import 'dart:typed_data';
+
+    void xor(Int32List a, Int32List b, Int32List c) {
+      for (int i = 0; i < c.length; i++) {
+        c[i] = a[i] ^ b[i];
+      }
+    }
+
+    int check(int length) {
+      final a = Int32List(length);
+      final b = Int32List(length);
+      final c = Int32List(length);
+      for (int i = 0; i < length; i++) {
+        a[i] = i;
+        b[i] = -1;
+      }
+      xor(a, b, c);
+      int sum = 0;
+      for (int i = 0; i < length; i++) {
+        sum += c[i];
+      }
+      return sum;
+    }
+
+    int checkOdd() => check(6);
+
+    void main() {
+      for (int i = 0; i < 100; i++) {
+        check(i);
+      }
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+
+  FlowGraph* flow_graph = CompileAndRun(root_library, "xor");
+  EXPECT_EQ(1, CountSimdOps(flow_graph));
+
+  // ~i summed over 0..5.
+  const auto& result = Object::Handle(Invoke(root_library, "checkOdd"));
+  EXPECT(result.IsInteger());
+  EXPECT_EQ(-21, Integer::Cast(result).AsInt64Value());
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVectorizer_InductionAsValue) {
+  if (!FlowGraphCompiler::SupportsUnboxedSimd128()) return;
+
+  const char* kScript = R"(
+    import 'dart:typed_data';
+
+    void iota(Float64List a) {
+      for (int i = 0; i < a.length; i++) {
+        a[i] = i.toDouble();
+      }
+    }
+
+    void main() {
+      for (int i = 0; i < 100; i++) {
+        iota(Float64List(i));
+      }
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+
+  // Stored values depend on the lane, which is not supported.
+  FlowGraph* flow_graph = CompileAndRun(root_library, "iota");
+  EXPECT_EQ(0, CountSimdOps(flow_graph));
+}
+
+}  // namespace dart
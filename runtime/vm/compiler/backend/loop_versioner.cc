@@ -0,0 +1,487 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_versioner.h"
+
+#include "vm/bit_vector.h"
+#include "vm/compiler/backend/loop_cloner.h"
+#include "vm/compiler/backend/range_analysis.h"
+#include "vm/compiler/runtime_api.h"
+#include "vm/flags.h"
+
+namespace dart {
+
+DEFINE_FLAG(bool,
+            loop_versioning,
+            true,
+            "Version loops to remove bounds and null checks.");
+DEFINE_FLAG(int,
+            loop_versioning_max_size,
+            64,
+            "Maximum number of instructions in a loop that is versioned.");
+DEFINE_FLAG(bool, trace_loop_versioning, false, "Trace loop versioning.");
+
+// Offsets are kept small so that adding them to a Smi never overflows.
+static bool IsSmallOffset(int64_t offset) {
+  return -kMaxInt32 <= offset && offset <= kMaxInt32;
+}
+
+// Returns true if adding a small offset to [def] cannot wrap around.
+static bool IsSmiRange(Definition* def) {
+  return RangeUtils::IsWithin(def->range(), compiler::target::kSmiMin,
+                              compiler::target::kSmiMax);
+}
+
+static bool IsInt64Convertible(Definition* def) {
+  switch (def->representation()) {
+    case kUnboxedInt64:
+    case kUnboxedInt32:
+    case kUnboxedUint32:
+      return true;
+    case kTagged:
+      return def->Type()->IsInt();
+    default:
+      return false;
+  }
+}
+
+LoopVersioner::LoopVersioner(FlowGraph* flow_graph)
+    : flow_graph_(flow_graph), zone_(flow_graph->zone()), versioned_() {}
+
+bool LoopVersioner::Optimize() {
+  if (!FLAG_loop_versioning) {
+    return false;
+  }
+  // Loops entered from the OSR entry would bypass the guards.
+  if (flow_graph_->IsCompiledForOsr()) {
+    return false;
+  }
+
+  // Versioning rewrites the block order, dominators and loop hierarchy, so
+  // candidates are looked up again after every transformation.
+  bool changed = false;
+  bool found = true;
+  while (found) {
+    found = false;
+    const LoopHierarchy& loops = flow_graph_->GetLoopHierarchy();
+    loops.ComputeInduction();
+    for (intptr_t i = 0; i < loops.num_loops(); ++i) {
+      Plan plan;
+      if (IsCandidate(loops.headers()[i]->loop_info(), &plan)) {
+        if (FLAG_trace_loop_versioning) {
+          THR_Print("Versioning loop B%" Pd " (%" Pd " checks) in %s\n",
+                    plan.header->block_id(), plan.checks.length(),
+                    flow_graph_->function().ToFullyQualifiedCString());
+        }
+        Version(plan);
+        changed = found = true;
+        break;
+      }
+    }
+  }
+  return changed;
+}
+
+bool LoopVersioner::IsCandidate(LoopInfo* loop, Plan* plan) {
+  if (loop->inner() != nullptr || loop->control() == nullptr) {
+    return false;
+  }
+  JoinEntryInstr* header = loop->header()->AsJoinEntry();
+  if (header == nullptr || header->PredecessorCount() != 2 ||
+      header->try_index() != kInvalidTryIndex) {
+    return false;
+  }
+  for (intptr_t i = 0; i < versioned_.length(); ++i) {
+    if (versioned_[i] == header->block_id()) {
+      return false;
+    }
+  }
+  if (loop->back_edges().length() != 1) {
+    return false;
+  }
+  TargetEntryInstr* body = loop->back_edges()[0]->AsTargetEntry();
+  if (body == nullptr || body->PredecessorAt(0) != header ||
+      !body->last_instruction()->IsGoto()) {
+    return false;
+  }
+  for (BitVector::Iterator it(loop->blocks()); !it.Done(); it.Advance()) {
+    const intptr_t n = it.Current();
+    if (n != header->preorder_number() && n != body->preorder_number()) {
+      return false;
+    }
+  }
+  const intptr_t back_edge_index = header->IndexOfPredecessor(body);
+  BlockEntryInstr* preheader = header->PredecessorAt(1 - back_edge_index);
+  if (!preheader->last_instruction()->IsGoto()) {
+    return false;
+  }
+
+  // The exit test is copied as is, so it must not need a deoptimization
+  // target of its own.
+  BranchInstr* exit_test = header->last_instruction()->AsBranch();
+  if (exit_test == nullptr || exit_test->comparison()->InputCount() != 2 ||
+      exit_test->comparison()->CanDeoptimize() ||
+      exit_test->comparison()->MayThrow()) {
+    return false;
+  }
+
+  // The exit test must bound the control induction as i < U (i++).
+  int64_t stride = 0;
+  if (!InductionVar::IsLinear(loop->control(), &stride) || stride != 1) {
+    return false;
+  }
+  InductionVar* limit = nullptr;
+  for (auto bound : loop->control()->bounds()) {
+    if (bound.branch_ == exit_test) {
+      limit = bound.limit_;
+      break;
+    }
+  }
+  if (limit == nullptr) {
+    return false;
+  }
+
+  plan->loop = loop;
+  plan->header = header;
+  plan->body = body;
+  plan->preheader = preheader;
+
+  intptr_t size = 0;
+  for (ForwardInstructionIterator it(header); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current();
+    if (instr != exit_test && !LoopCloner::CanClone(instr)) {
+      return false;
+    }
+    size++;
+  }
+  for (ForwardInstructionIterator it(body); !it.Done(); it.Advance()) {
+    Instruction* instr = it.Current();
+    size++;
+    if (instr->IsGoto()) {
+      continue;
+    }
+    if (auto check = instr->AsCheckBoundBase()) {
+      if (CanRemoveBoundsCheck(loop, limit, check, plan)) {
+        plan->checks.Add(check);
+      }
+      continue;
+    }
+    if (auto check = instr->AsCheckNull()) {
+      if (!CanRemoveNullCheck(loop, check, plan)) {
+        return false;
+      }
+      plan->checks.Add(check);
+      continue;
+    }
+    if (!LoopCloner::CanClone(instr)) {
+      return false;
+    }
+  }
+  return !plan->checks.is_empty() && size <= FLAG_loop_versioning_max_size;
+}
+
+bool LoopVersioner::CanRemoveBoundsCheck(LoopInfo* loop,
+                                         InductionVar* limit,
+                                         CheckBoundBase* check,
+                                         Plan* plan) {
+  Definition* length = check->length()
+                           ->definition()
+                           ->OriginalDefinitionIgnoreBoxingAndConstraints();
+  if (loop->Contains(length->GetBlock()) || !IsInt64Convertible(length)) {
+    return false;
+  }
+
+  // The index must be i + c for the control induction i.
+  InductionVar* index = loop->LookupInduction(
+      check->index()
+          ->definition()
+          ->OriginalDefinitionIgnoreBoxingAndConstraints());
+  int64_t c = 0;
+  if (index == nullptr ||
+      !loop->control()->CanComputeDifferenceWith(index, &c) ||
+      !IsSmallOffset(c)) {
+    return false;
+  }
+
+  // First index: i0 + c >= 0.
+  InductionVar* initial = loop->control()->initial();
+  if (!IsSmallOffset(initial->offset())) {
+    return false;
+  }
+  const int64_t first = initial->offset() + c;
+  bool has_lower_guard = false;
+  if (initial->mult() == 0) {
+    if (first < 0) {
+      return false;
+    }
+  } else if (initial->mult() == 1 && IsInt64Convertible(initial->def()) &&
+             (initial->offset() == 0 || IsSmiRange(initial->def()))) {
+    has_lower_guard = true;
+  } else {
+    return false;
+  }
+
+  // Last index: U - 1 + c < length, that is U + c <= length.
+  if (!IsSmallOffset(limit->offset())) {
+    return false;
+  }
+  const int64_t last = limit->offset() + c;
+  if (limit->mult() == 0) {
+    if (last > 0) {
+      AddGuard(plan, Guard::kAtLeast, length, nullptr, last);
+    }
+  } else if (limit->mult() == 1 && IsInt64Convertible(limit->def()) &&
+             (limit->offset() == 0 || IsSmiRange(limit->def())) &&
+             (last == 0 || RangeUtils::IsWithin(length->range(), 0,
+                                                compiler::target::kSmiMax))) {
+    AddGuard(plan, Guard::kAtMost, limit->def(), length, -last);
+  } else {
+    return false;
+  }
+  if (has_lower_guard) {
+    AddGuard(plan, Guard::kAtLeast, initial->def(), nullptr, -first);
+  }
+  return true;
+}
+
+bool LoopVersioner::CanRemoveNullCheck(LoopInfo* loop,
+                                       CheckNullInstr* check,
+                                       Plan* plan) {
+  Definition* value = check->value()->definition();
+  if (loop->Contains(value->GetBlock()) ||
+      value->representation() != kTagged) {
+    return false;
+  }
+  AddGuard(plan, Guard::kNotNull, value, nullptr, 0);
+  return true;
+}
+
+void LoopVersioner::AddGuard(Plan* plan,
+                             Guard::Kind kind,
+                             Definition* value,
+                             Definition* limit,
+                             int64_t offset) {
+  for (intptr_t i = 0; i < plan->guards.length(); ++i) {
+    const Guard& guard = plan->guards[i];
+    if (guard.kind == kind && guard.value == value && guard.limit == limit &&
+        guard.offset == offset) {
+      return;
+    }
+  }
+  plan->guards.Add({kind, value, limit, offset});
+}
+
+void LoopVersioner::Version(const Plan& plan) {
+  JoinEntryInstr* header = plan.header;
+  TargetEntryInstr* body = plan.body;
+  BranchInstr* exit_test = header->last_instruction()->AsBranch();
+  const bool body_on_true = exit_test->true_successor() == body;
+  TargetEntryInstr* exit =
+      body_on_true ? exit_test->false_successor() : exit_test->true_successor();
+  const intptr_t back_edge_index = header->IndexOfPredecessor(body);
+  const intptr_t entry_index = 1 - back_edge_index;
+  GotoInstr* entry = plan.preheader->last_instruction()->AsGoto();
+
+  // Snapshot the code to copy before the graph starts changing.
+  GrowableArray<Instruction*> header_code;
+  for (ForwardInstructionIterator it(header); !it.Done(); it.Advance()) {
+    if (it.Current() != exit_test) {
+      header_code.Add(it.Current());
+    }
+  }
+  GrowableArray<Instruction*> body_code;
+  for (ForwardInstructionIterator it(body); !it.Done(); it.Advance()) {
+    if (!it.Current()->IsGoto()) {
+      body_code.Add(it.Current());
+    }
+  }
+  GrowableArray<PhiInstr*> phis;
+  GrowableArray<Definition*> initial;
+  for (PhiIterator it(header); !it.Done(); it.Advance()) {
+    phis.Add(it.Current());
+    initial.Add(it.Current()->InputAt(entry_index)->definition());
+  }
+
+  // The exit block becomes a join of both loops, and the original exit edge
+  // now goes through its own block into the join.
+  LoopCloner cloner(flow_graph_);
+  cloner.PrepareExit(plan.loop, exit);
+  cloner.ResetMap();
+  TargetEntryInstr* loop_exit = cloner.AddExit();
+  if (body_on_true) {
+    *exit_test->false_successor_address() = loop_exit;
+  } else {
+    *exit_test->true_successor_address() = loop_exit;
+  }
+
+  // The preheader evaluates the guards and enters the fast loop if all of
+  // them hold, or the original loop as soon as one of them fails.
+  JoinEntryInstr* fast_header = new (zone_)
+      JoinEntryInstr(flow_graph_->allocate_block_id(), header->try_index(),
+                     DeoptId::kNone);
+  GrowableArray<ComparisonInstr*> tests;
+  for (intptr_t i = 0; i < plan.guards.length(); ++i) {
+    tests.Add(EmitGuard(plan.guards[i], entry));
+  }
+  JoinEntryInstr* slow_entry = header;
+  if (tests.length() > 1) {
+    slow_entry = new (zone_)
+        JoinEntryInstr(flow_graph_->allocate_block_id(), header->try_index(),
+                       DeoptId::kNone);
+    GotoInstr* jump = new (zone_) GotoInstr(header, DeoptId::kNone);
+    slow_entry->AppendInstruction(jump);
+    slow_entry->set_last_instruction(jump);
+  }
+  BlockEntryInstr* block = plan.preheader;
+  Instruction* cursor = entry->previous();
+  for (intptr_t i = 0; i < tests.length(); ++i) {
+    BranchInstr* branch = new (zone_) BranchInstr(tests[i], DeoptId::kNone);
+    cursor->AppendInstruction(branch);
+    block->set_last_instruction(branch);
+    TargetEntryInstr* pass = cloner.NewTarget(header, 1.0);
+    TargetEntryInstr* fail = cloner.NewTarget(header, 0.0);
+    GotoInstr* jump = new (zone_) GotoInstr(slow_entry, DeoptId::kNone);
+    fail->AppendInstruction(jump);
+    fail->set_last_instruction(jump);
+    *branch->true_successor_address() = pass;
+    *branch->false_successor_address() = fail;
+    block = pass;
+    cursor = pass;
+  }
+  GotoInstr* enter_fast = new (zone_) GotoInstr(fast_header, DeoptId::kNone);
+  cursor->AppendInstruction(enter_fast);
+  block->set_last_instruction(enter_fast);
+  BlockEntryInstr* fast_entry = block;
+
+  // The fast loop is a copy of the original one without the checks.
+  GrowableArray<PhiInstr*> fast_phis;
+  for (intptr_t i = 0; i < phis.length(); ++i) {
+    PhiInstr* phi = new (zone_) PhiInstr(fast_header, 2);
+    phi->set_representation(phis[i]->representation());
+    phi->mark_alive();
+    flow_graph_->AllocateSSAIndexes(phi);
+    if (phis[i]->range() != nullptr) {
+      phi->set_range(*phis[i]->range());
+    }
+    fast_header->InsertPhi(phi);
+    fast_phis.Add(phi);
+    cloner.Map(phis[i], phi);
+  }
+  cursor = fast_header;
+  for (intptr_t i = 0; i < header_code.length(); ++i) {
+    cursor = cloner.AppendClone(cursor, header_code[i]);
+  }
+  BranchInstr* fast_test = cloner.CloneBranch(exit_test);
+  cursor->AppendInstruction(fast_test);
+  fast_header->set_last_instruction(fast_test);
+
+  TargetEntryInstr* fast_body = cloner.NewTarget(body, body->edge_weight());
+  TargetEntryInstr* fast_exit = cloner.AddExit();
+  *fast_test->true_successor_address() = body_on_true ? fast_body : fast_exit;
+  *fast_test->false_successor_address() = body_on_true ? fast_exit : fast_body;
+
+  cursor = fast_body;
+  for (intptr_t i = 0; i < body_code.length(); ++i) {
+    Instruction* instr = body_code[i];
+    if (plan.checks.Contains(instr)) {
+      // Uses of the checked value see the unchecked one.
+      Definition* check = instr->AsDefinition();
+      if (check->HasSSATemp()) {
+        cloner.Map(check,
+                   cloner.Lookup(check->RedefinedValue()->definition()));
+      }
+      continue;
+    }
+    cursor = cloner.AppendClone(cursor, instr);
+  }
+  GotoInstr* back_edge = new (zone_) GotoInstr(fast_header, DeoptId::kNone);
+  cursor->AppendInstruction(back_edge);
+  fast_body->set_last_instruction(back_edge);
+  GrowableArray<Definition*> next;
+  for (intptr_t i = 0; i < phis.length(); ++i) {
+    next.Add(cloner.Lookup(phis[i]->InputAt(back_edge_index)->definition()));
+  }
+
+  flow_graph_->DiscoverBlocks();
+  LoopCloner::RestorePhiInputOrder(header, body, back_edge_index);
+
+  const intptr_t fast_entry_index = fast_header->IndexOfPredecessor(fast_entry);
+  const intptr_t fast_back_edge_index =
+      fast_header->IndexOfPredecessor(fast_body);
+  for (intptr_t i = 0; i < fast_phis.length(); ++i) {
+    Value* initial_value = new (zone_) Value(initial[i]);
+    fast_phis[i]->SetInputAt(fast_entry_index, initial_value);
+    initial[i]->AddInputUse(initial_value);
+    Value* next_value = new (zone_) Value(next[i]);
+    fast_phis[i]->SetInputAt(fast_back_edge_index, next_value);
+    next[i]->AddInputUse(next_value);
+  }
+  cloner.MergeExits();
+
+  versioned_.Add(header->block_id());
+  versioned_.Add(fast_header->block_id());
+
+  GrowableArray<BitVector*> dominance_frontier;
+  flow_graph_->ComputeDominators(&dominance_frontier);
+}
+
+ComparisonInstr* LoopVersioner::EmitGuard(const Guard& guard,
+                                          Instruction* before) {
+  if (guard.kind == Guard::kNotNull) {
+    return new (zone_) StrictCompareInstr(
+        InstructionSource(), Token::kNE_STRICT, new (zone_) Value(guard.value),
+        new (zone_) Value(flow_graph_->constant_null()),
+        /*needs_number_check=*/false, DeoptId::kNone);
+  }
+  auto constant = [&](int64_t value) -> Definition* {
+    return flow_graph_->GetConstant(
+        Integer::ZoneHandle(zone_, Integer::NewCanonical(value)),
+        kUnboxedInt64);
+  };
+  Definition* value = EmitInt64(guard.value, before);
+  Definition* limit = nullptr;
+  if (guard.limit == nullptr) {
+    limit = constant(guard.offset);
+  } else {
+    limit = EmitInt64(guard.limit, before);
+    if (guard.offset != 0) {
+      BinaryInt64OpInstr* sum = new (zone_) BinaryInt64OpInstr(
+          Token::kADD, new (zone_) Value(limit),
+          new (zone_) Value(constant(guard.offset)), DeoptId::kNone,
+          Instruction::kNotSpeculative);
+      sum->set_can_overflow(false);
+      flow_graph_->InsertBefore(before, sum, nullptr, FlowGraph::kValue);
+      limit = sum;
+    }
+  }
+  return new (zone_) RelationalOpInstr(
+      InstructionSource(),
+      guard.kind == Guard::kAtLeast ? Token::kGTE : Token::kLTE,
+      new (zone_) Value(value), new (zone_) Value(limit), kMintCid,
+      DeoptId::kNone, Instruction::kNotSpeculative);
+}
+
+Definition* LoopVersioner::EmitInt64(Definition* def, Instruction* before) {
+  Definition* converted = nullptr;
+  switch (def->representation()) {
+    case kUnboxedInt64:
+      return def;
+    case kUnboxedInt32:
+    case kUnboxedUint32:
+      converted = new (zone_) IntConverterInstr(
+          def->representation(), kUnboxedInt64, new (zone_) Value(def),
+          DeoptId::kNone);
+      break;
+    default:
+      ASSERT(def->representation() == kTagged && def->Type()->IsInt());
+      converted =
+          UnboxInstr::Create(kUnboxedInt64, new (zone_) Value(def),
+                             DeoptId::kNone, Instruction::kNotSpeculative);
+      break;
+  }
+  flow_graph_->InsertBefore(before, converted, nullptr, FlowGraph::kValue);
+  return converted;
+}
+
+}  // namespace dart
@@ -0,0 +1,99 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_BACKEND_LOOP_VERSIONER_H_
+#define RUNTIME_VM_COMPILER_BACKEND_LOOP_VERSIONER_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/compiler/backend/flow_graph.h"
+#include "vm/compiler/backend/il.h"
+#include "vm/compiler/backend/loops.h"
+
+namespace dart {
+
+// Removes bounds and null checks from hot loops by versioning them.
+//
+// A loop qualifies when it has the shape
+//
+//   H: i = phi(i0, i + 1); header code; Branch(i < U) B, X
+//   B: body; Goto H
+//
+// and its body checks bounds of an index i + c against an invariant length
+// or checks an invariant value for null. Since the induction takes all
+// values in [i0, U), all of these checks pass exactly when
+//
+//   i0 + c >= 0 and U + c <= length and value != null
+//
+// which only involves loop invariants. The loop is then preceded by these
+// guards, which enter a copy of the loop without the checks when they all
+// hold and the original loop otherwise:
+//
+//   P:  guards; Branch(...) FH, H
+//   FH: i' = phi(i0, i' + 1); header code; Branch(i' < U) FB, X
+//   FB: body without checks; Goto FH
+//
+// Values defined in the header and used after the loop are merged from both
+// exits with new phis in the exit block.
+class LoopVersioner : public ValueObject {
+ public:
+  explicit LoopVersioner(FlowGraph* flow_graph);
+
+  // Returns true if any loop was versioned.
+  bool Optimize();
+
+ private:
+  // A condition on loop invariants that makes some checks redundant:
+  //   value != null                    (kNotNull)
+  //   value >= [limit +] offset        (kAtLeast)
+  //   value <= [limit +] offset        (kAtMost)
+  struct Guard {
+    enum Kind { kNotNull, kAtLeast, kAtMost };
+
+    Kind kind;
+    Definition* value;
+    Definition* limit;
+    int64_t offset;
+  };
+
+  // What needs to be known about a loop to version.
+  struct Plan {
+    LoopInfo* loop = nullptr;
+    JoinEntryInstr* header = nullptr;
+    TargetEntryInstr* body = nullptr;
+    BlockEntryInstr* preheader = nullptr;
+    GrowableArray<Instruction*> checks;
+    GrowableArray<Guard> guards;
+  };
+
+  bool IsCandidate(LoopInfo* loop, Plan* plan);
+  bool CanRemoveBoundsCheck(LoopInfo* loop,
+                            InductionVar* limit,
+                            CheckBoundBase* check,
+                            Plan* plan);
+  bool CanRemoveNullCheck(LoopInfo* loop, CheckNullInstr* check, Plan* plan);
+  void AddGuard(Plan* plan,
+                Guard::Kind kind,
+                Definition* value,
+                Definition* limit,
+                int64_t offset);
+
+  void Version(const Plan& plan);
+
+  ComparisonInstr* EmitGuard(const Guard& guard, Instruction* before);
+  Definition* EmitInt64(Definition* def, Instruction* before);
+
+  FlowGraph* const flow_graph_;
+  Zone* const zone_;
+
+  // Block ids of headers of loops that were versioned or created by
+  // versioning.
+  GrowableArray<intptr_t> versioned_;
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_BACKEND_LOOP_VERSIONER_H_
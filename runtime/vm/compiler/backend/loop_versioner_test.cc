@@ -0,0 +1,102 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/backend/loop_versioner.h"
+
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/compiler_pass.h"
+#include "vm/object.h"
+#include "vm/unit_test.h"
+
+namespace dart {
+
+#if defined(DART_PRECOMPILER)
+
+DECLARE_FLAG(bool, loop_versioning);
+
+static intptr_t CountBoundChecks(FlowGraph* flow_graph) {
+  intptr_t count = 0;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      if (it.Current()->IsCheckBoundBase()) {
+        count++;
+      }
+    }
+  }
+  return count;
+}
+
+static FlowGraph* CompileAOT(const char* script, const char* name) {
+  const auto& root_library = Library::Handle(LoadTestScript(script));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, name));
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  return pipeline.RunPasses({});
+}
+
+static const char* kSumScript = R"(
+    import 'dart:typed_data';
+
+    @pragma('vm:never-inline')
+    int sum(Uint8List list, int n) {
+      int result = 0;
+      for (int i = 0; i < n; i++) {
+        result += list[i];
+      }
+      return result;
+    }
+
+    void main() {
+      sum(Uint8List(8), 8);
+    }
+  )";
+
+ISOLATE_UNIT_TEST_CASE(LoopVersioner_ParameterBound) {
+  SetFlagScope<bool> sfs(&FLAG_loop_versioning, true);
+  FlowGraph* flow_graph = CompileAOT(kSumScript, "sum");
+
+  // Only the fallback loop still checks bounds.
+  EXPECT_EQ(2, flow_graph->GetLoopHierarchy().num_loops());
+  EXPECT_EQ(1, CountBoundChecks(flow_graph));
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVersioner_Disabled) {
+  SetFlagScope<bool> sfs(&FLAG_loop_versioning, false);
+  FlowGraph* flow_graph = CompileAOT(kSumScript, "sum");
+
+  EXPECT_EQ(1, flow_graph->GetLoopHierarchy().num_loops());
+  EXPECT_EQ(1, CountBoundChecks(flow_graph));
+}
+
+ISOLATE_UNIT_TEST_CASE(LoopVersioner_NonLinearIndex) {
+  const char* kScript = R"(
+    import 'dart:typed_data';
+
+    @pragma('vm:never-inline')
+    int sum(Uint8List list, int n) {
+      int result = 0;
+      for (int i = 0; i < n; i++) {
+        result += list[i * i];
+      }
+      return result;
+    }
+
+    void main() {
+      sum(Uint8List(64), 8);
+    }
+  )";
+
+  SetFlagScope<bool> sfs(&FLAG_loop_versioning, true);
+  FlowGraph* flow_graph = CompileAOT(kScript, "sum");
+
+  // No guard before the loop can prove i * i in range.
+  EXPECT_EQ(1, flow_graph->GetLoopHierarchy().num_loops());
+  EXPECT_EQ(1, CountBoundChecks(flow_graph));
+}
+
+#endif  // defined(DART_PRECOMPILER)
+
+}  // namespace dart
@@ -21,6 +21,10 @@ DEFINE_FLAG(bool,
             optimize_lazy_initializer_calls,
             true,
             "Eliminate redundant lazy initializer calls.");
+DEFINE_FLAG(bool,
+            partial_escape_analysis,
+            true,
+            "Sink allocations that only escape on paths ending in a throw.");
 DEFINE_FLAG(bool,
             trace_load_optimization,
             false,
@@ -3409,6 +3413,15 @@ void AllocationSinking::EliminateAllocation(Definition* alloc) {
 // rematerialized at deoptimization exits if needed. See IsSafeUse
 // for the description of algorithm used below.
 void AllocationSinking::CollectCandidates() {
+  // Copies made on cold paths have no deoptimization environment, so only
+  // look for them in AOT mode where none is needed.
+  const bool collect_cold_path_candidates =
+      FLAG_partial_escape_analysis && CompilerState::Current().is_aot();
+  if (collect_cold_path_candidates) {
+    ComputeColdBlocks();
+  }
+  GrowableArray<BlockEntryInstr*> roots;
+
   // Optimistically collect all potential candidates.
   for (BlockIterator block_it = flow_graph_->reverse_postorder_iterator();
        !block_it.Done(); block_it.Advance()) {
@@ -3423,6 +3436,9 @@ void AllocationSinking::CollectCandidates() {
       if (IsAllocationSinkingCandidate(alloc, kOptimisticCheck)) {
         alloc->SetIdentity(AliasIdentity::AllocationSinkingCandidate());
         candidates_.Add(alloc);
+      } else if (collect_cold_path_candidates &&
+                 CanMaterializeOnColdPaths(alloc, &roots)) {
+        cold_path_candidates_.Add(alloc);
       }
     }
   }
@@ -3459,6 +3475,24 @@ void AllocationSinking::CollectCandidates() {
     }
   }
   candidates_.TruncateTo(j);
+
+  // Cold path candidates are only stored into themselves outside of cold
+  // paths, so they stay valid whatever happened to other candidates above.
+  // They are not marked until now so that nothing stored into them is sunk.
+  for (auto* alloc : cold_path_candidates_) {
+    // Materializing other candidates does not change uses of this one.
+    CanMaterializeOnColdPaths(alloc, &roots);
+    ASSERT(!roots.is_empty());
+    for (auto* root : roots) {
+      MaterializeOnColdPath(alloc->AsAllocateObject(), root);
+    }
+    if (FLAG_trace_optimization) {
+      THR_Print("discovered partially escaping allocation: v%" Pd "\n",
+                alloc->ssa_temp_index());
+    }
+    alloc->SetIdentity(AliasIdentity::AllocationSinkingCandidate());
+    candidates_.Add(alloc);
+  }
 }
 
 // If materialization references an allocation sinking candidate then replace
@@ -3559,6 +3593,10 @@ void AllocationSinking::DiscoverFailedCandidates() {
         if (use->instruction()->IsLoadField() ||
             use->instruction()->IsLoadIndexed()) {
           Definition* load = use->instruction()->AsDefinition();
+          if (cold_path_loads_.Contains(load)) {
+            // Initializes a copy made on a cold path: keep it.
+            continue;
+          }
           load->ReplaceUsesWith(flow_graph_->constant_null());
           load->RemoveFromGraph();
         } else {
@@ -3649,10 +3687,20 @@ void AllocationSinking::Optimize() {
   // point and we can eliminate it. Loads inserted above were forwarded so there
   // are no uses of the allocation outside other candidates to eliminate, just
   // as in the beginning of the pass.
+  intptr_t num_partially_escaping = 0;
   for (intptr_t i = 0; i < candidates_.length(); i++) {
+    if (cold_path_candidates_.Contains(candidates_[i])) {
+      num_partially_escaping++;
+    }
     EliminateAllocation(candidates_[i]);
   }
 
+  if (FLAG_trace_optimization) {
+    THR_Print("allocation sinking eliminated %" Pd " allocations, %" Pd
+              " of them escaping on cold paths\n",
+              candidates_.length(), num_partially_escaping);
+  }
+
   // Process materializations and unbox their arguments: materializations
   // are part of the environment and can materialize boxes for double/mint/simd
   // values when needed.
@@ -3918,6 +3966,170 @@ void AllocationSinking::InsertMaterializations(Definition* alloc) {
   }
 }
 
+// A block is cold if every path starting at it ends in a throw. Successors
+// are visited before their predecessors in postorder except for back edges,
+// so cold paths never contain loops.
+void AllocationSinking::ComputeColdBlocks() {
+  const auto& postorder = flow_graph_->postorder();
+  cold_blocks_ = new (Z) BitVector(Z, postorder.length());
+  for (intptr_t i = 0; i < postorder.length(); i++) {
+    BlockEntryInstr* block = postorder[i];
+    Instruction* last = block->last_instruction();
+    bool is_cold = last->IsThrow() || last->IsReThrow();
+    if (!is_cold && (last->SuccessorCount() > 0)) {
+      is_cold = true;
+      for (intptr_t j = 0; j < last->SuccessorCount(); j++) {
+        if (!IsColdBlock(last->SuccessorAt(j))) {
+          is_cold = false;
+          break;
+        }
+      }
+    }
+    if (is_cold) {
+      cold_blocks_->Add(block->preorder_number());
+    }
+  }
+}
+
+BlockEntryInstr* AllocationSinking::ColdPathRoot(BlockEntryInstr* block) const {
+  ASSERT(IsColdBlock(block));
+  while ((block->dominator() != nullptr) && IsColdBlock(block->dominator())) {
+    block = block->dominator();
+  }
+  return block;
+}
+
+// Returns the block in which the value of the given use is needed. For phis
+// this is the predecessor the value flows from.
+static BlockEntryInstr* UseBlock(Value* use) {
+  if (PhiInstr* phi = use->instruction()->AsPhi()) {
+    return phi->block()->PredecessorAt(use->use_index());
+  }
+  return use->instruction()->GetBlock();
+}
+
+bool AllocationSinking::CanMaterializeOnColdPaths(
+    Definition* alloc,
+    GrowableArray<BlockEntryInstr*>* roots) {
+  if (!alloc->IsAllocateObject() || IsColdBlock(alloc->GetBlock())) {
+    return false;
+  }
+
+  roots->Clear();
+  for (Value* use = alloc->input_use_list(); use != nullptr;
+       use = use->next_use()) {
+    BlockEntryInstr* block = UseBlock(use);
+    if (!IsColdBlock(block)) {
+      // Outside of cold paths the object can only be initialized. Storing
+      // it anywhere, even into itself, would let a copy made on a cold path
+      // observe the original object.
+      auto* store = use->instruction()->AsStoreInstanceField();
+      if ((store == nullptr) || (use != store->instance()) ||
+          (store->value()->definition() == alloc)) {
+        return false;
+      }
+      continue;
+    }
+    BlockEntryInstr* root = ColdPathRoot(block);
+    ASSERT(alloc->GetBlock()->Dominates(root));
+    if (!root->IsTargetEntry() && !root->IsJoinEntry()) {
+      return false;
+    }
+    AddInstruction(roots, root);
+  }
+
+  if (roots->is_empty()) {
+    return false;
+  }
+
+  // Uses are only redirected to the copy in blocks dominated by the root of
+  // a cold path, so no cold path may merge into another one.
+  for (BlockIterator block_it = flow_graph_->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    BlockEntryInstr* block = block_it.Current();
+    for (auto* root : *roots) {
+      if (!root->Dominates(block)) {
+        continue;
+      }
+      Instruction* last = block->last_instruction();
+      for (intptr_t i = 0; i < last->SuccessorCount(); i++) {
+        if (!root->Dominates(last->SuccessorAt(i))) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+void AllocationSinking::MaterializeOnColdPath(AllocateObjectInstr* alloc,
+                                              BlockEntryInstr* root) {
+  if (FLAG_trace_optimization) {
+    THR_Print("materializing allocation v%" Pd " on cold path B%" Pd "\n",
+              alloc->ssa_temp_index(), root->block_id());
+  }
+
+  // Collect uses to redirect before any new ones are inserted.
+  GrowableArray<Value*> uses;
+  for (Value* use = alloc->input_use_list(); use != nullptr;
+       use = use->next_use()) {
+    if (root->Dominates(UseBlock(use))) {
+      uses.Add(use);
+    }
+  }
+  GrowableArray<Instruction*> env_users;
+  for (Value* use = alloc->env_use_list(); use != nullptr;
+       use = use->next_use()) {
+    if (root->Dominates(use->instruction()->GetBlock())) {
+      AddInstruction(&env_users, use->instruction());
+    }
+  }
+
+  // Fields initialized outside of the cold path.
+  auto slots = new (Z) ZoneGrowableArray<const Slot*>(5);
+  for (Value* use = alloc->input_use_list(); use != nullptr;
+       use = use->next_use()) {
+    if (root->Dominates(UseBlock(use))) {
+      continue;
+    }
+    StoreInstanceFieldInstr* store = use->instruction()->AsStoreInstanceField();
+    ASSERT((store != nullptr) && (use == store->instance()));
+    AddSlot(slots, store->slot());
+  }
+
+  // Copy the state of the object at the start of the cold path. Loads
+  // inserted here are forwarded by the load optimizer just like loads
+  // inserted for materializations at deoptimization exits.
+  Instruction* next = root->next();
+  Value* type_arguments =
+      (alloc->type_arguments() != nullptr)
+          ? new (Z) Value(alloc->type_arguments()->definition())
+          : nullptr;
+  AllocateObjectInstr* copy = new (Z) AllocateObjectInstr(
+      alloc->source(), alloc->cls(), DeoptId::kNone, type_arguments);
+  flow_graph_->InsertBefore(next, copy, nullptr, FlowGraph::kValue);
+  for (auto slot : *slots) {
+    LoadFieldInstr* load =
+        new (Z) LoadFieldInstr(new (Z) Value(alloc), *slot, alloc->source());
+    flow_graph_->InsertBefore(next, load, nullptr, FlowGraph::kValue);
+    cold_path_loads_.Add(load);
+    flow_graph_->InsertBefore(
+        next,
+        new (Z) StoreInstanceFieldInstr(
+            *slot, new (Z) Value(copy), new (Z) Value(load),
+            kEmitStoreBarrier, alloc->source(),
+            StoreInstanceFieldInstr::Kind::kInitializing),
+        nullptr, FlowGraph::kEffect);
+  }
+
+  for (Value* use : uses) {
+    use->BindTo(copy);
+  }
+  for (Instruction* instr : env_users) {
+    instr->ReplaceInEnvironment(alloc, copy);
+  }
+}
+
 // TryCatchAnalyzer tries to reduce the state that needs to be synchronized
 // on entry to the catch by discovering Parameter-s which are never used
 // or which are always constant.
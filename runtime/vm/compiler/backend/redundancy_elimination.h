@@ -19,7 +19,10 @@ class CSEInstructionSet;
 class AllocationSinking : public ZoneAllocated {
  public:
   explicit AllocationSinking(FlowGraph* flow_graph)
-      : flow_graph_(flow_graph), candidates_(5), materializations_(5) {}
+      : flow_graph_(flow_graph),
+        candidates_(5),
+        materializations_(5),
+        cold_blocks_(nullptr) {}
 
   const GrowableArray<Definition*>& candidates() const { return candidates_; }
 
@@ -72,6 +75,28 @@ class AllocationSinking : public ZoneAllocated {
 
   void EliminateAllocation(Definition* alloc);
 
+  // Partial escape analysis. An allocation that escapes only on cold paths,
+  // i.e. paths that always end in a throw, is copied into a real object at
+  // the start of each such path and sunk like any other candidate elsewhere.
+  void ComputeColdBlocks();
+
+  bool IsColdBlock(BlockEntryInstr* block) const {
+    return cold_blocks_->Contains(block->preorder_number());
+  }
+
+  // Returns the outermost block of the cold path that contains [block].
+  BlockEntryInstr* ColdPathRoot(BlockEntryInstr* block) const;
+
+  // Check if [alloc] only escapes on cold paths and collect the roots of
+  // these paths into [roots].
+  bool CanMaterializeOnColdPaths(Definition* alloc,
+                                 GrowableArray<BlockEntryInstr*>* roots);
+
+  // Allocate a copy of [alloc] at the start of [root] and make all uses of
+  // [alloc] dominated by [root] use the copy instead.
+  void MaterializeOnColdPath(AllocateObjectInstr* alloc,
+                             BlockEntryInstr* root);
+
   Zone* zone() const { return flow_graph_->zone(); }
 
   FlowGraph* flow_graph_;
@@ -79,6 +104,14 @@ class AllocationSinking : public ZoneAllocated {
   GrowableArray<Definition*> candidates_;
   GrowableArray<MaterializeObjectInstr*> materializations_;
 
+  // Blocks that always end in a throw, indexed by preorder number.
+  BitVector* cold_blocks_;
+
+  // Candidates that are materialized on cold paths and the loads inserted
+  // to initialize their copies there.
+  GrowableArray<Definition*> cold_path_candidates_;
+  GrowableArray<Definition*> cold_path_loads_;
+
   ExitsCollector exits_collector_;
 };
 
@@ -1232,6 +1232,76 @@ main() {
   EXPECT(string_interpolate->ArgumentAt(0) == create_array);
 }
 
+DECLARE_FLAG(bool, partial_escape_analysis);
+
+static const char* kColdEscapeScript = R"(
+    class Box {
+      final int value;
+      Box(this.value);
+    }
+
+    @pragma('vm:never-inline')
+    int test(int x) {
+      final box = Box(x);
+      if (x < 0) {
+        throw box;
+      }
+      return box.value + 1;
+    }
+
+    void main() {
+      test(1);
+    }
+  )";
+
+static FlowGraph* CompileColdEscape(const Library& root_library) {
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "test"));
+  TestPipeline pipeline(function, CompilerPass::kAOT);
+  return pipeline.RunPasses({});
+}
+
+// Returns the block of the only allocation of [cls] in the graph.
+static BlockEntryInstr* FindOnlyAllocation(FlowGraph* flow_graph,
+                                           const Class& cls) {
+  BlockEntryInstr* result = nullptr;
+  for (BlockIterator block_it = flow_graph->reverse_postorder_iterator();
+       !block_it.Done(); block_it.Advance()) {
+    for (ForwardInstructionIterator it(block_it.Current()); !it.Done();
+         it.Advance()) {
+      auto* alloc = it.Current()->AsAllocateObject();
+      if ((alloc != nullptr) && (alloc->cls().ptr() == cls.ptr())) {
+        EXPECT(result == nullptr);
+        result = block_it.Current();
+      }
+    }
+  }
+  return result;
+}
+
+ISOLATE_UNIT_TEST_CASE(AllocationSinking_PartialEscape) {
+  SetFlagScope<bool> sfs(&FLAG_partial_escape_analysis, true);
+  const auto& root_library = Library::Handle(LoadTestScript(kColdEscapeScript));
+  const auto& cls = Class::Handle(GetClass(root_library, "Box"));
+  FlowGraph* flow_graph = CompileColdEscape(root_library);
+
+  // The box is only allocated right before it is thrown.
+  BlockEntryInstr* block = FindOnlyAllocation(flow_graph, cls);
+  EXPECT(block != nullptr);
+  EXPECT(block != flow_graph->graph_entry()->normal_entry());
+  EXPECT(block->last_instruction()->IsThrow());
+}
+
+ISOLATE_UNIT_TEST_CASE(AllocationSinking_PartialEscapeDisabled) {
+  SetFlagScope<bool> sfs(&FLAG_partial_escape_analysis, false);
+  const auto& root_library = Library::Handle(LoadTestScript(kColdEscapeScript));
+  const auto& cls = Class::Handle(GetClass(root_library, "Box"));
+  FlowGraph* flow_graph = CompileColdEscape(root_library);
+
+  BlockEntryInstr* block = FindOnlyAllocation(flow_graph, cls);
+  EXPECT(block == flow_graph->graph_entry()->normal_entry());
+}
+
 #if !defined(TARGET_ARCH_IA32)
 
 ISOLATE_UNIT_TEST_CASE(DelayAllocations_DelayAcrossCalls) {
@@ -0,0 +1,100 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/compiler/compilation_record.h"
+
+#include "vm/compiler/api/deopt_id.h"
+#include "vm/json_writer.h"
+#include "vm/object.h"
+#include "vm/timeline.h"
+
+namespace dart {
+
+CompilationRecord* CompilationRecord::StartIfEnabled(Zone* zone) {
+#if defined(SUPPORT_TIMELINE)
+  TimelineStream* stream = Timeline::GetCompilerDecisionsStream();
+  ASSERT(stream != nullptr);
+  if (stream->enabled()) {
+    return new (zone) CompilationRecord(zone);
+  }
+#endif  // defined(SUPPORT_TIMELINE)
+  return nullptr;
+}
+
+void CompilationRecord::AddPass(const char* name, int64_t micros) {
+  passes_.Add({name, micros});
+}
+
+void CompilationRecord::AddInlining(intptr_t deopt_id,
+                                    intptr_t depth,
+                                    const Function& callee,
+                                    const char* reason) {
+  // The instruction count is cached once the inliner has built a graph of
+  // the callee, and is 0 if it never did.
+  inlining_.Add({deopt_id, depth, callee.ToQualifiedCString(),
+                 callee.optimized_instruction_count(), reason});
+}
+
+void CompilationRecord::Emit(const Function& function,
+                             const char* tier,
+                             intptr_t osr_id,
+                             const Code& code,
+                             int64_t start_micros,
+                             int64_t end_micros) {
+#if defined(SUPPORT_TIMELINE)
+  TimelineStream* stream = Timeline::GetCompilerDecisionsStream();
+  ASSERT(stream != nullptr);
+
+  // Serialize the arguments before calling StartEvent, which blocks safe
+  // points until Complete is called.
+  JSONWriter writer;
+  writer.OpenObject();
+  writer.PrintProperty("function", function.ToQualifiedCString());
+  writer.PrintProperty("tier", tier);
+  if (osr_id != DeoptId::kNone) {
+    writer.PrintProperty("osrId", osr_id);
+  }
+  writer.PrintProperty("codeSize", static_cast<intptr_t>(code.Size()));
+  writer.PrintProperty64("time", end_micros - start_micros);
+  writer.OpenArray("passes");
+  for (intptr_t i = 0; i < passes_.length(); i++) {
+    writer.OpenArray();
+    writer.PrintValue(passes_[i].name);
+    writer.PrintValue64(passes_[i].micros);
+    writer.CloseArray();
+  }
+  writer.CloseArray();
+  writer.OpenArray("inlining");
+  for (intptr_t i = 0; i < inlining_.length(); i++) {
+    const Inlining& inlining = inlining_[i];
+    writer.OpenArray();
+    writer.PrintValue(inlining.deopt_id);
+    writer.PrintValue(inlining.depth);
+    writer.PrintValue(inlining.callee);
+    writer.PrintValue(inlining.size);
+    if (inlining.reason == nullptr) {
+      writer.PrintValueNull();
+    } else {
+      writer.PrintValue(inlining.reason);
+    }
+    writer.CloseArray();
+  }
+  writer.CloseArray();
+  writer.CloseObject();
+
+  char* args = nullptr;
+  intptr_t args_length = 0;
+  writer.Steal(&args, &args_length);
+
+  TimelineEvent* event = stream->StartEvent();
+  if (event == nullptr) {
+    free(args);
+    return;
+  }
+  event->Duration("Compile", start_micros, end_micros);
+  event->CompleteWithPreSerializedArgs(args);
+#endif  // defined(SUPPORT_TIMELINE)
+}
+
+}  // namespace dart
@@ -0,0 +1,84 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_COMPILER_COMPILATION_RECORD_H_
+#define RUNTIME_VM_COMPILER_COMPILATION_RECORD_H_
+
+#if defined(DART_PRECOMPILED_RUNTIME)
+#error "AOT runtime should not use compiler sources (including header files)"
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
+#include "vm/allocation.h"
+#include "vm/growable_array.h"
+
+namespace dart {
+
+class Code;
+class Function;
+
+// Decisions taken while compiling one function, emitted as a single
+// "Compile" event on the CompilerDecisions timeline stream once the code is
+// installed. The arguments of the event are
+//
+//   {
+//     "function": <qualified name>,
+//     "tier": "unoptimized" | "baseline" | "optimized" | "osr",
+//     "osrId": <deopt id of the OSR entry, only for "osr">,
+//     "codeSize": <size of the instructions in bytes>,
+//     "time": <compile time in microseconds>,
+//     "passes": [[<pass name>, <microseconds>], ...],
+//     "inlining": [[<deopt id>, <depth>, <callee>, <size>, <reason>], ...]
+//   }
+//
+// where the reason of an inlined call is null. Records are only collected
+// while the stream is enabled, so the stream can be left on in production.
+class CompilationRecord : public ZoneAllocated {
+ public:
+  explicit CompilationRecord(Zone* zone)
+      : passes_(zone, 16), inlining_(zone, 0) {}
+
+  // Returns a new record if the CompilerDecisions stream is enabled, or
+  // nullptr otherwise.
+  static CompilationRecord* StartIfEnabled(Zone* zone);
+
+  void AddPass(const char* name, int64_t micros);
+
+  // Records the decision to inline [callee] at the call with [deopt_id], or
+  // not to inline it if [reason] is not null.
+  void AddInlining(intptr_t deopt_id,
+                   intptr_t depth,
+                   const Function& callee,
+                   const char* reason);
+
+  // Emits the record for [code] compiled for [function] in [tier].
+  void Emit(const Function& function,
+            const char* tier,
+            intptr_t osr_id,
+            const Code& code,
+            int64_t start_micros,
+            int64_t end_micros);
+
+ private:
+  struct Pass {
+    const char* name;
+    int64_t micros;
+  };
+
+  struct Inlining {
+    intptr_t deopt_id;
+    intptr_t depth;
+    const char* callee;
+    intptr_t size;
+    const char* reason;
+  };
+
+  GrowableArray<Pass> passes_;
+  GrowableArray<Inlining> inlining_;
+
+  DISALLOW_COPY_AND_ASSIGN(CompilationRecord);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_COMPILER_COMPILATION_RECORD_H_
@@ -12,10 +12,14 @@
 #include "vm/compiler/backend/il_printer.h"
 #include "vm/compiler/backend/inliner.h"
 #include "vm/compiler/backend/linearscan.h"
+#include "vm/compiler/backend/loop_unroller.h"
+#include "vm/compiler/backend/loop_vectorizer.h"
+#include "vm/compiler/backend/loop_versioner.h"
 #include "vm/compiler/backend/range_analysis.h"
 #include "vm/compiler/backend/redundancy_elimination.h"
 #include "vm/compiler/backend/type_propagator.h"
 #include "vm/compiler/call_specializer.h"
+#include "vm/compiler/compilation_record.h"
 #include "vm/compiler/compiler_timings.h"
 #include "vm/compiler/write_barrier_elimination.h"
 #if defined(DART_PRECOMPILER)
@@ -223,10 +227,16 @@ void CompilerPass::Run(CompilerPassState* state) const {
     PrintGraph(state, kTraceBefore, round);
     {
       TIMELINE_DURATION(thread, CompilerVerbose, name());
+      CompilationRecord* record = CompilerState::Current().record();
+      const int64_t start =
+          record != nullptr ? OS::GetCurrentMonotonicMicros() : 0;
       {
         COMPILER_TIMINGS_PASS_TIMER_SCOPE(thread, id());
         repeat = DoBody(state);
       }
+      if (record != nullptr) {
+        record->AddPass(name(), OS::GetCurrentMonotonicMicros() - start);
+      }
       thread->CheckForSafepoint();
     }
     PrintGraph(state, kTraceAfter, round);
@@ -327,6 +337,34 @@ FlowGraph* CompilerPass::RunForceOptimizedPipeline(
   return pass_state->flow_graph();
 }
 
+FlowGraph* CompilerPass::RunBaselinePipeline(CompilerPassState* pass_state) {
+  ASSERT(CompilerState::Current().is_baseline());
+  // Baseline code is entered after a short time in unoptimized code, so the
+  // ICData it would be specialized on is sparse. Instance calls are kept as
+  // IC calls instead, which keep collecting feedback for the full pipeline.
+  INVOKE_PASS(ComputeSSA);
+  INVOKE_PASS(SetOuterInliningId);
+  INVOKE_PASS(TypePropagation);
+  INVOKE_PASS(Inlining);
+  INVOKE_PASS(TypePropagation);
+  INVOKE_PASS(Canonicalize);
+  INVOKE_PASS(WidenSmiToInt32);
+  INVOKE_PASS(SelectRepresentations_Final);
+  INVOKE_PASS(TypePropagation);
+  INVOKE_PASS(TryCatchOptimization);
+  INVOKE_PASS(EliminateEnvironments);
+  INVOKE_PASS(EliminateDeadPhis);
+  // Currently DCE assumes that EliminateEnvironments has already been run,
+  // so it should not be lifted earlier than that pass.
+  INVOKE_PASS(DCE);
+  INVOKE_PASS(Canonicalize);
+  INVOKE_PASS(EliminateWriteBarriers);
+  INVOKE_PASS(FinalizeGraph);
+  INVOKE_PASS(AllocateRegisters);
+  INVOKE_PASS(ReorderBlocks);
+  return pass_state->flow_graph();
+}
+
 FlowGraph* CompilerPass::RunPipeline(PipelineMode mode,
                                      CompilerPassState* pass_state) {
   INVOKE_PASS(ComputeSSA);
@@ -365,6 +403,9 @@ FlowGraph* CompilerPass::RunPipeline(PipelineMode mode,
   INVOKE_PASS(TypePropagation);
   INVOKE_PASS(RangeAnalysis);
   INVOKE_PASS(OptimizeBranches);
+  INVOKE_PASS(LoopVersioning);
+  INVOKE_PASS(LoopVectorization);
+  INVOKE_PASS(LoopUnrolling);
   INVOKE_PASS(TypePropagation);
   INVOKE_PASS(TryCatchOptimization);
   INVOKE_PASS(EliminateEnvironments);
@@ -491,6 +532,21 @@ COMPILER_PASS(LICM, {
   flow_graph->RemoveRedefinitions(/*keep_checks*/ true);
 });
 
+COMPILER_PASS(LoopUnrolling, {
+  LoopUnroller unroller(flow_graph);
+  unroller.Optimize();
+});
+
+COMPILER_PASS(LoopVectorization, {
+  LoopVectorizer vectorizer(flow_graph);
+  vectorizer.Optimize();
+});
+
+COMPILER_PASS(LoopVersioning, {
+  LoopVersioner versioner(flow_graph);
+  versioner.Optimize();
+});
+
 COMPILER_PASS(DSE, { DeadStoreElimination::Optimize(flow_graph); });
 
 COMPILER_PASS(RangeAnalysis, {
@@ -40,6 +40,9 @@ namespace dart {
   V(IfConvert)                                                                 \
   V(Inlining)                                                                  \
   V(LICM)                                                                      \
+  V(LoopUnrolling)                                                             \
+  V(LoopVectorization)                                                         \
+  V(LoopVersioning)                                                            \
   V(OptimisticallySpecializeSmiPhis)                                           \
   V(OptimizeBranches)                                                          \
   V(OptimizeTypedDataAccesses)                                                 \
@@ -183,6 +186,15 @@ class CompilerPass {
   static FlowGraph* RunForceOptimizedPipeline(PipelineMode mode,
                                               CompilerPassState* state);
 
+  // Pipeline of the baseline tier of the JIT, which sits between unoptimized
+  // code and the full pipeline above.
+  //
+  // Only inlines small leaf functions into static calls and skips all loop,
+  // range and redundancy optimizations. Instance calls are not specialized
+  // on ICData, they go through IC stubs which keep updating it.
+  DART_WARN_UNUSED_RESULT
+  static FlowGraph* RunBaselinePipeline(CompilerPassState* state);
+
  protected:
   // This function executes the pass. If it returns true then
   // we will run Canonicalize on the graph and execute the pass
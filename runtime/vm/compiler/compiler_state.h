@@ -17,6 +17,7 @@
 
 namespace dart {
 
+class CompilationRecord;
 class CompilerPass;
 struct CompilerPassState;
 class Function;
@@ -88,6 +89,15 @@ class CompilerState : public ThreadStackResource {
   bool is_aot() const { return is_aot_; }
 
   bool is_optimizing() const { return is_optimizing_; }
+
+  // Whether the function is compiled in the baseline tier, which runs a
+  // cheaper pipeline than fully optimized code (see
+  // CompilerPass::RunBaselinePipeline).
+  bool is_baseline() const { return is_baseline_; }
+  void set_is_baseline(bool value) {
+    ASSERT(!value || (is_optimizing() && !is_aot()));
+    is_baseline_ = value;
+  }
   bool should_clone_fields() {
     return !is_aot() && (is_optimizing() || FLAG_force_clone_compiler_objects);
   }
@@ -119,6 +129,11 @@ class CompilerState : public ThreadStackResource {
   const CompilerPass* pass() const { return pass_; }
   const CompilerPassState* pass_state() const { return pass_state_; }
 
+  // Decisions of this compilation to report on the CompilerDecisions
+  // timeline stream, or nullptr if the stream is disabled.
+  CompilationRecord* record() const { return record_; }
+  void set_record(CompilationRecord* record) { record_ = record; }
+
   void ReportCrash();
 
  private:
@@ -134,6 +149,7 @@ class CompilerState : public ThreadStackResource {
 
   const bool is_aot_;
   const bool is_optimizing_;
+  bool is_baseline_ = false;
 
   const CompilerTracing tracing_;
 
@@ -146,6 +162,7 @@ class CompilerState : public ThreadStackResource {
   const Function* function_ = nullptr;
   const CompilerPass* pass_ = nullptr;
   const CompilerPassState* pass_state_ = nullptr;
+  CompilationRecord* record_ = nullptr;
 
   CompilerState* previous_;
 };
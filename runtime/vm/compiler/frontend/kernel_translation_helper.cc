@@ -2896,18 +2896,27 @@ String& KernelReaderHelper::SourceTableUriFor(intptr_t index) {
 }
 
 const String& KernelReaderHelper::GetSourceFor(intptr_t index) {
-  AlternativeReadingScope alt(&reader_);
-  SetOffset(GetOffsetForSourceInfo(index));
-  SkipBytes(ReadUInt());       // skip uri.
-  intptr_t size = ReadUInt();  // read source List<byte> size.
-  ASSERT(size >= 0);
+  intptr_t size = 0;
+  const uint8_t* source = GetSourceBytesFor(index, &size);
   if (size == 0) {
     return Symbols::Empty();
   } else {
-    return H.DartString(reader_.BufferAt(ReaderOffset()), size, Heap::kOld);
+    return H.DartString(source, size, Heap::kOld);
   }
 }
 
+// Returns the UTF-8 encoded source of the script at [index], which is only
+// valid until the next allocation.
+const uint8_t* KernelReaderHelper::GetSourceBytesFor(intptr_t index,
+                                                     intptr_t* length) {
+  AlternativeReadingScope alt(&reader_);
+  SetOffset(GetOffsetForSourceInfo(index));
+  SkipBytes(ReadUInt());  // skip uri.
+  *length = ReadUInt();   // read source List<byte> size.
+  ASSERT(*length >= 0);
+  return reader_.BufferAt(ReaderOffset());
+}
+
 TypedDataPtr KernelReaderHelper::GetLineStartsFor(intptr_t index) {
   // Line starts are delta encoded. So get the max delta first so that we
   // can store them as tighly as possible.
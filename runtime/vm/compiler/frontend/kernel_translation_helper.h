@@ -1290,6 +1290,7 @@ class KernelReaderHelper {
   intptr_t GetOffsetForSourceInfo(intptr_t index);
   String& SourceTableUriFor(intptr_t index);
   const String& GetSourceFor(intptr_t index);
+  const uint8_t* GetSourceBytesFor(intptr_t index, intptr_t* length);
   TypedDataPtr GetLineStartsFor(intptr_t index);
   String& SourceTableImportUriFor(intptr_t index, uint32_t binaryVersion);
   ExternalTypedDataPtr GetConstantCoverageFor(intptr_t index);
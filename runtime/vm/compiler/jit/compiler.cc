@@ -20,6 +20,7 @@
 #include "vm/compiler/backend/redundancy_elimination.h"
 #include "vm/compiler/backend/type_propagator.h"
 #include "vm/compiler/cha.h"
+#include "vm/compiler/compilation_record.h"
 #include "vm/compiler/compiler_pass.h"
 #include "vm/compiler/compiler_state.h"
 #include "vm/compiler/frontend/flow_graph_builder.h"
@@ -53,6 +54,13 @@ DEFINE_FLAG(
     max_deoptimization_counter_threshold,
     16,
     "How many times we allow deoptimization before we disallow optimization.");
+DEFINE_FLAG(int,
+            baseline_optimization_counter_threshold,
+            -1,
+            "Function's usage-counter value before it is compiled with the "
+            "baseline optimizing pipeline, -1 means never. Baseline code "
+            "keeps updating ICData and is recompiled with the full pipeline "
+            "once it becomes hot in turn.");
 DEFINE_FLAG(charp, optimization_filter, NULL, "Optimize only named function");
 DEFINE_FLAG(bool, print_flow_graph, false, "Print the IR flow graph.");
 DEFINE_FLAG(bool,
@@ -82,6 +90,11 @@ DEFINE_FLAG(bool,
             false,
             "Trace only optimizing compiler operations.");
 DEFINE_FLAG(bool, trace_bailout, false, "Print bailout from ssa compiler.");
+DEFINE_FLAG(int,
+            background_compiler_tasks,
+            1,
+            "Maximum number of concurrent background compiler tasks per "
+            "isolate group.");
 
 DECLARE_FLAG(bool, trace_failed_optimization_attempts);
 
@@ -292,6 +305,13 @@ bool Compiler::CanOptimizeFunction(Thread* thread, const Function& function) {
   return true;
 }
 
+bool Compiler::UseBaselineTier(const Function& function) {
+  return (FLAG_baseline_optimization_counter_threshold >= 0) &&
+         (FLAG_baseline_optimization_counter_threshold <
+          FLAG_optimization_counter_threshold) &&
+         !function.ForceOptimize() && !function.IsIrregexpFunction();
+}
+
 bool Compiler::IsBackgroundCompilation() {
   // For now: compilation in non mutator thread is the background compoilation.
   return !Thread::Current()->IsMutatorThread();
@@ -301,9 +321,11 @@ class CompileParsedFunctionHelper : public ValueObject {
  public:
   CompileParsedFunctionHelper(ParsedFunction* parsed_function,
                               bool optimized,
+                              bool baseline,
                               intptr_t osr_id)
       : parsed_function_(parsed_function),
         optimized_(optimized),
+        baseline_(baseline),
         osr_id_(osr_id),
         thread_(Thread::Current()) {}
 
@@ -312,16 +334,27 @@ class CompileParsedFunctionHelper : public ValueObject {
  private:
   ParsedFunction* parsed_function() const { return parsed_function_; }
   bool optimized() const { return optimized_; }
+  bool baseline() const { return baseline_; }
   intptr_t osr_id() const { return osr_id_; }
+
+  // Name of the tier of the compiled code in compilation records.
+  const char* TierName() const {
+    if (osr_id() != Compiler::kNoOSRDeoptId) return "osr";
+    if (baseline()) return "baseline";
+    return optimized() ? "optimized" : "unoptimized";
+  }
+
   Thread* thread() const { return thread_; }
   Isolate* isolate() const { return thread_->isolate(); }
   IsolateGroup* isolate_group() const { return thread_->isolate_group(); }
+
   CodePtr FinalizeCompilation(compiler::Assembler* assembler,
                               FlowGraphCompiler* graph_compiler,
                               FlowGraph* flow_graph);
 
   ParsedFunction* parsed_function_;
   const bool optimized_;
+  const bool baseline_;
   const intptr_t osr_id_;
   Thread* const thread_;
 
@@ -493,6 +526,11 @@ CodePtr CompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
   // suppression, since we don't restart optimization.
   SpeculativeInliningPolicy speculative_policy(/*enable_suppression=*/false);
 
+  // Compilation time of the tier, including retries with far branches.
+  Timer compile_timer;
+  compile_timer.Start();
+  const int64_t compile_start_micros = OS::GetCurrentMonotonicMicros();
+
   Code* volatile result = &Code::ZoneHandle(zone);
   while (!done) {
     *result = Code::null();
@@ -504,6 +542,9 @@ CodePtr CompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
       CompilerState compiler_state(thread(), /*is_aot=*/false, optimized(),
                                    CompilerState::ShouldTrace(function));
       compiler_state.set_function(function);
+      compiler_state.set_is_baseline(baseline());
+      CompilationRecord* record = CompilationRecord::StartIfEnabled(zone);
+      compiler_state.set_record(record);
 
       {
         // Extract type feedback before the graph is built, as the graph
@@ -565,7 +606,12 @@ CodePtr CompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
         JitCallSpecializer call_specializer(flow_graph, &speculative_policy);
         pass_state.call_specializer = &call_specializer;
 
-        flow_graph = CompilerPass::RunPipeline(CompilerPass::kJIT, &pass_state);
+        if (baseline()) {
+          flow_graph = CompilerPass::RunBaselinePipeline(&pass_state);
+        } else {
+          flow_graph =
+              CompilerPass::RunPipeline(CompilerPass::kJIT, &pass_state);
+        }
       }
 
       ASSERT(pass_state.inline_id_to_function.length() ==
@@ -586,6 +632,18 @@ CodePtr CompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
         auto install_code_fun = [&]() {
           *result =
               FinalizeCompilation(&assembler, &graph_compiler, flow_graph);
+          if (!result->IsNull()) {
+            // Installation is serialized by the program lock, so the
+            // metrics are not updated concurrently.
+            Metric* metric =
+                !optimized()
+                    ? isolate_group()->GetCompilationTimeUnoptimizedMetric()
+                : baseline()
+                    ? isolate_group()->GetCompilationTimeBaselineMetric()
+                    : isolate_group()->GetCompilationTimeOptimizedMetric();
+            metric->set_value(metric->value() +
+                              compile_timer.TotalElapsedTime());
+          }
 #if !defined(PRODUCT)
           // Isolate debuggers need to be notified of compiled function right
           // away as code is installed because there might be latent breakpoints
@@ -629,6 +687,11 @@ CodePtr CompileParsedFunctionHelper::Compile(CompilationPipeline* pipeline) {
         // Must be called outside of safepoint.
         Code::NotifyCodeObservers(function, *result, optimized());
 
+        if (record != nullptr) {
+          record->Emit(function, TierName(), osr_id(), *result,
+                       compile_start_micros, OS::GetCurrentMonotonicMicros());
+        }
+
         if (FLAG_disassemble && FlowGraphPrinter::ShouldPrint(function)) {
           Disassembler::DisassembleCode(function, *result, optimized());
         } else if (FLAG_disassemble_optimized && optimized() &&
@@ -687,6 +750,11 @@ static ObjectPtr CompileFunctionHelper(CompilationPipeline* pipeline,
     Zone* const zone = stack_zone.GetZone();
     const bool trace_compiler =
         FLAG_trace_compiler || (FLAG_trace_optimizing_compiler && optimized);
+    // Functions enter the baseline tier from unoptimized code and leave it
+    // for the full pipeline. OSR always uses the full pipeline.
+    const bool baseline = optimized && (osr_id == Compiler::kNoOSRDeoptId) &&
+                          Compiler::UseBaselineTier(function) &&
+                          !function.HasOptimizedCode();
     Timer per_compile_timer;
     per_compile_timer.Start();
 
@@ -696,7 +764,7 @@ static ObjectPtr CompileFunctionHelper(CompilationPipeline* pipeline,
       const intptr_t token_size = function.SourceSize();
       THR_Print("Compiling %s%sfunction %s: '%s' @ token %s, size %" Pd "\n",
                 (osr_id == Compiler::kNoOSRDeoptId ? "" : "osr "),
-                (optimized ? "optimized " : ""),
+                (baseline ? "baseline " : (optimized ? "optimized " : "")),
                 (Compiler::IsBackgroundCompilation() ? "(background)" : ""),
                 function.ToFullyQualifiedCString(),
                 function.token_pos().ToCString(), token_size);
@@ -707,7 +775,8 @@ static ObjectPtr CompileFunctionHelper(CompilationPipeline* pipeline,
       pipeline->ParseFunction(parsed_function);
     }
 
-    CompileParsedFunctionHelper helper(parsed_function, optimized, osr_id);
+    CompileParsedFunctionHelper helper(parsed_function, optimized, baseline,
+                                       osr_id);
 
     const Code& result = Code::Handle(helper.Compile(pipeline));
 
@@ -978,112 +1047,254 @@ void Compiler::AbortBackgroundCompilation(intptr_t deopt_id, const char* msg) {
       deopt_id, Object::background_compilation_error());
 }
 
-// C-heap allocated background compilation queue element.
-class QueueElement {
- public:
-  explicit QueueElement(const Function& function)
-      : next_(NULL), function_(function.ptr()) {}
-
-  virtual ~QueueElement() {
-    next_ = NULL;
-    function_ = Function::null();
-  }
+QueueElement::QueueElement(const dart::Function& function,
+                           int64_t enqueue_micros)
+    : prev_(nullptr),
+      next_(nullptr),
+      function_(function.ptr()),
+      code_(function.CurrentCode()),
+      enqueue_micros_(enqueue_micros),
+      rate_(0),
+      heap_index_(-1),
+      in_progress_(false) {}
+
+QueueElement::~QueueElement() {
+  prev_ = nullptr;
+  next_ = nullptr;
+  function_ = dart::Function::null();
+  code_ = Code::null();
+}
 
-  FunctionPtr Function() const { return function_; }
+BackgroundCompilationQueue::BackgroundCompilationQueue()
+    : first_(nullptr),
+      last_(nullptr),
+      pending_(),
+      num_in_progress_(0),
+      rates_micros_(kMinInt64) {}
 
-  void set_next(QueueElement* elem) { next_ = elem; }
-  QueueElement* next() const { return next_; }
+BackgroundCompilationQueue::~BackgroundCompilationQueue() {
+  Clear();
+}
 
-  ObjectPtr function() const { return function_; }
-  ObjectPtr* function_untag() {
-    return reinterpret_cast<ObjectPtr*>(&function_);
+void BackgroundCompilationQueue::VisitObjectPointers(
+    ObjectPointerVisitor* visitor) {
+  ASSERT(visitor != nullptr);
+  QueueElement* p = first_;
+  while (p != nullptr) {
+    visitor->VisitPointer(p->function_untag());
+    visitor->VisitPointer(p->code_untag());
+    p = p->next_;
   }
+}
 
- private:
-  QueueElement* next_;
-  FunctionPtr function_;
+void BackgroundCompilationQueue::Add(QueueElement* value) {
+  ASSERT(value != nullptr);
+  ASSERT(value->next_ == nullptr && value->prev_ == nullptr);
+  ASSERT(!value->in_progress());
+  if (first_ == nullptr) {
+    first_ = value;
+    ASSERT(last_ == nullptr);
+  } else {
+    ASSERT(last_ != nullptr);
+    last_->next_ = value;
+    value->prev_ = last_;
+  }
+  last_ = value;
+  // No invocations while waiting yet. The next refresh of the rates gives
+  // the element its place among the others.
+  value->rate_ = 0;
+  HeapAdd(value);
+  ASSERT(first_ != nullptr && last_ != nullptr);
+}
 
-  DISALLOW_COPY_AND_ASSIGN(QueueElement);
-};
+void BackgroundCompilationQueue::Remove(QueueElement* value) {
+  Unlink(value);
+  if (value->in_progress()) {
+    num_in_progress_--;
+  } else {
+    HeapRemove(value);
+  }
+}
 
-// Allocated in C-heap. Handles both input and output of background compilation.
-// It implements a FIFO queue, using Peek, Add, Remove operations.
-class BackgroundCompilationQueue {
- public:
-  BackgroundCompilationQueue() : first_(NULL), last_(NULL) {}
-  virtual ~BackgroundCompilationQueue() { Clear(); }
-
-  void VisitObjectPointers(ObjectPointerVisitor* visitor) {
-    ASSERT(visitor != NULL);
-    QueueElement* p = first_;
-    while (p != NULL) {
-      visitor->VisitPointer(p->function_untag());
-      p = p->next();
-    }
+void BackgroundCompilationQueue::Unlink(QueueElement* value) {
+  ASSERT(value != nullptr);
+  if (value->prev_ == nullptr) {
+    ASSERT(first_ == value);
+    first_ = value->next_;
+  } else {
+    value->prev_->next_ = value->next_;
+  }
+  if (value->next_ == nullptr) {
+    ASSERT(last_ == value);
+    last_ = value->prev_;
+  } else {
+    value->next_->prev_ = value->prev_;
   }
+  value->prev_ = nullptr;
+  value->next_ = nullptr;
+}
 
-  bool IsEmpty() const { return first_ == NULL; }
+void BackgroundCompilationQueue::Requeue(QueueElement* value,
+                                         const Function& function,
+                                         int64_t now_micros) {
+  ASSERT(value->in_progress());
+  ASSERT(value->function() == function.ptr());
+  value->set_in_progress(false);
+  value->set_enqueue_micros(now_micros);
+  num_in_progress_--;
+  // The compiler reset the counter when it gave up. Count the invocations
+  // while waiting again from scratch, as when the function was first queued.
+  function.SetUsageCounter(kMinInt32);
+  value->rate_ = 0;
+  HeapAdd(value);
+}
 
-  void Add(QueueElement* value) {
-    ASSERT(value != NULL);
-    ASSERT(value->next() == NULL);
-    if (first_ == NULL) {
-      first_ = value;
-      ASSERT(last_ == NULL);
-    } else {
-      ASSERT(last_ != NULL);
-      last_->set_next(value);
+QueueElement* BackgroundCompilationQueue::RemoveHottest(int64_t now_micros,
+                                                        Function* function,
+                                                        intptr_t* stale) {
+  if ((now_micros - kRatesRefreshMicros) >= rates_micros_) {
+    RefreshRates(now_micros, function, stale);
+  }
+  while (!pending_.is_empty()) {
+    QueueElement* hottest = pending_[0];
+    *function = hottest->Function();
+    if (IsStale(*function, hottest)) {
+      Remove(hottest);
+      delete hottest;
+      (*stale)++;
+      continue;
     }
-    last_ = value;
-    ASSERT(first_ != NULL && last_ != NULL);
+    HeapRemove(hottest);
+    hottest->set_in_progress(true);
+    num_in_progress_++;
+    return hottest;
   }
+  return nullptr;
+}
 
-  QueueElement* Peek() const { return first_; }
-
-  FunctionPtr PeekFunction() const {
-    QueueElement* e = Peek();
-    if (e == NULL) {
-      return Function::null();
-    } else {
-      return e->Function();
+bool BackgroundCompilationQueue::ContainsObj(const Object& obj) const {
+  QueueElement* p = first_;
+  while (p != nullptr) {
+    if (p->function() == obj.ptr()) {
+      return true;
     }
+    p = p->next_;
   }
+  return false;
+}
 
-  QueueElement* Remove() {
-    ASSERT(first_ != NULL);
-    QueueElement* result = first_;
-    first_ = first_->next();
-    if (first_ == NULL) {
-      last_ = NULL;
-    }
-    return result;
+void BackgroundCompilationQueue::Clear() {
+  while (!pending_.is_empty()) {
+    QueueElement* p = pending_.Last();
+    Remove(p);
+    delete p;
   }
+}
+
+bool BackgroundCompilationQueue::IsStale(const Function& function,
+                                         QueueElement* element) {
+  return function.HasOptimizedCode() &&
+         (function.CurrentCode() != element->code());
+}
 
-  bool ContainsObj(const Object& obj) const {
-    QueueElement* p = first_;
-    while (p != NULL) {
-      if (p->function() == obj.ptr()) {
-        return true;
+int64_t BackgroundCompilationQueue::InvocationRate(const Function& function,
+                                                   int64_t wait_micros) {
+  const int64_t counter = function.usage_counter();
+  const int64_t invocations = counter < 0 ? counter - kMinInt32 : counter;
+  return (invocations * kMicrosecondsPerMillisecond) /
+         (Utils::Maximum<int64_t>(wait_micros, 0) +
+          kMicrosecondsPerMillisecond);
+}
+
+void BackgroundCompilationQueue::RefreshRates(int64_t now_micros,
+                                              Function* function,
+                                              intptr_t* stale) {
+  rates_micros_ = now_micros;
+  intptr_t i = 0;
+  while (i < pending_.length()) {
+    QueueElement* element = pending_[i];
+    *function = element->Function();
+    if (IsStale(*function, element)) {
+      // The heap order is restored below.
+      QueueElement* last = pending_.RemoveLast();
+      if (last != element) {
+        pending_[i] = last;
+        last->heap_index_ = i;
       }
-      p = p->next();
+      element->heap_index_ = -1;
+      Unlink(element);
+      delete element;
+      (*stale)++;
+    } else {
+      element->rate_ =
+          InvocationRate(*function, now_micros - element->enqueue_micros());
+      i++;
     }
-    return false;
   }
+  for (intptr_t i = pending_.length() / 2 - 1; i >= 0; i--) {
+    SiftDown(i);
+  }
+}
 
-  void Clear() {
-    while (!IsEmpty()) {
-      QueueElement* e = Remove();
-      delete e;
-    }
-    ASSERT((first_ == NULL) && (last_ == NULL));
+bool BackgroundCompilationQueue::IsHotter(const QueueElement* a,
+                                          const QueueElement* b) {
+  if (a->rate_ != b->rate_) {
+    return a->rate_ > b->rate_;
   }
+  return a->enqueue_micros() < b->enqueue_micros();
+}
 
- private:
-  QueueElement* first_;
-  QueueElement* last_;
+void BackgroundCompilationQueue::HeapAdd(QueueElement* value) {
+  ASSERT(value->heap_index_ == -1);
+  value->heap_index_ = pending_.length();
+  pending_.Add(value);
+  SiftUp(value->heap_index_);
+}
 
-  DISALLOW_COPY_AND_ASSIGN(BackgroundCompilationQueue);
-};
+void BackgroundCompilationQueue::HeapRemove(QueueElement* value) {
+  const intptr_t index = value->heap_index_;
+  ASSERT(pending_[index] == value);
+  QueueElement* last = pending_.RemoveLast();
+  value->heap_index_ = -1;
+  if (last != value) {
+    pending_[index] = last;
+    last->heap_index_ = index;
+    SiftUp(index);
+    SiftDown(last->heap_index_);
+  }
+}
+
+void BackgroundCompilationQueue::SiftUp(intptr_t index) {
+  QueueElement* value = pending_[index];
+  while (index > 0) {
+    const intptr_t parent = (index - 1) / 2;
+    if (!IsHotter(value, pending_[parent])) break;
+    pending_[index] = pending_[parent];
+    pending_[index]->heap_index_ = index;
+    index = parent;
+  }
+  pending_[index] = value;
+  value->heap_index_ = index;
+}
+
+void BackgroundCompilationQueue::SiftDown(intptr_t index) {
+  QueueElement* value = pending_[index];
+  const intptr_t length = pending_.length();
+  for (;;) {
+    intptr_t child = 2 * index + 1;
+    if (child >= length) break;
+    if ((child + 1 < length) &&
+        IsHotter(pending_[child + 1], pending_[child])) {
+      child++;
+    }
+    if (!IsHotter(pending_[child], value)) break;
+    pending_[index] = pending_[child];
+    pending_[index]->heap_index_ = index;
+    index = child;
+  }
+  pending_[index] = value;
+  value->heap_index_ = index;
+}
 
 class BackgroundCompilerTask : public ThreadPool::Task {
  public:
@@ -1104,7 +1315,7 @@ BackgroundCompiler::BackgroundCompiler(IsolateGroup* isolate_group)
       monitor_(),
       function_queue_(new BackgroundCompilationQueue()),
       running_(false),
-      done_(true),
+      active_tasks_(0),
       disabled_depth_(0) {}
 
 // Fields all deleted in ::Stop; here clear them.
@@ -1125,42 +1336,64 @@ void BackgroundCompiler::Run() {
     QueueElement* element = nullptr;
     {
       SafepointMonitorLocker ml(&monitor_);
-      if (running_ && !function_queue()->IsEmpty()) {
-        element = function_queue()->Remove();
-        function ^= element->function();
+      if (running_) {
+        const int64_t now = OS::GetCurrentMonotonicMicros();
+        intptr_t stale = 0;
+        element = function_queue()->RemoveHottest(now, &function, &stale);
+        if (stale > 0) {
+          Metric* metric =
+              isolate_group_->GetBackgroundCompilationStaleMetric();
+          metric->set_value(metric->value() + stale);
+        }
+        if (element != nullptr) {
+          function ^= element->function();
+          const int64_t wait = now - element->enqueue_micros();
+          Metric* metric = isolate_group_->GetBackgroundCompilationWaitMetric();
+          metric->set_value(metric->value() + wait);
+          isolate_group_->GetBackgroundCompilationWaitMaxMetric()->SetValue(
+              wait);
+        }
+        UpdateQueueLengthMetricLocked();
       }
     }
     if (element != nullptr) {
-      delete element;
       Compiler::CompileOptimizedFunction(thread, function,
                                          Compiler::kNoOSRDeoptId);
 
       // If an optimizable method is not optimized, put it back on
       // the background queue (unless it was passed to foreground).
+      bool requeue = false;
       if ((!function.HasOptimizedCode() && function.IsOptimizable()) ||
           FLAG_stress_test_background_compilation) {
-        if (Compiler::CanOptimizeFunction(thread, function)) {
-          SafepointMonitorLocker ml(&monitor_);
-          if (running_) {
-            QueueElement* repeat_qelem = new QueueElement(function);
-            function_queue()->Add(repeat_qelem);
-          }
-        }
+        requeue = Compiler::CanOptimizeFunction(thread, function);
+      }
+      SafepointMonitorLocker ml(&monitor_);
+      if (requeue && running_) {
+        function_queue()->Requeue(element, function,
+                                  OS::GetCurrentMonotonicMicros());
+      } else {
+        function_queue()->Remove(element);
+        delete element;
       }
+      UpdateQueueLengthMetricLocked();
     }
   }
   Thread::ExitIsolateGroupAsHelper(/*bypass_safepoint=*/false);
   {
     MonitorLocker ml(&monitor_);
-    if (running_ && !function_queue()->IsEmpty() &&
+    // Keep going only while there is more pending work than the other idle
+    // tasks will pick up.
+    if (running_ &&
+        (function_queue()->num_pending() > IdleTasksLocked() - 1) &&
         Dart::thread_pool()->Run<BackgroundCompilerTask>(this)) {
       // Successfully scheduled a new task.
     } else {
-      // Background compiler done. This notification must happen after the
-      // thread leaves to group to avoid a shutdown race with the thread
-      // registry.
-      running_ = false;
-      done_ = true;
+      // This task is done. The notification must happen after the thread
+      // leaves the group to avoid a shutdown race with the thread registry.
+      active_tasks_--;
+      if (active_tasks_ == 0) {
+        running_ = false;
+      }
       ml.NotifyAll();
     }
   }
@@ -1173,30 +1406,46 @@ bool BackgroundCompiler::EnqueueCompilation(const Function& function) {
 
   SafepointMonitorLocker ml(&monitor_);
   if (disabled_depth_ > 0) return false;
-  if (!running_ && done_) {
+  if (!running_ && (active_tasks_ == 0)) {
     running_ = true;
-    done_ = false;
-    // If we ever wanted to run the BG compiler on the
-    // `IsolateGroup::mutator_pool()` we would need to ensure the BG compiler
-    // stops when it's idle - otherwise the [MutatorThreadPool]-based idle
-    // notification would not work anymore.
-    if (!Dart::thread_pool()->Run<BackgroundCompilerTask>(this)) {
-      running_ = false;
-      done_ = true;
-      return false;
-    }
   }
 
   ASSERT(running_);
   if (function_queue()->ContainsObj(function)) {
     return true;
   }
-  QueueElement* elem = new QueueElement(function);
+  // Start another task if the new element would otherwise have to wait for
+  // a busy one.
+  // If we ever wanted to run the BG compiler on the
+  // `IsolateGroup::mutator_pool()` we would need to ensure the BG compiler
+  // stops when it's idle - otherwise the [MutatorThreadPool]-based idle
+  // notification would not work anymore.
+  if ((active_tasks_ < Utils::Maximum(FLAG_background_compiler_tasks, 1)) &&
+      (function_queue()->num_pending() >= IdleTasksLocked())) {
+    if (Dart::thread_pool()->Run<BackgroundCompilerTask>(this)) {
+      active_tasks_++;
+    } else if (active_tasks_ == 0) {
+      running_ = false;
+      return false;
+    }
+  }
+  QueueElement* elem =
+      new QueueElement(function, OS::GetCurrentMonotonicMicros());
   function_queue()->Add(elem);
+  UpdateQueueLengthMetricLocked();
   ml.NotifyAll();
   return true;
 }
 
+intptr_t BackgroundCompiler::IdleTasksLocked() const {
+  return active_tasks_ - function_queue_->num_in_progress();
+}
+
+void BackgroundCompiler::UpdateQueueLengthMetricLocked() {
+  isolate_group_->GetBackgroundCompilationQueueLengthMetric()->set_value(
+      function_queue_->num_pending());
+}
+
 void BackgroundCompiler::VisitPointers(ObjectPointerVisitor* visitor) {
   function_queue_->VisitObjectPointers(visitor);
 }
@@ -1214,9 +1463,11 @@ void BackgroundCompiler::StopLocked(Thread* thread,
                                     SafepointMonitorLocker* locker) {
   running_ = false;
   function_queue_->Clear();
-  while (!done_) {
+  UpdateQueueLengthMetricLocked();
+  while (active_tasks_ > 0) {
     locker->Wait();
   }
+  ASSERT(function_queue_->IsEmpty());
 }
 
 void BackgroundCompiler::Enable() {
@@ -1238,7 +1489,7 @@ void BackgroundCompiler::Disable() {
 
   SafepointMonitorLocker ml(&monitor_);
   disabled_depth_++;
-  if (done_) return;
+  if (active_tasks_ == 0) return;
   StopLocked(thread, &ml);
 }
 
@@ -1267,6 +1518,10 @@ bool Compiler::CanOptimizeFunction(Thread* thread, const Function& function) {
   return false;
 }
 
+bool Compiler::UseBaselineTier(const Function& function) {
+  return false;
+}
+
 ObjectPtr Compiler::CompileFunction(Thread* thread, const Function& function) {
   FATAL1("Attempt to compile function %s", function.ToCString());
   return Error::null();
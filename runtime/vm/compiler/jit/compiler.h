@@ -76,6 +76,10 @@ class Compiler : public AllStatic {
   // The result for a function may change if debugging gets turned on/off.
   static bool CanOptimizeFunction(Thread* thread, const Function& function);
 
+  // Whether [function] is compiled with the baseline pipeline before it is
+  // fully optimized (see --baseline_optimization_counter_threshold).
+  static bool UseBaselineTier(const Function& function);
+
 #if !defined(PRODUCT)
   // Whether it's possible for unoptimized code to optimize immediately on entry
   // (can happen with random or very low optimization counter thresholds)
@@ -122,9 +126,135 @@ class Compiler : public AllStatic {
   static void AbortBackgroundCompilation(intptr_t deopt_id, const char* msg);
 };
 
-// Class to run optimizing compilation in a background thread.
-// Current implementation: one task per isolate, it dies with the owning
-// isolate.
+// C-heap allocated background compilation queue element.
+class QueueElement {
+ public:
+  QueueElement(const Function& function, int64_t enqueue_micros);
+  virtual ~QueueElement();
+
+  FunctionPtr Function() const { return function_; }
+
+  ObjectPtr function() const { return function_; }
+  ObjectPtr* function_untag() {
+    return reinterpret_cast<ObjectPtr*>(&function_);
+  }
+
+  // The code the function had when it was queued. If the function has
+  // different code by the time a compiler task gets to it, someone else
+  // already compiled it and the element is stale.
+  CodePtr code() const { return code_; }
+  ObjectPtr* code_untag() { return reinterpret_cast<ObjectPtr*>(&code_); }
+
+  int64_t enqueue_micros() const { return enqueue_micros_; }
+  void set_enqueue_micros(int64_t value) { enqueue_micros_ = value; }
+
+  // True while a compiler task is working on the function. In-progress
+  // elements stay in the queue so duplicates are still rejected.
+  bool in_progress() const { return in_progress_; }
+  void set_in_progress(bool value) { in_progress_ = value; }
+
+ private:
+  friend class BackgroundCompilationQueue;
+
+  QueueElement* prev_;
+  QueueElement* next_;
+  FunctionPtr function_;
+  CodePtr code_;
+  int64_t enqueue_micros_;
+  // The invocation rate at the last refresh, see
+  // BackgroundCompilationQueue::RemoveHottest.
+  int64_t rate_;
+  // The index in the heap of pending elements, or -1.
+  intptr_t heap_index_;
+  bool in_progress_;
+
+  DISALLOW_COPY_AND_ASSIGN(QueueElement);
+};
+
+// Allocated in C-heap. Handles both input and output of background
+// compilation. All elements are kept in arrival order, so duplicates are
+// rejected while a function is queued or compiling. Pending elements are also
+// kept in a heap ordered by their invocation rate, so compiler tasks take the
+// hottest one in logarithmic time.
+class BackgroundCompilationQueue {
+ public:
+  // The rates of all pending elements are recomputed at most this often,
+  // which bounds the cost of picking the hottest element when many are
+  // taken in a burst.
+  static constexpr int64_t kRatesRefreshMicros = 1000;
+
+  BackgroundCompilationQueue();
+  virtual ~BackgroundCompilationQueue();
+
+  void VisitObjectPointers(ObjectPointerVisitor* visitor);
+
+  bool IsEmpty() const { return first_ == nullptr; }
+
+  // Number of elements not yet picked up by a compiler task.
+  intptr_t num_pending() const { return pending_.length(); }
+  // Number of elements compiler tasks are working on.
+  intptr_t num_in_progress() const { return num_in_progress_; }
+
+  void Add(QueueElement* value);
+  void Remove(QueueElement* value);
+
+  // Marks an in-progress element for [function] as pending again, and resets
+  // the usage counter of [function] to measure its invocation rate anew.
+  void Requeue(QueueElement* value,
+               const Function& function,
+               int64_t now_micros);
+
+  // Picks the pending element with the highest invocation rate since it was
+  // queued and marks it in progress. The rates are those of the last refresh
+  // (see kRatesRefreshMicros), elements queued since then count as cold.
+  // Elements whose function got new optimized code since they were queued
+  // are stale; they are deleted on the way and counted in [stale]. Ties go
+  // to the oldest element.
+  QueueElement* RemoveHottest(int64_t now_micros,
+                              Function* function,
+                              intptr_t* stale);
+
+  bool ContainsObj(const Object& obj) const;
+
+  // Deletes all pending elements. In-progress elements are owned by the
+  // compiler tasks working on them, which remove them when done.
+  void Clear();
+
+ private:
+  static bool IsStale(const Function& function, QueueElement* element);
+
+  // Removes [value] from the list of all elements.
+  void Unlink(QueueElement* value);
+
+  // Invocations per millisecond since the function was queued. Once a
+  // function is queued the mutator resets its usage counter to INT32_MIN (see
+  // OptimizeInvokedFunction), so the distance from that is the number of
+  // invocations while waiting.
+  static int64_t InvocationRate(const Function& function, int64_t wait_micros);
+
+  // Recomputes the rates of all pending elements, deletes the stale ones and
+  // restores the heap order.
+  void RefreshRates(int64_t now_micros, Function* function, intptr_t* stale);
+
+  static bool IsHotter(const QueueElement* a, const QueueElement* b);
+  void HeapAdd(QueueElement* value);
+  void HeapRemove(QueueElement* value);
+  void SiftUp(intptr_t index);
+  void SiftDown(intptr_t index);
+
+  QueueElement* first_;
+  QueueElement* last_;
+  // Max-heap of the pending elements by rate.
+  MallocGrowableArray<QueueElement*> pending_;
+  intptr_t num_in_progress_;
+  int64_t rates_micros_;
+
+  DISALLOW_COPY_AND_ASSIGN(BackgroundCompilationQueue);
+};
+
+// Class to run optimizing compilation in background threads.
+// Up to FLAG_background_compiler_tasks tasks per isolate group take the
+// hottest queued function first; they die with the owning isolate group.
 // No OSR compilation in the background compiler.
 class BackgroundCompiler {
  public:
@@ -154,14 +284,17 @@ class BackgroundCompiler {
   void StopLocked(Thread* thread, SafepointMonitorLocker* done_locker);
   void Enable();
   void Disable();
-  bool IsRunning() { return !done_; }
+  bool IsRunning() { return active_tasks_ > 0; }
+  // Tasks that are scheduled but not compiling anything yet.
+  intptr_t IdleTasksLocked() const;
+  void UpdateQueueLengthMetricLocked();
 
   IsolateGroup* isolate_group_;
 
   Monitor monitor_;  // Controls access to the queue and running state.
   BackgroundCompilationQueue* function_queue_;
   bool running_;            // While true, will try to read queue and compile.
-  bool done_;               // True if the thread is done.
+  intptr_t active_tasks_;   // Number of scheduled or running tasks.
   int16_t disabled_depth_;
 
   DISALLOW_IMPLICIT_CONSTRUCTORS(BackgroundCompiler);
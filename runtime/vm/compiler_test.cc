@@ -16,6 +16,9 @@
 
 namespace dart {
 
+DECLARE_FLAG(int, background_compiler_tasks);
+DECLARE_FLAG(int, baseline_optimization_counter_threshold);
+
 ISOLATE_UNIT_TEST_CASE(CompileFunction) {
   const char* kScriptChars =
       "class A {\n"
@@ -100,6 +103,144 @@ ISOLATE_UNIT_TEST_CASE(OptimizeCompileFunctionOnHelperThread) {
   delete m;
 }
 
+ISOLATE_UNIT_TEST_CASE(OptimizeCompileFunctionsOnMultipleHelperThreads) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static f0() { return 0; }\n"
+      "  static f1() { return 1; }\n"
+      "  static f2() { return 2; }\n"
+      "  static f3() { return 3; }\n"
+      "}\n";
+  Dart_Handle library;
+  {
+    TransitionVMToNative transition(thread);
+    library = TestCase::LoadTestScript(kScriptChars, NULL);
+  }
+  const Library& lib =
+      Library::Handle(Library::RawCast(Api::UnwrapHandle(library)));
+  EXPECT(ClassFinalizer::ProcessPendingClasses());
+  Class& cls =
+      Class::Handle(lib.LookupClass(String::Handle(Symbols::New(thread, "A"))));
+  EXPECT(!cls.IsNull());
+  const auto& error = cls.EnsureIsFinalized(thread);
+  EXPECT(error == Error::null());
+
+  const intptr_t kNumFunctions = 4;
+  const Array& functions = Array::Handle(Array::New(kNumFunctions));
+  String& name = String::Handle();
+  Function& func = Function::Handle();
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    name = String::NewFormatted("f%" Pd, i);
+    func = cls.LookupStaticFunction(name);
+    EXPECT(!func.IsNull());
+    CompilerTest::TestCompileFunction(func);
+    EXPECT(func.HasCode());
+    EXPECT(!func.HasOptimizedCode());
+    functions.SetAt(i, func);
+  }
+
+#if !defined(PRODUCT)
+  // Constant in product mode.
+  FLAG_background_compilation = true;
+#endif
+  SetFlagScope<int> sfs(&FLAG_background_compiler_tasks, 2);
+  auto isolate_group = thread->isolate_group();
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    func ^= functions.At(i);
+    EXPECT(isolate_group->background_compiler()->EnqueueCompilation(func));
+    // Duplicates are rejected while the function is queued or compiling.
+    EXPECT(isolate_group->background_compiler()->EnqueueCompilation(func));
+  }
+  Monitor* m = new Monitor();
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    func ^= functions.At(i);
+    SafepointMonitorLocker ml(m);
+    while (!func.HasOptimizedCode()) {
+      ml.Wait(1);
+    }
+  }
+  delete m;
+
+  BackgroundCompiler::Stop(isolate_group);
+  EXPECT_EQ(0, isolate_group->GetBackgroundCompilationQueueLengthMetric()
+                   ->value());
+  EXPECT(isolate_group->GetBackgroundCompilationWaitMaxMetric()->value() >= 0);
+}
+
+ISOLATE_UNIT_TEST_CASE(BackgroundCompilationQueueOrder) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static f0() { return 0; }\n"
+      "  static f1() { return 1; }\n"
+      "  static f2() { return 2; }\n"
+      "  static f3() { return 3; }\n"
+      "  static f4() { return 4; }\n"
+      "}\n";
+  Dart_Handle library;
+  {
+    TransitionVMToNative transition(thread);
+    library = TestCase::LoadTestScript(kScriptChars, NULL);
+  }
+  const Library& lib =
+      Library::Handle(Library::RawCast(Api::UnwrapHandle(library)));
+  EXPECT(ClassFinalizer::ProcessPendingClasses());
+  Class& cls =
+      Class::Handle(lib.LookupClass(String::Handle(Symbols::New(thread, "A"))));
+  EXPECT(!cls.IsNull());
+  const auto& error = cls.EnsureIsFinalized(thread);
+  EXPECT(error == Error::null());
+
+  // Invocations while waiting, counted from INT32_MIN as after
+  // OptimizeInvokedFunction. f4 is as hot as f0 but queued later.
+  const intptr_t kNumFunctions = 5;
+  const int32_t kInvocations[kNumFunctions] = {10, 1000, 0, 100, 10};
+  const intptr_t kExpectedOrder[kNumFunctions] = {1, 3, 0, 4, 2};
+  const int64_t kEnqueueMicros = 1000000;
+  const Array& functions = Array::Handle(Array::New(kNumFunctions));
+  String& name = String::Handle();
+  Function& func = Function::Handle();
+  BackgroundCompilationQueue queue;
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    name = String::NewFormatted("f%" Pd, i);
+    func = cls.LookupStaticFunction(name);
+    EXPECT(!func.IsNull());
+    CompilerTest::TestCompileFunction(func);
+    functions.SetAt(i, func);
+    func.SetUsageCounter(kMinInt32 + kInvocations[i]);
+    queue.Add(new QueueElement(func, kEnqueueMicros + i));
+  }
+  EXPECT_EQ(kNumFunctions, queue.num_pending());
+
+  const int64_t now = kEnqueueMicros + 1000;
+  QueueElement* elements[kNumFunctions];
+  intptr_t stale = 0;
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    elements[i] = queue.RemoveHottest(now, &func, &stale);
+    EXPECT(elements[i] != nullptr);
+    EXPECT(elements[i]->in_progress());
+    EXPECT(elements[i]->function() == functions.At(kExpectedOrder[i]));
+  }
+  EXPECT(queue.RemoveHottest(now, &func, &stale) == nullptr);
+  EXPECT_EQ(0, stale);
+  EXPECT_EQ(0, queue.num_pending());
+  EXPECT_EQ(kNumFunctions, queue.num_in_progress());
+
+  // Requeued functions count their invocations from scratch.
+  func ^= functions.At(kExpectedOrder[0]);
+  queue.Requeue(elements[0], func, now);
+  EXPECT_EQ(kMinInt32, func.usage_counter());
+  EXPECT_EQ(1, queue.num_pending());
+  EXPECT(queue.ContainsObj(func));
+
+  for (intptr_t i = 0; i < kNumFunctions; i++) {
+    queue.Remove(elements[i]);
+    delete elements[i];
+  }
+  EXPECT(queue.IsEmpty());
+  EXPECT_EQ(0, queue.num_pending());
+  EXPECT_EQ(0, queue.num_in_progress());
+}
+
 ISOLATE_UNIT_TEST_CASE(CompileFunctionOnHelperThread) {
   // Create a simple function and compile it without optimization.
   const char* kScriptChars =
@@ -127,6 +268,104 @@ ISOLATE_UNIT_TEST_CASE(CompileFunctionOnHelperThread) {
   EXPECT(func.HasCode());
 }
 
+ISOLATE_UNIT_TEST_CASE(CompileFunctionBaselineTier) {
+  const char* kScriptChars =
+      "class A {\n"
+      "  static foo(int x) { return x + 42; }\n"
+      "}\n";
+  SetFlagScope<int> sfs(&FLAG_baseline_optimization_counter_threshold, 0);
+  Dart_Handle library;
+  {
+    TransitionVMToNative transition(thread);
+    library = TestCase::LoadTestScript(kScriptChars, NULL);
+  }
+  const Library& lib =
+      Library::Handle(Library::RawCast(Api::UnwrapHandle(library)));
+  EXPECT(ClassFinalizer::ProcessPendingClasses());
+  Class& cls =
+      Class::Handle(lib.LookupClass(String::Handle(Symbols::New(thread, "A"))));
+  EXPECT(!cls.IsNull());
+  const auto& error = cls.EnsureIsFinalized(thread);
+  EXPECT(error == Error::null());
+  String& function_foo_name = String::Handle(String::New("foo"));
+  Function& func =
+      Function::Handle(cls.LookupStaticFunction(function_foo_name));
+  EXPECT(Compiler::UseBaselineTier(func));
+  CompilerTest::TestCompileFunction(func);
+  EXPECT(func.HasCode());
+
+  auto isolate_group = thread->isolate_group();
+  Metric* baseline = isolate_group->GetCompilationTimeBaselineMetric();
+  Metric* optimized = isolate_group->GetCompilationTimeOptimizedMetric();
+  const int64_t baseline_time = baseline->value();
+  const int64_t optimized_time = optimized->value();
+
+  // The first optimizing compile uses the baseline pipeline, the next one
+  // replaces baseline code with fully optimized code.
+  const auto& result =
+      Object::Handle(Compiler::CompileOptimizedFunction(thread, func));
+  EXPECT(result.IsCode());
+  EXPECT(func.HasOptimizedCode());
+  EXPECT(baseline->value() > baseline_time);
+  EXPECT_EQ(optimized_time, optimized->value());
+
+  Compiler::CompileOptimizedFunction(thread, func);
+  EXPECT(func.HasOptimizedCode());
+  EXPECT(optimized->value() > optimized_time);
+}
+
+// Baseline code is not specialized on the ICData collected by unoptimized
+// code, and keeps adding receivers to it.
+ISOLATE_UNIT_TEST_CASE(BaselineTierUpdatesICData) {
+  const char* kScriptChars =
+      "class A { m() => 1; }\n"
+      "class B { m() => 2; }\n"
+      "callM(o) => o.m();\n"
+      "callA() => callM(A());\n"
+      "callB() => callM(B());\n";
+  SetFlagScope<int> sfs(&FLAG_baseline_optimization_counter_threshold, 0);
+  Dart_Handle library;
+  {
+    TransitionVMToNative transition(thread);
+    library = TestCase::LoadTestScript(kScriptChars, NULL);
+    Dart_Handle result = Dart_Invoke(library, NewString("callA"), 0, NULL);
+    EXPECT_VALID(result);
+  }
+  const Library& lib =
+      Library::Handle(Library::RawCast(Api::UnwrapHandle(library)));
+  const Function& func = Function::Handle(
+      lib.LookupLocalFunction(String::Handle(String::New("callM"))));
+  EXPECT(!func.IsNull());
+  EXPECT(func.HasCode());
+  EXPECT(Compiler::UseBaselineTier(func));
+
+  const auto& result =
+      Object::Handle(Compiler::CompileOptimizedFunction(thread, func));
+  EXPECT(result.IsCode());
+  EXPECT(func.HasOptimizedCode());
+  {
+    TransitionVMToNative transition(thread);
+    Dart_Handle result = Dart_Invoke(library, NewString("callB"), 0, NULL);
+    EXPECT_VALID(result);
+  }
+  // Still running baseline code, which called B.m through an IC stub.
+  EXPECT(func.HasOptimizedCode());
+
+  ZoneGrowableArray<const ICData*>* ic_data_array =
+      new ZoneGrowableArray<const ICData*>();
+  func.RestoreICDataMap(ic_data_array, /*clone_ic_data=*/false);
+  const ICData* m_call = nullptr;
+  for (intptr_t i = 0; i < ic_data_array->length(); i++) {
+    const ICData* ic_data = (*ic_data_array)[i];
+    if ((ic_data != nullptr) && !ic_data->is_static_call() &&
+        (String::Handle(ic_data->target_name()).Equals("m"))) {
+      m_call = ic_data;
+    }
+  }
+  EXPECT(m_call != nullptr);
+  EXPECT_EQ(2, m_call->NumberOfUsedChecks());
+}
+
 ISOLATE_UNIT_TEST_CASE(RegenerateAllocStubs) {
   const char* kScriptChars =
       "class A {\n"
@@ -5854,6 +5854,32 @@ DART_EXPORT Dart_Handle Dart_FinalizeLoading(bool complete_futures) {
   return Api::Success();
 }
 
+// Deserializes the snapshot of [unit]. Returns an error, or null if the
+// unit was read.
+static ObjectPtr ReadLoadingUnit(Thread* T,
+                                 const LoadingUnit& unit,
+                                 const uint8_t* snapshot_data,
+                                 const uint8_t* snapshot_instructions) {
+#if defined(SUPPORT_TIMELINE)
+  TimelineBeginEndScope tbes(T, Timeline::GetIsolateStream(),
+                             "ReadUnitSnapshot");
+#endif  // defined(SUPPORT_TIMELINE)
+  const Snapshot* snapshot = Snapshot::SetupFromBuffer(snapshot_data);
+  if (snapshot == NULL) {
+    return ApiError::New(String::Handle(String::New("Invalid snapshot")));
+  }
+  if (!IsSnapshotCompatible(Dart::vm_snapshot_kind(), snapshot->kind())) {
+    const String& message = String::Handle(String::NewFormatted(
+        "Incompatible snapshot kinds: vm '%s', isolate '%s'",
+        Snapshot::KindToCString(Dart::vm_snapshot_kind()),
+        Snapshot::KindToCString(snapshot->kind())));
+    return ApiError::New(message);
+  }
+
+  FullSnapshotReader reader(snapshot, snapshot_instructions, T);
+  return reader.ReadUnitSnapshot(unit);
+}
+
 static Dart_Handle DeferredLoadComplete(intptr_t loading_unit_id,
                                         bool error,
                                         const uint8_t* snapshot_data,
@@ -5883,26 +5909,10 @@ static Dart_Handle DeferredLoadComplete(intptr_t loading_unit_id,
         T, unit.CompleteLoad(String::Handle(String::New(error_message)),
                              transient_error));
   } else {
-#if defined(SUPPORT_TIMELINE)
-    TimelineBeginEndScope tbes(T, Timeline::GetIsolateStream(),
-                               "ReadUnitSnapshot");
-#endif  // defined(SUPPORT_TIMELINE)
-    const Snapshot* snapshot = Snapshot::SetupFromBuffer(snapshot_data);
-    if (snapshot == NULL) {
-      return Api::NewError("Invalid snapshot");
-    }
-    if (!IsSnapshotCompatible(Dart::vm_snapshot_kind(), snapshot->kind())) {
-      const String& message = String::Handle(String::NewFormatted(
-          "Incompatible snapshot kinds: vm '%s', isolate '%s'",
-          Snapshot::KindToCString(Dart::vm_snapshot_kind()),
-          Snapshot::KindToCString(snapshot->kind())));
-      return Api::NewHandle(T, ApiError::New(message));
-    }
-
-    FullSnapshotReader reader(snapshot, snapshot_instructions, T);
-    const Error& error = Error::Handle(reader.ReadUnitSnapshot(unit));
-    if (!error.IsNull()) {
-      return Api::NewHandle(T, error.ptr());
+    const Object& result = Object::Handle(
+        ReadLoadingUnit(T, unit, snapshot_data, snapshot_instructions));
+    if (result.IsError()) {
+      return Api::NewHandle(T, result.ptr());
     }
 
     return Api::NewHandle(T, unit.CompleteLoad(String::Handle(), false));
@@ -5925,6 +5935,46 @@ Dart_DeferredLoadCompleteError(intptr_t loading_unit_id,
                               error_message, transient);
 }
 
+DART_EXPORT Dart_Handle
+Dart_PrefetchLoadingUnit(intptr_t loading_unit_id,
+                         const uint8_t* snapshot_data,
+                         const uint8_t* snapshot_instructions) {
+  DARTSCOPE(Thread::Current());
+  API_TIMELINE_DURATION(T);
+  auto IG = T->isolate_group();
+  CHECK_CALLBACK_STATE(T);
+
+  const Array& loading_units =
+      Array::Handle(IG->object_store()->loading_units());
+  if (loading_units.IsNull() || (loading_unit_id <= LoadingUnit::kRootId) ||
+      (loading_unit_id >= loading_units.Length())) {
+    return Api::NewError("Invalid loading unit");
+  }
+  LoadingUnit& unit = LoadingUnit::Handle();
+  unit ^= loading_units.At(loading_unit_id);
+  if (unit.loaded()) {
+    return Api::Success();
+  }
+  const LoadingUnit& parent = LoadingUnit::Handle(unit.parent());
+  if ((parent.id() != LoadingUnit::kRootId) && !parent.loaded()) {
+    return Api::NewError("Parent of loading unit %" Pd " is not loaded",
+                         loading_unit_id);
+  }
+
+  const Object& result = Object::Handle(
+      ReadLoadingUnit(T, unit, snapshot_data, snapshot_instructions));
+  if (result.IsError()) {
+    return Api::NewHandle(T, result.ptr());
+  }
+  unit.set_prefetched(true);
+  if (unit.load_outstanding()) {
+    // The program is already waiting for the unit.
+    return Api::NewHandle(T, unit.CompleteLoad(String::Handle(), false));
+  }
+  unit.set_loaded(true);
+  return Api::Success();
+}
+
 DART_EXPORT Dart_Handle
 Dart_SetNativeResolver(Dart_Handle library,
                        Dart_NativeEntryResolver resolver,
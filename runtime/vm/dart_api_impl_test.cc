@@ -25,6 +25,7 @@ namespace dart {
 
 DECLARE_FLAG(bool, verify_acquired_data);
 DECLARE_FLAG(bool, complete_timeline);
+DECLARE_FLAG(int, out_of_line_typed_data_threshold);
 
 #ifndef PRODUCT
 
@@ -8220,6 +8221,98 @@ TEST_CASE(DartAPI_NativePortPostExternalTypedData) {
   EXPECT(Dart_CloseNativePort(port_id));
 }
 
+static const intptr_t kLargeSendLength = 64 * KB;
+static Monitor* large_typed_data_monitor = nullptr;
+static intptr_t large_typed_data_received = 0;
+
+static void ExpectLargeTypedData(const uint8_t* data, intptr_t length) {
+  EXPECT_EQ(kLargeSendLength, length);
+  for (intptr_t i = 0; i < length; i++) {
+    EXPECT_EQ(i & 0xff, data[i]);
+  }
+}
+
+static void NewNativePort_LargeTypedData(Dart_Port dest_port_id,
+                                         Dart_CObject* message) {
+  // Ports created with Dart_NewNativePort, like those of dart:io, always get
+  // typed data, however large.
+  EXPECT_EQ(Dart_CObject_kTypedData, message->type);
+  if (message->type == Dart_CObject_kTypedData) {
+    EXPECT_EQ(Dart_TypedData_kUint8, message->value.as_typed_data.type);
+    ExpectLargeTypedData(message->value.as_typed_data.values,
+                         message->value.as_typed_data.length);
+  }
+  MonitorLocker ml(large_typed_data_monitor);
+  large_typed_data_received++;
+  ml.Notify();
+}
+
+static void NewNativePort_LargeExternalTypedData(Dart_Port dest_port_id,
+                                                 Dart_CObject* message) {
+  EXPECT_EQ(Dart_CObject_kExternalTypedData, message->type);
+  if (message->type == Dart_CObject_kExternalTypedData) {
+    EXPECT_EQ(Dart_TypedData_kUint8,
+              message->value.as_external_typed_data.type);
+    ExpectLargeTypedData(message->value.as_external_typed_data.data,
+                         message->value.as_external_typed_data.length);
+    // The handler owns the buffer.
+    message->value.as_external_typed_data.callback(
+        nullptr, message->value.as_external_typed_data.peer);
+  }
+  MonitorLocker ml(large_typed_data_monitor);
+  large_typed_data_received++;
+  ml.Notify();
+}
+
+TEST_CASE(DartAPI_NativePortPostLargeTypedData) {
+  SetFlagScope<int> sfs(&FLAG_out_of_line_typed_data_threshold, 1 * KB);
+  const char* kScriptChars = R"(
+    import 'dart:typed_data';
+    import 'dart:isolate';
+    void callPort(SendPort port, int length) {
+      final data = new Uint8List(length);
+      for (int i = 0; i < length; i++) {
+        data[i] = i & 0xff;
+      }
+      port.send(data);
+    }
+  )";
+  Dart_Handle lib = TestCase::LoadTestScript(kScriptChars, NULL);
+  Dart_EnterScope();
+
+  Monitor monitor;
+  large_typed_data_monitor = &monitor;
+  large_typed_data_received = 0;
+  Dart_Port port_id1 =
+      Dart_NewNativePort("Port123", NewNativePort_LargeTypedData, true);
+  Dart_Port port_id2 = Dart_NewNativePortReceivingExternalTypedData(
+      "Port321", NewNativePort_LargeExternalTypedData, true);
+
+  Dart_Handle dart_args[2];
+  dart_args[1] = Dart_NewInteger(kLargeSendLength);
+  dart_args[0] = Dart_NewSendPort(port_id1);
+  EXPECT_VALID(dart_args[0]);
+  Dart_Handle result = Dart_Invoke(lib, NewString("callPort"), 2, dart_args);
+  EXPECT_VALID(result);
+  dart_args[0] = Dart_NewSendPort(port_id2);
+  EXPECT_VALID(dart_args[0]);
+  result = Dart_Invoke(lib, NewString("callPort"), 2, dart_args);
+  EXPECT_VALID(result);
+
+  {
+    MonitorLocker ml(&monitor);
+    while (large_typed_data_received < 2) {
+      ml.Wait();
+    }
+  }
+  large_typed_data_monitor = nullptr;
+
+  Dart_ExitScope();
+
+  EXPECT(Dart_CloseNativePort(port_id1));
+  EXPECT(Dart_CloseNativePort(port_id2));
+}
+
 static void NewNativePort_nativeReceiveNull(Dart_Port dest_port_id,
                                             Dart_CObject* message) {
   EXPECT_NOTNULL(message);
@@ -569,6 +569,7 @@ LibraryPtr ActivationFrame::Library() {
 
 void ActivationFrame::GetPcDescriptors() {
   if (pc_desc_.IsNull()) {
+    code().EnsureCodeMetadata();
     pc_desc_ = code().pc_descriptors();
     ASSERT(!pc_desc_.IsNull());
   }
@@ -870,6 +871,7 @@ void ActivationFrame::ExtractTokenPositionFromAsyncClosure() {
     return;
   }
 
+  code().EnsureCodeMetadata();
   const auto& pc_descriptors =
       PcDescriptors::Handle(zone, code().pc_descriptors());
   ASSERT(!pc_descriptors.IsNull());
@@ -3887,6 +3889,7 @@ static bool IsAtAsyncJump(ActivationFrame* top_frame) {
            top_frame->function().IsAsyncGenClosure());
     ASSERT(closure_or_null.IsInstance());
     ASSERT(Instance::Cast(closure_or_null).IsClosure());
+    top_frame->code().EnsureCodeMetadata();
     const auto& pc_descriptors =
         PcDescriptors::Handle(zone, top_frame->code().pc_descriptors());
     if (pc_descriptors.IsNull()) {
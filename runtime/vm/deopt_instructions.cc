@@ -47,6 +47,7 @@ DeoptContext::DeoptContext(const StackFrame* frame,
       num_args_(0),
       deopt_reason_(ICData::kDeoptUnknown),
       deopt_flags_(0),
+      deopt_id_(DeoptId::kNone),
       thread_(Thread::Current()),
       deopt_start_micros_(0),
       deferred_slots_(NULL),
@@ -174,6 +175,29 @@ DeoptContext::~DeoptContext() {
         timeline_event->Complete();
       }
     }
+    TimelineStream* decisions_stream = Timeline::GetCompilerDecisionsStream();
+    ASSERT(decisions_stream != NULL);
+    if (decisions_stream->enabled()) {
+      const Code& code = Code::Handle(zone(), code_);
+      const Function& function = Function::Handle(zone(), code.function());
+      const char* function_name = function.ToQualifiedCString();
+      const char* reason = DeoptReasonToCString(deopt_reason());
+      const int counter = function.deoptimization_counter();
+      TimelineEvent* timeline_event = decisions_stream->StartEvent();
+      if (timeline_event != NULL) {
+        timeline_event->Duration("Deoptimize", deopt_start_micros_,
+                                 OS::GetCurrentMonotonicMicros());
+        timeline_event->SetNumArguments(5);
+        timeline_event->CopyArgument(0, "function", function_name);
+        timeline_event->FormatArgument(1, "deoptId", "%" Pd, deopt_id());
+        timeline_event->CopyArgument(2, "reason", reason);
+        timeline_event->CopyArgument(3, "lazy",
+                                     is_lazy_deopt() ? "true" : "false");
+        timeline_event->FormatArgument(4, "deoptimizationCount", "%d",
+                                       counter);
+        timeline_event->Complete();
+      }
+    }
   }
 #endif  // !PRODUCT
 }
@@ -293,6 +317,15 @@ void DeoptContext::FillDestFrame() {
     to_index += obj->ArgumentCount();
   }
 
+  // The innermost frame, which is described first, resumes at the deopt id
+  // of its return address.
+  for (intptr_t i = num_materializations; i < len; i++) {
+    if (deopt_instructions[i]->kind() == DeoptInstr::kRetAddress) {
+      deopt_id_ = DeoptInstr::GetDeoptId(deopt_instructions[i]);
+      break;
+    }
+  }
+
   // Populate stack frames.
   for (intptr_t to_index = frame_size - 1, from_index = len - 1; to_index >= 0;
        to_index--, from_index--) {
@@ -897,6 +930,11 @@ uword DeoptInstr::GetRetAddress(DeoptInstr* instr,
   return res;
 }
 
+intptr_t DeoptInstr::GetDeoptId(DeoptInstr* instr) {
+  ASSERT(instr->kind() == kRetAddress);
+  return static_cast<DeoptRetAddressInstr*>(instr)->deopt_id();
+}
+
 DeoptInstr* DeoptInstr::Create(intptr_t kind_as_int, intptr_t source_index) {
   Kind kind = static_cast<Kind>(kind_as_int);
   switch (kind) {
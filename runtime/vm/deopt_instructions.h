@@ -131,6 +131,11 @@ class DeoptContext : public MallocAllocated {
   bool deoptimizing_code() const { return deoptimizing_code_; }
 
   ICData::DeoptReasonId deopt_reason() const { return deopt_reason_; }
+
+  // The deopt id in the unoptimized code of the innermost frame where
+  // execution resumes. Only known once the destination frame is filled.
+  intptr_t deopt_id() const { return deopt_id_; }
+
   bool HasDeoptFlag(ICData::DeoptFlags flag) {
     return (deopt_flags_ & flag) != 0;
   }
@@ -243,6 +248,7 @@ class DeoptContext : public MallocAllocated {
   intptr_t num_args_;
   ICData::DeoptReasonId deopt_reason_;
   uint32_t deopt_flags_;
+  intptr_t deopt_id_;
   intptr_t caller_fp_;
   Thread* thread_;
   int64_t deopt_start_micros_;
@@ -323,6 +329,9 @@ class DeoptInstr : public ZoneAllocated {
                              const ObjectPool& object_pool,
                              Code* code);
 
+  // Get the deopt id which is encoded in this kRetAddress deopt instruction.
+  static intptr_t GetDeoptId(DeoptInstr* instr);
+
   // Return number of initialized fields in the object that will be
   // materialized by kMaterializeObject instruction.
   static intptr_t GetFieldCount(DeoptInstr* instr) {
@@ -60,6 +60,17 @@ class MessageFinalizableData {
     return records_[take_position_++];
   }
 
+  // The index of the FinalizableData returned by the next call to [Get].
+  intptr_t get_position() const { return get_position_; }
+
+  // Transfer ownership of the FinalizableData at [index], previously
+  // retrieved with [Get], to the caller. Its finalizer is no longer run when
+  // |this| is destroyed.
+  void Transfer(intptr_t index) {
+    ASSERT(index < get_position_);
+    records_[index].callback = [](void* data, void* peer) {};
+  }
+
   void SerializationSucceeded() {
     for (intptr_t i = 0; i < records_.length(); i++) {
       if (records_[i].successful_write_callback != nullptr) {
@@ -110,6 +110,9 @@ constexpr bool FLAG_support_il_printer = false;
     "Deoptimize on every N stack overflow checks")                             \
   P(deoptimize_on_runtime_call_every, int, 0,                                  \
     "Deoptimize functions on every runtime call.")                             \
+  P(deserializer_tasks, int, 2,                                                \
+    "The number of tasks to fill snapshot clusters with during "               \
+    "deserialization (0 means fill all clusters on the main thread).")         \
   R(dump_megamorphic_stats, false, bool, false,                                \
     "Dump megamorphic cache statistics")                                       \
   R(dump_symbol_stats, false, bool, false, "Dump symbol table statistics")     \
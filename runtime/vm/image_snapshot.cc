@@ -262,6 +262,8 @@ intptr_t ImageWriter::SizeInSnapshot(ObjectPtr raw_object) {
       return compiler::target::PcDescriptors::InstanceSize(
           raw_desc->untag()->length_);
     }
+    case kDoubleCid:
+      return compiler::target::Double::InstanceSize();
     case kInstructionsCid: {
       auto raw_insns = Instructions::RawCast(raw_object);
       return compiler::target::Instructions::InstanceSize(
@@ -543,6 +545,13 @@ void ImageWriter::WriteROData(NonStreamingWriteStream* stream, bool vm) {
       ASSERT_EQUAL(stream->Position() - object_start,
                    compiler::target::PcDescriptors::HeaderSize());
       stream->WriteBytes(desc.ptr()->untag()->data(), desc.Length());
+    } else if (obj.IsDouble()) {
+      // Pad up to the value, which is 8-byte aligned on all targets.
+      while (stream->Position() - object_start <
+             compiler::target::Double::value_offset()) {
+        stream->WriteByte(0);
+      }
+      stream->WriteFixed<double>(Double::Cast(obj).value());
     } else if (obj.IsString()) {
       const String& str = String::Cast(obj);
       RELEASE_ASSERT(String::GetCachedHash(str.ptr()) != 0);
@@ -54,6 +54,7 @@
 #include "vm/visitor.h"
 
 #if !defined(DART_PRECOMPILED_RUNTIME)
+#include "vm/compiler/aot/aot_profile.h"
 #include "vm/compiler/assembler/assembler.h"
 #include "vm/compiler/stub_code_compiler.h"
 #endif
@@ -73,6 +74,10 @@ DECLARE_FLAG(bool, reload_every_back_off);
 DECLARE_FLAG(bool, trace_reload);
 #endif  // !defined(PRODUCT) && !defined(DART_PRECOMPILED_RUNTIME)
 
+#if !defined(DART_PRECOMPILED_RUNTIME)
+DECLARE_FLAG(charp, write_aot_profile_to);
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
+
 static void DeterministicModeHandler(bool value) {
   if (value) {
     FLAG_background_compilation = false;  // Timing dependent.
@@ -352,6 +357,7 @@ IsolateGroup::IsolateGroup(std::shared_ptr<IsolateGroupSource> source,
 #endif
       store_buffer_(new StoreBuffer()),
       heap_(nullptr),
+      lazy_code_metadata_(new LazyCodeMetadata()),
       saved_unlinked_calls_(Array::null()),
       initial_field_table_(new FieldTable(/*isolate=*/nullptr)),
 #if !defined(DART_PRECOMPILED_RUNTIME)
@@ -416,6 +422,10 @@ IsolateGroup::~IsolateGroup() {
   heap_ = nullptr;
   ASSERT(marking_stack_ == nullptr);
 
+  for (intptr_t i = 0; i < decompressed_snapshots_.length(); i++) {
+    free(decompressed_snapshots_[i]);
+  }
+
   if (obfuscation_map_ != nullptr) {
     for (intptr_t i = 0; obfuscation_map_[i] != nullptr; i++) {
       delete[] obfuscation_map_[i];
@@ -2574,6 +2584,15 @@ void Isolate::Shutdown() {
 
 #endif  // !defined(PRODUCT) && !defined(DART_PRECOMPILED_RUNTIME)
 
+#if !defined(DART_PRECOMPILED_RUNTIME)
+  if ((FLAG_write_aot_profile_to != nullptr) && is_runnable() &&
+      !Isolate::IsSystemIsolate(this)) {
+    StackZone zone(thread);
+    HandleScope handle_scope(thread);
+    AotProfileWriter::Write(thread, FLAG_write_aot_profile_to);
+  }
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
+
   // Then, proceed with low-level teardown.
   Isolate::UnMarkIsolateReady(this);
 
@@ -3070,6 +3089,8 @@ void Isolate::PrintJSON(JSONStream* stream, bool ref) {
 
   jsobj.AddProperty("runnable", is_runnable());
   jsobj.AddProperty("livePorts", message_handler()->live_ports());
+  jsobj.AddProperty("_workerMigrations",
+                    message_handler()->worker_migrations());
   jsobj.AddProperty("pauseOnExit", message_handler()->should_pause_on_exit());
 #if !defined(DART_PRECOMPILED_RUNTIME)
   jsobj.AddProperty("_isReloading", group()->IsReloading());
@@ -26,6 +26,7 @@
 #include "vm/handles.h"
 #include "vm/heap/verifier.h"
 #include "vm/intrusive_dlist.h"
+#include "vm/lazy_code_metadata.h"
 #include "vm/megamorphic_cache_table.h"
 #include "vm/metrics.h"
 #include "vm/os_thread.h"
@@ -393,6 +394,17 @@ class IsolateGroup : public IntrusiveDListEntry<IsolateGroup> {
     dispatch_table_snapshot_size_ = size;
   }
 
+  LazyCodeMetadata* lazy_code_metadata() const {
+    return lazy_code_metadata_.get();
+  }
+
+  // Takes ownership of [snapshot], a malloced copy of decompressed snapshot
+  // data that objects of this group may point into.
+  void AddDecompressedSnapshot(uint8_t* snapshot) {
+    MutexLocker ml(&decompressed_snapshots_mutex_);
+    decompressed_snapshots_.Add(snapshot);
+  }
+
   SharedClassTable* shared_class_table() const {
     return shared_class_table_.get();
   }
@@ -884,6 +896,9 @@ class IsolateGroup : public IntrusiveDListEntry<IsolateGroup> {
   std::unique_ptr<DispatchTable> dispatch_table_;
   const uint8_t* dispatch_table_snapshot_ = nullptr;
   intptr_t dispatch_table_snapshot_size_ = 0;
+  std::unique_ptr<LazyCodeMetadata> lazy_code_metadata_;
+  Mutex decompressed_snapshots_mutex_;
+  MallocGrowableArray<uint8_t*> decompressed_snapshots_;
   ArrayPtr saved_unlinked_calls_;
   std::shared_ptr<FieldTable> initial_field_table_;
   uint32_t isolate_group_flags_ = 0;
@@ -9,6 +9,7 @@
 
 #include <memory>
 
+#include "platform/unicode.h"
 #include "vm/compiler/backend/flow_graph_compiler.h"
 #include "vm/compiler/frontend/constant_reader.h"
 #include "vm/compiler/frontend/kernel_translation_helper.h"
@@ -23,8 +24,18 @@
 #include "vm/service_isolate.h"
 #include "vm/symbols.h"
 #include "vm/thread.h"
+#include "vm/thread_barrier.h"
+#include "vm/thread_pool.h"
+#include "vm/thread_stack_resource.h"
 
 namespace dart {
+
+DEFINE_FLAG(int,
+            kernel_source_tasks,
+            2,
+            "Number of threads, including the loading thread, that decode "
+            "the script sources in kernel binaries.");
+
 namespace kernel {
 
 #define Z (zone_)
@@ -377,6 +388,44 @@ StringPtr KernelLoader::FindSourceForScript(const uint8_t* kernel_buffer,
   return String::null();
 }
 
+// The source of a script, decoded from UTF-8 into Latin-1 or UTF-16 code
+// units by a helper thread.
+struct DecodedSource {
+  const uint8_t* utf8;
+  intptr_t utf8_length;
+  Utf8::Type type;
+  intptr_t length;
+  void* code_units;  // Malloced, or nullptr if the source was not decoded.
+};
+
+// Frees the decoded sources that were not taken by LoadScriptAt when the
+// scripts are loaded, or when loading one of them long jumps.
+class DecodedSourcesScope : public ThreadStackResource {
+ public:
+  DecodedSourcesScope(Thread* thread, DecodedSource** sources, intptr_t count)
+      : ThreadStackResource(thread), sources_(sources), count_(count) {
+    ASSERT(*sources_ == nullptr);
+  }
+
+  ~DecodedSourcesScope() {
+    DecodedSource* sources = *sources_;
+    if (sources == nullptr) {
+      return;
+    }
+    for (intptr_t i = 0; i < count_; i++) {
+      free(sources[i].code_units);
+      sources[i].code_units = nullptr;
+    }
+    *sources_ = nullptr;
+  }
+
+ private:
+  DecodedSource** sources_;
+  const intptr_t count_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecodedSourcesScope);
+};
+
 void KernelLoader::InitializeFields(UriToSourceTable* uri_to_source_table) {
   const intptr_t source_table_size = helper_.SourceTableSize();
   const Array& scripts =
@@ -450,6 +499,11 @@ void KernelLoader::InitializeFields(UriToSourceTable* uri_to_source_table) {
 
   H.InitFromKernelProgramInfo(kernel_program_info_);
 
+  DecodedSourcesScope decoded_sources(thread_, &decoded_sources_,
+                                      source_table_size);
+  if (uri_to_source_table == nullptr) {
+    DecodeSources(source_table_size);
+  }
   Script& script = Script::Handle(Z);
   for (intptr_t index = 0; index < source_table_size; ++index) {
     script = LoadScriptAt(index, uri_to_source_table);
@@ -457,6 +511,121 @@ void KernelLoader::InitializeFields(UriToSourceTable* uri_to_source_table) {
   }
 }
 
+struct SourceDecodingWork {
+  DecodedSource* sources;
+  intptr_t count;
+  RelaxedAtomic<intptr_t> next = 0;
+};
+
+// Decodes sources taken from [work] until there are none left. Each source
+// is decoded into its own buffer, so the result does not depend on how the
+// sources are distributed.
+static void DecodeSourcesFrom(SourceDecodingWork* work) {
+  for (;;) {
+    const intptr_t i = work->next.fetch_add(1);
+    if (i >= work->count) {
+      break;
+    }
+    DecodedSource* source = &work->sources[i];
+    source->length =
+        Utf8::CodeUnitCount(source->utf8, source->utf8_length, &source->type);
+    if (source->type == Utf8::kLatin1) {
+      uint8_t* latin1 = reinterpret_cast<uint8_t*>(malloc(source->length));
+      if (Utf8::DecodeToLatin1(source->utf8, source->utf8_length, latin1,
+                               source->length)) {
+        source->code_units = latin1;
+      } else {
+        free(latin1);
+      }
+    } else {
+      uint16_t* utf16 = reinterpret_cast<uint16_t*>(
+          malloc(source->length * sizeof(uint16_t)));
+      if (Utf8::DecodeToUTF16(source->utf8, source->utf8_length, utf16,
+                              source->length)) {
+        source->code_units = utf16;
+      } else {
+        free(utf16);
+      }
+    }
+  }
+}
+
+class SourceDecodingTask : public ThreadPool::Task {
+ public:
+  SourceDecodingTask(ThreadBarrier* barrier, SourceDecodingWork* work)
+      : barrier_(barrier), work_(work) {}
+
+  virtual void Run() {
+    if (!barrier_->TryEnter()) {
+      barrier_->Release();
+      return;
+    }
+    DecodeSourcesFrom(work_);
+    barrier_->Sync();
+    barrier_->Release();
+  }
+
+ private:
+  ThreadBarrier* barrier_;
+  SourceDecodingWork* work_;
+
+  DISALLOW_COPY_AND_ASSIGN(SourceDecodingTask);
+};
+
+void KernelLoader::DecodeSources(intptr_t source_table_size) {
+  const intptr_t kMinSourcesPerTask = 8;
+  const intptr_t num_tasks = Utils::Minimum<intptr_t>(
+      FLAG_kernel_source_tasks, source_table_size / kMinSourcesPerTask);
+  if (num_tasks < 2) {
+    return;
+  }
+
+  DecodedSource* sources = Z->Alloc<DecodedSource>(source_table_size);
+  for (intptr_t i = 0; i < source_table_size; i++) {
+    sources[i].utf8 = helper_.GetSourceBytesFor(i, &sources[i].utf8_length);
+    sources[i].code_units = nullptr;
+  }
+
+  // The helpers read the kernel binary directly, which cannot move as this
+  // thread does not allocate until they are done.
+  SourceDecodingWork work = {sources, source_table_size};
+  ThreadBarrier* barrier = new ThreadBarrier(num_tasks, 1);
+  for (intptr_t i = 0; i < num_tasks - 1; i++) {
+    bool result = Dart::thread_pool()->Run<SourceDecodingTask>(barrier, &work);
+    ASSERT(result);
+  }
+  DecodeSourcesFrom(&work);
+  barrier->Sync();
+  barrier->Release();
+
+  decoded_sources_ = sources;
+}
+
+const String& KernelLoader::SourceFor(intptr_t index) {
+  if (decoded_sources_ != nullptr) {
+    DecodedSource* source = &decoded_sources_[index];
+    if (source->code_units != nullptr) {
+      // The buffer stays owned by the DecodedSourcesScope until it has been
+      // copied, in case allocating the string long jumps.
+      void* code_units = source->code_units;
+      String& result = String::ZoneHandle(Z);
+      if (source->length == 0) {
+        result = Symbols::Empty().ptr();
+      } else if (source->type == Utf8::kLatin1) {
+        result = String::FromLatin1(reinterpret_cast<uint8_t*>(code_units),
+                                    source->length, Heap::kOld);
+      } else {
+        result = String::FromUTF16(reinterpret_cast<uint16_t*>(code_units),
+                                   source->length, Heap::kOld);
+      }
+      source->code_units = nullptr;
+      free(code_units);
+      return result;
+    }
+  }
+  return helper_.GetSourceFor(index);
+}
+
 KernelLoader::KernelLoader(const Script& script,
                            const ExternalTypedData& kernel_data,
                            intptr_t data_program_offset,
@@ -2137,7 +2306,7 @@ ScriptPtr KernelLoader::LoadScriptAt(intptr_t index,
   }
 
   if (sources.IsNull() || line_starts.IsNull()) {
-    const String& script_source = helper_.GetSourceFor(index);
+    const String& script_source = SourceFor(index);
     line_starts = helper_.GetLineStartsFor(index);
 
     if (script_source.ptr() == Symbols::Empty().ptr() &&
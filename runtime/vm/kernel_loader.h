@@ -176,6 +176,8 @@ struct UriToSourceTableTrait {
   }
 };
 
+struct DecodedSource;
+
 class KernelLoader : public ValueObject {
  public:
   explicit KernelLoader(
@@ -310,6 +312,11 @@ class KernelLoader : public ValueObject {
       intptr_t index,
       DirectChainedHashMap<UriToSourceTableTrait>* uri_to_source_table);
 
+  // Decodes the sources of all scripts from UTF-8 on helper threads if there
+  // are enough of them, so that LoadScriptAt only needs to copy them.
+  void DecodeSources(intptr_t source_table_size);
+  const String& SourceFor(intptr_t index);
+
   // If klass's script is not the script at the uri index, return a PatchClass
   // for klass whose script corresponds to the uri index.
   // Otherwise return klass.
@@ -445,6 +452,10 @@ class KernelLoader : public ValueObject {
   GrowableArray<const Function*> functions_;
   GrowableArray<const Field*> fields_;
 
+  // Indexed by script, only while scripts are loaded. The buffers that were
+  // not taken are freed by a DecodedSourcesScope in InitializeFields.
+  DecodedSource* decoded_sources_ = nullptr;
+
   friend class BuildingTranslationHelper;
 
   DISALLOW_COPY_AND_ASSIGN(KernelLoader);
@@ -0,0 +1,28 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/lazy_code_metadata.h"
+
+#include "vm/lockers.h"
+
+namespace dart {
+
+intptr_t LazyCodeMetadata::Reserve(intptr_t count) {
+  MutexLocker ml(&mutex_);
+  const intptr_t first = entries_.length();
+  for (intptr_t i = 0; i < count; i++) {
+    entries_.Add({nullptr, 0});
+  }
+  return first;
+}
+
+const uint8_t* LazyCodeMetadata::Lookup(intptr_t index, intptr_t* length) {
+  MutexLocker ml(&mutex_);
+  const Entry& entry = entries_[index];
+  ASSERT(entry.data != nullptr);
+  *length = entry.length;
+  return entry.data;
+}
+
+}  // namespace dart
@@ -0,0 +1,53 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_LAZY_CODE_METADATA_H_
+#define RUNTIME_VM_LAZY_CODE_METADATA_H_
+
+#include "vm/globals.h"
+#include "vm/growable_array.h"
+#include "vm/os_thread.h"
+
+namespace dart {
+
+// The PcDescriptors and CodeSourceMaps of an AOT snapshot written with
+// --lazy_code_metadata are not deserialized with the rest of the program.
+// Until they are first used, the Code objects referring to them hold a Smi
+// indexing this table, which points at their contents in the snapshot.
+//
+// The table belongs to an isolate group and only grows while snapshots are
+// loaded, so entries can be read at any later time.
+class LazyCodeMetadata {
+ public:
+  LazyCodeMetadata() {}
+
+  // Reserves [count] entries and returns the index of the first one.
+  intptr_t Reserve(intptr_t count);
+
+  Mutex* mutex() { return &mutex_; }
+
+  // Requires [mutex] to be held.
+  void SetLocked(intptr_t index, const uint8_t* data, intptr_t length) {
+    ASSERT(mutex_.IsOwnedByCurrentThread());
+    entries_[index] = {data, length};
+  }
+
+  // Returns the contents of the entry at [index].
+  const uint8_t* Lookup(intptr_t index, intptr_t* length);
+
+ private:
+  struct Entry {
+    const uint8_t* data;
+    intptr_t length;
+  };
+
+  Mutex mutex_;
+  MallocGrowableArray<Entry> entries_;
+
+  DISALLOW_COPY_AND_ASSIGN(LazyCodeMetadata);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_LAZY_CODE_METADATA_H_
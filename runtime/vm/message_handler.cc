@@ -20,6 +20,12 @@ namespace dart {
 
 DECLARE_FLAG(bool, trace_service_pause_events);
 
+DEFINE_FLAG(bool,
+            isolate_affinity,
+            false,
+            "Prefer running an isolate's messages on the thread pool worker "
+            "which last ran the isolate.");
+
 class MessageHandlerTask : public ThreadPool::Task {
  public:
   explicit MessageHandlerTask(MessageHandler* handler) : handler_(handler) {
@@ -71,6 +77,8 @@ MessageHandler::MessageHandler()
       task_running_(false),
       delete_me_(false),
       pool_(NULL),
+      last_worker_hint_(ThreadPool::kNoWorkerHint),
+      worker_migrations_(0),
       start_callback_(NULL),
       end_callback_(NULL),
       callback_data_(0) {
@@ -169,7 +177,11 @@ void MessageHandler::PostMessage(std::unique_ptr<Message> message,
     if (pool_ != nullptr && !task_running_) {
       ASSERT(!delete_me_);
       task_running_ = true;
-      const bool launched_successfully = pool_->Run<MessageHandlerTask>(this);
+      const bool launched_successfully =
+          FLAG_isolate_affinity
+              ? pool_->RunWithAffinity<MessageHandlerTask>(last_worker_hint_,
+                                                           this)
+              : pool_->Run<MessageHandlerTask>(this);
       ASSERT(launched_successfully);
     }
   }
@@ -402,6 +414,13 @@ void MessageHandler::TaskCallback() {
     // [task_running_] to false.
     ASSERT(task_running_);
 
+    const intptr_t worker_hint = pool_->CurrentWorkerHint();
+    if (last_worker_hint_ != ThreadPool::kNoWorkerHint &&
+        worker_hint != last_worker_hint_) {
+      worker_migrations_.fetch_add(1);
+    }
+    last_worker_hint_ = worker_hint;
+
 #if !defined(PRODUCT)
     if (ShouldPauseOnStart(kOK)) {
       if (!is_paused_on_start()) {
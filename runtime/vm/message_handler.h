@@ -86,6 +86,10 @@ class MessageHandler {
 
   intptr_t live_ports() const { return live_ports_; }
 
+  // The number of times this handler ran on a different thread pool worker
+  // than the previous time.
+  intptr_t worker_migrations() const { return worker_migrations_; }
+
   bool paused() const { return paused_ > 0; }
 
   void increment_paused() { paused_++; }
@@ -171,6 +175,10 @@ class MessageHandler {
   // Return Isolate to which this message handler corresponds to.
   virtual Isolate* isolate() const { return NULL; }
 
+  // Does this message handler take large typed data out of line, see
+  // --out-of-line-typed-data-threshold?
+  virtual bool ReceivesExternalTypedData() const { return false; }
+
   // Posts a message on this handler's message queue.
   // If before_events is true, then the message is enqueued before any pending
   // events, but after any pending isolate library events.
@@ -268,6 +276,9 @@ class MessageHandler {
   bool task_running_;
   bool delete_me_;
   ThreadPool* pool_;
+  // The worker which last ran this handler, see [ThreadPool::RunWithAffinity].
+  intptr_t last_worker_hint_;
+  RelaxedAtomic<intptr_t> worker_migrations_;
   StartCallback start_callback_;
   EndCallback end_callback_;
   CallbackData callback_data_;
@@ -21,11 +21,29 @@
 #include "vm/object.h"
 #include "vm/object_graph_copy.h"
 #include "vm/object_store.h"
+#include "vm/port.h"
 #include "vm/symbols.h"
 #include "vm/type_testing_stubs.h"
 
 namespace dart {
 
+DEFINE_FLAG(int,
+            out_of_line_typed_data_threshold,
+            -1,
+            "Typed data of at least this many bytes sent to a native port "
+            "created with Dart_NewNativePortReceivingExternalTypedData is "
+            "copied into its own buffer instead of the message snapshot. The "
+            "port receives it as Dart_CObject_kExternalTypedData and owns the "
+            "buffer. Negative values disable this.");
+
+DEFINE_FLAG(int,
+            incremental_message_deserialization_threshold,
+            -1,
+            "Messages whose snapshot is at least this many KB are "
+            "deserialized in chunks: their objects are allocated in old space "
+            "and the reader checks in for safepoints between chunks. "
+            "Negative values disable this.");
+
 static Dart_CObject cobj_null = {.type = Dart_CObject_kNull,
                                  .value = {.as_int64 = 0}};
 static Dart_CObject cobj_sentinel = {.type = Dart_CObject_kUnsupported};
@@ -191,7 +209,9 @@ class BaseSerializer : public StackResource {
 
 class MessageSerializer : public BaseSerializer {
  public:
-  MessageSerializer(Thread* thread, bool can_send_any_object);
+  MessageSerializer(Thread* thread,
+                    bool can_send_any_object,
+                    bool out_of_line_typed_data);
   ~MessageSerializer();
 
   bool MarkObjectId(ObjectPtr object, intptr_t id) {
@@ -252,6 +272,7 @@ class MessageSerializer : public BaseSerializer {
   }
 
   bool can_send_any_object() const { return can_send_any_object_; }
+  bool out_of_line_typed_data() const { return out_of_line_typed_data_; }
   const char* exception_message() const { return exception_message_; }
   Thread* thread() const {
     return static_cast<Thread*>(StackResource::thread());
@@ -268,6 +289,7 @@ class MessageSerializer : public BaseSerializer {
   WeakTable* forward_table_old_;
   GrowableArray<Object*> stack_;
   bool const can_send_any_object_;
+  bool const out_of_line_typed_data_;
   const char* exception_message_;
 };
 
@@ -377,7 +399,12 @@ class MessageDeserializer : public BaseDeserializer {
   MessageDeserializer(Thread* thread, Message* message)
       : BaseDeserializer(thread->zone(), message),
         thread_(thread),
-        refs_(Array::Handle(thread->zone())) {}
+        refs_(Array::Handle(thread->zone())),
+        incremental_(
+            (FLAG_incremental_message_deserialization_threshold >= 0) &&
+            (message->snapshot_length() >=
+             FLAG_incremental_message_deserialization_threshold * KB)),
+        last_safepoint_position_(0) {}
   ~MessageDeserializer() {}
 
   DART_NOINLINE void AddBaseObject(ObjectPtr base_object) {
@@ -408,15 +435,39 @@ class MessageDeserializer : public BaseDeserializer {
   IsolateGroup* isolate_group() const { return thread_->isolate_group(); }
   ArrayPtr refs() const { return refs_.ptr(); }
 
+  // Space for objects materialized from this message. Large messages go
+  // straight to old space so scavenges don't copy the partially built graph.
+  Heap::Space space() const { return incremental_ ? Heap::kOld : Heap::kNew; }
+
+  // For large messages, checks in for a safepoint once another chunk of the
+  // snapshot has been consumed. Returns true if it did, in which case any raw
+  // object pointers held by the caller must be reloaded.
+  bool MaybeCheckForSafepoint() {
+    if (!incremental_ ||
+        (stream_.Position() - last_safepoint_position_) <
+            kIncrementalChunkSize) {
+      return false;
+    }
+    last_safepoint_position_ = stream_.Position();
+    thread_->CheckForSafepoint();
+    return true;
+  }
+
  private:
+  static constexpr intptr_t kIncrementalChunkSize = 64 * KB;
+
   Thread* const thread_;
   Array& refs_;
+  const bool incremental_;
+  intptr_t last_safepoint_position_;
 };
 
 class ApiMessageDeserializer : public BaseDeserializer {
  public:
   ApiMessageDeserializer(Zone* zone, Message* message)
-      : BaseDeserializer(zone, message), refs_(nullptr) {}
+      : BaseDeserializer(zone, message),
+        refs_(nullptr),
+        out_of_line_typed_data_(zone, 0) {}
   ~ApiMessageDeserializer() {}
 
   void AddBaseObject(Dart_CObject* base_object) { AssignRef(base_object); }
@@ -439,11 +490,27 @@ class ApiMessageDeserializer : public BaseDeserializer {
 
   Dart_CObject* ReadRef() { return Ref(ReadUnsigned()); }
 
+  // Records typed data whose contents were written into a separate buffer,
+  // which is retrieved from [finalizable_data] next.
+  void AddOutOfLineTypedData(Dart_CObject* object) {
+    out_of_line_typed_data_.Add({object, finalizable_data()->get_position()});
+  }
+
   void AddBaseObjects();
   Dart_CObject* Deserialize();
 
  private:
+  // Transfers ownership of the separate buffers to the native port, except
+  // for the ones backing views.
+  void TransferOutOfLineTypedData();
+
+  struct OutOfLineTypedData {
+    Dart_CObject* object;
+    intptr_t finalizable_data_index;
+  };
+
   Dart_CObject** refs_;
+  GrowableArray<OutOfLineTypedData> out_of_line_typed_data_;
 };
 
 void MessageDeserializationCluster::ReadNodesWrapped(MessageDeserializer* d) {
@@ -858,7 +925,8 @@ class InstanceMessageDeserializationCluster
 
     intptr_t count = d->ReadUnsigned();
     for (intptr_t i = 0; i < count; i++) {
-      d->AssignRef(Instance::New(cls_));
+      d->AssignRef(Instance::New(cls_, d->space()));
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -904,6 +972,7 @@ class InstanceMessageDeserializationCluster
         }
 #endif
       }
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -1329,7 +1398,8 @@ class MintMessageDeserializationCluster : public MessageDeserializationCluster {
     for (intptr_t i = 0; i < count; i++) {
       int64_t value = d->Read<int64_t>();
       d->AssignRef(is_canonical() ? Mint::NewCanonical(value)
-                                  : Mint::New(value));
+                                  : Mint::New(value, d->space()));
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -1406,7 +1476,8 @@ class DoubleMessageDeserializationCluster
     for (intptr_t i = 0; i < count; i++) {
       double value = d->Read<double>();
       d->AssignRef(is_canonical() ? Double::NewCanonical(value)
-                                  : Double::New(value));
+                                  : Double::New(value, d->space()));
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -1476,9 +1547,11 @@ class GrowableObjectArrayMessageDeserializationCluster
     GrowableObjectArray& array = GrowableObjectArray::Handle(d->zone());
     for (intptr_t i = 0; i < count; i++) {
       intptr_t length = d->ReadUnsigned();
-      array = GrowableObjectArray::New(length);  // Here length is capacity.
+      // Here length is capacity.
+      array = GrowableObjectArray::New(length, d->space());
       array.SetLength(length);
       d->AssignRef(array.ptr());
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -1490,6 +1563,7 @@ class GrowableObjectArrayMessageDeserializationCluster
           static_cast<TypeArgumentsPtr>(d->ReadRef()));
       for (intptr_t i = 0, n = array.Length(); i < n; i++) {
         array.untag()->data()->untag()->set_element(i, d->ReadRef());
+        d->MaybeCheckForSafepoint();
       }
     }
   }
@@ -1527,6 +1601,25 @@ class GrowableObjectArrayMessageDeserializationCluster
   }
 };
 
+// This function's name can appear in Observatory.
+static void IsolateMessageTypedDataFinalizer(void* isolate_callback_data,
+                                             void* buffer) {
+  free(buffer);
+}
+
+// The length of typed data in a message is written shifted left by one, the
+// lowest bit tells whether the contents follow inline or were moved into a
+// separate buffer attached to the message as finalizable data.
+static constexpr intptr_t kTypedDataOutOfLineBit = 1;
+
+static bool ShouldWriteTypedDataOutOfLine(MessageSerializer* s,
+                                          intptr_t length_in_bytes) {
+  return s->out_of_line_typed_data() &&
+         FLAG_out_of_line_typed_data_threshold >= 0 &&
+         length_in_bytes > 0 &&
+         length_in_bytes >= FLAG_out_of_line_typed_data_threshold;
+}
+
 class TypedDataMessageSerializationCluster
     : public MessageSerializationCluster {
  public:
@@ -1550,10 +1643,23 @@ class TypedDataMessageSerializationCluster
       TypedData* data = objects_[i];
       s->AssignRef(data);
       intptr_t length = data->Length();
-      s->WriteUnsigned(length);
+      intptr_t length_in_bytes = length * element_size;
       NoSafepointScope no_safepoint;
       uint8_t* cdata = reinterpret_cast<uint8_t*>(data->untag()->data());
-      s->WriteBytes(cdata, length * element_size);
+      if (ShouldWriteTypedDataOutOfLine(s, length_in_bytes)) {
+        // Copy the contents once into a buffer the receiver can own, instead
+        // of growing the snapshot by them.
+        s->WriteUnsigned((length << 1) | kTypedDataOutOfLineBit);
+        void* passed_data = malloc(length_in_bytes);
+        memmove(passed_data, cdata, length_in_bytes);
+        s->finalizable_data()->Put(length_in_bytes,
+                                   passed_data,  // data
+                                   passed_data,  // peer,
+                                   IsolateMessageTypedDataFinalizer);
+      } else {
+        s->WriteUnsigned(length << 1);
+        s->WriteBytes(cdata, length_in_bytes);
+      }
     }
   }
 
@@ -1569,7 +1675,7 @@ class TypedDataMessageSerializationCluster
       Dart_CObject* data = reinterpret_cast<Dart_CObject*>(objects_[i]);
       s->AssignRef(data);
       intptr_t length = data->value.as_external_typed_data.length;
-      s->WriteUnsigned(length);
+      s->WriteUnsigned(length << 1);
       uint8_t* cdata =
           reinterpret_cast<uint8_t*>(data->value.as_typed_data.values);
       s->WriteBytes(cdata, length * element_size);
@@ -1592,12 +1698,24 @@ class TypedDataMessageDeserializationCluster
     intptr_t count = d->ReadUnsigned();
     TypedData& data = TypedData::Handle(d->zone());
     for (intptr_t i = 0; i < count; i++) {
-      intptr_t length = d->ReadUnsigned();
-      data = TypedData::New(cid_, length);
+      const intptr_t encoded_length = d->ReadUnsigned();
+      const intptr_t length = encoded_length >> 1;
+      data = TypedData::New(cid_, length, d->space());
       d->AssignRef(data.ptr());
       const intptr_t length_in_bytes = length * element_size;
-      NoSafepointScope no_safepoint;
-      d->ReadBytes(data.untag()->data(), length_in_bytes);
+      if ((encoded_length & kTypedDataOutOfLineBit) != 0) {
+        FinalizableData finalizable_data = d->finalizable_data()->Take();
+        {
+          NoSafepointScope no_safepoint;
+          memmove(data.untag()->data(), finalizable_data.data,
+                  length_in_bytes);
+        }
+        finalizable_data.callback(nullptr, finalizable_data.peer);
+      } else {
+        NoSafepointScope no_safepoint;
+        d->ReadBytes(data.untag()->data(), length_in_bytes);
+      }
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -1653,8 +1771,26 @@ class TypedDataMessageDeserializationCluster
     intptr_t element_size = TypedData::ElementSizeInBytes(cid_);
     intptr_t count = d->ReadUnsigned();
     for (intptr_t i = 0; i < count; i++) {
+      const intptr_t encoded_length = d->ReadUnsigned();
+      const intptr_t length = encoded_length >> 1;
+      if ((encoded_length & kTypedDataOutOfLineBit) != 0) {
+        // The native port takes ownership of the buffer unless it turns out
+        // to be the backing store of a view, see
+        // [ApiMessageDeserializer::TransferOutOfLineTypedData].
+        Dart_CObject* data = d->Allocate(Dart_CObject_kExternalTypedData);
+        d->AddOutOfLineTypedData(data);
+        FinalizableData finalizable_data = d->finalizable_data()->Get();
+        data->value.as_external_typed_data.type = type;
+        data->value.as_external_typed_data.length = length;
+        data->value.as_external_typed_data.data =
+            reinterpret_cast<uint8_t*>(finalizable_data.data);
+        data->value.as_external_typed_data.peer = finalizable_data.peer;
+        data->value.as_external_typed_data.callback =
+            finalizable_data.callback;
+        d->AssignRef(data);
+        continue;
+      }
       Dart_CObject* data = d->Allocate(Dart_CObject_kTypedData);
-      intptr_t length = d->ReadUnsigned();
       data->value.as_typed_data.type = type;
       data->value.as_typed_data.length = length;
       if (length == 0) {
@@ -1672,12 +1808,6 @@ class TypedDataMessageDeserializationCluster
   const intptr_t cid_;
 };
 
-// This function's name can appear in Observatory.
-static void IsolateMessageTypedDataFinalizer(void* isolate_callback_data,
-                                             void* buffer) {
-  free(buffer);
-}
-
 class ExternalTypedDataMessageSerializationCluster
     : public MessageSerializationCluster {
  public:
@@ -2038,6 +2168,14 @@ class TypedDataViewMessageDeserializationCluster
 
     for (intptr_t id = start_index_; id < stop_index_; id++) {
       Dart_CTypedDataView* view = static_cast<Dart_CTypedDataView*>(d->Ref(id));
+      if (view->typed_data->type == Dart_CObject_kExternalTypedData) {
+        // The message keeps ownership of buffers shared with views, so they
+        // are only valid while the native port handles the message.
+        Dart_CObject* backing = view->typed_data;
+        uint8_t* values = backing->value.as_external_typed_data.data;
+        backing->type = Dart_CObject_kTypedData;
+        backing->value.as_typed_data.values = values;
+      }
       if (view->typed_data->type == Dart_CObject_kTypedData) {
         view->type = Dart_CObject_kTypedData;
         view->value.as_typed_data.type = type;
@@ -2598,7 +2736,7 @@ class LinkedHashMapMessageDeserializationCluster
   void ReadNodes(MessageDeserializer* d) {
     const intptr_t count = d->ReadUnsigned();
     for (intptr_t i = 0; i < count; i++) {
-      d->AssignRef(LinkedHashMap::NewUninitialized(cid_));
+      d->AssignRef(LinkedHashMap::NewUninitialized(cid_, d->space()));
     }
   }
 
@@ -2694,7 +2832,7 @@ class LinkedHashSetMessageDeserializationCluster
   void ReadNodes(MessageDeserializer* d) {
     const intptr_t count = d->ReadUnsigned();
     for (intptr_t i = 0; i < count; i++) {
-      d->AssignRef(LinkedHashSet::NewUninitialized(cid_));
+      d->AssignRef(LinkedHashSet::NewUninitialized(cid_, d->space()));
     }
   }
 
@@ -2823,7 +2961,8 @@ class ArrayMessageDeserializationCluster
     const intptr_t count = d->ReadUnsigned();
     for (intptr_t i = 0; i < count; i++) {
       intptr_t length = d->ReadUnsigned();
-      d->AssignRef(Array::New(cid_, length));
+      d->AssignRef(Array::New(cid_, length, d->space()));
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -2835,6 +2974,9 @@ class ArrayMessageDeserializationCluster
           static_cast<TypeArgumentsPtr>(d->ReadRef()));
       for (intptr_t j = 0; j < length; j++) {
         array->untag()->set_element(j, d->ReadRef());
+        if (d->MaybeCheckForSafepoint()) {
+          array = static_cast<ArrayPtr>(d->Ref(id));
+        }
       }
     }
   }
@@ -2960,7 +3102,8 @@ class OneByteStringMessageDeserializationCluster
       d->Advance(length * sizeof(uint8_t));
       d->AssignRef(is_canonical()
                        ? Symbols::FromLatin1(d->thread(), data, length)
-                       : String::FromLatin1(data, length));
+                       : String::FromLatin1(data, length, d->space()));
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -3070,7 +3213,8 @@ class TwoByteStringMessageDeserializationCluster
       d->Advance(length * sizeof(uint16_t));
       d->AssignRef(is_canonical()
                        ? Symbols::FromUTF16(d->thread(), data, length)
-                       : String::FromUTF16(data, length));
+                       : String::FromUTF16(data, length, d->space()));
+      d->MaybeCheckForSafepoint();
     }
   }
 
@@ -3128,12 +3272,15 @@ BaseSerializer::~BaseSerializer() {
   delete finalizable_data_;
 }
 
-MessageSerializer::MessageSerializer(Thread* thread, bool can_send_any_object)
+MessageSerializer::MessageSerializer(Thread* thread,
+                                     bool can_send_any_object,
+                                     bool out_of_line_typed_data)
     : BaseSerializer(thread, thread->zone()),
       forward_table_new_(),
       forward_table_old_(),
       stack_(thread->zone(), 0),
       can_send_any_object_(can_send_any_object),
+      out_of_line_typed_data_(out_of_line_typed_data),
       exception_message_(nullptr) {
   isolate()->set_forward_table_new(new WeakTable());
   isolate()->set_forward_table_old(new WeakTable());
@@ -3818,6 +3965,7 @@ Dart_CObject* ApiMessageDeserializer::Deserialize() {
       clusters[i]->PostLoadApi(this);
     }
   }
+  TransferOutOfLineTypedData();
 
   // We should have completely filled the ref array.
   ASSERT_EQUAL(next_ref_index_ - kFirstReference, num_objects);
@@ -3825,6 +3973,15 @@ Dart_CObject* ApiMessageDeserializer::Deserialize() {
   return ReadRef();
 }
 
+void ApiMessageDeserializer::TransferOutOfLineTypedData() {
+  for (intptr_t i = 0; i < out_of_line_typed_data_.length(); i++) {
+    const OutOfLineTypedData& entry = out_of_line_typed_data_[i];
+    if (entry.object->type == Dart_CObject_kExternalTypedData) {
+      finalizable_data()->Transfer(entry.finalizable_data_index);
+    }
+  }
+}
+
 std::unique_ptr<Message> WriteMessage(bool can_send_any_object,
                                       bool same_group,
                                       const Object& obj,
@@ -3841,7 +3998,10 @@ std::unique_ptr<Message> WriteMessage(bool can_send_any_object,
   }
 
   Thread* thread = Thread::Current();
-  MessageSerializer serializer(thread, can_send_any_object);
+  // Only native ports that asked for it get typed data out of line, other
+  // receivers expect it as Dart_CObject_kTypedData or copy it anyway.
+  MessageSerializer serializer(thread, can_send_any_object,
+                               PortMap::ReceivesExternalTypedData(dest_port));
 
   volatile bool has_exception = false;
   {
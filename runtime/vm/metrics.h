@@ -26,7 +26,19 @@ class JSONStream;
   V(MaxMetric, HeapNewCapacityMax, "heap.new.capacity.max", kByte)             \
   V(MetricHeapNewExternal, HeapNewExternal, "heap.new.external", kByte)        \
   V(MetricHeapUsed, HeapGlobalUsed, "heap.global.used", kByte)                 \
-  V(MaxMetric, HeapGlobalUsedMax, "heap.global.used.max", kByte)
+  V(MaxMetric, HeapGlobalUsedMax, "heap.global.used.max", kByte)               \
+  V(Metric, BackgroundCompilationQueueLength,                                  \
+    "compiler.background.queue.length", kCounter)                              \
+  V(Metric, BackgroundCompilationWait, "compiler.background.queue.wait",       \
+    kMicrosecond)                                                              \
+  V(MaxMetric, BackgroundCompilationWaitMax,                                   \
+    "compiler.background.queue.wait.max", kMicrosecond)                        \
+  V(Metric, BackgroundCompilationStale, "compiler.background.queue.stale",     \
+    kCounter)                                                                  \
+  V(Metric, CompilationTimeUnoptimized, "compiler.time.unoptimized",           \
+    kMicrosecond)                                                              \
+  V(Metric, CompilationTimeBaseline, "compiler.time.baseline", kMicrosecond)   \
+  V(Metric, CompilationTimeOptimized, "compiler.time.optimized", kMicrosecond)
 
 // Metrics for each isolate.
 #define ISOLATE_METRIC_LIST(V)                                                 \
@@ -71,9 +71,9 @@ DART_EXPORT bool Dart_PostInteger(Dart_Port port_id, int64_t message) {
   return PostCObjectHelper(port_id, &cobj);
 }
 
-DART_EXPORT Dart_Port Dart_NewNativePort(const char* name,
-                                         Dart_NativeMessageHandler handler,
-                                         bool handle_concurrently) {
+static Dart_Port NewNativePort(const char* name,
+                               Dart_NativeMessageHandler handler,
+                               bool receives_external_typed_data) {
   if (name == NULL) {
     name = "<UnnamedNativePort>";
   }
@@ -88,7 +88,8 @@ DART_EXPORT Dart_Port Dart_NewNativePort(const char* name,
   // Start the native port without a current isolate.
   IsolateLeaveScope saver(Isolate::Current());
 
-  NativeMessageHandler* nmh = new NativeMessageHandler(name, handler);
+  NativeMessageHandler* nmh =
+      new NativeMessageHandler(name, handler, receives_external_typed_data);
   Dart_Port port_id = PortMap::CreatePort(nmh);
   if (port_id != ILLEGAL_PORT) {
     PortMap::SetPortState(port_id, PortMap::kLivePort);
@@ -101,6 +102,21 @@ DART_EXPORT Dart_Port Dart_NewNativePort(const char* name,
   return port_id;
 }
 
+DART_EXPORT Dart_Port Dart_NewNativePort(const char* name,
+                                         Dart_NativeMessageHandler handler,
+                                         bool handle_concurrently) {
+  return NewNativePort(name, handler,
+                       /*receives_external_typed_data=*/false);
+}
+
+DART_EXPORT Dart_Port
+Dart_NewNativePortReceivingExternalTypedData(const char* name,
+                                             Dart_NativeMessageHandler handler,
+                                             bool handle_concurrently) {
+  return NewNativePort(name, handler,
+                       /*receives_external_typed_data=*/true);
+}
+
 DART_EXPORT bool Dart_CloseNativePort(Dart_Port native_port_id) {
   // Close the native port without a current isolate.
   IsolateLeaveScope saver(Isolate::Current());
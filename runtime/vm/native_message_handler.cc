@@ -15,8 +15,11 @@
 namespace dart {
 
 NativeMessageHandler::NativeMessageHandler(const char* name,
-                                           Dart_NativeMessageHandler func)
-    : name_(Utils::StrDup(name)), func_(func) {}
+                                           Dart_NativeMessageHandler func,
+                                           bool receives_external_typed_data)
+    : name_(Utils::StrDup(name)),
+      func_(func),
+      receives_external_typed_data_(receives_external_typed_data) {}
 
 NativeMessageHandler::~NativeMessageHandler() {
   free(name_);
@@ -15,7 +15,9 @@ namespace dart {
 // native C handlers.
 class NativeMessageHandler : public MessageHandler {
  public:
-  NativeMessageHandler(const char* name, Dart_NativeMessageHandler func);
+  NativeMessageHandler(const char* name,
+                       Dart_NativeMessageHandler func,
+                       bool receives_external_typed_data = false);
   ~NativeMessageHandler();
 
   const char* name() const { return name_; }
@@ -31,9 +33,15 @@ class NativeMessageHandler : public MessageHandler {
   // Delete this handlers when its last live port is closed.
   virtual bool OwnedByPortMap() const { return true; }
 
+ protected:
+  virtual bool ReceivesExternalTypedData() const {
+    return receives_external_typed_data_;
+  }
+
  private:
   char* name_;
   Dart_NativeMessageHandler func_;
+  const bool receives_external_typed_data_;
 };
 
 }  // namespace dart
@@ -1461,6 +1461,20 @@ void Object::FinalizeVMIsolate(IsolateGroup* isolate_group) {
   }
 }
 
+// Doubles with an integer value have the identity hash of that integer.
+static bool IsInt64Double(double val) {
+  return (val >= kMinInt64RepresentableAsDouble) &&
+         (val <= kMaxInt64RepresentableAsDouble) &&
+         (static_cast<double>(static_cast<int64_t>(val)) == val);
+}
+
+// The identity hash of any other double only depends on its bits.
+static intptr_t DoubleIdentityHash(double val) {
+  ASSERT(!IsInt64Double(val));
+  uint64_t uval = bit_cast<uint64_t>(val);
+  return ((uval >> 32) ^ (uval)) & kSmiMax;
+}
+
 void Object::FinalizeReadOnlyObject(ObjectPtr object) {
   NoSafepointScope no_safepoint;
   intptr_t cid = object->GetClassId();
@@ -1499,6 +1513,19 @@ void Object::FinalizeReadOnlyObject(ObjectPtr object) {
       intptr_t hash = String::Hash(str);
       String::SetCachedHashIfNotSet(str, hash);
     }
+  } else if (cid == kDoubleCid) {
+#if defined(HASH_IN_OBJECT_HEADER)
+    // The identity hash of a double depends only on its value, but it cannot
+    // be cached on first use once the double is read-only.
+    DoublePtr dbl = Double::RawCast(object);
+    const double val = dbl->untag()->value_;
+    if (!IsInt64Double(val) && (Object::GetCachedHash(dbl) == 0)) {
+      const intptr_t hash = DoubleIdentityHash(val);
+      if (hash != 0) {
+        Object::SetCachedHashIfNotSet(dbl, hash);
+      }
+    }
+#endif
   } else if (cid == kCodeSourceMapCid) {
     CodeSourceMapPtr map = CodeSourceMap::RawCast(object);
     intptr_t size = CodeSourceMap::UnroundedSize(map);
@@ -16747,6 +16774,37 @@ void Code::set_state_bits(intptr_t bits) const {
   StoreNonPointer(&untag()->state_bits_, bits);
 }
 
+#if defined(DART_PRECOMPILED_RUNTIME)
+// Another thread may materialize the same metadata concurrently. Both copies
+// are equal and either one can be kept, so no lock is held while allocating.
+PcDescriptorsPtr Code::MaterializePcDescriptors(SmiPtr index) const {
+  ASSERT(Thread::Current()->no_safepoint_scope_depth() == 0);
+  intptr_t length = 0;
+  const uint8_t* data =
+      IsolateGroup::Current()->lazy_code_metadata()->Lookup(Smi::Value(index),
+                                                            &length);
+  const auto& descriptors =
+      PcDescriptors::Handle(PcDescriptors::New(data, length));
+  untag()->set_pc_descriptors<std::memory_order_release>(descriptors.ptr());
+  return descriptors.ptr();
+}
+
+CodeSourceMapPtr Code::MaterializeCodeSourceMap(SmiPtr index) const {
+  ASSERT(Thread::Current()->no_safepoint_scope_depth() == 0);
+  intptr_t length = 0;
+  const uint8_t* data =
+      IsolateGroup::Current()->lazy_code_metadata()->Lookup(Smi::Value(index),
+                                                            &length);
+  const auto& map = CodeSourceMap::Handle(CodeSourceMap::New(length));
+  {
+    NoSafepointScope no_safepoint;
+    memmove(map.Data(), data, length);
+  }
+  untag()->set_code_source_map<std::memory_order_release>(map.ptr());
+  return map.ptr();
+}
+#endif  // defined(DART_PRECOMPILED_RUNTIME)
+
 void Code::set_is_optimized(bool value) const {
   set_state_bits(OptimizedBit::update(value, untag()->state_bits_));
 }
@@ -17352,6 +17410,7 @@ CodePtr Code::FindCode(uword pc, int64_t timestamp) {
 }
 
 TokenPosition Code::GetTokenIndexOfPC(uword pc) const {
+  EnsureCodeMetadata();
   uword pc_offset = pc - PayloadStart();
   const PcDescriptors& descriptors = PcDescriptors::Handle(pc_descriptors());
   PcDescriptors::Iterator iter(descriptors, UntaggedPcDescriptors::kAnyKind);
@@ -17365,6 +17424,7 @@ TokenPosition Code::GetTokenIndexOfPC(uword pc) const {
 
 uword Code::GetPcForDeoptId(intptr_t deopt_id,
                             UntaggedPcDescriptors::Kind kind) const {
+  EnsureCodeMetadata();
   const PcDescriptors& descriptors = PcDescriptors::Handle(pc_descriptors());
   PcDescriptors::Iterator iter(descriptors, kind);
   while (iter.MoveNext()) {
@@ -17379,6 +17439,7 @@ uword Code::GetPcForDeoptId(intptr_t deopt_id,
 }
 
 intptr_t Code::GetDeoptIdForOsr(uword pc) const {
+  EnsureCodeMetadata();
   uword pc_offset = pc - PayloadStart();
   const PcDescriptors& descriptors = PcDescriptors::Handle(pc_descriptors());
   PcDescriptors::Iterator iter(descriptors, UntaggedPcDescriptors::kOsrEntry);
@@ -17536,6 +17597,7 @@ void Code::GetInlinedFunctionsAtInstruction(
     intptr_t pc_offset,
     GrowableArray<const Function*>* functions,
     GrowableArray<TokenPosition>* token_positions) const {
+  EnsureCodeMetadata();
   const CodeSourceMap& map = CodeSourceMap::Handle(code_source_map());
   if (map.IsNull()) {
     ASSERT(!IsFunctionCode());
@@ -17552,6 +17614,7 @@ void Code::PrintJSONInlineIntervals(JSONObject* jsobj) const {
   if (!is_optimized()) {
     return;  // No inlining.
   }
+  EnsureCodeMetadata();
   const CodeSourceMap& map = CodeSourceMap::Handle(code_source_map());
   const Array& id_map = Array::Handle(inlined_id_to_function());
   const Function& root = Function::Handle(function());
@@ -17561,6 +17624,7 @@ void Code::PrintJSONInlineIntervals(JSONObject* jsobj) const {
 #endif
 
 void Code::DumpInlineIntervals() const {
+  EnsureCodeMetadata();
   const CodeSourceMap& map = CodeSourceMap::Handle(code_source_map());
   if (map.IsNull()) {
     // Stub code.
@@ -17573,6 +17637,7 @@ void Code::DumpInlineIntervals() const {
 }
 
 void Code::DumpSourcePositions(bool relative_addresses) const {
+  EnsureCodeMetadata();
   const CodeSourceMap& map = CodeSourceMap::Handle(code_source_map());
   if (map.IsNull()) {
     // Stub code.
@@ -18362,6 +18427,7 @@ LoadingUnitPtr LoadingUnit::New() {
   result.set_id(kIllegalId);
   result.set_loaded(false);
   result.set_load_outstanding(false);
+  result.set_prefetched(false);
   return result.ptr();
 }
 
@@ -18384,19 +18450,45 @@ const char* LoadingUnit::ToCString() const {
 }
 
 ObjectPtr LoadingUnit::IssueLoad() const {
-  ASSERT(!loaded());
   ASSERT(!load_outstanding());
   set_load_outstanding(true);
+  StoreNonPointer(&untag()->load_issued_micros_,
+                  OS::GetCurrentMonotonicMicros());
+  if (prefetched()) {
+    // Loaded with Dart_PrefetchLoadingUnit before the program asked for it.
+    ASSERT(loaded());
+    return CompleteLoad(String::Handle(), false);
+  }
+  ASSERT(!loaded());
   return Isolate::Current()->CallDeferredLoadHandler(id());
 }
 
 ObjectPtr LoadingUnit::CompleteLoad(const String& error_message,
                                     bool transient_error) const {
-  ASSERT(!loaded());
+  ASSERT(!loaded() || error_message.IsNull());
   ASSERT(load_outstanding());
   set_loaded(error_message.IsNull());
   set_load_outstanding(false);
 
+#if defined(SUPPORT_TIMELINE)
+  // The time the program waited for the unit, from the request to the
+  // completion of its load.
+  TimelineStream* stream = Timeline::GetIsolateStream();
+  ASSERT(stream != nullptr);
+  TimelineEvent* event = stream->StartEvent();
+  if (event != nullptr) {
+    event->Duration("DeferredLoad", untag()->load_issued_micros_,
+                    OS::GetCurrentMonotonicMicros());
+    event->SetNumArguments(3);
+    event->FormatArgument(0, "loadingUnit", "%" Pd, id());
+    event->CopyArgument(1, "prefetched", prefetched() ? "true" : "false");
+    event->CopyArgument(2, "result", error_message.IsNull()
+                                         ? "loaded"
+                                         : error_message.ToCString());
+    event->Complete();
+  }
+#endif  // defined(SUPPORT_TIMELINE)
+
   const Library& lib = Library::Handle(Library::CoreLibrary());
   const String& sel = String::Handle(String::New("_completeLoads"));
   const Function& func = Function::Handle(lib.LookupFunctionAllowPrivate(sel));
@@ -18922,16 +19014,22 @@ IntegerPtr Instance::IdentityHashCode(Thread* thread) const {
       hash = Bool::Cast(*this).value() ? kTrueIdentityHash : kFalseIdentityHash;
     } else if (IsDouble()) {
       double val = Double::Cast(*this).value();
-      if ((val >= kMinInt64RepresentableAsDouble) &&
-          (val <= kMaxInt64RepresentableAsDouble)) {
-        int64_t ival = static_cast<int64_t>(val);
-        if (static_cast<double>(ival) == val) {
-          return Integer::New(ival);
-        }
+      if (IsInt64Double(val)) {
+        return Integer::New(static_cast<int64_t>(val));
       }
 
-      uint64_t uval = bit_cast<uint64_t>(val);
-      hash = ((uval >> 32) ^ (uval)) & kSmiMax;
+      hash = DoubleIdentityHash(val);
+#if defined(HASH_IN_OBJECT_HEADER)
+      if (hash == 0) {
+        // Nothing to cache, and the double may be read-only.
+        return Smi::New(hash);
+      }
+#else
+      // The hash only depends on the value, so it is not worth an entry in
+      // the weak table. Doubles mapped from a snapshot would otherwise keep
+      // one each.
+      return Smi::New(hash);
+#endif
     } else {
       do {
         hash = thread->random()->NextUInt32() & 0x3FFFFFFF;
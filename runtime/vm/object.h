@@ -6467,14 +6467,48 @@ class Code : public Object {
   // Returns true if there is a debugger breakpoint set in this code object.
   bool HasBreakpoint() const;
 
-  PcDescriptorsPtr pc_descriptors() const { return untag()->pc_descriptors(); }
+  // In AOT snapshots written with --lazy_code_metadata, the PcDescriptors
+  // and CodeSourceMap are only read from the snapshot by EnsureCodeMetadata.
+  // It allocates, so it must be called outside of any NoSafepointScope before
+  // the getters below are used. The getters never allocate.
+  void EnsureCodeMetadata() const {
+#if defined(DART_PRECOMPILED_RUNTIME)
+    ObjectPtr descriptors =
+        untag()->pc_descriptors<std::memory_order_acquire>();
+    if (UNLIKELY(descriptors->IsSmi())) {
+      MaterializePcDescriptors(static_cast<SmiPtr>(descriptors));
+    }
+    ObjectPtr map = untag()->code_source_map<std::memory_order_acquire>();
+    if (UNLIKELY(map->IsSmi())) {
+      MaterializeCodeSourceMap(static_cast<SmiPtr>(map));
+    }
+#endif
+  }
+
+  PcDescriptorsPtr pc_descriptors() const {
+#if defined(DART_PRECOMPILED_RUNTIME)
+    PcDescriptorsPtr descriptors =
+        untag()->pc_descriptors<std::memory_order_acquire>();
+    ASSERT(!descriptors->IsSmi());
+    return descriptors;
+#else
+    return untag()->pc_descriptors();
+#endif
+  }
   void set_pc_descriptors(const PcDescriptors& descriptors) const {
     ASSERT(descriptors.IsOld());
     untag()->set_pc_descriptors(descriptors.ptr());
   }
 
   CodeSourceMapPtr code_source_map() const {
+#if defined(DART_PRECOMPILED_RUNTIME)
+    CodeSourceMapPtr map =
+        untag()->code_source_map<std::memory_order_acquire>();
+    ASSERT(!map->IsSmi());
+    return map;
+#else
     return untag()->code_source_map();
+#endif
   }
 
   void set_code_source_map(const CodeSourceMap& code_source_map) const {
@@ -6813,6 +6847,12 @@ class Code : public Object {
  private:
   void set_state_bits(intptr_t bits) const;
 
+#if defined(DART_PRECOMPILED_RUNTIME)
+  // Reads the metadata at [index] in the isolate group's LazyCodeMetadata.
+  PcDescriptorsPtr MaterializePcDescriptors(SmiPtr index) const;
+  CodeSourceMapPtr MaterializeCodeSourceMap(SmiPtr index) const;
+#endif
+
   friend class UntaggedObject;  // For UntaggedObject::SizeFromClass().
   friend class UntaggedCode;
   friend struct RelocatorTestHelper;
@@ -7361,6 +7401,13 @@ class LoadingUnit : public Object {
     StoreNonPointer(&untag()->load_outstanding_, value);
   }
 
+  // True if the embedder loaded this unit with Dart_PrefetchLoadingUnit
+  // before the program requested it.
+  bool prefetched() const { return untag()->prefetched_; }
+  void set_prefetched(bool value) const {
+    StoreNonPointer(&untag()->prefetched_, value);
+  }
+
   ObjectPtr IssueLoad() const;
   ObjectPtr CompleteLoad(const String& error_message,
                          bool transient_error) const;
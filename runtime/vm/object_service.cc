@@ -937,6 +937,7 @@ void Code::PrintJSONImpl(JSONStream* stream, bool ref) const {
       Disassemble(&formatter);
     }
   }
+  EnsureCodeMetadata();
   const PcDescriptors& descriptors = PcDescriptors::Handle(pc_descriptors());
   if (!descriptors.IsNull()) {
     JSONObject desc(&jsobj, "_descriptors");
@@ -218,6 +218,10 @@ class OSThread : public BaseThread {
   static ThreadId ThreadIdFromIntPtr(intptr_t id);
   static bool Compare(ThreadId a, ThreadId b);
 
+  // Restricts the current thread to run only on the given CPUs. Returns
+  // false if the platform does not support this or the request failed.
+  static bool SetCurrentThreadAffinity(const intptr_t* cpus, intptr_t length);
+
   // This function can be called only once per OSThread, and should only be
   // called when the retunred id will eventually be passed to OSThread::Join().
   static ThreadJoinId GetCurrentThreadJoinId(OSThread* thread);
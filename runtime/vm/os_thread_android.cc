@@ -9,6 +9,7 @@
 #include "vm/os_thread.h"
 
 #include <errno.h>  // NOLINT
+#include <sched.h>  // NOLINT
 #include <stdio.h>
 #include <sys/resource.h>  // NOLINT
 #include <sys/time.h>      // NOLINT
@@ -248,6 +249,19 @@ bool OSThread::Compare(ThreadId a, ThreadId b) {
   return a == b;
 }
 
+bool OSThread::SetCurrentThreadAffinity(const intptr_t* cpus,
+                                        intptr_t length) {
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (intptr_t i = 0; i < length; i++) {
+    if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) {
+      return false;
+    }
+    CPU_SET(cpus[i], &set);
+  }
+  return sched_setaffinity(0, sizeof(set), &set) == 0;
+}
+
 bool OSThread::GetCurrentStackBounds(uword* lower, uword* upper) {
   pthread_attr_t attr;
   if (pthread_getattr_np(pthread_self(), &attr) != 0) {
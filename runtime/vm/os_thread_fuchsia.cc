@@ -203,6 +203,12 @@ bool OSThread::Compare(ThreadId a, ThreadId b) {
   return pthread_equal(a, b) != 0;
 }
 
+bool OSThread::SetCurrentThreadAffinity(const intptr_t* cpus,
+                                        intptr_t length) {
+  // Not supported by Zircon.
+  return false;
+}
+
 bool OSThread::GetCurrentStackBounds(uword* lower, uword* upper) {
   pthread_attr_t attr;
   if (pthread_getattr_np(pthread_self(), &attr) != 0) {
@@ -227,6 +227,12 @@ bool OSThread::Compare(ThreadId a, ThreadId b) {
   return pthread_equal(a, b) != 0;
 }
 
+bool OSThread::SetCurrentThreadAffinity(const intptr_t* cpus,
+                                        intptr_t length) {
+  // Mac OS X only supports affinity hints between threads, not pinning.
+  return false;
+}
+
 bool OSThread::GetCurrentStackBounds(uword* lower, uword* upper) {
   *upper = reinterpret_cast<uword>(pthread_get_stackaddr_np(pthread_self()));
   *lower = *upper - pthread_get_stacksize_np(pthread_self());
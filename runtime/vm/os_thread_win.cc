@@ -171,6 +171,18 @@ bool OSThread::Compare(ThreadId a, ThreadId b) {
   return a == b;
 }
 
+bool OSThread::SetCurrentThreadAffinity(const intptr_t* cpus,
+                                        intptr_t length) {
+  DWORD_PTR mask = 0;
+  for (intptr_t i = 0; i < length; i++) {
+    if (cpus[i] < 0 || cpus[i] >= static_cast<intptr_t>(sizeof(mask) * 8)) {
+      return false;
+    }
+    mask |= static_cast<DWORD_PTR>(1) << cpus[i];
+  }
+  return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+}
+
 bool OSThread::GetCurrentStackBounds(uword* lower, uword* upper) {
 // On Windows stack limits for the current thread are available in
 // the thread information block (TIB). Its fields can be accessed through
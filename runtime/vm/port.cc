@@ -236,6 +236,22 @@ bool PortMap::IsLocalPort(Dart_Port id) {
   return handler->IsCurrentIsolate();
 }
 
+bool PortMap::ReceivesExternalTypedData(Dart_Port id) {
+  MutexLocker ml(mutex_);
+  if (ports_ == nullptr) {
+    return false;
+  }
+  auto it = ports_->TryLookup(id);
+  if (it == ports_->end()) {
+    // Port does not exist.
+    return false;
+  }
+
+  MessageHandler* handler = (*it).handler;
+  ASSERT(handler != nullptr);
+  return handler->ReceivesExternalTypedData();
+}
+
 bool PortMap::IsLivePort(Dart_Port id) {
   MutexLocker ml(mutex_);
   if (ports_ == nullptr) {
@@ -63,6 +63,10 @@ class PortMap : public AllStatic {
   // Returns the owning Isolate for port 'id'.
   static Isolate* GetIsolate(Dart_Port id);
 
+  // Returns whether the handler of port 'id' takes large typed data out of
+  // line, see Dart_NewNativePortReceivingExternalTypedData.
+  static bool ReceivesExternalTypedData(Dart_Port id);
+
   // Whether the destination port's isolate is a member of [isolate_group].
   static bool IsReceiverInThisIsolateGroup(Dart_Port receiver,
                                            IsolateGroup* group);
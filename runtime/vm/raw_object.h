@@ -2419,6 +2419,8 @@ class UntaggedLoadingUnit : public UntaggedObject {
   int32_t id_;
   bool load_outstanding_;
   bool loaded_;
+  bool prefetched_;
+  ALIGN8 int64_t load_issued_micros_;
 };
 
 class UntaggedError : public UntaggedObject {
@@ -2767,6 +2769,7 @@ class UntaggedDouble : public UntaggedNumber {
 
   friend class Api;
   friend class Class;
+  friend class Object;
 };
 COMPILE_ASSERT(sizeof(UntaggedDouble) == 16);
 
@@ -205,6 +205,7 @@ static void DoThrowNullError(Isolate* isolate,
     isolate->group()->heap()->CollectAllGarbage(GCReason::kDebugging);
   }
 
+  code.EnsureCodeMetadata();
   const CodeSourceMap& map =
       CodeSourceMap::Handle(zone, code.code_source_map());
   String& member_name = String::Handle(zone);
@@ -0,0 +1,244 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#include "vm/snapshot_compression.h"
+
+#include "platform/atomic.h"
+#include "platform/unaligned.h"
+#include "vm/dart.h"
+#include "vm/datastream.h"
+#include "vm/flags.h"
+#include "vm/growable_array.h"
+#include "vm/os.h"
+#include "vm/thread_barrier.h"
+#include "vm/thread_pool.h"
+#include "zlib/zlib.h"
+
+namespace dart {
+
+#if !defined(DART_PRECOMPILED_RUNTIME)
+DEFINE_FLAG(bool,
+            compress_snapshot_data,
+            false,
+            "Compress the clustered data of snapshots with zlib, to reduce the "
+            "I/O needed to start from them.");
+DEFINE_FLAG(int,
+            snapshot_compression_block_size,
+            256 * KB,
+            "The size of the blocks of compressed snapshot data, which are "
+            "decompressed in parallel.");
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
+
+// Block size, number of blocks and uncompressed size.
+static constexpr intptr_t kTableHeaderSize =
+    2 * sizeof(uint32_t) + sizeof(uint64_t);
+
+#if !defined(DART_PRECOMPILED_RUNTIME)
+intptr_t SnapshotCompression::WriteFormat(NonStreamingWriteStream* stream) {
+  const intptr_t format_position = stream->Position();
+  stream->WriteByte(kUncompressed);
+  return format_position;
+}
+
+intptr_t SnapshotCompression::Compress(NonStreamingWriteStream* stream,
+                                       intptr_t format_position) {
+  ASSERT(stream->buffer()[format_position] == kUncompressed);
+  const intptr_t data_start = format_position + 1;
+  const intptr_t data_size = stream->bytes_written() - data_start;
+  if (!FLAG_compress_snapshot_data || (data_size == 0)) {
+    return data_size;
+  }
+  const intptr_t block_size = FLAG_snapshot_compression_block_size;
+  if ((block_size <= 0) || (block_size > kMaxInt32)) {
+    FATAL1("Invalid --snapshot-compression-block-size: %" Pd, block_size);
+  }
+  const intptr_t num_blocks = (data_size + block_size - 1) / block_size;
+
+  const uint8_t* data = stream->buffer() + data_start;
+  MallocWriteStream blocks(data_size);
+  MallocGrowableArray<uint32_t> block_sizes(num_blocks);
+  const uLong bound = compressBound(block_size);
+  uint8_t* block = reinterpret_cast<uint8_t*>(malloc(bound));
+  for (intptr_t i = 0; i < num_blocks; i++) {
+    const intptr_t start = i * block_size;
+    const intptr_t length = Utils::Minimum(block_size, data_size - start);
+    uLongf compressed_length = bound;
+    const int status = compress2(block, &compressed_length, data + start,
+                                 length, Z_BEST_COMPRESSION);
+    if (status != Z_OK) {
+      FATAL1("Failed to compress snapshot data: %s", zError(status));
+    }
+    block_sizes.Add(static_cast<uint32_t>(compressed_length));
+    blocks.WriteBytes(block, compressed_length);
+  }
+  free(block);
+
+  const intptr_t compressed_size = kTableHeaderSize +
+                                   num_blocks * sizeof(uint32_t) +
+                                   blocks.bytes_written();
+  if (compressed_size >= data_size) {
+    return data_size;
+  }
+  stream->SetPosition(format_position);
+  stream->WriteByte(kCompressed);
+  stream->WriteFixed<uint32_t>(block_size);
+  stream->WriteFixed<uint32_t>(num_blocks);
+  stream->WriteFixed<uint64_t>(data_size);
+  for (intptr_t i = 0; i < num_blocks; i++) {
+    stream->WriteFixed<uint32_t>(block_sizes[i]);
+  }
+  stream->WriteBytes(blocks.buffer(), blocks.bytes_written());
+  return data_size;
+}
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
+
+namespace {
+
+// The blocks to decompress, which are taken by the decompressing threads in
+// order.
+struct DecompressionWork {
+  const uint8_t* blocks;
+  // The offsets of the blocks in [blocks], followed by the end of the last.
+  const intptr_t* block_offsets;
+  intptr_t num_blocks;
+  intptr_t block_size;
+  uint8_t* output;
+  intptr_t output_size;
+  RelaxedAtomic<intptr_t> next = 0;
+  RelaxedAtomic<bool> failed = false;
+};
+
+}  // namespace
+
+static void DecompressBlocks(DecompressionWork* work) {
+  for (;;) {
+    const intptr_t i = work->next.fetch_add(1);
+    if (i >= work->num_blocks) {
+      break;
+    }
+    const intptr_t start = i * work->block_size;
+    const intptr_t length =
+        Utils::Minimum(work->block_size, work->output_size - start);
+    uLongf output_length = length;
+    const int status =
+        uncompress(work->output + start, &output_length,
+                   work->blocks + work->block_offsets[i],
+                   work->block_offsets[i + 1] - work->block_offsets[i]);
+    if ((status != Z_OK) || (static_cast<intptr_t>(output_length) != length)) {
+      work->failed = true;
+    }
+  }
+}
+
+class DecompressionTask : public ThreadPool::Task {
+ public:
+  DecompressionTask(ThreadBarrier* barrier, DecompressionWork* work)
+      : barrier_(barrier), work_(work) {}
+
+  virtual void Run() {
+    if (!barrier_->TryEnter()) {
+      barrier_->Release();
+      return;
+    }
+
+    DecompressBlocks(work_);
+
+    barrier_->Sync();
+    barrier_->Release();
+  }
+
+ private:
+  ThreadBarrier* barrier_;
+  DecompressionWork* work_;
+
+  DISALLOW_COPY_AND_ASSIGN(DecompressionTask);
+};
+
+uint8_t* SnapshotCompression::Decompress(const uint8_t* buffer,
+                                         intptr_t size,
+                                         intptr_t format_position,
+                                         intptr_t num_tasks,
+                                         intptr_t* decompressed_size,
+                                         char** error) {
+  ASSERT(buffer[format_position] == kCompressed);
+  const intptr_t data_start = format_position + 1;
+  const intptr_t table_start = data_start + kTableHeaderSize;
+  if (table_start > size) {
+    *error = Utils::StrDup("Truncated compressed snapshot data");
+    return nullptr;
+  }
+  const intptr_t block_size = LoadUnaligned(
+      reinterpret_cast<const uint32_t*>(buffer + data_start));
+  const intptr_t num_blocks = LoadUnaligned(
+      reinterpret_cast<const uint32_t*>(buffer + data_start + 4));
+  const uint64_t data_size = LoadUnaligned(
+      reinterpret_cast<const uint64_t*>(buffer + data_start + 8));
+  if ((block_size == 0) || (data_size > static_cast<uint64_t>(kMaxInt32)) ||
+      (num_blocks !=
+       (static_cast<intptr_t>(data_size) + block_size - 1) / block_size)) {
+    *error = Utils::StrDup("Invalid compressed snapshot data");
+    return nullptr;
+  }
+  const intptr_t blocks_start =
+      table_start + num_blocks * static_cast<intptr_t>(sizeof(uint32_t));
+  if (blocks_start > size) {
+    *error = Utils::StrDup("Truncated compressed snapshot data");
+    return nullptr;
+  }
+  MallocGrowableArray<intptr_t> block_offsets(num_blocks + 1);
+  intptr_t block_offset = 0;
+  for (intptr_t i = 0; i < num_blocks; i++) {
+    block_offsets.Add(block_offset);
+    block_offset += LoadUnaligned(reinterpret_cast<const uint32_t*>(
+        buffer + table_start + i * sizeof(uint32_t)));
+  }
+  block_offsets.Add(block_offset);
+  if (blocks_start + block_offset > size) {
+    *error = Utils::StrDup("Truncated compressed snapshot data");
+    return nullptr;
+  }
+
+  // Objects are read from the decompressed data at the positions they were
+  // written at, so it follows a copy of the header.
+  *decompressed_size = data_start + static_cast<intptr_t>(data_size);
+  uint8_t* decompressed =
+      reinterpret_cast<uint8_t*>(malloc(*decompressed_size));
+  if (decompressed == nullptr) {
+    OUT_OF_MEMORY();
+  }
+  memmove(decompressed, buffer, data_start);
+
+  DecompressionWork work;
+  work.blocks = buffer + blocks_start;
+  work.block_offsets = block_offsets.data();
+  work.num_blocks = num_blocks;
+  work.block_size = block_size;
+  work.output = decompressed + data_start;
+  work.output_size = data_size;
+
+  num_tasks = Utils::Minimum(num_tasks, num_blocks);
+  if ((num_tasks > 1) && (Dart::thread_pool() != nullptr)) {
+    // This thread decompresses blocks too. A task that starts after it
+    // reached the barrier does not participate.
+    ThreadBarrier* barrier = new ThreadBarrier(num_tasks, 1);
+    for (intptr_t i = 0; i < num_tasks - 1; i++) {
+      bool result = Dart::thread_pool()->Run<DecompressionTask>(barrier, &work);
+      ASSERT(result);
+    }
+    DecompressBlocks(&work);
+    barrier->Sync();
+    barrier->Release();
+  } else {
+    DecompressBlocks(&work);
+  }
+
+  if (work.failed) {
+    free(decompressed);
+    *error = Utils::StrDup("Corrupt compressed snapshot data");
+    return nullptr;
+  }
+  return decompressed;
+}
+
+}  // namespace dart
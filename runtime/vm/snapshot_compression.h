@@ -0,0 +1,61 @@
+// Copyright (c) 2022, the Dart project authors.  Please see the AUTHORS file
+// for details. All rights reserved. Use of this source code is governed by a
+// BSD-style license that can be found in the LICENSE file.
+
+#ifndef RUNTIME_VM_SNAPSHOT_COMPRESSION_H_
+#define RUNTIME_VM_SNAPSHOT_COMPRESSION_H_
+
+#include "vm/allocation.h"
+#include "vm/globals.h"
+
+namespace dart {
+
+class NonStreamingWriteStream;
+
+// The clustered data of a snapshot, which follows its version and features,
+// starts with a byte giving its format. With --compress-snapshot-data, it is
+// split into blocks that are compressed independently with zlib, so they can
+// be decompressed in parallel when the snapshot is read:
+//
+//   uint8 kCompressed
+//   uint32 block size, uint32 number of blocks, uint64 uncompressed size
+//   for each block: uint32 compressed size
+//   the compressed blocks
+//
+// The data images of the snapshot are not compressed, because they are used
+// in place.
+class SnapshotCompression : public AllStatic {
+ public:
+  enum Format : uint8_t {
+    kUncompressed = 0,
+    kCompressed = 1,
+  };
+
+#if !defined(DART_PRECOMPILED_RUNTIME)
+  // Writes the format byte for the clustered data that follows, and returns
+  // its position for Compress.
+  static intptr_t WriteFormat(NonStreamingWriteStream* stream);
+
+  // Compresses the clustered data written to [stream] after the format byte
+  // at [format_position], if --compress-snapshot-data is given and it makes
+  // the data smaller. Returns the size of the data before compression.
+  static intptr_t Compress(NonStreamingWriteStream* stream,
+                           intptr_t format_position);
+#endif  // !defined(DART_PRECOMPILED_RUNTIME)
+
+  // Returns a malloced copy of the [size] bytes of snapshot in [buffer], with
+  // the clustered data after the format byte at [format_position]
+  // decompressed, so it is at the position it had when it was written. Uses
+  // up to [num_tasks] threads. Returns nullptr and sets [error] to a malloced
+  // message if the data is corrupt.
+  static uint8_t* Decompress(const uint8_t* buffer,
+                             intptr_t size,
+                             intptr_t format_position,
+                             intptr_t num_tasks,
+                             intptr_t* decompressed_size,
+                             char** error);
+};
+
+}  // namespace dart
+
+#endif  // RUNTIME_VM_SNAPSHOT_COMPRESSION_H_
@@ -4,6 +4,7 @@
 
 #include "platform/globals.h"
 
+#include "include/dart_native_api.h"
 #include "include/dart_tools_api.h"
 #include "platform/assert.h"
 #include "platform/unicode.h"
@@ -16,13 +17,20 @@
 #include "vm/flags.h"
 #include "vm/malloc_hooks.h"
 #include "vm/message_snapshot.h"
+#include "vm/random.h"
 #include "vm/snapshot.h"
+#include "vm/snapshot_compression.h"
 #include "vm/symbols.h"
 #include "vm/timer.h"
 #include "vm/unit_test.h"
 
 namespace dart {
 
+DECLARE_FLAG(bool, compress_snapshot_data);
+DECLARE_FLAG(int, incremental_message_deserialization_threshold);
+DECLARE_FLAG(int, snapshot_compression_block_size);
+DECLARE_FLAG(int, out_of_line_typed_data_threshold);
+
 // Check if serialized and deserialized objects are equal.
 static bool Equals(const Object& expected, const Object& actual) {
   if (expected.IsNull()) {
@@ -582,6 +590,101 @@ ISOLATE_UNIT_TEST_CASE(SerializeByteArray) {
   CheckEncodeDecodeMessage(scope.zone(), root);
 }
 
+ISOLATE_UNIT_TEST_CASE(SerializeByteArrayOutOfLine) {
+  SetFlagScope<int> sfs(&FLAG_out_of_line_typed_data_threshold, 1024);
+  const int kSmallLength = 16;
+  const int kLargeLength = 4096;
+  const Array& array = Array::Handle(Array::New(2));
+  TypedData& typed_data = TypedData::Handle();
+  typed_data = TypedData::New(kTypedDataUint8ArrayCid, kSmallLength);
+  array.SetAt(0, typed_data);
+  typed_data = TypedData::New(kTypedDataUint8ArrayCid, kLargeLength);
+  for (int i = 0; i < kLargeLength; i++) {
+    typed_data.SetUint8(i, i & 0xff);
+  }
+  array.SetAt(1, typed_data);
+
+  // Dart receivers get it in the message.
+  std::unique_ptr<Message> message =
+      WriteMessage(/* can_send_any_object */ true, /* same_group */ false,
+                   array, ILLEGAL_PORT, Message::kNormalPriority);
+  EXPECT(message->Size() > kLargeLength);
+  Array& serialized_array = Array::Handle();
+  serialized_array ^= ReadMessage(thread, message.get());
+  typed_data ^= serialized_array.At(1);
+  EXPECT(typed_data.IsTypedData());
+  EXPECT_EQ(kLargeLength, typed_data.Length());
+  for (int i = 0; i < kLargeLength; i++) {
+    EXPECT_EQ(i & 0xff, typed_data.GetUint8(i));
+  }
+
+  // Native ports that asked for it get the large one as external typed data
+  // they own.
+  Dart_Port port = Dart_NewNativePortReceivingExternalTypedData(
+      "OutOfLine", [](Dart_Port port, Dart_CObject* message) {}, false);
+  EXPECT_NE(ILLEGAL_PORT, port);
+  message = WriteMessage(/* can_send_any_object */ true, /* same_group */ false,
+                         array, port, Message::kNormalPriority);
+  EXPECT(Dart_CloseNativePort(port));
+  EXPECT(message->Size() < kLargeLength);
+  {
+    ApiNativeScope scope;
+    Dart_CObject* root = ReadApiMessage(scope.zone(), message.get());
+    EXPECT_EQ(Dart_CObject_kArray, root->type);
+    EXPECT_EQ(Dart_CObject_kTypedData,
+              root->value.as_array.values[0]->type);
+    Dart_CObject* large = root->value.as_array.values[1];
+    EXPECT_EQ(Dart_CObject_kExternalTypedData, large->type);
+    EXPECT_EQ(kLargeLength, large->value.as_external_typed_data.length);
+    message.reset();
+    // The buffer outlives the message.
+    for (int i = 0; i < kLargeLength; i++) {
+      EXPECT_EQ(i & 0xff, large->value.as_external_typed_data.data[i]);
+    }
+    large->value.as_external_typed_data.callback(
+        nullptr, large->value.as_external_typed_data.peer);
+  }
+}
+
+ISOLATE_UNIT_TEST_CASE(SerializeLargeMessageIncrementally) {
+  SetFlagScope<int> sfs(&FLAG_incremental_message_deserialization_threshold,
+                        0);
+  // Enough elements that the reader crosses several safepoint chunks while
+  // filling in a single array.
+  const intptr_t kLength = 100000;
+  const Array& array = Array::Handle(Array::New(kLength));
+  String& str = String::Handle();
+  Integer& integer = Integer::Handle();
+  for (intptr_t i = 0; i < kLength; i++) {
+    if ((i % 2) == 0) {
+      str = String::New("element");
+      array.SetAt(i, str);
+    } else {
+      integer = Integer::New(kMaxInt64 - i);
+      array.SetAt(i, integer);
+    }
+  }
+  std::unique_ptr<Message> message =
+      WriteMessage(/* can_send_any_object */ true, /* same_group */ false,
+                   array, ILLEGAL_PORT, Message::kNormalPriority);
+
+  Array& serialized_array = Array::Handle();
+  serialized_array ^= ReadMessage(thread, message.get());
+  EXPECT_EQ(kLength, serialized_array.Length());
+  EXPECT(serialized_array.ptr()->IsOldObject());
+  for (intptr_t i = 0; i < kLength; i++) {
+    if ((i % 2) == 0) {
+      str ^= serialized_array.At(i);
+      EXPECT(str.ptr()->IsOldObject());
+      EXPECT(str.Equals("element"));
+    } else {
+      integer ^= serialized_array.At(i);
+      EXPECT(integer.ptr()->IsOldObject());
+      EXPECT_EQ(kMaxInt64 - i, integer.AsInt64Value());
+    }
+  }
+}
+
 #define TEST_TYPED_ARRAY(darttype, ctype)                                      \
   {                                                                            \
     StackZone zone(thread);                                                    \
@@ -673,7 +776,7 @@ ISOLATE_UNIT_TEST_CASE(SerializeEmptyByteArray) {
   CheckEncodeDecodeMessage(scope.zone(), root);
 }
 
-VM_UNIT_TEST_CASE(FullSnapshot) {
+static void TestFullSnapshot() {
   // clang-format off
   auto kScriptChars = Utils::CStringUniquePtr(
       OS::SCreate(
@@ -760,6 +863,101 @@ VM_UNIT_TEST_CASE(FullSnapshot) {
   free(isolate_snapshot_data_buffer);
 }
 
+VM_UNIT_TEST_CASE(FullSnapshot) {
+  TestFullSnapshot();
+}
+
+VM_UNIT_TEST_CASE(FullSnapshotSerialFill) {
+  SetFlagScope<int> sfs(&FLAG_deserializer_tasks, 0);
+  TestFullSnapshot();
+}
+
+VM_UNIT_TEST_CASE(FullSnapshotParallelFill) {
+  SetFlagScope<int> sfs(&FLAG_deserializer_tasks, 8);
+  TestFullSnapshot();
+}
+
+VM_UNIT_TEST_CASE(FullSnapshotCompressed) {
+  SetFlagScope<bool> sfs(&FLAG_compress_snapshot_data, true);
+  SetFlagScope<int> sfs_block_size(&FLAG_snapshot_compression_block_size,
+                                   16 * KB);
+  TestFullSnapshot();
+}
+
+TEST_CASE(SnapshotCompression_RoundTrip) {
+  SetFlagScope<bool> sfs(&FLAG_compress_snapshot_data, true);
+  SetFlagScope<int> sfs_block_size(&FLAG_snapshot_compression_block_size,
+                                   1 * KB);
+  const char* kHeader = "header";
+  const intptr_t kDataSize = 10 * KB + 17;
+
+  MallocWriteStream stream(1 * KB);
+  stream.WriteBytes(kHeader, strlen(kHeader));
+  const intptr_t format_position = SnapshotCompression::WriteFormat(&stream);
+  for (intptr_t i = 0; i < kDataSize; i++) {
+    stream.WriteByte(static_cast<uint8_t>((i / 7) % 13));
+  }
+  EXPECT_EQ(kDataSize,
+            SnapshotCompression::Compress(&stream, format_position));
+  EXPECT_EQ(SnapshotCompression::kCompressed,
+            stream.buffer()[format_position]);
+  const intptr_t compressed_size = stream.bytes_written();
+  EXPECT_LT(compressed_size, format_position + 1 + kDataSize);
+
+  for (intptr_t num_tasks = 0; num_tasks <= 4; num_tasks += 4) {
+    intptr_t decompressed_size = 0;
+    char* error = nullptr;
+    uint8_t* decompressed = SnapshotCompression::Decompress(
+        stream.buffer(), compressed_size, format_position, num_tasks,
+        &decompressed_size, &error);
+    EXPECT(error == nullptr);
+    EXPECT_EQ(format_position + 1 + kDataSize, decompressed_size);
+    EXPECT(memcmp(decompressed, kHeader, strlen(kHeader)) == 0);
+    for (intptr_t i = 0; i < kDataSize; i++) {
+      if (decompressed[format_position + 1 + i] != (i / 7) % 13) {
+        EXPECT(false);
+        break;
+      }
+    }
+    free(decompressed);
+  }
+
+  // Corrupt or truncated data is rejected.
+  intptr_t decompressed_size = 0;
+  char* error = nullptr;
+  EXPECT(SnapshotCompression::Decompress(stream.buffer(), compressed_size - 1,
+                                         format_position, 4,
+                                         &decompressed_size,
+                                         &error) == nullptr);
+  EXPECT_SUBSTRING("Truncated", error);
+  free(error);
+  error = nullptr;
+  stream.buffer()[compressed_size - 2] ^= 0xff;
+  EXPECT(SnapshotCompression::Decompress(stream.buffer(), compressed_size,
+                                         format_position, 4,
+                                         &decompressed_size,
+                                         &error) == nullptr);
+  EXPECT_SUBSTRING("Corrupt", error);
+  free(error);
+}
+
+TEST_CASE(SnapshotCompression_IncompressibleData) {
+  SetFlagScope<bool> sfs(&FLAG_compress_snapshot_data, true);
+  const intptr_t kDataSize = 4 * KB;
+
+  MallocWriteStream stream(1 * KB);
+  const intptr_t format_position = SnapshotCompression::WriteFormat(&stream);
+  Random random(42);
+  for (intptr_t i = 0; i < kDataSize; i++) {
+    stream.WriteByte(static_cast<uint8_t>(random.NextUInt32()));
+  }
+  EXPECT_EQ(kDataSize,
+            SnapshotCompression::Compress(&stream, format_position));
+  EXPECT_EQ(SnapshotCompression::kUncompressed,
+            stream.buffer()[format_position]);
+  EXPECT_EQ(format_position + 1 + kDataSize, stream.bytes_written());
+}
+
 // Helper function to call a top level Dart function and serialize the result.
 static std::unique_ptr<Message> GetSerialized(Dart_Handle lib,
                                               const char* dart_function) {
@@ -375,6 +375,7 @@ bool StackFrame::FindExceptionHandler(Thread* thread,
   if (code.IsNull()) {
     return false;  // Stub frames do not have exception handlers.
   }
+  code.EnsureCodeMetadata();
   start = code.PayloadStart();
   handlers = code.exception_handlers();
   descriptors = code.pc_descriptors();
@@ -419,6 +420,7 @@ TokenPosition StackFrame::GetTokenPos() const {
   if (code.IsNull()) {
     return TokenPosition::kNoSource;  // Stub frames do not have token_pos.
   }
+  code.EnsureCodeMetadata();
   uword pc_offset = pc() - code.PayloadStart();
   const PcDescriptors& descriptors =
       PcDescriptors::Handle(code.pc_descriptors());
@@ -494,6 +494,7 @@ void StackTraceUtils::UnwindAwaiterChain(
     code = function.EnsureHasCode();
     RELEASE_ASSERT(!code.IsNull());
     code_array.Add(code);
+    code.EnsureCodeMetadata();
     pc_descs = code.pc_descriptors();
     const intptr_t pc_offset = FindPcOffset(pc_descs, GetYieldIndex(closure));
     // Unlike other sources of PC offsets, the offset may be 0 here if we
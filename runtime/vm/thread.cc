@@ -260,6 +260,8 @@ const char* Thread::TaskKindToCString(TaskKind kind) {
       return "kSweeperTask";
     case kMarkerTask:
       return "kMarkerTask";
+    case kDeserializerTask:
+      return "kDeserializerTask";
     default:
       UNREACHABLE();
       return "";
@@ -309,6 +309,7 @@ class Thread : public ThreadState {
     kCompactorTask = 0x10,
     kScavengerTask = 0x20,
     kSampleBlockTask = 0x40,
+    kDeserializerTask = 0x80,
   };
   // Converts a TaskKind to its corresponding C-String name.
   static const char* TaskKindToCString(TaskKind kind);
@@ -4,6 +4,10 @@
 
 #include "vm/thread_pool.h"
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 #include "vm/dart.h"
 #include "vm/flags.h"
 #include "vm/lockers.h"
@@ -15,6 +19,12 @@ DEFINE_FLAG(int,
             5000,
             "Free workers when they have been idle for this amount of time.");
 
+DEFINE_FLAG(charp,
+            worker_cpus,
+            nullptr,
+            "Comma separated list of CPUs or CPU ranges (e.g. 0-3,8) to pin "
+            "thread pool workers to, one CPU per worker.");
+
 static int64_t ComputeTimeout(int64_t idle_start) {
   int64_t worker_timeout_micros =
       FLAG_worker_timeout_millis * kMicrosecondsPerMillisecond;
@@ -34,11 +44,152 @@ static int64_t ComputeTimeout(int64_t idle_start) {
   }
 }
 
+// Parses [FLAG_worker_cpus] into [cpus]. Returns the number of CPUs, or 0 if
+// the flag is not set or malformed.
+static intptr_t ParseWorkerCpus(intptr_t* cpus, intptr_t capacity) {
+  const char* current = FLAG_worker_cpus;
+  if (current == nullptr) {
+    return 0;
+  }
+  intptr_t length = 0;
+  while (*current != '\0') {
+    char* end = nullptr;
+    const intptr_t first = strtol(current, &end, 10);
+    intptr_t last = first;
+    if (end == current || first < 0) {
+      return 0;
+    }
+    if (*end == '-') {
+      current = end + 1;
+      last = strtol(current, &end, 10);
+      if (end == current || last < first) {
+        return 0;
+      }
+    }
+    for (intptr_t cpu = first; cpu <= last && length < capacity; cpu++) {
+      cpus[length++] = cpu;
+    }
+    if (*end == ',') {
+      end++;
+    } else if (*end != '\0') {
+      return 0;
+    }
+    current = end;
+  }
+  return length;
+}
+
+// Tells the CPU we are spinning, so a hyper-threaded sibling, possibly the
+// very worker we are waiting for, gets the execution resources.
+static inline void CpuRelax() {
+#if defined(HOST_ARCH_IA32) || defined(HOST_ARCH_X64)
+#if defined(_MSC_VER)
+  _mm_pause();
+#else
+  __builtin_ia32_pause();
+#endif
+#elif defined(HOST_ARCH_ARM64)
+#if defined(_MSC_VER)
+  __yield();
+#else
+  asm volatile("yield");
+#endif
+#endif
+}
+
+ThreadPool::WorkerSlot::WorkerSlot(intptr_t index)
+    : index_(index),
+      top_(0),
+      bottom_(0),
+      lifo_slot_(nullptr),
+      owner_running_task_(false),
+      tasks_stolen_(0),
+      affinity_tasks_length_(0),
+      affinity_progress_micros_(0),
+      affinity_tasks_migrated_(0) {
+  for (intptr_t i = 0; i < kCapacity; ++i) {
+    buffer_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
+
+bool ThreadPool::WorkerSlot::Push(Task* task) {
+  const intptr_t bottom = bottom_.load(std::memory_order_relaxed);
+  const intptr_t top = top_.load(std::memory_order_acquire);
+  if (bottom - top >= kCapacity) {
+    return false;
+  }
+  buffer_[bottom & kMask].store(task, std::memory_order_relaxed);
+  bottom_.store(bottom + 1, std::memory_order_release);
+  return true;
+}
+
+ThreadPool::Task* ThreadPool::WorkerSlot::Take() {
+  intptr_t top = top_.load(std::memory_order_acquire);
+  while (true) {
+    const intptr_t bottom = bottom_.load(std::memory_order_acquire);
+    if (top >= bottom) {
+      return nullptr;
+    }
+    // The slot might be overwritten by the owner as soon as another thread
+    // advanced [top_], in which case the CAS below fails and we retry.
+    Task* task = buffer_[top & kMask].load(std::memory_order_relaxed);
+    if (top_.compare_exchange_weak(top, top + 1, std::memory_order_acq_rel,
+                                   std::memory_order_acquire)) {
+      return task;
+    }
+  }
+}
+
+ThreadPool::Task* ThreadPool::WorkerSlot::StealHalfInto(WorkerSlot* thief,
+                                                        intptr_t* stolen) {
+  Task* tasks[kCapacity / 2];
+  intptr_t count = 0;
+  intptr_t top = top_.load(std::memory_order_acquire);
+  while (true) {
+    const intptr_t bottom = bottom_.load(std::memory_order_acquire);
+    const intptr_t available = bottom - top;
+    if (available <= 0) {
+      return nullptr;
+    }
+    count = thief == nullptr ? 1 : available - available / 2;
+    count = Utils::Minimum(count, kCapacity / 2);
+    for (intptr_t i = 0; i < count; ++i) {
+      tasks[i] = buffer_[(top + i) & kMask].load(std::memory_order_relaxed);
+    }
+    if (top_.compare_exchange_weak(top, top + count, std::memory_order_acq_rel,
+                                   std::memory_order_acquire)) {
+      break;
+    }
+  }
+  for (intptr_t i = 1; i < count; ++i) {
+    const bool pushed = thief->Push(tasks[i]);
+    ASSERT(pushed);
+  }
+  *stolen = count;
+  return tasks[0];
+}
+
 ThreadPool::ThreadPool(uintptr_t max_pool_size)
-    : all_workers_dead_(false), max_pool_size_(max_pool_size) {}
+    : all_workers_dead_(false), max_pool_size_(max_pool_size) {
+  for (intptr_t i = 0; i < kSlotWords; ++i) {
+    parked_slots_[i].store(0, std::memory_order_relaxed);
+    non_empty_slots_[i].store(0, std::memory_order_relaxed);
+    affinity_slots_[i].store(0, std::memory_order_relaxed);
+  }
+  for (intptr_t i = 0; i < kMaxWorkerSlots; ++i) {
+    worker_slots_[i].store(nullptr, std::memory_order_relaxed);
+  }
+}
 
 ThreadPool::~ThreadPool() {
   Shutdown();
+
+  const intptr_t length = worker_slots_length_.load();
+  for (intptr_t i = 0; i < length; ++i) {
+    WorkerSlot* slot = worker_slots_[i].load();
+    ASSERT(slot->IsEmpty() && !slot->HasAffinityTask());
+    delete slot;
+  }
 }
 
 void ThreadPool::Shutdown() {
@@ -48,15 +199,18 @@ void ThreadPool::Shutdown() {
     // Prevent scheduling of new tasks.
     shutting_down_ = true;
 
-    if (running_workers_.IsEmpty() && idle_workers_.IsEmpty()) {
+    if (live_workers_.IsEmpty()) {
       // All workers have already died.
       all_workers_dead_ = true;
-    } else {
-      // Tell workers to drain remaining work and then shut down.
-      ml.NotifyAll();
     }
   }
 
+  // Tell parked workers to drain remaining work and then shut down. Workers
+  // parking concurrently observe [shutting_down_] before they go to sleep.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  while (UnparkWorker()) {
+  }
+
   // Wait until all workers are dead. Any new death will notify the exit
   // monitor.
   {
@@ -65,10 +219,10 @@ void ThreadPool::Shutdown() {
       eml.Wait();
     }
   }
-  ASSERT(count_idle_ == 0);
-  ASSERT(count_running_ == 0);
-  ASSERT(idle_workers_.IsEmpty());
-  ASSERT(running_workers_.IsEmpty());
+  ASSERT(count_live_ == 0);
+  ASSERT(live_workers_.IsEmpty());
+  ASSERT(idle_state_ == 0);
+  ASSERT(global_tasks_.IsEmpty());
 
   WorkerList dead_workers_to_join;
   {
@@ -81,7 +235,7 @@ void ThreadPool::Shutdown() {
   ASSERT(dead_workers_.IsEmpty());
 }
 
-bool ThreadPool::RunImpl(std::unique_ptr<Task> task) {
+bool ThreadPool::RunImpl(std::unique_ptr<Task> task, intptr_t worker_hint) {
   Dart_PostTaskCallback post_task = Dart::post_task_callback();
   if (post_task != nullptr) {
     {
@@ -98,24 +252,87 @@ bool ThreadPool::RunImpl(std::unique_ptr<Task> task) {
     return true;
   }
 
-  Worker* new_worker = nullptr;
-  {
+  Worker* worker = CurrentWorker();
+  WorkerSlot* own_slot = worker != nullptr ? worker->slot_ : nullptr;
+  if (worker_hint != kNoWorkerHint &&
+      (own_slot == nullptr || own_slot->index() != worker_hint)) {
+    if (shutting_down_) {
+      return false;
+    }
+    if (PushAffinityTask(worker_hint, task.get())) {
+      task.release();
+      return true;
+    }
+    // The preferred worker is gone, schedule the task like any other.
+  }
+  if (own_slot != nullptr) {
+    // Fast path: a task scheduled by one of our own workers goes into the
+    // worker's local queue without taking [pool_monitor_]. The worker is
+    // alive and will drain its queue before it can exit, so there is no need
+    // to synchronize with a concurrent shutdown here.
+    if (shutting_down_) {
+      return false;
+    }
+    PushLocal(worker, task.release());
+  } else {
     MonitorLocker ml(&pool_monitor_);
     if (shutting_down_) {
       return false;
     }
-    new_worker = ScheduleTaskLocked(&ml, std::move(task));
+    global_tasks_.Append(task.release());
+    global_tasks_length_++;
   }
-  if (new_worker != nullptr) {
-    new_worker->StartThread();
+  EnsureWorkerForScheduledTask();
+  return true;
+}
+
+bool ThreadPool::PushAffinityTask(intptr_t worker_hint, Task* task) {
+  if (worker_hint < 0 ||
+      worker_hint >= worker_slots_length_.load(std::memory_order_acquire)) {
+    return false;
+  }
+  WorkerSlot* slot = worker_slots_[worker_hint].load(std::memory_order_acquire);
+  {
+    MutexLocker ml(&slot->affinity_mutex_);
+    if (!slot->accepts_affinity_tasks_) {
+      return false;
+    }
+    if (slot->affinity_tasks_.IsEmpty()) {
+      slot->affinity_progress_micros_.store(OS::GetCurrentMonotonicMicros(),
+                                            std::memory_order_relaxed);
+      affinity_slots_[slot->index() / kBitsPerWord].fetch_or(
+          uint64_t{1} << (slot->index() % kBitsPerWord));
+    }
+    slot->affinity_tasks_.Append(task);
+    slot->affinity_tasks_length_++;
+  }
+
+  // The task is published, see [idle_state_] for why this fence is needed.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!UnparkSlot(slot)) {
+    // The preferred worker is awake. If it is busy make sure somebody is
+    // around to steal the task once it is overdue.
+    EnsureWorkerForScheduledTask();
   }
   return true;
 }
 
+intptr_t ThreadPool::CurrentWorkerHint() {
+  Worker* worker = CurrentWorker();
+  if (worker == nullptr || worker->slot_ == nullptr) {
+    return kNoWorkerHint;
+  }
+  return worker->slot_->index();
+}
+
 bool ThreadPool::CurrentThreadIsWorker() {
+  return CurrentWorker() != nullptr;
+}
+
+ThreadPool::Worker* ThreadPool::CurrentWorker() {
   auto worker =
       static_cast<Worker*>(OSThread::Current()->owning_thread_pool_worker_);
-  return worker != nullptr && worker->pool_ == this;
+  return worker != nullptr && worker->pool_ == this ? worker : nullptr;
 }
 
 void ThreadPool::MarkCurrentWorkerAsBlocked() {
@@ -127,15 +344,13 @@ void ThreadPool::MarkCurrentWorkerAsBlocked() {
     ASSERT(!worker->is_blocked_);
     worker->is_blocked_ = true;
     if (max_pool_size_ > 0) {
-      ++max_pool_size_;
+      max_pool_size_.fetch_add(1);
       // This thread is blocked and therefore no longer usable as a worker.
-      // If we have pending tasks and there are no idle workers, we will spawn a
-      // new thread (temporarily allow exceeding the maximum pool size) to
-      // handle the pending tasks.
-      if (idle_workers_.IsEmpty() && pending_tasks_ > 0) {
-        new_worker = new Worker(this);
-        idle_workers_.Append(new_worker);
-        count_idle_++;
+      // If we have pending tasks, e.g. in this worker's own local queue, and
+      // no other worker is looking for them, we will spawn a new thread
+      // (temporarily allow exceeding the maximum pool size) to handle them.
+      if (HasWork()) {
+        new_worker = StartWorkerLocked(&ml);
       }
     }
   }
@@ -152,7 +367,7 @@ void ThreadPool::MarkCurrentWorkerAsUnBlocked() {
     if (worker->is_blocked_) {
       worker->is_blocked_ = false;
       if (max_pool_size_ > 0) {
-        --max_pool_size_;
+        max_pool_size_.fetch_sub(1);
         ASSERT(max_pool_size_ > 0);
       }
     }
@@ -163,93 +378,573 @@ void ThreadPool::WorkerLoop(Worker* worker) {
   WorkerList dead_workers_to_join;
 
   while (true) {
+    if (Task* found = FindTask(worker)) {
+      std::unique_ptr<Task> task(found);
+      WorkerSlot* slot = worker->slot_;
+      if (slot != nullptr) {
+        slot->owner_running_task_.store(true, std::memory_order_relaxed);
+      }
+      task->Run();
+      ASSERT(Isolate::Current() == nullptr);
+      task.reset();
+      if (slot != nullptr) {
+        slot->owner_running_task_.store(false, std::memory_order_relaxed);
+      }
+      continue;
+    }
+
+    // We are searching and did not find any work.
+    bool exit = false;
+    if (shutting_down_ || worker->slot_ == nullptr) {
+      exit = TryRetireWorker(worker);
+    } else {
+      // Exit if we timed out while parked.
+      exit = ParkWorker(worker);
+    }
+    if (exit) {
+      if (CloseAffinityQueue(worker)) {
+        break;
+      }
+      // Tasks with an affinity to us arrived while we decided to exit.
+      idle_state_.fetch_add(kOneUnparked + kOneSearching);
+      worker->is_searching_ = true;
+    }
+  }
+
+  {
+    MonitorLocker ml(&pool_monitor_);
+    ObtainDeadWorkersLocked(&dead_workers_to_join);
+    WorkerDiedLocked(worker);
+  }
+
+  // Before we transitioned to dead we obtained the list of previously died dead
+  // workers, which we join here. Since every death of a worker will join
+  // previously died workers, we keep the pending non-joined [dead_workers_] to
+  // effectively 1.
+  JoinDeadWorkersLocked(&dead_workers_to_join);
+}
+
+void ThreadPool::PushLocal(Worker* worker, Task* task) {
+  WorkerSlot* slot = worker->slot_;
+  Task* displaced = slot->ExchangeLifo(task);
+  if (displaced != nullptr && !slot->Push(displaced)) {
+    // The local queue overflowed, move the task into the global queue.
+    MonitorLocker ml(&pool_monitor_);
+    global_tasks_.Append(displaced);
+    global_tasks_length_++;
+  }
+  MarkSlotNonEmpty(slot);
+}
+
+void ThreadPool::EnsureWorkerForScheduledTask() {
+  // The task is published, see [idle_state_] for why this fence is needed.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  // A searching worker will find the task. Once it does and it was the last
+  // searching worker it will unpark another one if there is more work.
+  if (NumSearching(idle_state_.load()) > 0) {
+    return;
+  }
+  if (UnparkWorker()) {
+    return;
+  }
+
+  // All workers are busy. Start a new one unless we maxed out the number of
+  // threads, in which case the task runs once a worker becomes available.
+  if (max_pool_size_ > 0 && count_live_ >= max_pool_size_) {
+    return;
+  }
+  Worker* new_worker = nullptr;
+  {
     MonitorLocker ml(&pool_monitor_);
+    new_worker = StartWorkerLocked(&ml);
+  }
+  if (new_worker != nullptr) {
+    new_worker->StartThread();
+  }
+}
 
-    if (!tasks_.IsEmpty()) {
-      IdleToRunningLocked(worker);
-      while (!tasks_.IsEmpty()) {
-        std::unique_ptr<Task> task(tasks_.RemoveFirst());
-        pending_tasks_--;
-        MonitorLeaveScope mls(&ml);
-        task->Run();
-        ASSERT(Isolate::Current() == nullptr);
-        task.reset();
+bool ThreadPool::UnparkWorker() {
+  for (intptr_t word = 0; word < kSlotWords; ++word) {
+    uint64_t parked = parked_slots_[word].load();
+    while (parked != 0) {
+      const intptr_t bit = Utils::CountTrailingZeros64(parked);
+      const uint64_t mask = uint64_t{1} << bit;
+      if ((parked_slots_[word].fetch_and(~mask) & mask) != 0) {
+        // We claimed the worker. Account for it as searching right away, so
+        // concurrently scheduled tasks do not wake up more workers.
+        idle_state_.fetch_add(kOneUnparked + kOneSearching);
+        WorkerSlot* slot = worker_slots_[word * kBitsPerWord + bit].load();
+        MonitorLocker ml(&slot->park_monitor_);
+        slot->unpark_requested_ = true;
+        ml.Notify();
+        return true;
       }
-      RunningToIdleLocked(worker);
+      parked = parked_slots_[word].load();
+    }
+  }
+  return false;
+}
+
+bool ThreadPool::UnparkSlot(WorkerSlot* slot) {
+  const intptr_t word = slot->index() / kBitsPerWord;
+  const uint64_t mask = uint64_t{1} << (slot->index() % kBitsPerWord);
+  if ((parked_slots_[word].load() & mask) == 0 ||
+      (parked_slots_[word].fetch_and(~mask) & mask) == 0) {
+    return false;
+  }
+  idle_state_.fetch_add(kOneUnparked + kOneSearching);
+  MonitorLocker ml(&slot->park_monitor_);
+  slot->unpark_requested_ = true;
+  ml.Notify();
+  return true;
+}
+
+ThreadPool::Worker* ThreadPool::StartWorkerLocked(MonitorLocker* ml) {
+  if (NumSearching(idle_state_.load()) > 0 || UnparkWorker()) {
+    return nullptr;
+  }
+
+  // If we have maxed out the number of threads running, we will not start a
+  // new one.
+  if (max_pool_size_ > 0 && count_live_ >= max_pool_size_) {
+    return nullptr;
+  }
+
+  // Otherwise start a new worker. It starts out searching for work.
+  auto new_worker = new Worker(this);
+  AcquireWorkerSlotLocked(new_worker);
+  live_workers_.Append(new_worker);
+  count_live_++;
+  idle_state_.fetch_add(kOneUnparked + kOneSearching);
+  return new_worker;
+}
+
+ThreadPool::Task* ThreadPool::FindTask(Worker* worker) {
+  // Running tasks from the local queue does not touch any shared state.
+  Task* task = FindLocalTask(worker);
+  if (task != nullptr) {
+    return task;
+  }
+
+  TransitionToSearching(worker);
+  task = TakeGlobalTask();
+  if (task == nullptr) {
+    task = StealTask(worker);
+  }
+  if (task != nullptr) {
+    TransitionFromSearching(worker);
+  }
+  return task;
+}
+
+ThreadPool::Task* ThreadPool::FindLocalTask(Worker* worker) {
+  if (++worker->searches_ % kGlobalQueueCheckInterval == 0) {
+    if (Task* task = TakeGlobalTask()) {
+      return task;
+    }
+  }
+
+  WorkerSlot* slot = worker->slot_;
+  if (slot == nullptr) {
+    return nullptr;
+  }
+  Task* task = nullptr;
+  if (worker->lifo_streak_ < kMaxLifoStreak) {
+    task = slot->TakeLifo();
+  }
+  if (task != nullptr) {
+    worker->lifo_streak_++;
+    return task;
+  }
+  worker->lifo_streak_ = 0;
+  task = TakeAffinityTask(slot, /*migrate=*/false);
+  if (task != nullptr) {
+    return task;
+  }
+  task = slot->Take();
+  if (task == nullptr) {
+    task = slot->TakeLifo();
+  }
+  if (task == nullptr) {
+    // Only the owner pushes to its queue, so it stays empty.
+    MarkSlotEmpty(slot);
+  }
+  return task;
+}
+
+ThreadPool::Task* ThreadPool::TakeGlobalTask() {
+  if (global_tasks_length_ == 0) {
+    return nullptr;
+  }
+  MonitorLocker ml(&pool_monitor_);
+  if (global_tasks_.IsEmpty()) {
+    return nullptr;
+  }
+  global_tasks_length_--;
+  return global_tasks_.RemoveFirst();
+}
+
+ThreadPool::Task* ThreadPool::StealTask(Worker* worker) {
+  const intptr_t length = worker_slots_length_.load(std::memory_order_acquire);
+  if (length == 0) {
+    return nullptr;
+  }
+  uint64_t non_empty[kSlotWords];
+  for (intptr_t word = 0; word < kSlotWords; ++word) {
+    non_empty[word] = non_empty_slots_[word].load(std::memory_order_relaxed);
+  }
+
+  // Visit the non-empty slots starting at a random one, so workers do not
+  // all go after the same victims. The word containing [start] is visited
+  // twice: first for the bits at and above [start], last for the ones below.
+  WorkerSlot* const own_slot = worker->slot_;
+  WorkerSlot* lifo_victim = nullptr;
+  const intptr_t start = worker->random_.NextUInt32() % length;
+  const uint64_t start_mask = ~uint64_t{0} << (start % kBitsPerWord);
+  intptr_t probes = 0;
+  for (intptr_t i = 0; i <= kSlotWords && probes < kMaxStealProbes; ++i) {
+    const intptr_t word = (start / kBitsPerWord + i) % kSlotWords;
+    uint64_t bits = non_empty[word];
+    if (i == 0) {
+      bits &= start_mask;
+    } else if (i == kSlotWords) {
+      bits &= ~start_mask;
     }
+    while (bits != 0 && probes < kMaxStealProbes) {
+      const intptr_t index =
+          word * kBitsPerWord + Utils::CountTrailingZeros64(bits);
+      bits &= bits - 1;
+      WorkerSlot* victim =
+          worker_slots_[index].load(std::memory_order_acquire);
+      if (victim == nullptr || victim == own_slot) continue;
+      probes++;
 
-    if (running_workers_.IsEmpty()) {
-      ASSERT(tasks_.IsEmpty());
-      OnEnterIdleLocked(&ml);
-      if (!tasks_.IsEmpty()) {
-        continue;
+      intptr_t stolen = 0;
+      if (Task* task = victim->StealHalfInto(own_slot, &stolen)) {
+        if (own_slot != nullptr) {
+          own_slot->tasks_stolen_.fetch_add(stolen);
+          if (stolen > 1) {
+            MarkSlotNonEmpty(own_slot);
+          }
+        }
+        return task;
+      }
+      if (lifo_victim == nullptr && victim->HasLifoTask() &&
+          victim->owner_running_task()) {
+        lifo_victim = victim;
       }
     }
+  }
 
-    if (shutting_down_) {
-      ObtainDeadWorkersLocked(&dead_workers_to_join);
-      IdleToDeadLocked(worker);
-      break;
+  WorkerSlot* affinity_victim = nullptr;
+  if (Task* task = StealAffinityTask(worker, &affinity_victim)) {
+    return task;
+  }
+  if (lifo_victim == nullptr) {
+    if (affinity_victim == nullptr) {
+      return nullptr;
+    }
+    // Wait for the owner to take its affinity tasks or for them to become
+    // overdue.
+    int64_t now = OS::GetCurrentMonotonicMicros();
+    while (affinity_victim->HasAffinityTask() &&
+           !affinity_victim->AffinityTasksOverdue(now)) {
+      CpuRelax();
+      now = OS::GetCurrentMonotonicMicros();
     }
+    return affinity_victim->AffinityTasksOverdue(now)
+               ? TakeAffinityTask(affinity_victim, /*migrate=*/true)
+               : nullptr;
+  }
 
-    // Sleep until we get a new task, we time out or we're shutdown.
-    const int64_t idle_start = OS::GetCurrentMonotonicMicros();
-    bool done = false;
-    while (!done) {
-      const auto result = ml.WaitMicros(ComputeTimeout(idle_start));
+  // All rings we looked at were empty. Give one busy owner a short grace
+  // period to finish its current task and run its continuation itself, so a
+  // task scheduled at the end of another one stays on the same worker. An
+  // owner which is between tasks is about to run the LIFO task anyway.
+  const int64_t deadline =
+      OS::GetCurrentMonotonicMicros() + kLifoStealDelayMicros;
+  while (lifo_victim->owner_running_task() && lifo_victim->HasLifoTask() &&
+         OS::GetCurrentMonotonicMicros() < deadline) {
+    CpuRelax();
+  }
+  if (!lifo_victim->owner_running_task()) {
+    return nullptr;
+  }
+  Task* task = lifo_victim->TakeLifo();
+  if (task != nullptr && own_slot != nullptr) {
+    own_slot->tasks_stolen_.fetch_add(1);
+  }
+  return task;
+}
 
-      // We have to drain all pending tasks.
-      if (!tasks_.IsEmpty()) break;
+ThreadPool::Task* ThreadPool::TakeAffinityTask(WorkerSlot* slot,
+                                               bool migrate) {
+  if (!slot->HasAffinityTask()) {
+    return nullptr;
+  }
+  MutexLocker ml(&slot->affinity_mutex_);
+  if (slot->affinity_tasks_.IsEmpty()) {
+    return nullptr;
+  }
+  Task* task = slot->affinity_tasks_.RemoveFirst();
+  slot->affinity_tasks_length_--;
+  if (slot->affinity_tasks_.IsEmpty()) {
+    affinity_slots_[slot->index() / kBitsPerWord].fetch_and(
+        ~(uint64_t{1} << (slot->index() % kBitsPerWord)));
+  } else {
+    slot->affinity_progress_micros_.store(OS::GetCurrentMonotonicMicros(),
+                                          std::memory_order_relaxed);
+  }
+  if (migrate) {
+    slot->affinity_tasks_migrated_.fetch_add(1);
+  }
+  return task;
+}
 
-      if (shutting_down_ || result == Monitor::kTimedOut) {
-        done = true;
-        break;
+ThreadPool::Task* ThreadPool::StealAffinityTask(Worker* worker,
+                                                WorkerSlot** waiting_victim) {
+  const intptr_t length = worker_slots_length_.load(std::memory_order_acquire);
+  if (length == 0) {
+    return nullptr;
+  }
+  // Like [StealTask], look at a bounded number of queues starting at a random
+  // one.
+  const int64_t now = OS::GetCurrentMonotonicMicros();
+  const intptr_t start = worker->random_.NextUInt32() % length;
+  intptr_t probes = 0;
+  for (intptr_t i = 0; i < kSlotWords && probes < kMaxStealProbes; ++i) {
+    const intptr_t word = (start / kBitsPerWord + i) % kSlotWords;
+    uint64_t bits = affinity_slots_[word].load(std::memory_order_relaxed);
+    while (bits != 0 && probes < kMaxStealProbes) {
+      const intptr_t index =
+          word * kBitsPerWord + Utils::CountTrailingZeros64(bits);
+      bits &= bits - 1;
+      WorkerSlot* victim =
+          worker_slots_[index].load(std::memory_order_acquire);
+      if (victim == nullptr || victim == worker->slot_) continue;
+      probes++;
+      if (victim->AffinityTasksOverdue(now)) {
+        if (Task* task = TakeAffinityTask(victim, /*migrate=*/true)) {
+          return task;
+        }
+      } else if (*waiting_victim == nullptr && victim->HasAffinityTask()) {
+        *waiting_victim = victim;
       }
     }
-    if (done) {
-      ObtainDeadWorkersLocked(&dead_workers_to_join);
-      IdleToDeadLocked(worker);
-      break;
+  }
+  return nullptr;
+}
+
+bool ThreadPool::HasWork(WorkerSlot* own_slot) {
+  if (global_tasks_length_ > 0) {
+    return true;
+  }
+  if (own_slot != nullptr && own_slot->HasAffinityTask()) {
+    return true;
+  }
+  for (intptr_t word = 0; word < kSlotWords; ++word) {
+    uint64_t bits = non_empty_slots_[word].load();
+    while (bits != 0) {
+      const intptr_t index =
+          word * kBitsPerWord + Utils::CountTrailingZeros64(bits);
+      bits &= bits - 1;
+      WorkerSlot* slot = worker_slots_[index].load(std::memory_order_acquire);
+      if (slot != nullptr && !slot->IsEmpty()) {
+        return true;
+      }
     }
   }
+  return false;
+}
 
-  // Before we transitioned to dead we obtained the list of previously died dead
-  // workers, which we join here. Since every death of a worker will join
-  // previously died workers, we keep the pending non-joined [dead_workers_] to
-  // effectively 1.
-  JoinDeadWorkersLocked(&dead_workers_to_join);
+void ThreadPool::TransitionToSearching(Worker* worker) {
+  if (!worker->is_searching_) {
+    worker->is_searching_ = true;
+    idle_state_.fetch_add(kOneSearching);
+  }
+}
+
+void ThreadPool::TransitionFromSearching(Worker* worker) {
+  if (!worker->is_searching_) {
+    return;
+  }
+  worker->is_searching_ = false;
+  const uint64_t old_state = idle_state_.fetch_sub(kOneSearching);
+  if (NumSearching(old_state) > 1) {
+    return;
+  }
+
+  // We were the last searching worker and tasks scheduled in the meantime
+  // might have relied on us. Make sure somebody looks for them.
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (!HasWork() || UnparkWorker()) {
+    return;
+  }
+  if (max_pool_size_ > 0 && count_live_ >= max_pool_size_) {
+    return;
+  }
+  Worker* new_worker = nullptr;
+  {
+    MonitorLocker ml(&pool_monitor_);
+    new_worker = StartWorkerLocked(&ml);
+  }
+  if (new_worker != nullptr) {
+    new_worker->StartThread();
+  }
+}
+
+bool ThreadPool::ParkWorker(Worker* worker) {
+  ASSERT(worker->is_searching_);
+  WorkerSlot* slot = worker->slot_;
+  const intptr_t word = slot->index() / kBitsPerWord;
+  const uint64_t mask = uint64_t{1} << (slot->index() % kBitsPerWord);
+
+  // Become claimable by [UnparkWorker] before we stop searching, then look
+  // for work scheduled by threads which still counted on us searching.
+  parked_slots_[word].fetch_or(mask);
+  const uint64_t old_state =
+      idle_state_.fetch_sub(kOneUnparked + kOneSearching);
+  worker->is_searching_ = false;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (HasWork(slot) || shutting_down_) {
+    if ((parked_slots_[word].fetch_and(~mask) & mask) != 0) {
+      idle_state_.fetch_add(kOneUnparked + kOneSearching);
+      worker->is_searching_ = true;
+      return false;
+    }
+    // Somebody claimed us concurrently and is about to unpark us.
+  }
+
+  MonitorLocker ml(&slot->park_monitor_);
+  if (NumUnparked(old_state) == 1 && !slot->unpark_requested_) {
+    // We are the last worker to park.
+    OnEnterIdleLocked(&ml);
+  }
+
+  // Sleep until we get unparked or time out.
+  const int64_t idle_start = OS::GetCurrentMonotonicMicros();
+  while (!slot->unpark_requested_) {
+    const auto result = ml.WaitMicros(ComputeTimeout(idle_start));
+    if (!slot->unpark_requested_ && result == Monitor::kTimedOut &&
+        (parked_slots_[word].fetch_and(~mask) & mask) != 0) {
+      return true;
+    }
+  }
+  // The thread unparking us accounted for us searching.
+  slot->unpark_requested_ = false;
+  worker->is_searching_ = true;
+  return false;
+}
+
+bool ThreadPool::TryRetireWorker(Worker* worker) {
+  ASSERT(worker->is_searching_);
+  idle_state_.fetch_sub(kOneUnparked + kOneSearching);
+  worker->is_searching_ = false;
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+  if (HasWork(worker->slot_)) {
+    // A task was scheduled while we were deciding to exit and its scheduler
+    // might have counted on us.
+    idle_state_.fetch_add(kOneUnparked + kOneSearching);
+    worker->is_searching_ = true;
+    return false;
+  }
+  return true;
+}
+
+bool ThreadPool::CloseAffinityQueue(Worker* worker) {
+  WorkerSlot* slot = worker->slot_;
+  if (slot == nullptr) {
+    return true;
+  }
+  MutexLocker ml(&slot->affinity_mutex_);
+  if (!slot->affinity_tasks_.IsEmpty()) {
+    return false;
+  }
+  // From now on tasks with an affinity to this slot go through [Run].
+  slot->accepts_affinity_tasks_ = false;
+  return true;
 }
 
-void ThreadPool::IdleToRunningLocked(Worker* worker) {
-  ASSERT(idle_workers_.ContainsForDebugging(worker));
-  idle_workers_.Remove(worker);
-  running_workers_.Append(worker);
-  count_idle_--;
-  count_running_++;
+void ThreadPool::MarkSlotNonEmpty(WorkerSlot* slot) {
+  auto& word = non_empty_slots_[slot->index() / kBitsPerWord];
+  const uint64_t mask = uint64_t{1} << (slot->index() % kBitsPerWord);
+  // Only the owner changes its own bit, so we can skip the atomic update if
+  // the bit is already set.
+  if ((word.load(std::memory_order_relaxed) & mask) == 0) {
+    word.fetch_or(mask);
+  }
 }
 
-void ThreadPool::RunningToIdleLocked(Worker* worker) {
-  ASSERT(tasks_.IsEmpty());
+void ThreadPool::MarkSlotEmpty(WorkerSlot* slot) {
+  auto& word = non_empty_slots_[slot->index() / kBitsPerWord];
+  const uint64_t mask = uint64_t{1} << (slot->index() % kBitsPerWord);
+  if ((word.load(std::memory_order_relaxed) & mask) != 0) {
+    word.fetch_and(~mask);
+  }
+}
 
-  ASSERT(running_workers_.ContainsForDebugging(worker));
-  running_workers_.Remove(worker);
-  idle_workers_.Append(worker);
-  count_running_--;
-  count_idle_++;
+void ThreadPool::AcquireWorkerSlotLocked(Worker* worker) {
+  ASSERT(worker->slot_ == nullptr);
+  const intptr_t length = worker_slots_length_.load();
+  for (intptr_t i = 0; i < length; ++i) {
+    WorkerSlot* slot = worker_slots_[i].load();
+    if (!slot->in_use_) {
+      ASSERT(slot->IsEmpty());
+      slot->in_use_ = true;
+      worker->slot_ = slot;
+      MutexLocker ml(&slot->affinity_mutex_);
+      slot->accepts_affinity_tasks_ = true;
+      return;
+    }
+  }
+  if (length < kMaxWorkerSlots) {
+    auto slot = new WorkerSlot(length);
+    slot->in_use_ = true;
+    slot->accepts_affinity_tasks_ = true;
+    worker_slots_[length].store(slot, std::memory_order_release);
+    worker_slots_length_.store(length + 1, std::memory_order_release);
+    worker->slot_ = slot;
+  }
+}
+
+uint64_t ThreadPool::tasks_stolen() const {
+  uint64_t result = 0;
+  const intptr_t length = worker_slots_length_.load(std::memory_order_acquire);
+  for (intptr_t i = 0; i < length; ++i) {
+    result += worker_slots_[i].load()->tasks_stolen_.load();
+  }
+  return result;
 }
 
-void ThreadPool::IdleToDeadLocked(Worker* worker) {
-  ASSERT(tasks_.IsEmpty());
+uint64_t ThreadPool::affinity_tasks_migrated() const {
+  uint64_t result = 0;
+  const intptr_t length = worker_slots_length_.load(std::memory_order_acquire);
+  for (intptr_t i = 0; i < length; ++i) {
+    result += worker_slots_[i].load()->affinity_tasks_migrated_.load();
+  }
+  return result;
+}
 
-  ASSERT(idle_workers_.ContainsForDebugging(worker));
-  idle_workers_.Remove(worker);
+void ThreadPool::WorkerDiedLocked(Worker* worker) {
+  ASSERT(!worker->is_searching_);
+  ASSERT(live_workers_.ContainsForDebugging(worker));
+  WorkerSlot* slot = worker->slot_;
+  if (slot != nullptr) {
+    // Only the owner pushes to its queue and it drained the queue before
+    // deciding to exit.
+    ASSERT(slot->IsEmpty() && !slot->HasAffinityTask());
+    slot->in_use_ = false;
+    worker->slot_ = nullptr;
+  }
+  live_workers_.Remove(worker);
   dead_workers_.Append(worker);
-  count_idle_--;
+  count_live_--;
   count_dead_++;
 
   // Notify shutdown thread that the worker thread is about to finish.
   if (shutting_down_) {
-    if (running_workers_.IsEmpty() && idle_workers_.IsEmpty()) {
+    if (live_workers_.IsEmpty()) {
       all_workers_dead_ = true;
       MonitorLocker eml(&exit_monitor_);
       eml.Notify();
@@ -275,38 +970,10 @@ void ThreadPool::JoinDeadWorkersLocked(WorkerList* dead_workers_to_join) {
   ASSERT(dead_workers_to_join->IsEmpty());
 }
 
-ThreadPool::Worker* ThreadPool::ScheduleTaskLocked(MonitorLocker* ml,
-                                                   std::unique_ptr<Task> task) {
-  // Enqueue the new task.
-  tasks_.Append(task.release());
-  pending_tasks_++;
-  ASSERT(pending_tasks_ >= 1);
-
-  // Notify existing idle worker (if available).
-  if (count_idle_ >= pending_tasks_) {
-    ASSERT(!idle_workers_.IsEmpty());
-    ml->Notify();
-    return nullptr;
-  }
-
-  // If we have maxed out the number of threads running, we will not start a
-  // new one.
-  if (max_pool_size_ > 0 && (count_idle_ + count_running_) >= max_pool_size_) {
-    if (!idle_workers_.IsEmpty()) {
-      ml->Notify();
-    }
-    return nullptr;
-  }
-
-  // Otherwise start a new worker.
-  auto new_worker = new Worker(this);
-  idle_workers_.Append(new_worker);
-  count_idle_++;
-  return new_worker;
-}
-
 ThreadPool::Worker::Worker(ThreadPool* pool)
-    : pool_(pool), join_id_(OSThread::kInvalidThreadJoinId) {}
+    : pool_(pool),
+      join_id_(OSThread::kInvalidThreadJoinId),
+      random_(static_cast<uint64_t>(reinterpret_cast<uword>(this)) | 1) {}
 
 void ThreadPool::Worker::StartThread() {
   int result = OSThread::Start("DartWorker", &Worker::Main,
@@ -333,13 +1000,23 @@ void ThreadPool::Worker::Main(uword args) {
   os_thread->owning_thread_pool_worker_ = worker;
   worker->os_thread_ = os_thread;
 
+  if (FLAG_worker_cpus != nullptr && worker->slot_ != nullptr) {
+    const intptr_t kMaxCpus = 1024;
+    intptr_t cpus[kMaxCpus];
+    const intptr_t length = ParseWorkerCpus(cpus, kMaxCpus);
+    if (length > 0) {
+      OSThread::SetCurrentThreadAffinity(
+          &cpus[worker->slot_->index() % length], 1);
+    }
+  }
+
   // Once the worker quits it needs to be joined.
   worker->join_id_ = OSThread::GetCurrentThreadJoinId(os_thread);
 
 #if defined(DEBUG)
   {
     MonitorLocker ml(&pool->pool_monitor_);
-    ASSERT(pool->idle_workers_.ContainsForDebugging(worker));
+    ASSERT(pool->live_workers_.ContainsForDebugging(worker));
   }
 #endif
 
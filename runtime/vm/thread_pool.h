@@ -5,18 +5,33 @@
 #ifndef RUNTIME_VM_THREAD_POOL_H_
 #define RUNTIME_VM_THREAD_POOL_H_
 
+#include <atomic>
 #include <memory>
 #include <utility>
 
+#include "platform/atomic.h"
 #include "vm/allocation.h"
 #include "vm/globals.h"
 #include "vm/intrusive_dlist.h"
 #include "vm/os_thread.h"
+#include "vm/random.h"
 
 namespace dart {
 
 class MonitorLocker;
 
+// A pool of worker threads with per-worker run queues and work stealing.
+//
+// Tasks scheduled from one of the pool's workers go into that worker's local
+// queue, tasks scheduled from other threads into a global queue. Workers
+// without work steal from the local queues of other workers and park on their
+// own monitor when there is nothing left to steal. New workers are started
+// when a task is scheduled while all workers are busy, up to
+// [max_pool_size].
+//
+// Tasks can also be scheduled with an affinity to a particular worker (see
+// [RunWithAffinity]). They are queued for that worker and only taken by other
+// workers if it does not get to them in time.
 class ThreadPool {
  public:
   // Subclasses of Task are able to run on a ThreadPool.
@@ -34,6 +49,28 @@ class ThreadPool {
     DISALLOW_COPY_AND_ASSIGN(Task);
   };
 
+  // The capacity of the FIFO ring of each worker's local queue. Tasks which
+  // do not fit go into the global queue.
+  static constexpr intptr_t kLocalQueueCapacity = 256;
+
+  // After this many consecutive tasks taken from its LIFO slot a worker runs
+  // a task from its FIFO ring, so two isolates ping-ponging messages on one
+  // worker can not starve the other tasks queued there.
+  static constexpr intptr_t kMaxLifoStreak = 3;
+
+  // Every this many searches a worker checks the global queue first, so
+  // tasks posted from outside the pool are not starved by busy workers.
+  static constexpr intptr_t kGlobalQueueCheckInterval = 61;
+
+  // Returned by [CurrentWorkerHint] if the current thread is not a worker of
+  // this pool with a local queue.
+  static constexpr intptr_t kNoWorkerHint = -1;
+
+  // How long the queue of tasks scheduled with an affinity to a worker can go
+  // without that worker taking a task from it before other workers may
+  // steal them.
+  static constexpr int64_t kAffinityStealDelayMicros = 50;
+
   explicit ThreadPool(uintptr_t max_pool_size = 0);
 
   // Prevent scheduling of new tasks, wait until all pending tasks are done
@@ -43,9 +80,23 @@ class ThreadPool {
   // Runs a task on the thread pool.
   template <typename T, typename... Args>
   bool Run(Args&&... args) {
-    return RunImpl(std::unique_ptr<Task>(new T(std::forward<Args>(args)...)));
+    return RunImpl(std::unique_ptr<Task>(new T(std::forward<Args>(args)...)),
+                   kNoWorkerHint);
   }
 
+  // Runs a task on the thread pool, preferably on the worker identified by
+  // [worker_hint] as returned by [CurrentWorkerHint]. Falls back to [Run] if
+  // that worker no longer exists.
+  template <typename T, typename... Args>
+  bool RunWithAffinity(intptr_t worker_hint, Args&&... args) {
+    return RunImpl(std::unique_ptr<Task>(new T(std::forward<Args>(args)...)),
+                   worker_hint);
+  }
+
+  // Identifies the worker running on the current thread for
+  // [RunWithAffinity], or returns [kNoWorkerHint].
+  intptr_t CurrentWorkerHint();
+
   // Returns `true` if the current thread is runing on the [this] thread pool.
   bool CurrentThreadIsWorker();
 
@@ -62,11 +113,158 @@ class ThreadPool {
   void Shutdown();
 
   // Exposed for unit test in thread_pool_test.cc
-  uint64_t workers_started() const { return count_idle_ + count_running_; }
+  uint64_t workers_started() const { return count_live_; }
   // Exposed for unit test in thread_pool_test.cc
   uint64_t workers_stopped() const { return count_dead_; }
+  // Number of tasks workers took out of other workers' local queues.
+  uint64_t tasks_stolen() const;
+  // Number of tasks scheduled with an affinity to one worker which were run
+  // by another one.
+  uint64_t affinity_tasks_migrated() const;
 
  private:
+  static constexpr intptr_t kCacheLineSize = 64;
+
+  // Upper bound on the number of workers with a local queue. Workers started
+  // beyond this limit only run tasks from the global queue or stolen from
+  // other workers, and exit as soon as they run out of work instead of
+  // parking.
+  static constexpr intptr_t kMaxWorkerSlots = 256;
+  static constexpr intptr_t kBitsPerWord = 64;
+  static constexpr intptr_t kSlotWords = kMaxWorkerSlots / kBitsPerWord;
+
+  // The maximum number of non-empty local queues a searching worker looks at
+  // in one steal attempt.
+  static constexpr intptr_t kMaxStealProbes = 8;
+
+  // How long a stealing worker waits for a busy owner to finish its current
+  // task and pick up its LIFO slot itself.
+  static constexpr int64_t kLifoStealDelayMicros = 3;
+
+  using TaskList = IntrusiveDList<Task>;
+
+  // The number of searching and unparked workers are packed into
+  // [idle_state_], so a worker can leave both states with one atomic update.
+  static constexpr int kUnparkedShift = 32;
+  static constexpr uint64_t kSearchingMask =
+      (uint64_t{1} << kUnparkedShift) - 1;
+  static constexpr uint64_t kOneSearching = 1;
+  static constexpr uint64_t kOneUnparked = uint64_t{1} << kUnparkedShift;
+  static intptr_t NumSearching(uint64_t state) {
+    return static_cast<intptr_t>(state & kSearchingMask);
+  }
+  static intptr_t NumUnparked(uint64_t state) {
+    return static_cast<intptr_t>(state >> kUnparkedShift);
+  }
+
+  // State kept per worker slot: the local run queue, the monitor the owning
+  // worker parks on and the owner's statistics.
+  //
+  // Tasks scheduled by the owner go into the LIFO slot, which the owner
+  // checks first once its current task is done. This makes continuations
+  // (e.g. a message handler re-running after a message was sent to it from
+  // this worker) run on warm caches. A task displaced from the LIFO slot
+  // moves into a bounded FIFO ring.
+  //
+  // Only the owner pushes, but any worker can take tasks from both the ring
+  // and the LIFO slot, which is how searching workers steal work. Slots are
+  // allocated lazily and never freed before the pool dies, so stealing
+  // workers can access them without synchronizing with worker deaths. Unused
+  // slots are always empty.
+  //
+  // Tasks scheduled by other threads with an affinity to the owner go into a
+  // separate, lock protected queue. It is not part of [IsEmpty], so other
+  // workers do not keep searching for tasks they may not take yet.
+  class WorkerSlot {
+   public:
+    explicit WorkerSlot(intptr_t index);
+
+    intptr_t index() const { return index_; }
+
+    // Owner only. Returns the task previously held by the LIFO slot, if any.
+    Task* ExchangeLifo(Task* task) {
+      return lifo_slot_.exchange(task, std::memory_order_acq_rel);
+    }
+    // Owner only. Returns false if the ring is full.
+    bool Push(Task* task);
+
+    // Any thread.
+    bool HasLifoTask() const {
+      return lifo_slot_.load(std::memory_order_relaxed) != nullptr;
+    }
+    // Any thread.
+    Task* TakeLifo() {
+      if (!HasLifoTask()) {
+        return nullptr;
+      }
+      return lifo_slot_.exchange(nullptr, std::memory_order_acq_rel);
+    }
+    // Any thread.
+    Task* Take();
+    // Takes half of the tasks in this slot's ring and moves all but the
+    // first into [thief]'s ring, which has to be empty. Returns the first
+    // task, or nullptr if the ring was empty.
+    Task* StealHalfInto(WorkerSlot* thief, intptr_t* stolen);
+
+    bool IsEmpty() const {
+      return !HasLifoTask() && top_.load(std::memory_order_acquire) >=
+                                   bottom_.load(std::memory_order_acquire);
+    }
+    bool owner_running_task() const {
+      return owner_running_task_.load(std::memory_order_relaxed);
+    }
+    bool HasAffinityTask() const {
+      return affinity_tasks_length_.load(std::memory_order_acquire) > 0;
+    }
+    // Whether the owner made no progress on its affinity queue for
+    // [kAffinityStealDelayMicros] at [now].
+    bool AffinityTasksOverdue(int64_t now) const {
+      return HasAffinityTask() &&
+             now - affinity_progress_micros_.load(std::memory_order_relaxed) >=
+                 kAffinityStealDelayMicros;
+    }
+
+   private:
+    friend class ThreadPool;
+
+    static constexpr intptr_t kCapacity = kLocalQueueCapacity;
+    static constexpr intptr_t kMask = kCapacity - 1;
+    COMPILE_ASSERT(Utils::IsPowerOfTwo(kCapacity));
+
+    const intptr_t index_;
+
+    // Written by stealing workers.
+    alignas(kCacheLineSize) std::atomic<intptr_t> top_;
+
+    // Mostly written by the owner.
+    alignas(kCacheLineSize) std::atomic<intptr_t> bottom_;
+    std::atomic<Task*> lifo_slot_;
+    // Whether the owner is currently inside [Task::Run]. Other workers only
+    // steal the LIFO slot of a busy owner.
+    std::atomic<bool> owner_running_task_;
+    RelaxedAtomic<uint64_t> tasks_stolen_;
+
+    std::atomic<Task*> buffer_[kCapacity];
+
+    // The owner parks on this monitor, see [ThreadPool::ParkWorker].
+    Monitor park_monitor_;
+    bool unpark_requested_ = false;
+
+    // Tasks scheduled with an affinity to the owner.
+    Mutex affinity_mutex_;
+    TaskList affinity_tasks_;             // Guarded by [affinity_mutex_].
+    bool accepts_affinity_tasks_ = false;  // Guarded by [affinity_mutex_].
+    std::atomic<intptr_t> affinity_tasks_length_;
+    // When the queue turned non-empty or a task was last taken from it.
+    std::atomic<int64_t> affinity_progress_micros_;
+    RelaxedAtomic<uint64_t> affinity_tasks_migrated_;
+
+    // Guarded by [ThreadPool::pool_monitor_].
+    bool in_use_ = false;
+
+    DISALLOW_COPY_AND_ASSIGN(WorkerSlot);
+  };
+
   class Worker : public IntrusiveDListEntry<Worker> {
    public:
     explicit Worker(ThreadPool* pool);
@@ -88,52 +286,106 @@ class ThreadPool {
     OSThread* os_thread_ = nullptr;
     bool is_blocked_ = false;
 
+    // Can be `nullptr` if the pool already handed out [kMaxWorkerSlots]
+    // slots.
+    WorkerSlot* slot_ = nullptr;
+
+    // Only accessed by the worker thread itself.
+    bool is_searching_ = true;
+    intptr_t lifo_streak_ = 0;
+    intptr_t searches_ = 0;
+    Random random_;
+
     DISALLOW_COPY_AND_ASSIGN(Worker);
   };
 
  protected:
-  // Called when the thread pool turns idle.
+  // Called when the last unparked worker is about to park, i.e. when the
+  // thread pool turns idle.
   //
-  // Subclasses can override this to perform some action.
-  // NOTE: While this function is running the thread pool will be locked.
+  // Subclasses can override this to perform some action. [ml] locks the
+  // monitor the worker parks on: waiting on it returns early if a task gets
+  // scheduled.
   virtual void OnEnterIdleLocked(MonitorLocker* ml) {}
 
   // Whether a shutdown was requested.
   bool ShuttingDownLocked() { return shutting_down_; }
 
   // Whether new tasks are ready to be run.
-  bool TasksWaitingToRunLocked() { return !tasks_.IsEmpty(); }
+  bool TasksWaitingToRunLocked() { return HasWork(); }
 
  private:
-  using TaskList = IntrusiveDList<Task>;
   using WorkerList = IntrusiveDList<Worker>;
 
-  bool RunImpl(std::unique_ptr<Task> task);
+  bool RunImpl(std::unique_ptr<Task> task, intptr_t worker_hint);
   void WorkerLoop(Worker* worker);
 
-  Worker* ScheduleTaskLocked(MonitorLocker* ml, std::unique_ptr<Task> task);
-
-  void IdleToRunningLocked(Worker* worker);
-  void RunningToIdleLocked(Worker* worker);
-  void IdleToDeadLocked(Worker* worker);
+  // Returns the worker of this pool running on the current thread, if any.
+  Worker* CurrentWorker();
+
+  void PushLocal(Worker* worker, Task* task);
+  void EnsureWorkerForScheduledTask();
+  bool UnparkWorker();
+  bool UnparkSlot(WorkerSlot* slot);
+  bool PushAffinityTask(intptr_t worker_hint, Task* task);
+  Worker* StartWorkerLocked(MonitorLocker* ml);
+
+  Task* FindTask(Worker* worker);
+  Task* FindLocalTask(Worker* worker);
+  Task* TakeGlobalTask();
+  Task* StealTask(Worker* worker);
+  Task* TakeAffinityTask(WorkerSlot* slot, bool migrate);
+  Task* StealAffinityTask(Worker* worker, WorkerSlot** waiting_victim);
+  // Whether there is work for any worker, or for the owner of [own_slot].
+  bool HasWork(WorkerSlot* own_slot = nullptr);
+
+  void TransitionToSearching(Worker* worker);
+  void TransitionFromSearching(Worker* worker);
+  bool ParkWorker(Worker* worker);
+  bool TryRetireWorker(Worker* worker);
+  bool CloseAffinityQueue(Worker* worker);
+
+  void MarkSlotNonEmpty(WorkerSlot* slot);
+  void MarkSlotEmpty(WorkerSlot* slot);
+  void AcquireWorkerSlotLocked(Worker* worker);
+
+  void WorkerDiedLocked(Worker* worker);
   void ObtainDeadWorkersLocked(WorkerList* dead_workers_to_join);
   void JoinDeadWorkersLocked(WorkerList* dead_workers_to_join);
 
-  Monitor pool_monitor_;
-  bool shutting_down_ = false;
-  uint64_t count_running_ = 0;
-  uint64_t count_idle_ = 0;
-  uint64_t count_dead_ = 0;
-  WorkerList running_workers_;
-  WorkerList idle_workers_;
+  // Idle workers are tracked without [pool_monitor_]: scheduling a task reads
+  // [idle_state_] and only wakes a parked worker if no worker is searching.
+  // Workers about to park or exit first publish their new state and then
+  // re-check for work, while scheduling first publishes the task and then
+  // inspects [idle_state_] and [parked_slots_]. Sequentially consistent
+  // fences on both sides guarantee that one of them observes the other.
+  alignas(kCacheLineSize) std::atomic<uint64_t> idle_state_ = {0};
+  alignas(kCacheLineSize) std::atomic<uint64_t> parked_slots_[kSlotWords];
+  alignas(kCacheLineSize) std::atomic<uint64_t> non_empty_slots_[kSlotWords];
+  // Slots with a non-empty affinity queue, updated under the slot's
+  // [affinity_mutex_].
+  alignas(kCacheLineSize) std::atomic<uint64_t> affinity_slots_[kSlotWords];
+  alignas(kCacheLineSize) std::atomic<intptr_t> global_tasks_length_ = {0};
+  std::atomic<bool> shutting_down_ = {false};
+
+  alignas(kCacheLineSize) Monitor pool_monitor_;
+  // Updated under [pool_monitor_], read without it by the accessors above.
+  std::atomic<uint64_t> count_live_ = {0};
+  std::atomic<uint64_t> count_dead_ = {0};
+
+  // Guarded by [pool_monitor_].
+  WorkerList live_workers_;
   WorkerList dead_workers_;
-  uint64_t pending_tasks_ = 0;
-  TaskList tasks_;
+  TaskList global_tasks_;
+
+  std::atomic<WorkerSlot*> worker_slots_[kMaxWorkerSlots];
+  std::atomic<intptr_t> worker_slots_length_ = {0};
 
   Monitor exit_monitor_;
   std::atomic<bool> all_workers_dead_;
 
-  uintptr_t max_pool_size_ = 0;
+  // Changed under [pool_monitor_], read without it when scheduling tasks.
+  RelaxedAtomic<uintptr_t> max_pool_size_;
 
   DISALLOW_COPY_AND_ASSIGN(ThreadPool);
 };
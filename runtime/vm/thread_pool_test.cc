@@ -256,4 +256,395 @@ THREAD_POOL_UNIT_TEST_CASE(ThreadPool_RecursiveSpawn) {
   EXPECT_EQ(kTotalTasks, done);
 }
 
+class ChildTask : public ThreadPool::Task {
+ public:
+  ChildTask(Monitor* sync, int* done) : sync_(sync), done_(done) {}
+
+  // Both the parent task and the test's main thread wait on [sync_].
+  virtual void Run() {
+    MonitorLocker ml(sync_);
+    (*done_)++;
+    ml.NotifyAll();
+  }
+
+ private:
+  Monitor* sync_;
+  int* done_;
+};
+
+class ParentTask : public ThreadPool::Task {
+ public:
+  ParentTask(ThreadPool* pool, Monitor* sync, int children, int* done)
+      : pool_(pool), sync_(sync), children_(children), done_(done) {}
+
+  // Schedules all children into this worker's local queue and then blocks
+  // until they are done, so they have to be stolen by other workers.
+  virtual void Run() {
+    for (int i = 0; i < children_; i++) {
+      EXPECT(pool_->Run<ChildTask>(sync_, done_));
+    }
+    MonitorLocker ml(sync_);
+    while (*done_ < children_) {
+      ml.Wait();
+    }
+    (*done_)++;
+    ml.Notify();
+  }
+
+ private:
+  ThreadPool* pool_;
+  Monitor* sync_;
+  int children_;
+  int* done_;
+};
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_StealFromBusyWorker) {
+  ThreadPool thread_pool;
+  Monitor sync;
+  // All children fit into the parent's local queue, none goes to the global
+  // queue.
+  const int kChildren = 16;
+  ASSERT(kChildren < ThreadPool::kLocalQueueCapacity);
+  int done = 0;
+  thread_pool.Run<ParentTask>(&thread_pool, &sync, kChildren, &done);
+  {
+    MonitorLocker ml(&sync);
+    while (done < kChildren + 1) {
+      ml.Wait();
+    }
+  }
+  EXPECT_EQ(kChildren + 1, done);
+  // The parent does not get to run any of them, so each one was stolen,
+  // including the one in its LIFO slot.
+  EXPECT_EQ(static_cast<uint64_t>(kChildren), thread_pool.tasks_stolen());
+}
+
+// Records the order and the threads in which tasks ran.
+class TaskLog {
+ public:
+  static const intptr_t kMaxEntries = 256;
+
+  void Record(intptr_t id) {
+    MonitorLocker ml(&monitor_);
+    RELEASE_ASSERT(length_ < kMaxEntries);
+    ids_[length_] = id;
+    threads_[length_] = OSThread::GetCurrentThreadId();
+    length_++;
+    ml.NotifyAll();
+  }
+
+  void WaitForLength(intptr_t length) {
+    MonitorLocker ml(&monitor_);
+    while (length_ < length) {
+      ml.Wait();
+    }
+  }
+
+  intptr_t IndexOf(intptr_t id) {
+    MonitorLocker ml(&monitor_);
+    for (intptr_t i = 0; i < length_; i++) {
+      if (ids_[i] == id) return i;
+    }
+    return -1;
+  }
+
+  intptr_t id(intptr_t i) const { return ids_[i]; }
+  ThreadId thread(intptr_t i) const { return threads_[i]; }
+
+  Monitor* monitor() { return &monitor_; }
+
+ private:
+  Monitor monitor_;
+  intptr_t length_ = 0;
+  intptr_t ids_[kMaxEntries];
+  ThreadId threads_[kMaxEntries];
+};
+
+class LogTask : public ThreadPool::Task {
+ public:
+  LogTask(TaskLog* log, intptr_t id) : log_(log), id_(id) {}
+
+  virtual void Run() { log_->Record(id_); }
+
+ private:
+  TaskLog* log_;
+  intptr_t id_;
+};
+
+class ScheduleTask : public ThreadPool::Task {
+ public:
+  ScheduleTask(ThreadPool* pool, TaskLog* log, intptr_t children)
+      : pool_(pool), log_(log), children_(children) {}
+
+  virtual void Run() {
+    log_->Record(0);
+    for (intptr_t i = 1; i <= children_; i++) {
+      EXPECT(pool_->Run<LogTask>(log_, i));
+    }
+  }
+
+ private:
+  ThreadPool* pool_;
+  TaskLog* log_;
+  intptr_t children_;
+};
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_LifoSlotLocality) {
+  TaskLog log;
+  const intptr_t kChildren = 5;
+  {
+    ThreadPool thread_pool(/*max_pool_size=*/1);
+    thread_pool.Run<ScheduleTask>(&thread_pool, &log, kChildren);
+    log.WaitForLength(kChildren + 1);
+  }
+  // The last task scheduled by a worker runs next, on the same worker, and
+  // the tasks it displaced from the LIFO slot follow in FIFO order.
+  EXPECT_EQ(0, log.id(0));
+  EXPECT_EQ(kChildren, log.id(1));
+  for (intptr_t i = 1; i < kChildren; i++) {
+    EXPECT_EQ(i, log.id(i + 1));
+  }
+  for (intptr_t i = 1; i <= kChildren; i++) {
+    EXPECT(OSThread::Compare(log.thread(0), log.thread(i)));
+  }
+}
+
+// Runs [length] tasks, each scheduling the next one as its continuation. The
+// first one waits for [start] to be set.
+class ChainTask : public ThreadPool::Task {
+ public:
+  ChainTask(ThreadPool* pool,
+            TaskLog* log,
+            intptr_t index,
+            intptr_t length,
+            bool* start)
+      : pool_(pool), log_(log), index_(index), length_(length), start_(start) {}
+
+  virtual void Run() {
+    if (start_ != nullptr) {
+      MonitorLocker ml(log_->monitor());
+      while (!*start_) {
+        ml.Wait();
+      }
+    }
+    log_->Record(index_);
+    if (index_ < length_) {
+      EXPECT(pool_->Run<ChainTask>(pool_, log_, index_ + 1, length_, nullptr));
+    }
+  }
+
+ private:
+  ThreadPool* pool_;
+  TaskLog* log_;
+  intptr_t index_;
+  intptr_t length_;
+  bool* start_;
+};
+
+class ScheduleChainTask : public ThreadPool::Task {
+ public:
+  ScheduleChainTask(ThreadPool* pool, TaskLog* log, intptr_t id)
+      : pool_(pool), log_(log), id_(id) {}
+
+  virtual void Run() {
+    log_->Record(0);
+    EXPECT(pool_->Run<LogTask>(log_, id_));
+    EXPECT(pool_->Run<ChainTask>(pool_, log_, 1, 100, nullptr));
+  }
+
+ private:
+  ThreadPool* pool_;
+  TaskLog* log_;
+  intptr_t id_;
+};
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_LifoStreakIsBounded) {
+  TaskLog log;
+  const intptr_t kDisplacedId = 1000;
+  {
+    ThreadPool thread_pool(/*max_pool_size=*/1);
+    thread_pool.Run<ScheduleChainTask>(&thread_pool, &log, kDisplacedId);
+    log.WaitForLength(102);
+  }
+  // The displaced task runs after [kMaxLifoStreak] continuations even though
+  // the chain keeps refilling the LIFO slot.
+  EXPECT_EQ(ThreadPool::kMaxLifoStreak + 1, log.IndexOf(kDisplacedId));
+}
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_GlobalQueueIsNotStarved) {
+  TaskLog log;
+  const intptr_t kChainLength = 200;
+  const intptr_t kGlobalId = 1000;
+  bool start = false;
+  {
+    ThreadPool thread_pool(/*max_pool_size=*/1);
+    thread_pool.Run<ChainTask>(&thread_pool, &log, 1, kChainLength, &start);
+    // The only worker is now blocked in the first chain task, so the next
+    // task goes into the global queue.
+    EXPECT(thread_pool.Run<LogTask>(&log, kGlobalId));
+    {
+      MonitorLocker ml(log.monitor());
+      start = true;
+      ml.NotifyAll();
+    }
+    log.WaitForLength(kChainLength + 1);
+  }
+  const intptr_t index = log.IndexOf(kGlobalId);
+  EXPECT(index > 0);
+  EXPECT(index <= ThreadPool::kGlobalQueueCheckInterval);
+}
+
+class ScheduleAndSignalTask : public ThreadPool::Task {
+ public:
+  ScheduleAndSignalTask(ThreadPool* pool,
+                        Monitor* sync,
+                        int children,
+                        int* done,
+                        bool* scheduled)
+      : pool_(pool),
+        sync_(sync),
+        children_(children),
+        done_(done),
+        scheduled_(scheduled) {}
+
+  virtual void Run() {
+    for (int i = 0; i < children_; i++) {
+      EXPECT(pool_->Run<ChildTask>(sync_, done_));
+    }
+    {
+      MonitorLocker ml(sync_);
+      *scheduled_ = true;
+      ml.NotifyAll();
+    }
+    // Give the main thread time to start shutting down while the children
+    // are still in our local queue.
+    OS::Sleep(10);
+  }
+
+ private:
+  ThreadPool* pool_;
+  Monitor* sync_;
+  int children_;
+  int* done_;
+  bool* scheduled_;
+};
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_ShutdownDrainsLocalQueues) {
+  Monitor sync;
+  const int kChildren = 100;
+  int done = 0;
+  bool scheduled = false;
+  ThreadPool* thread_pool = new ThreadPool(/*max_pool_size=*/1);
+  thread_pool->Run<ScheduleAndSignalTask>(thread_pool, &sync, kChildren, &done,
+                                          &scheduled);
+  {
+    MonitorLocker ml(&sync);
+    while (!scheduled) {
+      ml.Wait();
+    }
+  }
+  delete thread_pool;
+
+  MonitorLocker ml(&sync);
+  EXPECT_EQ(kChildren, done);
+}
+
+// Records the worker it runs on and then blocks until [release] is set.
+class BlockingHintTask : public ThreadPool::Task {
+ public:
+  BlockingHintTask(ThreadPool* pool,
+                   TaskLog* log,
+                   intptr_t* hint,
+                   bool* release)
+      : pool_(pool), log_(log), hint_(hint), release_(release) {}
+
+  virtual void Run() {
+    MonitorLocker ml(log_->monitor());
+    *hint_ = pool_->CurrentWorkerHint();
+    {
+      MonitorLeaveScope mls(&ml);
+      log_->Record(0);
+    }
+    while (!*release_) {
+      ml.Wait();
+    }
+  }
+
+ private:
+  ThreadPool* pool_;
+  TaskLog* log_;
+  intptr_t* hint_;
+  bool* release_;
+};
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_RunWithAffinity) {
+  TaskLog log;
+  intptr_t hint = ThreadPool::kNoWorkerHint;
+  bool release = false;
+  ThreadPool thread_pool;
+  EXPECT_EQ(ThreadPool::kNoWorkerHint, thread_pool.CurrentWorkerHint());
+  thread_pool.Run<BlockingHintTask>(&thread_pool, &log, &hint, &release);
+  log.WaitForLength(1);
+  EXPECT_NE(ThreadPool::kNoWorkerHint, hint);
+
+  // The preferred worker is busy, so another worker steals the task once it
+  // is overdue.
+  EXPECT(thread_pool.RunWithAffinity<LogTask>(hint, &log, 1));
+  log.WaitForLength(2);
+  EXPECT(!OSThread::Compare(log.thread(0), log.thread(1)));
+  EXPECT_EQ(1, thread_pool.affinity_tasks_migrated());
+
+  {
+    MonitorLocker ml(log.monitor());
+    release = true;
+    ml.NotifyAll();
+  }
+
+  // Hints for workers which do not exist fall back to [Run].
+  EXPECT(thread_pool.RunWithAffinity<LogTask>(1000, &log, 2));
+  log.WaitForLength(3);
+}
+
+// Records the worker it runs on.
+class HintTask : public ThreadPool::Task {
+ public:
+  HintTask(ThreadPool* pool, TaskLog* log, intptr_t* hint)
+      : pool_(pool), log_(log), hint_(hint) {}
+
+  virtual void Run() {
+    {
+      MonitorLocker ml(log_->monitor());
+      *hint_ = pool_->CurrentWorkerHint();
+    }
+    log_->Record(0);
+  }
+
+ private:
+  ThreadPool* pool_;
+  TaskLog* log_;
+  intptr_t* hint_;
+};
+
+THREAD_POOL_UNIT_TEST_CASE(ThreadPool_RunWithAffinityOnIdleWorker) {
+  TaskLog log;
+  intptr_t hint = ThreadPool::kNoWorkerHint;
+  // With a single worker, no other worker can take the tasks, however long
+  // the preferred worker takes to wake up.
+  ThreadPool thread_pool(/*max_pool_size=*/1);
+  thread_pool.Run<HintTask>(&thread_pool, &log, &hint);
+  log.WaitForLength(1);
+  {
+    MonitorLocker ml(log.monitor());
+    EXPECT_NE(ThreadPool::kNoWorkerHint, hint);
+  }
+
+  // Once idle, the preferred worker runs the tasks queued for it.
+  for (intptr_t i = 1; i < 10; i++) {
+    EXPECT(thread_pool.RunWithAffinity<LogTask>(hint, &log, i));
+    log.WaitForLength(i + 1);
+    EXPECT(OSThread::Compare(log.thread(0), log.thread(i)));
+  }
+  EXPECT_EQ(0, thread_pool.affinity_tasks_migrated());
+}
+
 }  // namespace dart
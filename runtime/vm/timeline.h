@@ -60,6 +60,7 @@ class Zone;
   V(API, "dart:api")                                                           \
   V(Compiler, "dart:compiler")                                                 \
   V(CompilerVerbose, "dart:compiler.verbose")                                  \
+  V(CompilerDecisions, "dart:compiler.decisions")                              \
   V(Dart, "dart:dart")                                                         \
   V(Debugger, "dart:debugger")                                                 \
   V(Embedder, "dart:embedder")                                                 \
@@ -6,6 +6,8 @@
 
 #include "platform/assert.h"
 
+#include "vm/compiler/backend/il_test_helper.h"
+#include "vm/compiler/jit/compiler.h"
 #include "vm/dart_api_impl.h"
 #include "vm/dart_api_state.h"
 #include "vm/globals.h"
@@ -375,6 +377,120 @@ TEST_CASE(TimelineRingRecorderJSONOrder) {
   EXPECT(alpha < beta);
 }
 
+// Keeps the arguments of the last "Compile" event.
+class CompileEventRecorder : public TimelineEventCallbackRecorder {
+ public:
+  CompileEventRecorder() : args_(nullptr) {}
+  ~CompileEventRecorder() { free(args_); }
+
+  void OnEvent(TimelineEvent* event) {
+    if ((strcmp(event->label(), "Compile") == 0) &&
+        (event->arguments_length() == 1)) {
+      free(args_);
+      args_ = Utils::StrDup(event->arguments()[0].value);
+    }
+  }
+
+  const char* args() const { return args_; }
+
+  intptr_t Size() { return -1; }
+
+ private:
+  char* args_;
+};
+
+ISOLATE_UNIT_TEST_CASE(TimelineCompilerDecisions) {
+  const char* kScript = R"(
+    int add(int a, int b) => a + b;
+
+    @pragma('vm:never-inline')
+    int sum(int n) {
+      int result = 0;
+      for (int i = 0; i < n; i++) {
+        result = add(result, i);
+      }
+      return result;
+    }
+
+    void main() {
+      sum(10);
+    }
+  )";
+
+  const auto& root_library = Library::Handle(LoadTestScript(kScript));
+  Invoke(root_library, "main");
+  const auto& function = Function::Handle(GetFunction(root_library, "sum"));
+
+  TimelineRecorderOverride<CompileEventRecorder> override;
+  Timeline::SetStreamCompilerDecisionsEnabled(true);
+  const auto& result =
+      Object::Handle(Compiler::CompileOptimizedFunction(thread, function));
+  Timeline::SetStreamCompilerDecisionsEnabled(false);
+  EXPECT(result.IsCode());
+
+  const char* args = override.recorder()->args();
+  EXPECT(args != nullptr);
+  if (args != nullptr) {
+    EXPECT_SUBSTRING("\"function\":\"sum\"", args);
+    EXPECT_SUBSTRING("\"tier\":\"optimized\"", args);
+    EXPECT_SUBSTRING("[\"Inlining\",", args);
+    EXPECT_SUBSTRING("\"add\"", args);
+  }
+}
+
+// Keeps the duration and the arguments of the "DeferredLoad" events.
+class DeferredLoadEventRecorder : public TimelineEventCallbackRecorder {
+ public:
+  DeferredLoadEventRecorder() : count_(0), duration_(-1), args_(64) {}
+
+  void OnEvent(TimelineEvent* event) {
+    if (strcmp(event->label(), "DeferredLoad") != 0) {
+      return;
+    }
+    count_++;
+    duration_ = event->TimeDuration();
+    args_.Clear();
+    for (intptr_t i = 0; i < event->arguments_length(); i++) {
+      args_.Printf("%s=%s;", event->arguments()[i].name,
+                   event->arguments()[i].value);
+    }
+  }
+
+  intptr_t count() const { return count_; }
+  int64_t duration() const { return duration_; }
+  const char* args() const { return args_.buffer(); }
+
+  intptr_t Size() { return -1; }
+
+ private:
+  intptr_t count_;
+  int64_t duration_;
+  TextBuffer args_;
+};
+
+ISOLATE_UNIT_TEST_CASE(TimelineDeferredLoadOfPrefetchedUnit) {
+  TimelineRecorderOverride<DeferredLoadEventRecorder> override;
+  Timeline::SetStreamIsolateEnabled(true);
+
+  // As left by Dart_PrefetchLoadingUnit.
+  const auto& unit = LoadingUnit::Handle(LoadingUnit::New());
+  unit.set_id(2);
+  unit.set_loaded(true);
+  unit.set_prefetched(true);
+
+  // Completes without calling the deferred load handler, which is not set.
+  const auto& result = Object::Handle(unit.IssueLoad());
+  Timeline::SetStreamIsolateEnabled(false);
+  EXPECT(!result.IsError());
+  EXPECT(unit.loaded());
+  EXPECT(!unit.load_outstanding());
+
+  EXPECT_EQ(1, override.recorder()->count());
+  EXPECT(override.recorder()->duration() >= 0);
+  EXPECT_STREQ("loadingUnit=2;prefetched=true;result=loaded;",
+               override.recorder()->args());
+}
+
 #endif  // !PRODUCT
 
 }  // namespace dart
@@ -108,7 +108,7 @@ class TimerImpl : public ValueObject {
 class Timer : public ValueObject {
  public:
   Timer(int64_t elapsed, int64_t elapsed_cpu)
-      : monotonic_(elapsed), cpu_(elapsed) {}
+      : monotonic_(elapsed), cpu_(elapsed_cpu) {}
   Timer() { Reset(); }
   ~Timer() {}
 
@@ -168,8 +168,9 @@ class Timer : public ValueObject {
                                                 int64_t total_elapsed,
                                                 int64_t total_elapsed_cpu) {
     if ((total_elapsed == 0) ||
-        static_cast<double>(Utils::Abs(total_elapsed - total_elapsed_cpu) /
-                            total_elapsed) < kCpuTimeReportingThreshold) {
+        static_cast<double>(Utils::Abs(total_elapsed - total_elapsed_cpu)) /
+                total_elapsed <
+            kCpuTimeReportingThreshold) {
       return FormatTime(zone, total_elapsed);
     } else {
       return OS::SCreate(zone, "%s (cpu %s)", FormatTime(zone, total_elapsed),